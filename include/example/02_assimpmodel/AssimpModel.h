@@ -2,7 +2,10 @@
 #define ASSIMP_MODEL_H
 
 #include "ThirdPersonEngine.h"
+#include "VulkanBindlessTextures.h"
 #include "VulkanFrameBuffer.h"
+#include "VulkanGpuTimer.h"
+#include "VulkanPicker.h"
 #include "VulkanVertFragShader.h"
 #include "camera/ShadowCamera.h"
 #include "camera/UniformCamera.h"
@@ -15,21 +18,38 @@ namespace VulkanEngine {
 
 class AssimpModel : public ThirdPersonEngine {
  public:
-  AssimpModel() = default;
+  // the split view's layout camera gets its own copy of set 0
+  AssimpModel() { m_maxSets = 2; }
   ~AssimpModel() noexcept;
 
   void prepareFunctions() override;
   void prepareMyObjects() override;
   void buildMyObjects(VkCommandBuffer& cmd) override;
+  void buildLayoutObjects(VkCommandBuffer& cmd);
   void render() override;
+  void updateCommand() override;
   void setDescriptorSet();
   void createPipelines();
   void createCube();
   void createShadowFrameBuffer();
   void createDebugQuad();
+  void createPicker();
+  void updatePicking();
+  void updateViewCameras();
+  void setSplitView(bool split);
+  VkRect2D getSceneRect() const;
+  void buildCommandBuffers() override;
+  void frameCompleted() override;
+  void recordCommandBuffer(uint32_t frame) override;
   void buildCommandBuffersBeforeMainRenderPass(VkCommandBuffer& cmd) override;
+  void buildCommandBuffersAfterMainRenderPass(VkCommandBuffer& cmd) override;
+  void recordShadowPass(VkCommandBuffer& cmd);
+  int chooseShadowMapSize() const;
+  void updateShadowMapSize();
   void seeDebugQuad();
-  void OnUpdateUIOverlay(vks::UIOverlay* overlay) override{};
+  void applyPerformanceTier(PerformanceTier tier);
+  void applyShadowFilter(int32_t filter);
+  void OnUpdateUIOverlay(vks::UIOverlay* overlay) override;
 
  protected:
   std::shared_ptr<AssimpObject> m_assimpObject = nullptr;
@@ -40,8 +60,11 @@ class AssimpModel : public ThirdPersonEngine {
   std::shared_ptr<UniformCamera> m_cubeUniform = nullptr;
   std::shared_ptr<VulkanTexture2D> m_cubeTextureA = nullptr;
   std::shared_ptr<VulkanTexture2D> m_cubeTextureB = nullptr;
-  // line shader for drawing lines
-  std::shared_ptr<VulkanVertFragShader> m_lineShader = nullptr;
+  VulkanDescriptorSet* m_materialDescriptorSet = nullptr;
+  // replaces the material set when the device supports descriptor indexing
+  VulkanBindlessTextures* m_bindlessTextures = nullptr;
+  // draws each edge of the model once, colored by its state
+  std::shared_ptr<VulkanVertFragShader> m_edgeShader = nullptr;
 
   // debug plane + shader
   std::shared_ptr<VulkanPlane> m_debugPlane = nullptr;
@@ -51,7 +74,61 @@ class AssimpModel : public ThirdPersonEngine {
   std::shared_ptr<VulkanFrameBuffer> m_frameBuffer = nullptr;
   std::shared_ptr<VulkanVertFragShader> m_shadowShader = nullptr;
   std::shared_ptr<ShadowCamera> m_shadowCamera = nullptr;
+  // the shadow pass, one per draw command buffer, submitted only when the
+  // shadow map is out of date
+  std::vector<VkCommandBuffer> m_shadowCmdBuffers;
+  bool m_shadowDirty = true;
+  // light version the shadow map was last rendered with
+  uint32_t m_shadowVersion = 0;
+  // hover picking, when the device can write primitive ids
+  VulkanPicker* m_picker = nullptr;
+  std::shared_ptr<VulkanVertFragShader> m_pickShader = nullptr;
+  // whether the ids are out of date, and the view they were drawn from
+  bool m_pickDirty = true;
+  glm::mat4 m_pickView = glm::mat4(0.f);
   bool m_seeDebug = false;
+  bool m_wireframe = false;
+  bool m_showEdges = true;
+  // the orbit view on the left and a flat, top-down layout view on the
+  // right, each drawn again only when it changed
+  bool m_splitView = false;
+  VulkanViewport* m_sceneView = nullptr;
+  VulkanViewport* m_layoutView = nullptr;
+  ThirdPersonCamera m_layoutCamera;
+  std::shared_ptr<UniformCamera> m_layoutUniform = nullptr;
+  // whether the mouse drives the layout view, picked when a drag starts
+  bool m_layoutFocus = false;
+  // parts left by the last cull of each view, for the overlay
+  std::array<uint32_t, AssimpObject::CULL_VIEW_COUNT> m_visibleParts = {};
+  // index into the overlay's quality list, a PerformanceTier
+  int32_t m_quality = 0;
+
+  // how shadows are filtered, also an index into the overlay's list
+  enum ShadowFilter : int32_t {
+    // the recorded pass is not timed
+    SHADOW_UNTIMED = -1,
+    SHADOW_OFF = 0,
+    SHADOW_HARD = 1,
+    SHADOW_FOUR_TAP = 2,
+    SHADOW_POISSON = 3,
+    SHADOW_FILTER_COUNT
+  };
+  int32_t m_shadowFilter = SHADOW_FOUR_TAP;
+  // times the main render pass, to compare the filters' costs
+  VulkanGpuTimer* m_sceneTimer = nullptr;
+  // per swap chain image, the filter its command buffer was last recorded
+  // with, SHADOW_UNTIMED while its variant was still building
+  std::vector<int32_t> m_recordedFilters;
+  // running average of the main pass's GPU time per filter, in ms
+  std::array<float, SHADOW_FILTER_COUNT> m_shadowFilterCost = {};
+
+  // specialization constant ids of scene.frag
+  enum SceneConstant : uint32_t {
+    SHADOW_FILTER = 0,
+    SHADOWS = 1,
+    TEXTURE_BLEND = 2,
+    LIGHTING = 3
+  };
 };
 
 }  // namespace VulkanEngine
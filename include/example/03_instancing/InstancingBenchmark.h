@@ -0,0 +1,50 @@
+#ifndef INSTANCING_BENCHMARK_H
+#define INSTANCING_BENCHMARK_H
+
+#include "ThirdPersonEngine.h"
+#include "VulkanInstanceBuffer.h"
+#include "VulkanVertFragShader.h"
+#include "camera/UniformCamera.h"
+#include "mesh/VulkanCube.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Draws a grid of 10k independently placed cubes, either as one
+ * instanced draw or as one push-constant draw per cube
+ *
+ * The overlay switches between the two paths and shows how long recording
+ * a frame's command buffer took, next to the frame time.
+ */
+class InstancingBenchmark : public ThirdPersonEngine {
+ public:
+  InstancingBenchmark() = default;
+  ~InstancingBenchmark() noexcept;
+
+  void prepareMyObjects() override;
+  void buildMyObjects(VkCommandBuffer& cmd) override;
+  void recordCommandBuffer(uint32_t frame) override;
+  void render() override;
+  void OnUpdateUIOverlay(vks::UIOverlay* overlay) override;
+  void createCubes();
+  void setDescriptorSet();
+  void createPipelines();
+
+ protected:
+  static constexpr uint32_t GRID_SIZE = 100;
+
+  std::shared_ptr<VulkanCube> m_cube = nullptr;
+  std::shared_ptr<UniformCamera> m_uniform = nullptr;
+  std::shared_ptr<VulkanVertFragShader> m_shader = nullptr;
+  std::shared_ptr<VulkanVertFragShader> m_instancedShader = nullptr;
+  VulkanInstanceBuffer* m_instances = nullptr;
+  std::vector<glm::mat4> m_transforms;
+
+  bool m_instanced = true;
+  // how long the last recordCommandBuffer took, in milliseconds
+  float m_recordTime = 0.f;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* INSTANCING_BENCHMARK_H */
@@ -3,6 +3,7 @@
 
 #include "VulkanBaseEngine.h"
 #include "camera/ThirdPersonCamera.h"
+#include "mesh/ModelBVH.h"
 
 namespace VulkanEngine {
 
@@ -12,6 +13,10 @@ class VULKANENGINE_EXPORT_API ThirdPersonEngine : public VulkanBaseEngine {
   virtual ~ThirdPersonEngine() {}
 
   void updateCamera();
+  void updateCamera(ThirdPersonCamera& camera, float panScale = 0.f);
+  ModelBVH::Ray getMouseRay(glm::mat4 const& modelViewProjection) const;
+  ModelBVH::Ray getMouseRay(glm::mat4 const& modelViewProjection,
+                            VkRect2D const& region) const;
 
   ThirdPersonCamera m_camera;
 
@@ -22,6 +22,9 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+private slots:
+    void openWindow();
+
 private:
     Ui::MainWindow *ui;
     QVulkanWindow* vulkanWindow;
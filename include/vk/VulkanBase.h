@@ -11,7 +11,14 @@
 #ifndef VULKANBASE_H
 #define VULKANBASE_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+
 #include "VulkanDevice.hpp"
+#include "VulkanDeviceContext.h"
+#include "VulkanMemoryTracker.h"
+#include "VulkanRetireQueue.h"
 #include "VulkanSwapChain.h"
 #include "VulkanTools.h"
 #include "base_template.h"
@@ -21,7 +28,27 @@
 
 namespace VulkanEngine {
 
+/**
+ * @brief What the render thread is doing, or asked to do next
+ *
+ * RUNNING renders frames. PAUSED parks the thread on a condition variable
+ * until resumed. RESIZING recreates the swap chain once the window has kept
+ * its size for a moment, rendering at the old size until then, and goes back
+ * to RUNNING. QUITTING ends the render loop; nothing leaves it.
+ */
+enum class RenderState { RUNNING, PAUSED, RESIZING, QUITTING };
+
 class VulkanBase {
+ protected:
+  // Depth attachment of the main render pass, for one window size
+  struct DepthStencil {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    uint32_t width = 0;
+    uint32_t height = 0;
+  };
+
  public:  // INIT METHODS
   VulkanBase() = default;
   virtual ~VulkanBase();
@@ -35,38 +62,46 @@ class VulkanBase {
   virtual void prepareBase();
   virtual void renderLoop();
   virtual void renderFrame();
+  virtual void frameCompleted() {}
+  virtual void frameSubmitted() {}
   virtual void updateOverlay() {}
+  virtual VkCommandBuffer recordOverlay() { return VK_NULL_HANDLE; }
   virtual void render();
   virtual void draw();
   virtual void updateCommand(){};
 
-  void waitForCurrentFrameComplete();
-  void pause() { m_pause = true; }
-  void resume() { m_pause = false; }
-  void quit() { m_quit = true; }
+  // Render thread control, called from the window's thread
+  void pause();
+  void resume();
+  void quit();
+  void requestResize(uint32_t width, uint32_t height);
+  RenderState getRenderState() const { return m_renderState; }
   bool getPrepared() const { return m_prepared; }
 
  protected:  // INIT METHODS
-  void createInstance();
-  void pickPhysicalDevice();
-  virtual void getDeviceFeatures(){};
-  void createLogicalDevice();
   void initSwapchain();
   void createCommandPool();
   void createSwapChain();
   void createCommandBuffers();
   void createSynchronizationPrimitives();
+  void createRenderSemaphores();
   void createDepthStencil();
+  void resizeDepthStencil();
   void createRenderPass();
   void createPipelineCache();
   void createFramebuffers();
   virtual void buildCommandBuffers(){};
-  void prepareFrame();
+  RenderState beginFrame();
+  void endFrame();
+  void setRenderState(RenderState state);
+  void scheduleResize();
+  bool prepareFrame();
   void submitFrame();
 
  public:  // OPERATION METHODS
   void destroySurface();
   void destroyCommandBuffers();
+  void destroyDepthStencil(DepthStencil& depthStencil);
   void windowResize();
 
   virtual void keyPressed(uint32_t) {}
@@ -83,10 +118,6 @@ class VulkanBase {
   // Sets the window id
   void setWindow(uint64_t winId) { m_winId = winId; }
 
-  // destination width and height
-  uint32_t m_destWidth = 1280;
-  uint32_t m_destHeight = 720;
-
  protected:
   // Window / surface id
   uint64_t m_winId;
@@ -97,11 +128,26 @@ class VulkanBase {
 
   // Vulkan instance states
   bool m_debug = true;
-  bool m_stop = false;
-  bool m_quit = false;
-  bool m_pause = false;
-  bool m_prepared = false;
-  bool m_signalFrame = true;
+  std::atomic<bool> m_prepared{false};
+
+  // Render thread state. Written under m_stateMutex, so m_stateChanged
+  // waiters can't miss a change, but readable without it.
+  std::atomic<RenderState> m_renderState{RenderState::RUNNING};
+  std::mutex m_stateMutex;
+  std::condition_variable m_stateChanged;
+  // whether the render thread is between beginFrame() and endFrame()
+  bool m_inFrame = false;
+  // a resize arrived, possibly while paused; applied when running again
+  bool m_resizePending = false;
+  // when the window last changed size, to wait for a drag to settle
+  std::chrono::steady_clock::time_point m_resizeRequested;
+  // window size to resize to, from the window's thread
+  uint32_t m_destWidth = 1280;
+  uint32_t m_destHeight = 720;
+
+  // Instance and device, shared with the process's other windows. The
+  // handles below are copied from it.
+  std::shared_ptr<VulkanDeviceContext> m_deviceContext;
 
   // Vulkan components
   VkResult m_result = VK_SUCCESS;
@@ -122,41 +168,50 @@ class VulkanBase {
   VkPhysicalDeviceMemoryProperties m_deviceMemoryProperties;
   vks::VulkanDevice* m_vulkanDevice = nullptr;
 
-  // Features / extensions enabled for our Vulkan instance
-  std::vector<std::string> m_supportedInstanceExtensions;
-  std::vector<std::string> m_supportedDeviceExtensions;
-  std::vector<char const*> m_enabledDeviceExtensions;
-  std::vector<char const*> m_enabledInstanceExtensions;
-  VkPhysicalDeviceFeatures m_enabledFeatures;
-  void* m_deviceCreatepNextChain = nullptr;
+  // Optional capabilities detected while picking the physical device
+  VulkanDeviceContext::Capabilities m_capabilities;
 
   // The swap chain for drawing to the screen
   VulkanSwapChain m_swapChain;
 
+  // Frames overlap, so no semaphore is shared between them. Each acquire
+  // signals a free semaphore, which the image's submission waits on. Once the
+  // image's fence shows that submission is done, the semaphore is free again.
   struct RenderSemaphores {
-    // Swap chain image presentation
-    VkSemaphore presentComplete = VK_NULL_HANDLE;
-    // Command buffer submission and execution
-    VkSemaphore renderComplete = VK_NULL_HANDLE;
+    // per swap chain image, signaled by its last acquire
+    std::vector<VkSemaphore> imageAcquired;
+    // not waited on by any pending submission
+    std::vector<VkSemaphore> free;
+    // per swap chain image, signaled by its submission for its present, which
+    // is done waiting by the time the image is acquired again
+    std::vector<VkSemaphore> renderComplete;
   } m_semaphores;
 
-  struct {
-    VkImage image = VK_NULL_HANDLE;
-    VkDeviceMemory mem = VK_NULL_HANDLE;
-    VkImageView view = VK_NULL_HANDLE;
-  } m_depthStencil;
+  DepthStencil m_depthStencil;
+  // depth stencils of sizes the window had before, least recently used first,
+  // so going back to one of them doesn't allocate
+  std::vector<DepthStencil> m_depthStencilPool;
 
   // Fences for synchronizing CPU-GPU communication
   std::vector<VkFence> m_waitFences;
+  // slots of per-frame resources such as the uniform ring, 0 if they follow
+  // the swap chain. Images of a swap chain that grew past it share a slot,
+  // and prepareFrame() keeps them from being in flight together.
+  uint32_t m_frameSlots = 0;
+  // destroys replaced resources once the fences show no frame uses them
+  VulkanRetireQueue m_retireQueue;
 
   // Render context
   std::vector<VkCommandBuffer> m_drawCmdBuffers;
+  // passes render() queues for this frame, submitted ahead of the draw
+  std::vector<VkCommandBuffer> m_frameCmdBuffers;
   VkRenderPass m_renderPass;
   std::vector<VkFramebuffer> m_frameBuffers;
   uint32_t m_currentBuffer = 0;
   VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
   std::vector<VkShaderModule> m_shaderModules;
-  VkPipelineCache m_pipelineCache;
+  // owned by the device context
+  VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
 
   // Mouse positions
   glm::vec2 m_mousePos;
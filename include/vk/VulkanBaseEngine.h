@@ -1,12 +1,20 @@
 #ifndef VULKAN_BASE_ENGINE_H
 #define VULKAN_BASE_ENGINE_H
 
+#include <chrono>
+
 #include "VulkanBase.h"
+#include "VulkanCompositor.h"
 #include "VulkanContext.h"
 #include "VulkanDescriptorSet.h"
+#include "VulkanDynamicResolution.h"
+#include "VulkanGeometryArena.h"
 #include "VulkanPipelines.h"
+#include "VulkanShaderReloader.h"
 #include "VulkanUIOverlay.h"
+#include "VulkanUniformRing.h"
 #include "VulkanVertexDescriptions.h"
+#include "VulkanViewport.h"
 
 namespace VulkanEngine {
 
@@ -19,28 +27,52 @@ class VULKANENGINE_EXPORT_API VulkanBaseEngine : public VulkanBase {
   virtual void prepare() override;
   virtual void render() override;
   virtual void updateOverlay() override;
+  virtual VkCommandBuffer recordOverlay() override;
   virtual void drawUI(const VkCommandBuffer commandBuffer);
   virtual void OnUpdateUIOverlay(vks::UIOverlay* overlay){};
   virtual void processPrepareCallback(){};
   virtual void updateCommand() override;
+  virtual void frameCompleted() override;
+  virtual void frameSubmitted() override;
 
   void renderAsyncThread();
   void renderJoin();
 
  protected:
   void prepareImGui();
+  void prepareUIRenderPass();
   void prepareDescriptorSets();
+  void preparePipelineLayout(
+      std::vector<VkDescriptorSetLayout> const& setLayouts);
   void prepareVertexDescriptions();
   void prepareBasePipelines();
+  void prepareUniformRing();
+  void prepareGeometryArena();
   void prepareContext();
+  void prepareCompositor();
+  void prepareDynamicResolution();
+  void drawMemoryReport();
+  void drawDynamicResolution();
 
   virtual void prepareMyObjects(){};
   virtual void buildCommandBuffersBeforeMainRenderPass(VkCommandBuffer& cmd){};
   virtual void buildCommandBuffers() override;
+  virtual void recordCommandBuffer(uint32_t frame);
   virtual void buildCommandBuffersAfterMainRenderPass(VkCommandBuffer& cmd){};
   virtual void setViewPorts(VkCommandBuffer& cmd);
+  void bindDescriptorSets(VkCommandBuffer& cmd);
+  void drawScene(VkCommandBuffer& cmd);
   virtual void buildMyObjects(VkCommandBuffer& cmd){};
 
+  VulkanViewport* addViewport(glm::vec2 const& offset, glm::vec2 const& size,
+                              uint32_t descriptorIndex,
+                              VulkanViewport::DrawFunction const& draw);
+  void removeViewports();
+  void markSceneChanged();
+  void recordViewport(VulkanViewport* viewport, uint32_t frame,
+                      std::array<VkClearValue, 2> const& clearValues);
+  void submitViewports();
+
   template <class T>
   void REGISTER_OBJECT(std::shared_ptr<T>& obj) {
     obj = VkObject::New<T>(m_context);
@@ -60,6 +92,8 @@ class VULKANENGINE_EXPORT_API VulkanBaseEngine : public VulkanBase {
   int m_maxSets = 1;
   struct Settings {
     bool overlay = true;
+    // draw the scene at a scale that holds a frame time budget
+    bool dynamicResolution = false;
   } m_settings;
   bool m_rebuild = false;
 
@@ -67,11 +101,50 @@ class VULKANENGINE_EXPORT_API VulkanBaseEngine : public VulkanBase {
   std::thread* m_thread = nullptr;
 
   vks::UIOverlay m_UIOverlay;
-
+  // draws the UI over the finished frame, loading what the main pass stored
+  VkRenderPass m_uiRenderPass = VK_NULL_HANDLE;
+  // one per swap chain image, recorded every frame
+  std::vector<VkCommandBuffer> m_uiCmdBuffers;
+
+  // owned by the device context
+  VulkanDescriptorLayoutCache* m_descriptorLayoutCache = nullptr;
+  VulkanDescriptorAllocator* m_descriptorAllocator = nullptr;
+  // the per-frame set (set 0)
   VulkanDescriptorSet* m_vulkanDescriptorSet = nullptr;
   VulkanVertexDescriptions* m_vulkanVertexDescriptions = nullptr;
+  // the same vertices plus a per-instance model matrix at locations 3 to 6
+  VulkanVertexDescriptions* m_instancedVertexDescriptions = nullptr;
   VulkanPipelines* m_pipelines = nullptr;
+  // owned by the device context
+  VulkanPipelineBuildQueue* m_pipelineBuildQueue = nullptr;
+  // finished pipeline builds the command buffers were recorded with
+  uint32_t m_pipelinesCompleted = 0;
+  std::chrono::high_resolution_clock::time_point m_startTime;
+  bool m_startupReported = false;
+  // only with PAPERARIUM_SHADER_HOT_RELOAD
+  VulkanShaderReloader* m_shaderReloader = nullptr;
   VulkanContext* m_context = nullptr;
+  VulkanUniformRing* m_uniformRing = nullptr;
+  // owned by the device context
+  VulkanGeometryArena* m_geometryArena = nullptr;
+  // arena generation the command buffers were recorded against
+  uint32_t m_geometryGeneration = 0;
+  // index of the draw command buffer recordCommandBuffer is recording
+  uint32_t m_recordingBuffer = 0;
+  // per swap chain image, whether it must be recorded before its next frame
+  std::vector<bool> m_staleCommandBuffers;
+  // whether the scene is recorded through the dynamic resolution's target
+  bool m_scaled = false;
+  // draws offscreen targets into the main pass
+  VulkanCompositor* m_compositor = nullptr;
+  VulkanDynamicResolution* m_dynamicResolution = nullptr;
+  // size the scene is recorded at, the window's unless scaled or in a view
+  VkExtent2D m_sceneExtent = {0, 0};
+  // views sharing the window, which replace the single scene when present
+  std::vector<VulkanViewport*> m_viewports;
+  // the view recordCommandBuffer is recording, if any
+  VulkanViewport* m_recordingViewport = nullptr;
+  // owned by the descriptor layout cache
   VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
 };
 
@@ -0,0 +1,71 @@
+#ifndef VULKAN_BINDLESS_TEXTURES_H
+#define VULKAN_BINDLESS_TEXTURES_H
+
+#include "VulkanBuffer.hpp"
+#include "VulkanDescriptorLayoutCache.h"
+#include "VulkanDevice.hpp"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief One descriptor set holding every texture of the scene, for devices
+ * with VK_EXT_descriptor_indexing
+ *
+ * Binding 0 is a storage buffer with the texture index of every registered
+ * model part, and binding 1 a partially-bound array of up to `capacity`
+ * sampled images. A part draw passes its part slot as its first instance, and
+ * the fragment shader looks its texture up through both bindings. This way a
+ * whole model, whatever its number of materials, draws with one set bound and
+ * one indirect call.
+ *
+ * Both grow when full: the part buffer without bound, the texture array up
+ * to the device's descriptor limits. Growing replaces the set, and the set
+ * is written without update-after-bind, so textures and parts must only be
+ * added while no command buffer using the set is in flight, and command
+ * buffers that bound it must be recorded again.
+ */
+class VULKANENGINE_EXPORT_API VulkanBindlessTextures {
+ public:
+  // returned by addTexture() once the array is at the device's limits
+  static constexpr uint32_t INVALID_INDEX = ~0u;
+
+  VulkanBindlessTextures(vks::VulkanDevice* vulkanDevice,
+                         VulkanDescriptorLayoutCache* layoutCache,
+                         uint32_t capacity = 1024, uint32_t partCapacity = 4096);
+  ~VulkanBindlessTextures();
+
+  uint32_t addTexture(VkDescriptorImageInfo const& imageInfo);
+  uint32_t addParts(std::vector<uint32_t> const& textureIndices);
+
+  void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout,
+            uint32_t set) const;
+  VkDescriptorSetLayout getLayout() const { return m_layout; }
+  uint32_t getTextureCount() const { return m_textureCount; }
+  uint32_t getCapacity() const { return m_capacity; }
+
+ protected:
+  void allocateSet(uint32_t capacity);
+  void growParts(uint32_t partCapacity);
+  void writeParts();
+
+  vks::VulkanDevice* m_vulkanDevice = nullptr;
+  // textures the current set has room for, and the most the layout allows
+  uint32_t m_capacity = 0;
+  uint32_t m_maxCapacity = 0;
+  uint32_t m_partCapacity = 0;
+  uint32_t m_textureCount = 0;
+  uint32_t m_partCount = 0;
+
+  // texture index of every part, read by the fragment shader
+  vks::Buffer m_parts;
+  VkDescriptorPool m_pool = VK_NULL_HANDLE;
+  // owned by the layout cache
+  VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+  VkDescriptorSet m_set = VK_NULL_HANDLE;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_BINDLESS_TEXTURES_H */
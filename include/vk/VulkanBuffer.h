@@ -4,21 +4,36 @@
 #include "VkObject.h"
 #include "VulkanBuffer.h"
 #include "VulkanContext.h"
+#include "VulkanUniformRing.h"
 
 namespace VulkanEngine {
 
+/**
+ * @brief A uniform block stored in the context's per-frame uniform ring
+ *
+ * Bind it as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, with the offset from
+ * getDynamicOffset for the frame being recorded.
+ */
 class VULKANENGINE_EXPORT_API VulkanBuffer : public VkObject {
  public:
   VulkanBuffer() = default;
-  virtual ~VulkanBuffer();
+  virtual ~VulkanBuffer() = default;
 
   virtual void prepare() override;
   virtual void update() override;
   virtual void prepareUniformBuffers() = 0;
   virtual void updateUniformBuffers() = 0;
 
- public:
-  vks::Buffer m_uniformBuffer;
+  VkDescriptorBufferInfo& getDescriptor() { return m_descriptor; }
+  uint32_t getDynamicOffset(uint32_t frame) const;
+
+ protected:
+  void createUniformBuffer(VkDeviceSize size, void const* data);
+  void writeUniformBuffer(void const* data);
+
+ protected:
+  VulkanUniformRing::Allocation m_allocation;
+  VkDescriptorBufferInfo m_descriptor = {};
 };
 
 }  // namespace VulkanEngine
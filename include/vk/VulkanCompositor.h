@@ -0,0 +1,54 @@
+#ifndef VULKAN_COMPOSITOR_H
+#define VULKAN_COMPOSITOR_H
+
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Draws offscreen color targets into rectangles of the main pass
+ *
+ * Each target is drawn with one triangle covering its rectangle and a
+ * bilinear lookup, so a target drawn smaller than its rectangle is upscaled.
+ * The dynamic resolution's scene and the viewports' images both go through
+ * it. Every target gets its own descriptor set from allocate(), pointed at
+ * the target with write(), and gives it back with release() once no frame in
+ * flight uses it. Sets can't be freed on their own, so released ones are kept
+ * for the next allocate().
+ */
+class VULKANENGINE_EXPORT_API VulkanCompositor {
+ public:
+  VulkanCompositor(VkDevice device, VulkanDescriptorLayoutCache* layoutCache,
+                   VulkanDescriptorAllocator* allocator);
+  ~VulkanCompositor();
+
+  void preparePipeline(
+      VkPipelineCache pipelineCache, VkRenderPass renderPass,
+      std::vector<VkPipelineShaderStageCreateInfo> const& shaders);
+
+  VkDescriptorSet allocate();
+  void release(VkDescriptorSet descriptorSet);
+  void write(VkDescriptorSet descriptorSet,
+             VkDescriptorImageInfo const* image) const;
+  void draw(VkCommandBuffer cmd, VkDescriptorSet descriptorSet,
+            VkRect2D const& rect, VkExtent2D const& drawn,
+            VkExtent2D const& size) const;
+
+ protected:
+  VkDevice m_device = VK_NULL_HANDLE;
+  VulkanDescriptorAllocator* m_allocator = nullptr;
+  // released sets, rewritten by their next user
+  std::vector<VkDescriptorSet> m_freeSets;
+
+  // owned by the layout cache
+  VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  VkPipeline m_pipeline = VK_NULL_HANDLE;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_COMPOSITOR_H */
@@ -10,11 +10,19 @@
 #ifndef VULKAN_CONTEXT_H
 #define VULKAN_CONTEXT_H
 
+#include <functional>
+
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
 #include "VulkanDevice.hpp"
+#include "VulkanGeometryArena.h"
+#include "VulkanUniformRing.h"
 #include "render_common.h"
 
 namespace VulkanEngine {
 
+class VulkanDeviceContext;
+
 /**
  * @brief The basic Vulkan context exposed as an API
  *
@@ -29,6 +37,19 @@ struct VULKANENGINE_EXPORT_API VulkanContext {
   VkQueue queue = VK_NULL_HANDLE;
   uint32_t* pScreenWidth = nullptr;
   uint32_t* pScreenHeight = nullptr;
+  // per-frame uniform data, indexed by the swap chain image being rendered
+  VulkanUniformRing* uniformRing = nullptr;
+  uint32_t* pCurrentFrame = nullptr;
+  // vertex and index buffers shared by every mesh, of every window
+  VulkanGeometryArena* geometryArena = nullptr;
+  // what the windows share, such as textures loaded from files
+  VulkanDeviceContext* deviceContext = nullptr;
+  // for material and object descriptor sets
+  VulkanDescriptorLayoutCache* descriptorLayoutCache = nullptr;
+  VulkanDescriptorAllocator* descriptorAllocator = nullptr;
+  // for objects whose drawn content changes without a recording (buffers
+  // written in place), so views that only draw when dirty draw again
+  std::function<void()> sceneChanged;
 
   VkDevice& getDevice() { return vulkanDevice->logicalDevice; }
 
@@ -0,0 +1,40 @@
+#ifndef VULKAN_DESCRIPTOR_ALLOCATOR_H
+#define VULKAN_DESCRIPTOR_ALLOCATOR_H
+
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Allocates descriptor sets of any layout from a growing list of pools
+ *
+ * When the current pool runs out, a new one is taken, so callers never need to
+ * know how many sets or descriptors they will allocate up front. Sets live as
+ * long as the allocator; they are written again rather than freed, and
+ * owners that replace theirs, like the compositor, keep them for reuse.
+ */
+class VULKANENGINE_EXPORT_API VulkanDescriptorAllocator {
+ public:
+  explicit VulkanDescriptorAllocator(VkDevice device,
+                                     uint32_t setsPerPool = 64);
+  ~VulkanDescriptorAllocator();
+
+  VkResult allocate(VkDescriptorSetLayout layout,
+                    VkDescriptorSet* descriptorSet);
+
+ protected:
+  VkDescriptorPool createPool();
+
+ protected:
+  VkDevice m_device = VK_NULL_HANDLE;
+  uint32_t m_setsPerPool = 64;
+  VkDescriptorPool m_currentPool = VK_NULL_HANDLE;
+  std::vector<VkDescriptorPool> m_pools;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_DESCRIPTOR_ALLOCATOR_H */
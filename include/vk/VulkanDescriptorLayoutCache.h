@@ -0,0 +1,46 @@
+#ifndef VULKAN_DESCRIPTOR_LAYOUT_CACHE_H
+#define VULKAN_DESCRIPTOR_LAYOUT_CACHE_H
+
+#include <map>
+#include <mutex>
+
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Creates descriptor set layouts and pipeline layouts once and hands
+ * out the same handle for every identical request
+ *
+ * Set layouts are keyed by their binding signature (binding number, type,
+ * count, stages and binding flags), regardless of the order the bindings were
+ * added in.
+ * Pipeline layouts are keyed by their set layouts and push constant ranges.
+ * The cache owns everything it creates. It is shared by every window of the
+ * process, so lookups are locked.
+ */
+class VULKANENGINE_EXPORT_API VulkanDescriptorLayoutCache {
+ public:
+  explicit VulkanDescriptorLayoutCache(VkDevice device) : m_device(device) {}
+  ~VulkanDescriptorLayoutCache();
+
+  VkDescriptorSetLayout getLayout(
+      std::vector<VkDescriptorSetLayoutBinding> bindings,
+      std::vector<VkDescriptorBindingFlagsEXT> bindingFlags = {});
+  VkPipelineLayout getPipelineLayout(
+      std::vector<VkDescriptorSetLayout> const& setLayouts,
+      std::vector<VkPushConstantRange> const& pushConstantRanges);
+
+ protected:
+  VkDevice m_device = VK_NULL_HANDLE;
+  std::mutex m_mutex;
+  std::map<std::vector<uint64_t>, VkDescriptorSetLayout> m_layouts;
+  std::map<std::vector<uint64_t>, VkPipelineLayout> m_pipelineLayouts;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_DESCRIPTOR_LAYOUT_CACHE_H */
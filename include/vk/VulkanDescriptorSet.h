@@ -10,6 +10,8 @@
 #ifndef VULKAN_DESCRIPTOR_SET_H
 #define VULKAN_DESCRIPTOR_SET_H
 
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
 #include "VulkanInitializers.hpp"
 #include "VulkanTools.h"
 #include "render_common.h"
@@ -17,6 +19,8 @@
 
 namespace VulkanEngine {
 
+class VulkanBuffer;
+
 /**
  * @brief A wrapper around the VkDescriptorSet type
  *
@@ -24,10 +28,17 @@ namespace VulkanEngine {
  * Allows for bundling CPU resources together in a way that is accessible to
  * the GPU. Supports two types of descriptors: buffers (vertices, etc.) and
  * images (samplers) which are then usable on the GPU.
+ *
+ * Each wrapper fills one set number of the pipeline layout, chosen by how
+ * often its contents change: per frame (camera, shadow map) or per material
+ * (textures). Layouts come from a shared cache and sets from a shared
+ * allocator, so changing a texture only rewrites its material's set.
  */
 class VULKANENGINE_EXPORT_API VulkanDescriptorSet {
  public:
   enum class DescriptorType { IMAGE = 0, BUFFER = 1 };
+  // set numbers, ordered by how often their contents change
+  enum Frequency : uint32_t { PER_FRAME = 0, PER_MATERIAL = 1 };
 
   struct DescriptorInfo {
     uint32_t binding = 0;
@@ -37,11 +48,16 @@ class VULKANENGINE_EXPORT_API VulkanDescriptorSet {
     VkShaderStageFlags stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     int descriptorIndex = 0;
     DescriptorType type = DescriptorType::IMAGE;
+    // set for uniform blocks living in the per-frame uniform ring
+    VulkanBuffer* dynamicBuffer = nullptr;
   };
 
  public:
-  VulkanDescriptorSet(VkDevice device, int maxSets = 1);
-  ~VulkanDescriptorSet();
+  VulkanDescriptorSet(VkDevice device,
+                      VulkanDescriptorLayoutCache* layoutCache,
+                      VulkanDescriptorAllocator* allocator,
+                      uint32_t set = PER_FRAME, int maxSets = 1);
+  ~VulkanDescriptorSet() = default;
 
   void addBinding(uint32_t binding, VkDescriptorImageInfo* descriptorInfo,
                   VkDescriptorType descriptorType,
@@ -49,16 +65,37 @@ class VULKANENGINE_EXPORT_API VulkanDescriptorSet {
   void addBinding(uint32_t binding, VkDescriptorBufferInfo* descriptorInfo,
                   VkDescriptorType descriptorType,
                   VkShaderStageFlags stageFlags, int descriptorIndex);
+  void addBinding(uint32_t binding, VulkanBuffer* uniformBuffer,
+                  VkShaderStageFlags stageFlags, int descriptorIndex);
 
-  void GenPipelineLayout(VkPipelineLayout* pipelineLayout);
+  void build();
+  void update(uint32_t binding, VkDescriptorImageInfo* descriptorInfo,
+              int descriptorIndex = 0);
+  void update(uint32_t binding, VkDescriptorBufferInfo* descriptorInfo,
+              int descriptorIndex = 0);
+  std::vector<VkDescriptorSet> reallocate();
+  void recycle(std::vector<VkDescriptorSet> const& descriptorSets);
+
+  VkDescriptorSetLayout getLayout() const { return m_descriptorSetLayout; }
+  uint32_t getSet() const { return m_set; }
   VkDescriptorSet& get(int index);
   size_t getSize();
+  void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout,
+            uint32_t frame, int index = 0);
+
+ protected:
+  VkWriteDescriptorSet getWrite(DescriptorInfo const& descriptorInfo);
 
  protected:
   VkDevice m_device = VK_NULL_HANDLE;
+  VulkanDescriptorLayoutCache* m_layoutCache = nullptr;
+  VulkanDescriptorAllocator* m_allocator = nullptr;
+  uint32_t m_set = PER_FRAME;
   std::vector<VkDescriptorSet> m_descriptorSets;
+  // sets reallocate() replaced, handed back once no frame uses them
+  std::vector<VkDescriptorSet> m_spareSets;
   std::vector<DescriptorInfo> m_descriptorInfos;
-  VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+  // owned by the layout cache
   VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
 };
 
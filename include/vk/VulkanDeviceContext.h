@@ -0,0 +1,163 @@
+#ifndef VULKAN_DEVICE_CONTEXT_H
+#define VULKAN_DEVICE_CONTEXT_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "VulkanDescriptorLayoutCache.h"
+#include "VulkanDevice.hpp"
+#include "VulkanGeometryArena.h"
+#include "VulkanPipelineBuildQueue.h"
+#include "VulkanPipelineCacheFile.h"
+#include "VulkanPipelineMap.h"
+#include "VulkanRenderPassCache.h"
+#include "VulkanShaderModuleCache.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief How much shading work the device can afford, picked from its type.
+ * Examples use it to choose their shader variants.
+ */
+enum class PerformanceTier { LOW, MEDIUM, HIGH };
+
+class VulkanTexture2D;
+
+/**
+ * @brief The Vulkan instance and device, shared by every window of the
+ * process
+ *
+ * The first window to call acquire() creates the instance, picks the
+ * physical device and creates the logical device; the others get the same
+ * context, and the last one to let go destroys it. Each window keeps its own
+ * surface, swap chain, command pool and render loop on top of it.
+ *
+ * Along with the device, the windows share what only depends on the device:
+ * the pipeline cache (and its file, saved once), the pipeline build queue's
+ * workers, and the caches of descriptor layouts, render passes and shader
+ * modules. Pipelines are keyed on those, so a second window gets the first
+ * one's pipelines out of the pipeline map instead of building its own. They
+ * also share their content: meshes live in one geometry arena, and textures
+ * loaded through loadTexture() are loaded once while any window holds them.
+ *
+ * All windows submit to the same queue, which Vulkan requires to be used by
+ * one thread at a time. getQueueMutex() is held around each vkQueueSubmit,
+ * vkQueuePresentKHR and queue idle, and only those, so windows record and
+ * wait on their fences side by side.
+ */
+class VULKANENGINE_EXPORT_API VulkanDeviceContext {
+ public:
+  // Optional capabilities detected while picking the physical device
+  struct Capabilities {
+    bool memoryBudget = false;
+    // large partially-bound texture arrays, indexed per draw in the shader
+    bool descriptorIndexing = false;
+    // several indirect draws from one vkCmdDrawIndexedIndirect call
+    bool multiDrawIndirect = false;
+    // pipelines with VK_POLYGON_MODE_LINE
+    bool wireframe = false;
+    // gl_PrimitiveID in fragment shaders, for the picking pass
+    bool primitiveId = false;
+    PerformanceTier performanceTier = PerformanceTier::MEDIUM;
+  };
+
+ public:
+  static std::shared_ptr<VulkanDeviceContext> acquire(bool debug);
+  ~VulkanDeviceContext();
+
+  VkInstance getInstance() const { return m_instance; }
+  VkPhysicalDevice getPhysicalDevice() const { return m_physicalDevice; }
+  vks::VulkanDevice* getVulkanDevice() const { return m_vulkanDevice; }
+  VkDevice getDevice() const { return m_device; }
+  VkQueue getQueue() const { return m_queue; }
+  std::mutex& getQueueMutex() { return m_vulkanDevice->queueMutex; }
+
+  VkPhysicalDeviceProperties const& getProperties() const {
+    return m_deviceProperties;
+  }
+  VkPhysicalDeviceFeatures const& getFeatures() const {
+    return m_deviceFeatures;
+  }
+  VkPhysicalDeviceMemoryProperties const& getMemoryProperties() const {
+    return m_deviceMemoryProperties;
+  }
+  Capabilities const& getCapabilities() const { return m_capabilities; }
+  VkFormat getDepthFormat() const { return m_depthFormat; }
+
+  VkPipelineCache getPipelineCache() const { return m_pipelineCache; }
+  VulkanPipelineCacheFile& getPipelineCacheFile() {
+    return m_pipelineCacheFile;
+  }
+  VulkanPipelineBuildQueue* getPipelineBuildQueue() const {
+    return m_pipelineBuildQueue;
+  }
+  VulkanDescriptorLayoutCache* getDescriptorLayoutCache() const {
+    return m_descriptorLayoutCache;
+  }
+  VulkanRenderPassCache* getRenderPassCache() const {
+    return m_renderPassCache;
+  }
+  VulkanShaderModuleCache* getShaderModuleCache() const {
+    return m_shaderModuleCache;
+  }
+  VulkanPipelineMap* getPipelineMap() const { return m_pipelineMap; }
+  VulkanGeometryArena* getGeometryArena() const { return m_geometryArena; }
+
+  std::shared_ptr<VulkanTexture2D> loadTexture(std::string const& path,
+                                               VkFormat format);
+
+ protected:
+  VulkanDeviceContext() = default;
+
+  void createInstance(bool debug);
+  void pickPhysicalDevice();
+  void createLogicalDevice();
+  bool isInstanceExtensionEnabled(char const* extension) const;
+  bool isDeviceExtensionSupported(char const* extension) const;
+
+ protected:
+  VkInstance m_instance = VK_NULL_HANDLE;
+  VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+  vks::VulkanDevice* m_vulkanDevice = nullptr;
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkQueue m_queue = VK_NULL_HANDLE;
+
+  // Physical device metadata
+  VkPhysicalDeviceProperties m_deviceProperties;
+  VkPhysicalDeviceFeatures m_deviceFeatures;
+  VkPhysicalDeviceMemoryProperties m_deviceMemoryProperties;
+  Capabilities m_capabilities;
+  VkFormat m_depthFormat = VK_FORMAT_D16_UNORM_S8_UINT;
+
+  // Features / extensions enabled for our Vulkan instance
+  std::vector<std::string> m_supportedInstanceExtensions;
+  std::vector<std::string> m_supportedDeviceExtensions;
+  std::vector<char const*> m_enabledDeviceExtensions;
+  std::vector<char const*> m_enabledInstanceExtensions;
+  VkPhysicalDeviceFeatures m_enabledFeatures = {};
+  void* m_deviceCreatepNextChain = nullptr;
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT m_descriptorIndexingFeatures =
+      {};
+
+  VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+  // loads the pipeline cache when created and saves it when destroyed
+  VulkanPipelineCacheFile m_pipelineCacheFile;
+  VulkanPipelineBuildQueue* m_pipelineBuildQueue = nullptr;
+  VulkanDescriptorLayoutCache* m_descriptorLayoutCache = nullptr;
+  VulkanRenderPassCache* m_renderPassCache = nullptr;
+  VulkanShaderModuleCache* m_shaderModuleCache = nullptr;
+  VulkanPipelineMap* m_pipelineMap = nullptr;
+  VulkanGeometryArena* m_geometryArena = nullptr;
+
+  // textures some window still holds, by file and format
+  std::mutex m_textureMutex;
+  std::map<std::pair<std::string, VkFormat>, std::weak_ptr<VulkanTexture2D>>
+      m_textures;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_DEVICE_CONTEXT_H */
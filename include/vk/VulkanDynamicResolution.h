@@ -0,0 +1,82 @@
+#ifndef VULKAN_DYNAMIC_RESOLUTION_H
+#define VULKAN_DYNAMIC_RESOLUTION_H
+
+#include <chrono>
+
+#include "VulkanCompositor.h"
+#include "VulkanDevice.hpp"
+#include "VulkanFrameBuffer.h"
+#include "VulkanRetireQueue.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Draws the scene at a fraction of the window's size, chosen to hold
+ * a frame time budget, and upscales it to the swap chain image
+ *
+ * The scene goes into the top-left corner of an offscreen color + depth
+ * target the size of the window, with the formats of the main render pass,
+ * so the scene's pipelines draw into either pass. Changing the scale only
+ * changes the viewport, so it costs a recording of the command buffers but
+ * no reallocation. The upscale is drawn by the compositor in the main pass
+ * before the overlay, which stays at native resolution.
+ *
+ * update() is called once per frame and measures the time between calls. The
+ * scale drops as soon as the average is over budget, and rises by one step
+ * only once the next step is expected to fit, so it does not oscillate
+ * between two steps.
+ */
+class VULKANENGINE_EXPORT_API VulkanDynamicResolution {
+ public:
+  static constexpr float MIN_SCALE = 0.5f;
+  static constexpr float MAX_SCALE = 1.f;
+  static constexpr float STEP = 0.05f;
+
+ public:
+  VulkanDynamicResolution(vks::VulkanDevice* vulkanDevice,
+                          VulkanCompositor* compositor,
+                          VulkanRetireQueue* retireQueue, VkFormat colorFormat,
+                          VkFormat depthFormat);
+  ~VulkanDynamicResolution();
+
+  void resize(uint32_t width, uint32_t height);
+  bool update();
+  void reset();
+
+  void beginRenderPass(VkCommandBuffer cmd,
+                       std::array<VkClearValue, 2> const& clearValues) const;
+  void draw(VkCommandBuffer cmd) const;
+
+  VkExtent2D getExtent() const;
+  float getScale() const { return m_scale; }
+  float getTargetFrameTime() const { return m_targetMs; }
+  void setTargetFrameTime(float milliseconds) { m_targetMs = milliseconds; }
+  float getAverageFrameTime() const { return m_averageMs; }
+
+ protected:
+  vks::VulkanDevice* m_vulkanDevice = nullptr;
+  VkDevice m_device = VK_NULL_HANDLE;
+  VulkanCompositor* m_compositor = nullptr;
+  VulkanRetireQueue* m_retireQueue = nullptr;
+  VkFormat m_colorFormat = VK_FORMAT_B8G8R8A8_UNORM;
+  VkFormat m_depthFormat = VK_FORMAT_D16_UNORM;
+  VulkanFrameBuffer* m_target = nullptr;
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+
+  VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+  float m_scale = MAX_SCALE;
+  float m_targetMs = 33.3f;
+  float m_averageMs = 0.f;
+  // frames measured since the scale last changed
+  uint32_t m_settledFrames = 0;
+  std::chrono::steady_clock::time_point m_lastUpdate;
+  bool m_measuring = false;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_DYNAMIC_RESOLUTION_H */
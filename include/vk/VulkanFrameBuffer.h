@@ -4,6 +4,7 @@
 #include "VulkanContext.h"
 #include "VulkanDevice.hpp"
 #include "VulkanRenderPass.h"
+#include "VulkanRetireQueue.h"
 #include "base_template.h"
 #include "render_common.h"
 
@@ -16,6 +17,9 @@ class VULKANENGINE_EXPORT_API VulkanFrameBuffer {
 
   void createWithDepth();
   void createWithColorDepth();
+  bool resizeDepth(int width, int height,
+                   VulkanRetireQueue* retireQueue = nullptr);
+  bool resizeColorDepth(int width, int height);
 
   void setSize(int width, int height) {
     m_width = width;
@@ -34,10 +38,22 @@ class VULKANENGINE_EXPORT_API VulkanFrameBuffer {
   }
 
   void setFormat(VkFormat format) { m_format = format; }
+  // depth of color + depth frame buffers, picked from the device if not set
+  void setDepthFormat(VkFormat format) { m_depthFormat = format; }
+  // a render pass of the right formats, not owned, or one is created
+  void setRenderPass(VulkanRenderPass* renderPass) {
+    m_renderPass = renderPass;
+  }
 
   VulkanRenderPass*& getRenderPass() { return m_renderPass; }
   VkFramebuffer& get() { return m_frameBuffer; }
   VkDescriptorImageInfo& getDescriptor() { return m_descriptor; }
+  // the depth attachment through a comparison sampler, for sampler2DShadow
+  VkDescriptorImageInfo& getCompareDescriptor() { return m_compareDescriptor; }
+  // the same without filtering between the compares
+  VkDescriptorImageInfo& getNearestCompareDescriptor() {
+    return m_nearestCompareDescriptor;
+  }
 
   int getWidth() const { return m_width; }
   int getHeight() const { return m_height; }
@@ -45,34 +61,37 @@ class VULKANENGINE_EXPORT_API VulkanFrameBuffer {
   auto& getColorAttachment() { return m_color; }
   auto& getDepthAttachment() { return m_depth; }
 
+ protected:
+  void createDepthTarget();
+  void destroyDepthTarget();
+  void createColorDepthTarget();
+  void destroyColorDepthTarget();
+
  protected:
   int m_width = 2048;
   int m_height = 2048;
   VulkanContext* m_context = nullptr;
   VkDevice m_device = VK_NULL_HANDLE;
   VkFormat m_format = VK_FORMAT_D16_UNORM;
+  VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
   vks::VulkanDevice* m_vulkanDevice = nullptr;
   VulkanRenderPass* m_renderPass = nullptr;
+  bool m_ownsRenderPass = false;
   VkFramebuffer m_frameBuffer = VK_NULL_HANDLE;
 
-  struct ColorAttachment {
-    VkImageView view = VK_NULL_HANDLE;
-    VkImage image = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
-  } m_color;
-
-  struct DepthAttachment {
+  struct Attachment {
     VkImageView view = VK_NULL_HANDLE;
     VkImage image = VK_NULL_HANDLE;
     VkDeviceMemory memory = VK_NULL_HANDLE;
-  } m_depth;
+  } m_color, m_depth;
 
   VkSampler m_colorSampler = VK_NULL_HANDLE;
   VkSampler m_depthSampler = VK_NULL_HANDLE;
+  VkSampler m_depthCompareSampler = VK_NULL_HANDLE;
+  VkSampler m_depthNearestCompareSampler = VK_NULL_HANDLE;
   VkDescriptorImageInfo m_descriptor;
-
- public:
-  VkRenderPass m_pRenderPass;
+  VkDescriptorImageInfo m_compareDescriptor;
+  VkDescriptorImageInfo m_nearestCompareDescriptor;
 };
 
 }  // namespace VulkanEngine
@@ -0,0 +1,156 @@
+#ifndef VULKAN_GEOMETRY_ARENA_H
+#define VULKAN_GEOMETRY_ARENA_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "VulkanBuffer.hpp"
+#include "VulkanDevice.hpp"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief One device-local vertex buffer and one index buffer shared by every
+ * mesh in the scene
+ *
+ * Meshes are sub-allocated from the two buffers and referred to by a handle.
+ * A frame binds the buffers once and draws each mesh with its firstIndex and
+ * vertexOffset. Indices are stored relative to the mesh's first vertex, so
+ * meshes can be moved around without rewriting them.
+ *
+ * Freed ranges go back to a free list. When an upload does not fit, the arena
+ * first compacts the live meshes to the front of the buffers, and if that is
+ * not enough, reallocates bigger ones. Either way the buffers are replaced and
+ * the generation increases, so recorded command buffers must be rebuilt. The
+ * old buffers are copied from on the queue without waiting for it, and only
+ * destroyed once the copy's fence shows every frame reading them is done.
+ *
+ * The device context owns the arena and every window draws from it. A mesh
+ * uploaded under a key, such as its file's path, is only copied in once and
+ * freed with the last release under that key. Since uploads, releases and
+ * compaction may move or reuse ranges, they wait until no window is between
+ * recording a frame and submitting it, see lockShared().
+ */
+class VULKANENGINE_EXPORT_API VulkanGeometryArena {
+ public:
+  typedef uint32_t Handle;
+  static constexpr Handle INVALID_HANDLE = ~0u;
+
+  struct Mesh {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+    // uploads under the mesh's key that haven't been released yet
+    uint32_t users = 0;
+    std::string key;
+    bool live = false;
+  };
+
+ public:
+  VulkanGeometryArena(vks::VulkanDevice* vulkanDevice, VkQueue queue,
+                      uint32_t vertexStride, uint32_t vertexCapacity = 65536,
+                      uint32_t indexCapacity = 196608);
+  ~VulkanGeometryArena();
+
+  Handle upload(void const* vertices, uint32_t vertexCount,
+                uint32_t const* indices, uint32_t indexCount,
+                std::string const& key = "");
+  void release(Handle handle);
+  void compact();
+
+  void lockShared();
+  void unlockShared();
+
+  Mesh const& get(Handle handle) const { return m_meshes[handle]; }
+  void bind(VkCommandBuffer commandBuffer) const;
+  void draw(VkCommandBuffer commandBuffer, Handle handle,
+            uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+  void draw(VkCommandBuffer commandBuffer, Handle indices,
+            Handle vertices) const;
+
+  uint32_t getGeneration() const { return m_generation; }
+  uint32_t getVertexStride() const { return m_vertexStride; }
+
+ protected:
+  /**
+   * @brief First-fit allocator over a range of elements, merging neighbouring
+   * free blocks as they are released
+   */
+  class FreeList {
+   public:
+    void reset(uint32_t capacity, uint32_t used = 0);
+    bool allocate(uint32_t count, uint32_t& offset);
+    void release(uint32_t offset, uint32_t count);
+    uint32_t getFree() const { return m_free; }
+    uint32_t getCapacity() const { return m_capacity; }
+
+   private:
+    // offset -> size of every free block
+    std::map<uint32_t, uint32_t> m_blocks;
+    uint32_t m_capacity = 0;
+    uint32_t m_free = 0;
+  };
+
+  /**
+   * @brief Holds the arena for a change, against every window's frames
+   */
+  class ExclusiveLock {
+   public:
+    explicit ExclusiveLock(VulkanGeometryArena& arena);
+    ~ExclusiveLock();
+
+   private:
+    VulkanGeometryArena& m_arena;
+  };
+
+  void createBuffers(uint32_t vertexCapacity, uint32_t indexCapacity,
+                     vks::Buffer& vertices, vks::Buffer& indices);
+  void reallocate(uint32_t vertexCapacity, uint32_t indexCapacity);
+  void collectRetired(bool wait = false);
+  bool tryAllocate(uint32_t vertexCount, uint32_t indexCount, Mesh& mesh);
+
+ protected:
+  vks::VulkanDevice* m_vulkanDevice = nullptr;
+  VkQueue m_queue = VK_NULL_HANDLE;
+  uint32_t m_vertexStride = 0;
+
+  vks::Buffer m_vertices;
+  vks::Buffer m_indices;
+  // for the copies out of replaced buffers, only used with the arena held
+  // exclusively or m_lockMutex locked
+  VkCommandPool m_commandPool = VK_NULL_HANDLE;
+
+  // buffers replaced by reallocate(), waiting for the frames reading them
+  struct Retired {
+    vks::Buffer vertices;
+    vks::Buffer indices;
+    VkCommandBuffer copyCmd = VK_NULL_HANDLE;
+    // signaled once the copy and every submission before it are done
+    VkFence fence = VK_NULL_HANDLE;
+  };
+  std::vector<Retired> m_retired;
+  FreeList m_vertexFreeList;
+  FreeList m_indexFreeList;
+
+  std::vector<Mesh> m_meshes;
+  std::vector<Handle> m_freeHandles;
+  std::map<std::string, Handle> m_keys;
+  uint32_t m_generation = 0;
+
+  // frames between recording and submission hold the arena shared, changes
+  // hold it exclusively and go first once they are waiting
+  std::mutex m_lockMutex;
+  std::condition_variable m_lockReleased;
+  uint32_t m_sharedCount = 0;
+  uint32_t m_exclusiveWaiting = 0;
+  bool m_exclusive = false;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_GEOMETRY_ARENA_H */
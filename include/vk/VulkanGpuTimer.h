@@ -0,0 +1,45 @@
+#ifndef VULKAN_GPU_TIMER_H
+#define VULKAN_GPU_TIMER_H
+
+#include "VulkanDevice.hpp"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Measures how long a span of a command buffer takes on the GPU
+ *
+ * Each draw command buffer gets a pair of timestamp queries, written by
+ * begin() and end() while recording. Since the command buffers are recorded
+ * once and submitted many times, the queries are reset as part of the span.
+ * collect() reads the pair back once the frame's previous submission has
+ * finished, without waiting for the GPU.
+ */
+class VULKANENGINE_EXPORT_API VulkanGpuTimer {
+ public:
+  VulkanGpuTimer(vks::VulkanDevice* vulkanDevice, uint32_t queueFamily,
+                 uint32_t frameCount);
+  ~VulkanGpuTimer();
+
+  bool isSupported() const { return m_queryPool != VK_NULL_HANDLE; }
+  uint32_t getFrameCount() const { return m_frameCount; }
+
+  void begin(VkCommandBuffer cmd, uint32_t frame) const;
+  void end(VkCommandBuffer cmd, uint32_t frame) const;
+  bool collect(uint32_t frame, float& milliseconds);
+
+ protected:
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkQueryPool m_queryPool = VK_NULL_HANDLE;
+  uint32_t m_frameCount = 0;
+  // nanoseconds per timestamp tick
+  float m_timestampPeriod = 1.f;
+  uint64_t m_timestampMask = ~0ull;
+  // whether each frame's queries have been submitted since the last read
+  std::vector<bool> m_submitted;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_GPU_TIMER_H */
@@ -0,0 +1,57 @@
+#ifndef VULKAN_INSTANCE_BUFFER_H
+#define VULKAN_INSTANCE_BUFFER_H
+
+#include "VulkanBuffer.hpp"
+#include "VulkanDevice.hpp"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief A device-local buffer of per-instance model matrices
+ *
+ * Bound at INSTANCE_BUFFER_BIND_ID next to the geometry arena, it lets one
+ * mesh be drawn many times in a single call, each copy placed by its own
+ * matrix. Pipelines drawing from it need a vertex input state with
+ * VulkanVertexDescriptions::AddInstanceTransformDescriptions().
+ *
+ * Transforms are meant to change rarely (a page layout, a set of flaps), so
+ * they are kept once rather than per frame. An upload is a staging copy
+ * submitted to the queue, fenced by barriers against the frames around it,
+ * so it never waits for the queue. Its staging buffer, and a buffer it
+ * outgrew, are freed once its fence signals.
+ */
+class VULKANENGINE_EXPORT_API VulkanInstanceBuffer {
+ public:
+  VulkanInstanceBuffer(vks::VulkanDevice* vulkanDevice, VkQueue queue);
+  ~VulkanInstanceBuffer();
+
+  bool setTransforms(std::vector<glm::mat4> const& transforms);
+  void bind(VkCommandBuffer commandBuffer) const;
+  uint32_t getCount() const { return m_count; }
+
+ protected:
+  void retireUploads(bool wait);
+
+  // an upload in flight, and what must live until it completes
+  struct Upload {
+    VkFence fence = VK_NULL_HANDLE;
+    VkCommandPool cmdPool = VK_NULL_HANDLE;
+    VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+    vks::Buffer staging;
+    // the buffer this upload's one replaced, which older frames may read
+    vks::Buffer replaced;
+  };
+
+  vks::VulkanDevice* m_vulkanDevice = nullptr;
+  VkQueue m_queue = VK_NULL_HANDLE;
+  vks::Buffer m_buffer;
+  uint32_t m_capacity = 0;
+  uint32_t m_count = 0;
+  std::vector<Upload> m_uploads;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_INSTANCE_BUFFER_H */
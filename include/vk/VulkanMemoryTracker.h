@@ -0,0 +1,117 @@
+#ifndef VULKAN_MEMORY_TRACKER_H
+#define VULKAN_MEMORY_TRACKER_H
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Keeps a ledger of every device memory allocation the engine makes.
+ *
+ * Allocations are grouped into categories so we can see which subsystem is
+ * responsible for how much of the GPU's memory. When VK_EXT_memory_budget is
+ * available, the driver-reported budget and usage for each heap are queried
+ * alongside our own bookkeeping. Anything still in the ledger when the device
+ * is torn down is reported as a leak.
+ */
+class VulkanMemoryTracker {
+ public:
+  enum class Category : uint32_t {
+    MESH = 0,
+    TEXTURE,
+    SHADOW_MAP,
+    RENDER_TARGET,
+    UNIFORM,
+    UI,
+    STAGING,
+    OTHER,
+    COUNT
+  };
+
+  struct Usage {
+    VkDeviceSize current = 0;
+    VkDeviceSize peak = 0;
+    uint32_t allocations = 0;
+  };
+
+  struct HeapBudget {
+    bool deviceLocal = false;
+    VkDeviceSize size = 0;
+    // driver-reported values, only valid with VK_EXT_memory_budget
+    VkDeviceSize budget = 0;
+    VkDeviceSize usage = 0;
+    // what we have allocated from this heap ourselves
+    VkDeviceSize tracked = 0;
+  };
+
+  /**
+   * @brief Overrides the category (and name) of allocations made on this
+   * thread while the scope is alive.
+   *
+   * Useful for code paths that go through vks::VulkanDevice::createBuffer,
+   * whose category would otherwise be derived from the buffer usage flags.
+   */
+  class Scope {
+   public:
+    Scope(Category category, char const* name = nullptr);
+    ~Scope();
+
+   private:
+    bool m_previousActive;
+    Category m_previousCategory;
+    char const* m_previousName;
+  };
+
+  static VulkanMemoryTracker& get();
+  static char const* getCategoryName(Category category);
+  static Category categorize(VkBufferUsageFlags usage);
+
+  void attach(VkInstance instance, VkPhysicalDevice physicalDevice,
+              bool memoryBudget);
+  void detach();
+
+  VkResult allocate(VkDevice device, VkMemoryAllocateInfo const* allocateInfo,
+                    VkDeviceMemory* memory, Category category,
+                    char const* name = nullptr);
+  void free(VkDevice device, VkDeviceMemory memory);
+
+  Usage getUsage(Category category) const;
+  VkDeviceSize getTotal() const;
+  VkDeviceSize getPeak() const;
+  bool hasBudget() const { return m_getMemoryProperties2 != nullptr; }
+  std::vector<HeapBudget> getHeapBudgets() const;
+
+  size_t reportLeaks() const;
+
+ private:
+  VulkanMemoryTracker() = default;
+
+  struct Allocation {
+    VkDeviceSize size;
+    uint32_t heapIndex;
+    Category category;
+    std::string name;
+  };
+
+  mutable std::mutex m_mutex;
+  VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+  VkPhysicalDeviceMemoryProperties m_memoryProperties = {};
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_getMemoryProperties2 =
+      nullptr;
+
+  std::unordered_map<VkDeviceMemory, Allocation> m_allocations;
+  std::array<Usage, static_cast<size_t>(Category::COUNT)> m_usage;
+  std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_heapUsage = {};
+  VkDeviceSize m_total = 0;
+  VkDeviceSize m_peak = 0;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_MEMORY_TRACKER_H */
@@ -0,0 +1,106 @@
+#ifndef VULKAN_PICKER_H
+#define VULKAN_PICKER_H
+
+#include <cfloat>
+
+#include "VulkanBuffer.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanRenderPassCache.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Finds what is under the cursor by rendering ids instead of colors
+ *
+ * The pass draws into an R32_UINT attachment at 1 / SCALE of the screen's
+ * size, and only when the view or the scene changed. Every pick copies the
+ * (2 * RADIUS + 1)^2 texels around the cursor into one of a ring of
+ * host-visible buffers, in its own fenced submission. Results are read once
+ * that fence has signaled, normally on the next frame, so picking never
+ * waits on the GPU: while every slot is still in flight, a pick is skipped.
+ *
+ * Whatever the draw callback writes is the id, 0 meaning nothing.
+ */
+class VULKANENGINE_EXPORT_API VulkanPicker {
+ public:
+  struct Result {
+    // id under the cursor
+    uint32_t id = 0;
+    // the closest other id read around it, and its distance in pick texels,
+    // so borders between ids (e.g. edges between faces) can be hovered too
+    uint32_t neighborId = 0;
+    float neighborDistance = FLT_MAX;
+  };
+
+  // screen pixels per pick texel, in each direction
+  static constexpr uint32_t SCALE = 2;
+  // texels read on each side of the cursor
+  static constexpr int32_t RADIUS = 4;
+  static constexpr uint32_t SLOT_COUNT = 3;
+
+ public:
+  VulkanPicker(vks::VulkanDevice* vulkanDevice, VkQueue queue,
+               VkCommandPool cmdPool, VulkanRenderPassCache* renderPasses);
+  ~VulkanPicker();
+
+  void resize(uint32_t width, uint32_t height);
+  bool pick(glm::vec2 const& mousePos, bool redraw,
+            std::function<void(VkCommandBuffer)> const& draw);
+
+  VkRenderPass getRenderPass() { return m_renderPass->get(); }
+  uint32_t getWidth() const { return m_width; }
+  uint32_t getHeight() const { return m_height; }
+  Result const& getResult() const { return m_result; }
+
+ protected:
+  struct Slot {
+    vks::Buffer buffer;
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    bool inFlight = false;
+    // order of submission, to keep the newest result
+    uint64_t sequence = 0;
+    // the region copied, and the cursor within the pick target
+    VkOffset2D origin = {};
+    VkExtent2D extent = {};
+    glm::ivec2 cursor = glm::ivec2(0);
+  };
+
+  void createTarget();
+  void destroyTarget();
+  void collect();
+  void read(Slot const& slot);
+
+ protected:
+  vks::VulkanDevice* m_vulkanDevice = nullptr;
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkQueue m_queue = VK_NULL_HANDLE;
+  VkCommandPool m_cmdPool = VK_NULL_HANDLE;
+  VkFormat m_depthFormat = VK_FORMAT_D16_UNORM;
+  // from the render pass cache, not owned
+  VulkanRenderPass* m_renderPass = nullptr;
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+
+  struct Attachment {
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+  } m_ids, m_depth;
+  VkFramebuffer m_frameBuffer = VK_NULL_HANDLE;
+  // whether the ids have been drawn since the target was created
+  bool m_drawn = false;
+
+  std::array<Slot, SLOT_COUNT> m_slots;
+  uint64_t m_sequence = 0;
+  // sequence of the slot m_result was read from
+  uint64_t m_resultSequence = 0;
+  glm::ivec2 m_lastCursor = glm::ivec2(-1);
+  Result m_result;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_PICKER_H */
@@ -0,0 +1,85 @@
+#ifndef VULKAN_PIPELINE_BUILD_QUEUE_H
+#define VULKAN_PIPELINE_BUILD_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Everything needed to create a graphics pipeline, held by value so it
+ * can be built on another thread after the caller has moved on
+ */
+struct VULKANENGINE_EXPORT_API PipelineDescription {
+  std::vector<VkPipelineShaderStageCreateInfo> stages;
+  std::vector<VkVertexInputBindingDescription> vertexBindings;
+  std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+  // specialization constants, given to every stage
+  std::vector<VkSpecializationMapEntry> specializationEntries;
+  std::vector<uint32_t> specializationData;
+  VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
+  VkPipelineRasterizationStateCreateInfo rasterizationState = {};
+  VkPipelineColorBlendAttachmentState blendAttachmentState = {};
+  VkPipelineColorBlendStateCreateInfo colorBlendState = {};
+  VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+  VkPipelineViewportStateCreateInfo viewportState = {};
+  VkPipelineMultisampleStateCreateInfo multisampleState = {};
+  std::vector<VkDynamicState> dynamicStates;
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  VkRenderPass renderPass = VK_NULL_HANDLE;
+  uint32_t subpass = 0;
+
+  VkPipeline create(VkDevice device, VkPipelineCache pipelineCache);
+};
+
+/**
+ * @brief Compiles pipelines on a pool of worker threads
+ *
+ * Callers submit a description and get a future for the pipeline, which is
+ * VK_NULL_HANDLE if creation failed. All workers share one VkPipelineCache,
+ * which Vulkan synchronizes internally. The number of finished builds only
+ * ever grows, so the engine can tell when newly finished pipelines need
+ * recording into the command buffers.
+ */
+class VULKANENGINE_EXPORT_API VulkanPipelineBuildQueue {
+ public:
+  VulkanPipelineBuildQueue(VkDevice device, VkPipelineCache pipelineCache,
+                           uint32_t workerCount = 0);
+  ~VulkanPipelineBuildQueue();
+
+  std::shared_future<VkPipeline> submit(PipelineDescription description);
+  void waitIdle();
+  bool isIdle();
+  uint32_t getCompleted() const { return m_completed.load(); }
+
+ protected:
+  void work();
+
+ protected:
+  struct Job {
+    PipelineDescription description;
+    std::promise<VkPipeline> promise;
+  };
+
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_mutex;
+  std::condition_variable m_jobAdded;
+  std::condition_variable m_jobDone;
+  std::deque<Job> m_jobs;
+  uint32_t m_running = 0;
+  bool m_stopping = false;
+  std::atomic<uint32_t> m_completed{0};
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_PIPELINE_BUILD_QUEUE_H */
@@ -0,0 +1,57 @@
+#ifndef VULKAN_PIPELINE_CACHE_FILE_H
+#define VULKAN_PIPELINE_CACHE_FILE_H
+
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Keeps the pipeline cache on disk between runs
+ *
+ * The file lives in the user's cache directory and holds the data returned by
+ * vkGetPipelineCacheData, behind a small header of our own. On load, the
+ * Vulkan header's vendorID, deviceID and pipelineCacheUUID must match the
+ * current device, or the data is dropped and the cache starts out empty.
+ * Saving writes a temporary file and renames it over the old one, so a crash
+ * mid-write never leaves a truncated cache behind.
+ *
+ * The header also remembers how long the last start without a usable cache
+ * took, so a warm start can report the time it saved.
+ */
+class VULKANENGINE_EXPORT_API VulkanPipelineCacheFile {
+ public:
+  VulkanPipelineCacheFile() = default;
+  ~VulkanPipelineCacheFile() = default;
+
+  VkPipelineCache create(VkDevice device,
+                         VkPhysicalDeviceProperties const& properties);
+  void save(VkDevice device, VkPipelineCache pipelineCache) const;
+  void reportStartup(float milliseconds);
+
+  bool isWarm() const { return m_warm; }
+  static std::string getDefaultPath();
+
+ protected:
+  bool isValid(std::vector<char> const& data,
+               VkPhysicalDeviceProperties const& properties) const;
+
+ protected:
+  // our own header, in front of the Vulkan cache data
+  struct FileHeader {
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    // duration of the last start that began with an empty cache
+    float coldStartTime = 0.f;
+  };
+  static constexpr uint32_t MAGIC = 0x43505050;  // "PPPC"
+  static constexpr uint32_t VERSION = 1;
+
+  std::string m_path;
+  bool m_warm = false;
+  float m_coldStartTime = 0.f;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_PIPELINE_CACHE_FILE_H */
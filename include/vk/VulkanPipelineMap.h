@@ -0,0 +1,77 @@
+#ifndef VULKAN_PIPELINE_MAP_H
+#define VULKAN_PIPELINE_MAP_H
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief The state that differs between the engine's pipelines
+ *
+ * Everything else comes from the base state set up by
+ * VulkanPipelines::createBasePipelineInfo. Two requests with equal keys get
+ * the same pipeline.
+ */
+struct VULKANENGINE_EXPORT_API PipelineKey {
+  std::vector<VkPipelineShaderStageCreateInfo> stages;
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  VkRenderPass renderPass = VK_NULL_HANDLE;
+  VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+  VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+  VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  // depth-only passes have no color attachment to blend into
+  uint32_t colorAttachmentCount = 1;
+  bool blendEnable = true;
+  bool depthBias = false;
+  std::vector<VkVertexInputBindingDescription> vertexBindings;
+  std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+  // specialization constants as (constant_id, value), by increasing id
+  std::vector<std::pair<uint32_t, uint32_t>> constants;
+
+  bool operator==(PipelineKey const& other) const;
+  struct Hash {
+    size_t operator()(PipelineKey const& key) const;
+  };
+};
+
+/**
+ * @brief The pipelines of every window, once per distinct PipelineKey
+ *
+ * Owned by the device context. Keys are made of shader modules, pipeline
+ * layouts and render passes the windows get from the context's caches, so a
+ * window asking for a pipeline another window already built gets that one.
+ * The map owns every pipeline it holds, until releaseModule() hands them
+ * over, once the last user of one of their modules let go of it.
+ */
+class VULKANENGINE_EXPORT_API VulkanPipelineMap {
+ public:
+  // creates a pipeline missing from the map, maybe on another thread
+  using Build = std::function<std::shared_future<VkPipeline>()>;
+
+ public:
+  explicit VulkanPipelineMap(VkDevice device) : m_device(device) {}
+  ~VulkanPipelineMap();
+
+  std::shared_future<VkPipeline> get(PipelineKey const& key,
+                                     Build const& build);
+  std::vector<std::shared_future<VkPipeline>> releaseModule(
+      VkShaderModule shaderModule);
+
+ protected:
+  VkDevice m_device = VK_NULL_HANDLE;
+  std::mutex m_mutex;
+  std::unordered_map<PipelineKey, std::shared_future<VkPipeline>,
+                     PipelineKey::Hash>
+      m_pipelines;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_PIPELINE_MAP_H */
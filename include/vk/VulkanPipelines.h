@@ -10,11 +10,23 @@
 #ifndef VULKAN_PIPELINES_H
 #define VULKAN_PIPELINES_H
 
+#include "VulkanPipelineBuildQueue.h"
+#include "VulkanPipelineMap.h"
 #include "VulkanShader.h"
 #include "render_common.h"
 
 namespace VulkanEngine {
 
+/**
+ * @brief Creates the engine's pipelines from a shared base state, once per
+ * distinct PipelineKey
+ *
+ * The base state is never changed by a request, so requests can come in any
+ * order, and variants of a shader (e.g. wireframe and fill) can be asked for
+ * at any time: the second request for a key returns the first one's pipeline.
+ * Pipelines go in the device context's VulkanPipelineMap, which owns them, so
+ * another window asking for the same key gets the same pipeline.
+ */
 class VULKANENGINE_EXPORT_API VulkanPipelines {
  public:
   VulkanPipelines(VkDevice& device);
@@ -36,12 +48,28 @@ class VULKANENGINE_EXPORT_API VulkanPipelines {
     this->createPipeline(shader.get(), renderPass, mode);
   }
 
+  void recreatePipeline(VulkanShader* shader);
+
+  PipelineKey makeKey(VulkanShader* shader, VkRenderPass renderPass,
+                      VkPolygonMode mode) const;
+  std::shared_future<VkPipeline> getPipeline(PipelineKey const& key);
+
+ protected:
+  PipelineDescription describePipeline(PipelineKey const& key) const;
+
  public:
   VkDevice m_device;
-  VkGraphicsPipelineCreateInfo m_pipelineCreateInfo;
+  // vertex layout of shaders that don't bring their own
   VkPipelineVertexInputStateCreateInfo m_vertexInputState;
   VkPipelineCache m_pipelineCache;
+  // compiles pipelines off the calling thread when set, not owned
+  VulkanPipelineBuildQueue* m_buildQueue = nullptr;
+  // every window's pipelines, not owned
+  VulkanPipelineMap* m_pipelineMap = nullptr;
 
+  // base state, shared by every pipeline
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  VkRenderPass m_renderPass = VK_NULL_HANDLE;
   VkPipelineInputAssemblyStateCreateInfo m_inputAssemblyState;
   VkPipelineRasterizationStateCreateInfo m_rasterizationState;
   VkPipelineColorBlendAttachmentState m_blendAttachmentState;
@@ -52,11 +80,8 @@ class VULKANENGINE_EXPORT_API VulkanPipelines {
   std::vector<VkDynamicState> m_dynamicStateEnables = {
       VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR,
       VK_DYNAMIC_STATE_LINE_WIDTH};
-  VkPipelineDynamicStateCreateInfo m_dynamicState;
-
-  std::array<VkPipelineShaderStageCreateInfo, 2> m_shaderStages;
 };
 
 }  // namespace VulkanEngine
 
-#endif /*  VULKAN_CONTEXT_H  */
\ No newline at end of file
+#endif /*  VULKAN_CONTEXT_H  */
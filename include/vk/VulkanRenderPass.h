@@ -14,8 +14,10 @@ class VULKANENGINE_EXPORT_API VulkanRenderPass {
   void setDevice(VkDevice const& device) { m_device = device; }
   void setFormat(VkFormat format) { m_format = format; }
   void setDepthFormat(VkFormat format) { m_depthFormat = format; }
+  void createPresentPass();
   void createColorDepthPass();
   void createDepthPass();
+  void createPickPass();
 
   VkRenderPass& get() { return m_renderPass; }
 
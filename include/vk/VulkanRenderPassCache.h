@@ -0,0 +1,49 @@
+#ifndef VULKAN_RENDER_PASS_CACHE_H
+#define VULKAN_RENDER_PASS_CACHE_H
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "VulkanRenderPass.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Creates each kind of render pass once per set of formats, for every
+ * window
+ *
+ * Pipeline keys hold the render pass they were built for, so windows drawing
+ * into passes from here share their pipelines. The passes live as long as
+ * the cache, which keeps a closed window's handle from being reused by
+ * another pass while pipelines are still keyed on it.
+ */
+class VULKANENGINE_EXPORT_API VulkanRenderPassCache {
+ public:
+  enum class Type {
+    // color presented to the swap chain, with depth
+    PRESENT,
+    // depth only, sampled afterwards
+    DEPTH,
+    // ids copied out afterwards, with depth
+    PICK
+  };
+
+ public:
+  explicit VulkanRenderPassCache(VkDevice device) : m_device(device) {}
+  ~VulkanRenderPassCache();
+
+  VulkanRenderPass* get(Type type, VkFormat format,
+                        VkFormat depthFormat = VK_FORMAT_UNDEFINED);
+
+ protected:
+  VkDevice m_device = VK_NULL_HANDLE;
+  std::mutex m_mutex;
+  std::map<std::tuple<Type, VkFormat, VkFormat>, VulkanRenderPass*> m_passes;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_RENDER_PASS_CACHE_H */
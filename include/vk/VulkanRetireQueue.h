@@ -0,0 +1,47 @@
+#ifndef VULKAN_RETIRE_QUEUE_H
+#define VULKAN_RETIRE_QUEUE_H
+
+#include <functional>
+
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Destroys resources once every frame that may still use them is done
+ *
+ * retire() is called at the point after which no new submission references
+ * the resource, e.g. when the command buffers that recorded it are marked for
+ * recording again. The resource is then only in use by frames already
+ * submitted, so once each swap chain image's fence has been waited on again,
+ * it is safe to destroy. The render loop reports those waits through
+ * frameCompleted(), so nothing ever idles the queue for a replacement.
+ */
+class VULKANENGINE_EXPORT_API VulkanRetireQueue {
+ public:
+  using Destroy = std::function<void()>;
+
+ public:
+  VulkanRetireQueue() = default;
+  ~VulkanRetireQueue();
+
+  void setFrameCount(uint32_t frameCount);
+  void retire(Destroy const& destroy);
+  void frameCompleted(uint32_t frame);
+  void flush();
+
+ protected:
+  struct Entry {
+    Destroy destroy;
+    // one bit per swap chain image whose fence hasn't been waited on since
+    uint64_t pendingFrames = 0;
+  };
+
+  uint32_t m_frameCount = 0;
+  std::vector<Entry> m_entries;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_RETIRE_QUEUE_H */
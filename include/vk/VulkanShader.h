@@ -1,6 +1,9 @@
 #ifndef VULKAN_SHADER_H
 #define VULKAN_SHADER_H
 
+#include <future>
+#include <map>
+
 #include "VkObject.h"
 
 namespace VulkanEngine {
@@ -16,43 +19,80 @@ class VULKANENGINE_EXPORT_API VulkanShader : public VkObject {
   virtual void prepareShaders() = 0;
 
   // getters
-  VkPipeline& getPipeline() { return m_pipeline; }
+  VkPipeline& getPipeline();
   std::vector<VkPipelineShaderStageCreateInfo>& getShaderStages() {
     return m_shaderStages;
   }
   bool getDepthBiasEnabled() const { return m_depthBiasEnable; }
+  bool getBlendEnabled() const { return m_blendEnable; }
   bool isOneStage() const { return m_oneStage; }
   bool isInstanceShader() const { return m_instanceShader; }
   VkCullModeFlags getCullFlag() const { return m_cullFlag; }
   VkFrontFace getFrontFace() const { return m_frontFace; }
+  VkPrimitiveTopology getTopology() const { return m_topology; }
   VkPipelineVertexInputStateCreateInfo getVertexInputState() const {
     return m_inputState;
   }
+  std::vector<std::string> const& getStagePaths() const { return m_stagePaths; }
+  std::map<uint32_t, uint32_t> const& getConstants() const {
+    return m_constants;
+  }
+  VkRenderPass getRenderPass() const { return m_renderPass; }
+  VkPolygonMode getPolygonMode() const { return m_polygonMode; }
+  // whether a requested pipeline has yet to be swapped in by getPipeline()
+  bool isPipelinePending() const { return m_pendingPipeline.valid(); }
 
   // setters
   void setCullFlag(VkCullModeFlags flag) { m_cullFlag = flag; }
   void setFrontFace(VkFrontFace face) { m_frontFace = face; }
+  void setTopology(VkPrimitiveTopology topology) { m_topology = topology; }
   void setDepthBiasEnable(bool value) { m_depthBiasEnable = value; }
+  void setBlendEnable(bool value) { m_blendEnable = value; }
+  // takes effect the next time the shader's pipeline is requested
+  void setConstant(uint32_t constantId, uint32_t value) {
+    m_constants[constantId] = value;
+  }
   void setOneStage(bool value) { m_oneStage = value; }
   void setVertexInputState(
       VkPipelineVertexInputStateCreateInfo const& inputStateCreateInfo) {
     m_inputState = inputStateCreateInfo;
     m_instanceShader = true;
   }
+  void setPendingPipeline(std::shared_future<VkPipeline> pipeline);
+  void setPipelineRequest(VkRenderPass renderPass, VkPolygonMode mode) {
+    m_renderPass = renderPass;
+    m_polygonMode = mode;
+  }
+  VkShaderModule replaceShaderModule(size_t stage, VkShaderModule shaderModule);
 
  protected:
   VkPipelineShaderStageCreateInfo loadShader(
       std::string const& fileName, VkShaderStageFlagBits const& stage);
 
  protected:
+  // owned by the device context's VulkanPipelineMap, which may share it with
+  // other shaders, of any window
   VkPipeline m_pipeline = VK_NULL_HANDLE;
+  // a pipeline still being built, replacing m_pipeline once it is ready
+  std::shared_future<VkPipeline> m_pendingPipeline;
   std::vector<VkPipelineShaderStageCreateInfo> m_shaderStages;
+  // held in the device context's VulkanShaderModuleCache
   std::vector<VkShaderModule> m_shaderModules;
+  // specialization constants by constant_id, given to every stage. Booleans
+  // are VkBool32, so every constant is 32 bits wide.
+  std::map<uint32_t, uint32_t> m_constants;
+  // file each stage was loaded from, in stage order
+  std::vector<std::string> m_stagePaths;
+  // what the current pipeline was last requested with
+  VkRenderPass m_renderPass = VK_NULL_HANDLE;
+  VkPolygonMode m_polygonMode = VK_POLYGON_MODE_FILL;
 
   VkCullModeFlags m_cullFlag = VK_CULL_MODE_NONE;
   VkFrontFace m_frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  VkPrimitiveTopology m_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
   VkPipelineVertexInputStateCreateInfo m_inputState;
   bool m_depthBiasEnable = false;
+  bool m_blendEnable = true;
   bool m_instanceShader = false;
   bool m_oneStage = false;
 };
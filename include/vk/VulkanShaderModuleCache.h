@@ -0,0 +1,56 @@
+#ifndef VULKAN_SHADER_MODULE_CACHE_H
+#define VULKAN_SHADER_MODULE_CACHE_H
+
+#include <map>
+#include <mutex>
+
+#include "VulkanPipelineMap.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Loads each shader module once for every window, and counts its users
+ *
+ * Every stage loaded from a path gets the path's current module, so windows
+ * showing the same shaders build the same pipeline keys. Reloaded code makes
+ * a new current module, tagged with the source's version so the windows
+ * polling the same source take it instead of compiling it again. When the
+ * last user releases a module, its pipelines are taken out of the pipeline
+ * map and destroyed along with it, so a later module reusing the handle
+ * never meets them. Users release a module once no frame of theirs can draw
+ * with its pipelines anymore.
+ */
+class VULKANENGINE_EXPORT_API VulkanShaderModuleCache {
+ public:
+  VulkanShaderModuleCache(VkDevice device, VulkanPipelineMap* pipelineMap)
+      : m_device(device), m_pipelineMap(pipelineMap) {}
+  ~VulkanShaderModuleCache();
+
+  VkShaderModule acquire(std::string const& path);
+  VkShaderModule acquire(std::string const& path, int64_t version);
+  VkResult create(std::string const& path, int64_t version,
+                  std::vector<uint32_t> const& spirv,
+                  VkShaderModule& shaderModule);
+  void release(VkShaderModule shaderModule);
+
+ protected:
+  struct Entry {
+    std::string path;
+    // 0 for the module loaded from the path, else the source's version
+    int64_t version = 0;
+    uint32_t users = 0;
+  };
+
+  VkDevice m_device = VK_NULL_HANDLE;
+  VulkanPipelineMap* m_pipelineMap = nullptr;
+  std::mutex m_mutex;
+  std::map<VkShaderModule, Entry> m_modules;
+  // the module new stages get, by path
+  std::map<std::string, VkShaderModule> m_current;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_SHADER_MODULE_CACHE_H */
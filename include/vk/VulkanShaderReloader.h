@@ -0,0 +1,78 @@
+#ifndef VULKAN_SHADER_RELOADER_H
+#define VULKAN_SHADER_RELOADER_H
+
+#include <chrono>
+#include <map>
+
+#include "VkObject.h"
+#include "VulkanPipelines.h"
+#include "VulkanRetireQueue.h"
+#include "VulkanShader.h"
+#include "VulkanShaderModuleCache.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Recompiles shaders from their GLSL sources while the app is running
+ *
+ * Only built with PAPERARIUM_SHADER_HOT_RELOAD. A shader loaded from
+ * ":/shaders/<dir>/<name>.spv" is backed by
+ * resources/shaders/<dir>/glsl/<name> in the source tree. When that file
+ * changes, it is compiled with shaderc, the stages using it get the new
+ * module, and their pipelines are requested again. The new pipelines build on
+ * the pipeline build queue while the old ones keep drawing. Once the command
+ * buffers are recorded with the new ones, retire() has the retire queue
+ * release the old modules after the frames still using them; the module
+ * cache destroys them and their pipelines with their last user. Each window
+ * polls on its own, and takes the module another window already compiled
+ * from the same change. Compile errors are kept for the overlay, and the old
+ * shader stays in use.
+ */
+class VULKANENGINE_EXPORT_API VulkanShaderReloader {
+ public:
+  VulkanShaderReloader(VulkanPipelines* pipelines,
+                       VulkanShaderModuleCache* modules)
+      : m_pipelines(pipelines), m_modules(modules) {}
+  ~VulkanShaderReloader();
+
+  bool poll(std::vector<std::shared_ptr<VkObject>> const& objects);
+  void retire(VulkanRetireQueue& retireQueue);
+  std::map<std::string, std::string> const& getErrors() const {
+    return m_errors;
+  }
+
+  static std::string getSourcePath(std::string const& resourcePath);
+
+ protected:
+  bool compile(std::string const& sourcePath, std::vector<uint32_t>& spirv,
+               std::string& error) const;
+
+  // a shader's modules replaced by one poll, with the pipeline it drew with
+  // before
+  struct Replaced {
+    VulkanShader* shader = nullptr;
+    std::vector<VkShaderModule> shaderModules;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+  };
+  bool isRetirable(Replaced const& replaced) const;
+  static void release(VulkanShaderModuleCache* modules,
+                      Replaced const& replaced);
+
+ protected:
+  VulkanPipelines* m_pipelines = nullptr;
+  // shared by every window, not owned
+  VulkanShaderModuleCache* m_modules = nullptr;
+  std::chrono::steady_clock::time_point m_lastPoll;
+  // last modification time seen for each source, in ms since the epoch
+  std::map<std::string, int64_t> m_modified;
+  // compile errors by source path, until the source compiles again
+  std::map<std::string, std::string> m_errors;
+  // not yet retired, oldest first
+  std::vector<Replaced> m_replaced;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_SHADER_RELOADER_H */
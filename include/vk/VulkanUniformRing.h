@@ -0,0 +1,55 @@
+#ifndef VULKAN_UNIFORM_RING_H
+#define VULKAN_UNIFORM_RING_H
+
+#include "VulkanBuffer.hpp"
+#include "VulkanDevice.hpp"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief A persistently mapped uniform buffer split into one slot per frame
+ *
+ * Every uniform block reserves a fixed range once, at the same offset within
+ * each slot. Each frame only writes into its own slot, so the CPU never
+ * overwrites data a previous frame may still be reading on the GPU. Shaders
+ * read the blocks through VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+ * descriptors, which are all written once and pointed at the right slot with
+ * a dynamic offset when they are bound.
+ */
+class VULKANENGINE_EXPORT_API VulkanUniformRing {
+ public:
+  struct Allocation {
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+  };
+
+ public:
+  VulkanUniformRing() = default;
+  ~VulkanUniformRing();
+
+  void create(vks::VulkanDevice* vulkanDevice, uint32_t frameCount,
+              VkDeviceSize frameSize = 256 * 1024);
+
+  Allocation allocate(VkDeviceSize size);
+  void write(Allocation const& allocation, void const* data, uint32_t frame);
+  void writeAll(Allocation const& allocation, void const* data);
+
+  uint32_t getDynamicOffset(Allocation const& allocation,
+                            uint32_t frame) const;
+  VkDescriptorBufferInfo getDescriptor(Allocation const& allocation) const;
+  uint32_t getFrameCount() const { return m_frameCount; }
+  VkDeviceSize getUsed() const { return m_head; }
+
+ protected:
+  vks::Buffer m_buffer;
+  uint32_t m_frameCount = 0;
+  VkDeviceSize m_frameSize = 0;
+  VkDeviceSize m_alignment = 1;
+  VkDeviceSize m_head = 0;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_UNIFORM_RING_H */
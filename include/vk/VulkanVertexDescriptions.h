@@ -122,6 +122,31 @@ class VULKANENGINE_EXPORT_API VulkanVertexDescriptions {
         static_cast<uint32_t>(m_inputAttributes.size());
     m_inputState.pVertexAttributeDescriptions = m_inputAttributes.data();
   }
+
+  /**
+   * @brief Appends a per-instance model matrix, read from the instance buffer
+   * binding into four vec4 attributes starting at `firstLocation`
+   */
+  void AddInstanceTransformDescriptions(uint32_t firstLocation) {
+    m_inputBinding.push_back(vks::initializers::vertexInputBindingDescription(
+        INSTANCE_BUFFER_BIND_ID, sizeof(glm::mat4),
+        VK_VERTEX_INPUT_RATE_INSTANCE));
+    // a mat4 attribute takes one location per column
+    for (uint32_t column = 0; column < 4; column++) {
+      m_inputAttributes.push_back(
+          vks::initializers::vertexInputAttributeDescription(
+              INSTANCE_BUFFER_BIND_ID, firstLocation + column,
+              VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4) * column));
+    }
+
+    // the vectors may have moved, so point the input state at them again
+    m_inputState.vertexBindingDescriptionCount =
+        static_cast<uint32_t>(m_inputBinding.size());
+    m_inputState.pVertexBindingDescriptions = m_inputBinding.data();
+    m_inputState.vertexAttributeDescriptionCount =
+        static_cast<uint32_t>(m_inputAttributes.size());
+    m_inputState.pVertexAttributeDescriptions = m_inputAttributes.data();
+  }
 };
 
 }  // namespace VulkanEngine
@@ -0,0 +1,95 @@
+#ifndef VULKAN_VIEWPORT_H
+#define VULKAN_VIEWPORT_H
+
+#include <functional>
+
+#include "VulkanCompositor.h"
+#include "VulkanDevice.hpp"
+#include "VulkanFrameBuffer.h"
+#include "VulkanRetireQueue.h"
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief One view of the scene inside a part of the window, with its own
+ * camera, scissor and objects
+ *
+ * The view is drawn into an offscreen color + depth target the size of its
+ * part of the window, by command buffers of its own (one per swap chain
+ * image). The main pass only composites the target into the window, so a
+ * view is drawn again only when it is marked dirty: when its camera moves
+ * (see updateView()), when the command buffers are recorded again, or when
+ * anything else it shows changes. An idle view costs a composite, not a
+ * scene.
+ *
+ * The camera is picked by the descriptor index: the engine binds that copy
+ * of the per-frame set while recording the view, so each view can hold its
+ * own camera uniform.
+ */
+class VULKANENGINE_EXPORT_API VulkanViewport {
+ public:
+  using DrawFunction = std::function<void(VkCommandBuffer&)>;
+
+ public:
+  VulkanViewport(vks::VulkanDevice* vulkanDevice, VkCommandPool cmdPool,
+                 VulkanCompositor* compositor, VulkanRetireQueue* retireQueue,
+                 VkFormat colorFormat, VkFormat depthFormat,
+                 uint32_t descriptorIndex);
+  ~VulkanViewport();
+
+  void setRegion(glm::vec2 const& offset, glm::vec2 const& size);
+  void setDraw(DrawFunction const& draw) { m_draw = draw; }
+  void resize(uint32_t windowWidth, uint32_t windowHeight);
+  void allocateCommandBuffers(uint32_t count);
+
+  void beginRenderPass(VkCommandBuffer cmd,
+                       std::array<VkClearValue, 2> const& clearValues) const;
+  void draw(VkCommandBuffer& cmd) const;
+  void composite(VkCommandBuffer cmd) const;
+
+  bool updateView(glm::mat4 const& viewProjection);
+  void markDirty() { m_dirty = true; }
+  void clearDirty() { m_dirty = false; }
+  bool isDirty() const { return m_dirty; }
+
+  VkCommandBuffer getCommandBuffer(uint32_t frame) const {
+    return m_cmdBuffers[frame];
+  }
+  uint32_t getDescriptorIndex() const { return m_descriptorIndex; }
+  VkRect2D const& getRect() const { return m_rect; }
+  VkExtent2D const& getExtent() const { return m_rect.extent; }
+  float getAspect() const;
+  bool contains(glm::vec2 const& point) const;
+
+ protected:
+  vks::VulkanDevice* m_vulkanDevice = nullptr;
+  VkDevice m_device = VK_NULL_HANDLE;
+  VkCommandPool m_cmdPool = VK_NULL_HANDLE;
+  VulkanCompositor* m_compositor = nullptr;
+  VulkanRetireQueue* m_retireQueue = nullptr;
+  VkFormat m_colorFormat = VK_FORMAT_B8G8R8A8_UNORM;
+  VkFormat m_depthFormat = VK_FORMAT_D16_UNORM;
+  uint32_t m_descriptorIndex = 0;
+
+  // part of the window, as fractions of its size
+  glm::vec2 m_offset = glm::vec2(0.f);
+  glm::vec2 m_size = glm::vec2(1.f);
+  // the same in pixels, for the last resize
+  VkRect2D m_rect = {{0, 0}, {0, 0}};
+
+  VulkanFrameBuffer* m_target = nullptr;
+  VkDescriptorSet m_compositeSet = VK_NULL_HANDLE;
+  // one per swap chain image, reading that frame's uniform ring slot
+  std::vector<VkCommandBuffer> m_cmdBuffers;
+  DrawFunction m_draw;
+
+  bool m_dirty = true;
+  // what the target was last drawn from
+  glm::mat4 m_viewProjection = glm::mat4(0.f);
+};
+
+}  // namespace VulkanEngine
+
+#endif /* VULKAN_VIEWPORT_H */
@@ -0,0 +1,37 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief The six planes of a view volume, for culling bounding volumes
+ * before they are drawn
+ *
+ * Planes are taken from a clip transform with Vulkan's 0 to 1 depth range,
+ * so they live in whatever space the transform maps from. Tests are
+ * conservative: a volume is only rejected when it is entirely outside one
+ * plane.
+ */
+class VULKANENGINE_EXPORT_API Frustum {
+ public:
+  Frustum() = default;
+  explicit Frustum(glm::mat4 const& clip) { update(clip); }
+
+  void update(glm::mat4 const& clip);
+
+  bool intersectsSphere(glm::vec3 const& center, float radius) const;
+  bool intersectsBox(glm::vec3 const& min, glm::vec3 const& max) const;
+  void cullSpheres(float const* x, float const* y, float const* z,
+                   float const* radius, size_t count, uint8_t* visible) const;
+
+ protected:
+  // normalized, inside where dot(xyz, p) + w >= 0
+  std::array<glm::vec4, 6> m_planes;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* FRUSTUM_H */
@@ -8,7 +8,7 @@ namespace VulkanEngine {
 class VULKANENGINE_EXPORT_API ShadowCamera : public VulkanBuffer {
  public:
   struct ShadowMVP {
-    glm::mat4 depthMVP;
+    glm::mat4 depthMVP = glm::mat4(0.f);
   };
 
  public:
@@ -18,12 +18,29 @@ class VULKANENGINE_EXPORT_API ShadowCamera : public VulkanBuffer {
   virtual void prepareUniformBuffers() override;
   virtual void updateUniformBuffers() override;
 
+  void setBounds(glm::vec3 const& min, glm::vec3 const& max);
+
+  // increases whenever the light's matrix changes
+  uint32_t getVersion() const { return m_version; }
+
+ protected:
+  void fitBounds(glm::mat4& view, glm::mat4& projection) const;
+
  public:
   ShadowMVP m_uboVS;
+  // without bounds, the light looks at the origin through a fixed frustum
   float m_lightFOV = 45.f;
   float m_zNear = 1.f;
   float m_zFar = 96.f;
   glm::vec3 m_lightPos = glm::vec3(0.f);
+  // with bounds, whether the fitted frustum is a box instead of a pyramid
+  bool m_orthographic = false;
+
+ protected:
+  uint32_t m_version = 0;
+  bool m_hasBounds = false;
+  glm::vec3 m_boundsMin = glm::vec3(0.f);
+  glm::vec3 m_boundsMax = glm::vec3(0.f);
 };
 
 }  // namespace VulkanEngine
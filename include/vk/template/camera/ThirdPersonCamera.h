@@ -15,6 +15,8 @@ public:
   glm::vec3 m_cameraPos = glm::vec3();
   const float m_baseZoom = -2.f;
   float m_zoom = m_baseZoom;
+  // moves the view across the screen, for orthographic views
+  glm::vec2 m_pan = glm::vec2(0.f);
   
 };
 
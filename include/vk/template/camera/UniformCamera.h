@@ -8,12 +8,18 @@ namespace VulkanEngine {
 class VULKANENGINE_EXPORT_API UniformCamera : public VulkanBuffer {
 public:
 
+  // shaders may declare only a prefix of this block
   struct CameraMatrix {
     glm::mat4 projection;
     glm::mat4 model;
     glm::mat4 view;
+    // inverse transpose of modelView, for normals
     glm::mat4 normal;
     glm::vec4 lightpos;
+    // derived once per frame so vertex shaders don't have to
+    glm::mat4 modelView;
+    glm::mat4 modelViewProjection;
+    glm::vec4 lightPosView;
   };
 
 public:
@@ -30,6 +36,13 @@ public:
   glm::vec3 *m_pRotation = nullptr;
   glm::vec3 *m_pCameraPos = nullptr;
   float *m_pZoom = nullptr;
+  // moves the view across the screen, in view units; optional
+  glm::vec2 *m_pPan = nullptr;
+  // width over height, 0 for the window's
+  float m_aspect = 0.f;
+  // looks straight along the view axis, showing the height the perspective
+  // one shows at the zoom distance
+  bool m_orthographic = false;
 
 };
 
@@ -2,11 +2,33 @@
 #define ASSIMP_OBJECT_H
 
 #include "MeshObject.h"
+#include "ModelBVH.h"
+#include "VulkanBindlessTextures.h"
 #include "VulkanModel.hpp"
+#include "camera/Frustum.h"
+#include "texture/VulkanTexture2D.h"
 
 namespace VulkanEngine {
 
 class AssimpObject : public MeshObject {
+ public:
+  // how an edge is folded in the papercraft, one byte per edge on the GPU
+  enum class EdgeState : uint8_t {
+    FLAT = 0,
+    CUT = 1,
+    MOUNTAIN = 2,
+    VALLEY = 3
+  };
+  static constexpr uint32_t INVALID_EDGE = ~0u;
+  // views the parts are culled for, each with its own indirect commands
+  enum CullView : uint32_t {
+    CULL_CAMERA = 0,
+    CULL_SHADOW = 1,
+    // the flat layout view beside the camera's
+    CULL_LAYOUT = 2,
+    CULL_VIEW_COUNT
+  };
+
  public:
   AssimpObject() = default;
   virtual ~AssimpObject();
@@ -16,18 +38,82 @@ class AssimpObject : public MeshObject {
   void updateVertex() override{};
 
   glm::vec3* getCenter() { return &m_modelCenter; }
+  // box around the vertices as uploaded
+  vks::Model::Dimension const& getBounds() const { return m_model->dim; }
+  uint32_t getTriangleCount() const { return m_indexCount / 3; }
+  // over the triangles as uploaded, in the model's space
+  ModelBVH const& getBVH() const { return m_bvh; }
+  uint32_t getPartOfTriangle(uint32_t triangle) const;
+  bool getSharedEdge(uint32_t a, uint32_t b,
+                     std::array<glm::vec3, 2>& edge) const;
+
+  uint32_t getEdgeCount() const { return m_edgeCount; }
+  uint32_t getEdgeOfTriangles(uint32_t a, uint32_t b) const;
+  EdgeState getEdgeState(uint32_t edge) const {
+    return static_cast<EdgeState>(m_edgeStateValues[edge]);
+  }
+  void setEdgeState(uint32_t edge, EdgeState state);
+  VkDescriptorBufferInfo& getEdgeStateDescriptor() {
+    return m_edgeStates.descriptor;
+  }
+  void buildEdges(VkCommandBuffer& cmdBuffer, VulkanShader* vulkanShader);
+
+  void setBindless(VulkanBindlessTextures* bindlessTextures,
+                   uint32_t defaultTexture, bool multiDrawIndirect);
+  void build(VkCommandBuffer& cmdBuffer, VulkanShader* vulkanShader) override;
+  void build(VkCommandBuffer& cmdBuffer, VulkanShader* vulkanShader,
+             uint32_t frame, CullView view);
+  using MeshObject::build;
 
-  virtual void build(VkCommandBuffer& cmdBuffer,
-                     VulkanShader* vulkanShader) override;
-  virtual void build(VkCommandBuffer& cmdBuffer,
-                     std::shared_ptr<VulkanShader> vulkanShader) override {
-    this->build(cmdBuffer, vulkanShader.get());
+  uint32_t getPartCount() const {
+    return static_cast<uint32_t>(m_model->parts.size());
   }
+  uint32_t cull(glm::mat4 const& viewProjection, uint32_t frame,
+                CullView view);
+  void setFrameCount(uint32_t frameCount);
+
+ protected:
+  void prepareBindless();
+  void prepareEdges();
+  void preparePartBounds();
+  void createIndirectCommands();
+  void updateIndirectCommands(uint32_t region);
+  void drawIndirect(VkCommandBuffer& cmdBuffer, VulkanShader* vulkanShader,
+                    uint32_t region);
 
  protected:
   std::string m_modelPath;
   vks::Model* m_model = nullptr;
   glm::vec3 m_modelCenter;
+  ModelBVH m_bvh;
+
+  // every undirected edge once, as an index-only mesh over m_mesh's vertices
+  VulkanGeometryArena::Handle m_edgeMesh = VulkanGeometryArena::INVALID_HANDLE;
+  uint32_t m_edgeCount = 0;
+  // the three edges of each triangle, in corner order
+  std::vector<uint32_t> m_triangleEdges;
+  // the states, and the mapped storage buffer the edge shader reads them from
+  std::vector<uint8_t> m_edgeStateValues;
+  vks::Buffer m_edgeStates;
+
+  // bounding spheres of the parts, one array per component for the SIMD
+  // frustum test, and boxes to refine it
+  std::vector<float> m_partX, m_partY, m_partZ, m_partRadius;
+  std::vector<glm::vec3> m_partMin, m_partMax;
+  std::vector<uint8_t> m_partVisible;
+
+  // bindless mode: every part in one indirect call, textured from the table
+  VulkanBindlessTextures* m_bindlessTextures = nullptr;
+  uint32_t m_defaultTexture = 0;
+  bool m_multiDrawIndirect = false;
+  std::vector<std::shared_ptr<VulkanTexture2D>> m_materialTextures;
+  uint32_t m_firstPart = 0;
+  // one region of commands per part drawing everything, then one per frame
+  // and cull view, where culled parts get no instances. Mapped.
+  vks::Buffer m_indirectCommands;
+  uint32_t m_cullFrameCount = 0;
+  // arena generation region 0, then each frame's regions, were written for
+  std::vector<uint32_t> m_indirectGenerations;
 };
 
 }  // namespace VulkanEngine
@@ -3,7 +3,10 @@
 
 #include "VkObject.h"
 #include "VulkanContext.h"
+#include "VulkanDescriptorSet.h"
 #include "VulkanBuffer.hpp"
+#include "VulkanGeometryArena.h"
+#include "VulkanInstanceBuffer.h"
 #include "VulkanShader.h"
 
 namespace VulkanEngine {
@@ -22,8 +25,14 @@ public:
   virtual void build(VkCommandBuffer &cmdBuffer, std::shared_ptr<VulkanShader> vulkanShader) {
     this->build(cmdBuffer, vulkanShader.get());
   }
+  void buildInstanced(VkCommandBuffer &cmdBuffer, VulkanShader *vulkanShader, VulkanInstanceBuffer *instances);
+  void buildInstanced(VkCommandBuffer &cmdBuffer, std::shared_ptr<VulkanShader> vulkanShader, VulkanInstanceBuffer *instances) {
+    this->buildInstanced(cmdBuffer, vulkanShader.get(), instances);
+  }
 
   void setPosOffset(const glm::vec3 &offset) { m_posOffset = offset; }
+  void setMaterial(VulkanDescriptorSet *material) { m_material = material; }
+  void setTransform(const glm::mat4 &transform) { m_transform = transform; }
 
   template<class T>
   void staticMove(std::vector<T> &vertices) {
@@ -34,11 +43,23 @@ public:
     }
   }
 
+protected:
+  template<class T>
+  void uploadGeometry(std::vector<T> const &vertices, std::vector<uint32_t> const &indices) {
+    uploadGeometry(vertices.data(), static_cast<uint32_t>(vertices.size()), indices);
+  }
+  void uploadGeometry(void const *vertices, uint32_t vertexCount, std::vector<uint32_t> const &indices, std::string const &key = "");
+  bool bindPipeline(VkCommandBuffer &cmdBuffer, VulkanShader *vulkanShader);
+
 public:
-  vks::Buffer m_vertexBuffer;
-  vks::Buffer m_indexBuffer;
+  // this mesh's range within the context's geometry arena
+  VulkanGeometryArena::Handle m_mesh = VulkanGeometryArena::INVALID_HANDLE;
   uint32_t m_indexCount = 0;
+  // per-material set bound before drawing, if any
+  VulkanDescriptorSet *m_material = nullptr;
   glm::vec3 m_posOffset = glm::vec3(0.f);
+  // object to world transform, pushed as a vertex push constant on each draw
+  glm::mat4 m_transform = glm::mat4(1.f);
 
 };
 
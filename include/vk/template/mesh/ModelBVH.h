@@ -0,0 +1,100 @@
+#ifndef MODEL_BVH_H
+#define MODEL_BVH_H
+
+#include <cfloat>
+
+#include "render_common.h"
+#include "vulkan_macro.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief A bounding volume hierarchy over a mesh's triangles, for exact
+ * answers on the CPU: ray casts, nearest triangles and box queries
+ *
+ * Built with the surface area heuristic over binned centroids, the top
+ * levels in parallel. Nodes are 32 bytes, flattened depth first so a node's
+ * left child follows it, and triangles are stored in leaf order as a corner
+ * and two edges, so a traversal mostly walks memory forwards. Ray-box tests
+ * use SSE where available.
+ *
+ * Triangles are identified by their index in the mesh's index buffer / 3.
+ */
+class VULKANENGINE_EXPORT_API ModelBVH {
+ public:
+  static constexpr uint32_t INVALID_TRIANGLE = ~0u;
+
+  struct Ray {
+    glm::vec3 origin = glm::vec3(0.f);
+    glm::vec3 direction = glm::vec3(0.f, 0.f, 1.f);
+
+    static Ray fromScreen(glm::vec2 const& position, glm::vec2 const& size,
+                          glm::mat4 const& modelViewProjection);
+  };
+
+  struct Hit {
+    uint32_t triangle = INVALID_TRIANGLE;
+    // along the ray for casts, from the point for nearest queries
+    float distance = FLT_MAX;
+    glm::vec3 point = glm::vec3(0.f);
+    // weights of the triangle's second and third corners
+    glm::vec2 barycentric = glm::vec2(0.f);
+  };
+
+ public:
+  ModelBVH() = default;
+  ~ModelBVH() = default;
+
+  void build(float const* vertices, size_t vertexStride,
+             std::vector<uint32_t> const& indices);
+
+  bool intersect(Ray const& ray, Hit& hit, float maxDistance = FLT_MAX) const;
+  bool nearest(glm::vec3 const& point, Hit& hit,
+               float maxDistance = FLT_MAX) const;
+  void query(glm::vec3 const& min, glm::vec3 const& max,
+             std::vector<uint32_t>& triangles) const;
+
+  bool isEmpty() const { return m_nodes.empty(); }
+  size_t getTriangleCount() const { return m_triangleIds.size(); }
+  size_t getNodeCount() const { return m_nodes.size(); }
+
+ protected:
+  struct alignas(32) Node {
+    glm::vec3 min;
+    // interior nodes: index of the right child, the left one is next
+    // leaves: first triangle, in leaf order
+    uint32_t leftFirst;
+    glm::vec3 max;
+    // triangles in a leaf, 0 for interior nodes
+    uint32_t count;
+  };
+  static_assert(sizeof(Node) == 32, "two nodes per cache line");
+
+  struct Triangle {
+    glm::vec3 v0;
+    glm::vec3 edge1;
+    glm::vec3 edge2;
+  };
+
+  // what the build knows of each triangle
+  struct BuildTriangle {
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec3 centroid;
+  };
+
+  void buildNode(std::vector<Node>& nodes, uint32_t nodeIndex, uint32_t first,
+                 uint32_t count, uint32_t depth);
+
+ protected:
+  std::vector<Node> m_nodes;
+  std::vector<Triangle> m_triangles;
+  // mesh triangle of each triangle in leaf order
+  std::vector<uint32_t> m_triangleIds;
+  // only used while building
+  std::vector<BuildTriangle> m_buildTriangles;
+};
+
+}  // namespace VulkanEngine
+
+#endif /* MODEL_BVH_H */
@@ -2,6 +2,7 @@
 #define VULKAN_TEXTURE_H
 
 #include "VkObject.h"
+#include "VulkanMemoryTracker.h"
 #include "base_template.h"
 #include "render_common.h"
 
@@ -44,7 +45,7 @@ class VULKANENGINE_EXPORT_API VulkanTexture : public VkObject {
     vkDestroyImageView(device->logicalDevice, view, nullptr);
     vkDestroyImage(device->logicalDevice, image, nullptr);
     if (sampler) vkDestroySampler(device->logicalDevice, sampler, nullptr);
-    vkFreeMemory(device->logicalDevice, deviceMemory, nullptr);
+    VulkanMemoryTracker::get().free(device->logicalDevice, deviceMemory);
   }
 
   VkComponentMapping getComponentMapping(int channels) {
@@ -14,6 +14,7 @@
 
 #include "vulkan/vulkan.h"
 #include "VulkanTools.h"
+#include "VulkanMemoryTracker.h"
 
 namespace vks
 {	
@@ -153,7 +154,7 @@ namespace vks
 			}
 			if (memory)
 			{
-				vkFreeMemory(device, memory, nullptr);
+				VulkanEngine::VulkanMemoryTracker::get().free(device, memory);
 			}
 		}
 
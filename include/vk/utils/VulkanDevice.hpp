@@ -13,6 +13,9 @@
 #include <exception>
 #include <assert.h>
 #include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
 #include "vulkan/vulkan.h"
 #include "VulkanTools.h"
 #include "VulkanBuffer.hpp"
@@ -38,8 +41,12 @@ namespace vks
 		/** @brief List of extensions supported by the device */
 		std::vector<std::string> supportedExtensions;
 
-		/** @brief Default command pool for the graphics queue family index */
-		VkCommandPool commandPool = VK_NULL_HANDLE;
+		/** @brief Default command pools for the graphics queue family index, one per thread using them */
+		std::map<std::thread::id, VkCommandPool> commandPools;
+		std::mutex commandPoolMutex;
+
+		/** @brief Held around every submit to and present on the device's queues, which windows on other threads share */
+		std::mutex queueMutex;
 
 		/** @brief Set to true when the debug marker extension is detected */
 		bool enableDebugMarkers = false;
@@ -102,9 +109,9 @@ namespace vks
 		*/
 		~VulkanDevice()
 		{
-			if (commandPool)
+			for (auto& commandPool : commandPools)
 			{
-				vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
+				vkDestroyCommandPool(logicalDevice, commandPool.second, nullptr);
 			}
 			if (logicalDevice)
 			{
@@ -324,12 +331,6 @@ namespace vks
 
 			VkResult result = vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &logicalDevice);
 
-			if (result == VK_SUCCESS)
-			{
-				// Create a default command pool for graphics command buffers
-				commandPool = createCommandPool(queueFamilyIndices.graphics);
-			}
-
 			this->enabledFeatures = enabledFeatures;
 
 			return result;
@@ -361,7 +362,7 @@ namespace vks
 			memAlloc.allocationSize = memReqs.size;
 			// Find a memory type index that fits the properties of the buffer
 			memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-			VK_CHECK_RESULT(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, memory));
+			VK_CHECK_RESULT(VulkanEngine::VulkanMemoryTracker::get().allocate(logicalDevice, &memAlloc, memory, VulkanEngine::VulkanMemoryTracker::categorize(usageFlags)));
 			
 			// If a pointer to the buffer data has been passed, map the buffer and copy over the data
 			if (data != nullptr)
@@ -413,7 +414,7 @@ namespace vks
 			memAlloc.allocationSize = memReqs.size;
 			// Find a memory type index that fits the properties of the buffer
 			memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-			VK_CHECK_RESULT(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, &buffer->memory));
+			VK_CHECK_RESULT(VulkanEngine::VulkanMemoryTracker::get().allocate(logicalDevice, &memAlloc, &buffer->memory, VulkanEngine::VulkanMemoryTracker::categorize(usageFlags)));
 
 			buffer->alignment = memReqs.alignment;
 			buffer->size = size;
@@ -512,9 +513,27 @@ namespace vks
 			return cmdBuffer;
 		}
 			
+		/**
+		* Get the calling thread's default command pool, creating it on first use
+		*
+		* @note Command pools can only be used by one thread at a time, and every window renders on its own thread
+		*
+		* @return The thread's command pool for graphics command buffers
+		*/
+		VkCommandPool getCommandPool()
+		{
+			std::lock_guard<std::mutex> lock(commandPoolMutex);
+			VkCommandPool& commandPool = commandPools[std::this_thread::get_id()];
+			if (commandPool == VK_NULL_HANDLE)
+			{
+				commandPool = createCommandPool(queueFamilyIndices.graphics);
+			}
+			return commandPool;
+		}
+
 		VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, bool begin = false)
 		{
-			return createCommandBuffer(level, commandPool, begin);
+			return createCommandBuffer(level, getCommandPool(), begin);
 		}
 
 		/**
@@ -545,7 +564,10 @@ namespace vks
 			VkFence fence;
 			VK_CHECK_RESULT(vkCreateFence(logicalDevice, &fenceInfo, nullptr, &fence));
 			// Submit to the queue
-			VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+			}
 			// Wait for the fence to signal that command buffer has finished executing
 			VK_CHECK_RESULT(vkWaitForFences(logicalDevice, 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
 			vkDestroyFence(logicalDevice, fence, nullptr);
@@ -557,7 +579,7 @@ namespace vks
 
 		void flushCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue, bool free = true)
 		{
-			return flushCommandBuffer(commandBuffer, queue, commandPool, free);
+			return flushCommandBuffer(commandBuffer, queue, getCommandPool(), free);
 		}
 
 		/**
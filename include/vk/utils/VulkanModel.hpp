@@ -118,9 +118,17 @@ struct Model {
     uint32_t vertexCount;
     uint32_t indexBase;
     uint32_t indexCount;
+    uint32_t materialIndex;
   };
   std::vector<ModelPart> parts;
 
+  /** @brief Path of each material's diffuse texture, empty if it has none */
+  std::vector<std::string> diffuseTextures;
+
+  /** @brief CPU copy of the geometry, laid out as described by the layout */
+  std::vector<float> vertexData;
+  std::vector<uint32_t> indexData;
+
   static int const defaultFlags =
       aiProcess_FlipWindingOrder | aiProcess_Triangulate |
       aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace |
@@ -136,30 +144,27 @@ struct Model {
   void destroy() {
     assert(device);
     vkDestroyBuffer(device, vertices.buffer, nullptr);
-    vkFreeMemory(device, vertices.memory, nullptr);
+    VulkanEngine::VulkanMemoryTracker::get().free(device, vertices.memory);
     if (indices.buffer != VK_NULL_HANDLE) {
       vkDestroyBuffer(device, indices.buffer, nullptr);
-      vkFreeMemory(device, indices.memory, nullptr);
+      VulkanEngine::VulkanMemoryTracker::get().free(device, indices.memory);
     }
   }
 
   /**
-   * Loads a 3D model from a file into Vulkan buffers
+   * Loads a 3D model from a file into vertexData and indexData, without
+   * creating any Vulkan resources
+   *
+   * Indices are relative to the first vertex of the model, so the geometry
+   * can be placed anywhere within a shared vertex buffer.
    *
-   * @param device Pointer to the Vulkan device used to generated the vertex and
-   * index buffers on
    * @param filename File to load (must be a model format supported by ASSIMP)
    * @param layout Vertex layout components (position, normals, tangents, etc.)
    * @param createInfo MeshCreateInfo structure for load time settings like
    * scale, center, etc.
-   * @param copyQueue Queue used for the memory staging copy commands (must
-   * support transfer)
    */
-  bool loadFromFile(std::string const& filename, vks::VertexLayout layout,
-                    vks::ModelCreateInfo* createInfo, vks::VulkanDevice* device,
-                    VkQueue copyQueue, AAssetManager* manager) {
-    this->device = device->logicalDevice;
-
+  bool loadGeometry(std::string const& filename, vks::VertexLayout layout,
+                    vks::ModelCreateInfo* createInfo, AAssetManager* manager) {
     Assimp::Importer Importer;
     aiScene const* pScene;
 
@@ -212,8 +217,23 @@ struct Model {
         center = createInfo->center;
       }
 
-      std::vector<float> vertexBuffer;
-      std::vector<uint32_t> indexBuffer;
+      vertexData.clear();
+      indexData.clear();
+
+      // material textures are looked up relative to the model's directory
+      diffuseTextures.assign(pScene->mNumMaterials, std::string());
+      std::string directory;
+      size_t separator = filename.find_last_of("/\\");
+      if (separator != std::string::npos)
+        directory = filename.substr(0, separator + 1);
+      for (unsigned int i = 0; i < pScene->mNumMaterials; i++) {
+        aiString texturePath;
+        if (pScene->mMaterials[i]->GetTexture(aiTextureType_DIFFUSE, 0,
+                                              &texturePath) == AI_SUCCESS &&
+            texturePath.length > 0 && texturePath.C_Str()[0] != '*') {
+          diffuseTextures[i] = directory + texturePath.C_Str();
+        }
+      }
 
       vertexCount = 0;
       indexCount = 0;
@@ -225,6 +245,7 @@ struct Model {
         parts[i] = {};
         parts[i].vertexBase = vertexCount;
         parts[i].indexBase = indexCount;
+        parts[i].materialIndex = paiMesh->mMaterialIndex;
 
         vertexCount += pScene->mMeshes[i]->mNumVertices;
 
@@ -250,73 +271,72 @@ struct Model {
           for (auto& component : layout.components) {
             switch (component) {
               case VERTEX_COMPONENT_POSITION:
-                vertexBuffer.push_back(pPos->x * scale.x + center.x);
-                vertexBuffer.push_back(-pPos->y * scale.y + center.y);
-                vertexBuffer.push_back(pPos->z * scale.z + center.z);
+                vertexData.push_back(pPos->x * scale.x + center.x);
+                vertexData.push_back(-pPos->y * scale.y + center.y);
+                vertexData.push_back(pPos->z * scale.z + center.z);
                 break;
               case VERTEX_COMPONENT_NORMAL:
-                vertexBuffer.push_back(pNormal->x);
-                vertexBuffer.push_back(-pNormal->y);
-                vertexBuffer.push_back(pNormal->z);
+                vertexData.push_back(pNormal->x);
+                vertexData.push_back(-pNormal->y);
+                vertexData.push_back(pNormal->z);
                 break;
               case VERTEX_COMPONENT_UV:
-                vertexBuffer.push_back(pTexCoord->x * uvscale.s);
-                vertexBuffer.push_back(pTexCoord->y * uvscale.t);
+                vertexData.push_back(pTexCoord->x * uvscale.s);
+                vertexData.push_back(pTexCoord->y * uvscale.t);
                 break;
               case VERTEX_COMPONENT_UVVEC4:
-                vertexBuffer.push_back(pTexCoord->x * uvscale.s);
-                vertexBuffer.push_back(pTexCoord->y * uvscale.t);
-                vertexBuffer.push_back(0.f);
-                vertexBuffer.push_back(0.f);
+                vertexData.push_back(pTexCoord->x * uvscale.s);
+                vertexData.push_back(pTexCoord->y * uvscale.t);
+                vertexData.push_back(0.f);
+                vertexData.push_back(0.f);
                 break;
               case VERTEX_COMPONENT_COLOR:
-                vertexBuffer.push_back(pColor.r);
-                vertexBuffer.push_back(pColor.g);
-                vertexBuffer.push_back(pColor.b);
+                vertexData.push_back(pColor.r);
+                vertexData.push_back(pColor.g);
+                vertexData.push_back(pColor.b);
                 break;
               case VERTEX_COMPONENT_TANGENT:
-                vertexBuffer.push_back(pTangent->x);
-                vertexBuffer.push_back(pTangent->y);
-                vertexBuffer.push_back(pTangent->z);
+                vertexData.push_back(pTangent->x);
+                vertexData.push_back(pTangent->y);
+                vertexData.push_back(pTangent->z);
                 break;
               case VERTEX_COMPONENT_BITANGENT:
-                vertexBuffer.push_back(pBiTangent->x);
-                vertexBuffer.push_back(pBiTangent->y);
-                vertexBuffer.push_back(pBiTangent->z);
+                vertexData.push_back(pBiTangent->x);
+                vertexData.push_back(pBiTangent->y);
+                vertexData.push_back(pBiTangent->z);
                 break;
               // Dummy components for padding
               case VERTEX_COMPONENT_DUMMY_FLOAT:
-                vertexBuffer.push_back(0.0f);
+                vertexData.push_back(0.0f);
                 break;
               case VERTEX_COMPONENT_DUMMY_VEC4:
-                vertexBuffer.push_back(0.0f);
-                vertexBuffer.push_back(0.0f);
-                vertexBuffer.push_back(0.0f);
-                vertexBuffer.push_back(0.0f);
+                vertexData.push_back(0.0f);
+                vertexData.push_back(0.0f);
+                vertexData.push_back(0.0f);
+                vertexData.push_back(0.0f);
                 break;
             };
           }
 
-          dim.max.x = fmax(pPos->x, dim.max.x);
-          dim.max.y = fmax(pPos->y, dim.max.y);
-          dim.max.z = fmax(pPos->z, dim.max.z);
-
-          dim.min.x = fmin(pPos->x, dim.min.x);
-          dim.min.y = fmin(pPos->y, dim.min.y);
-          dim.min.z = fmin(pPos->z, dim.min.z);
+          // bounds of the positions as written, scaled and with y flipped
+          glm::vec3 pos(pPos->x * scale.x + center.x,
+                        -pPos->y * scale.y + center.y,
+                        pPos->z * scale.z + center.z);
+          dim.max = glm::max(pos, dim.max);
+          dim.min = glm::min(pos, dim.min);
         }
 
         dim.size = dim.max - dim.min;
 
         parts[i].vertexCount = paiMesh->mNumVertices;
 
-        uint32_t indexBase = static_cast<uint32_t>(indexBuffer.size());
+        uint32_t indexBase = parts[i].vertexBase;
         for (unsigned int j = 0; j < paiMesh->mNumFaces; j++) {
           aiFace const& Face = paiMesh->mFaces[j];
           if (Face.mNumIndices != 3) continue;
-          indexBuffer.push_back(indexBase + Face.mIndices[0]);
-          indexBuffer.push_back(indexBase + Face.mIndices[1]);
-          indexBuffer.push_back(indexBase + Face.mIndices[2]);
+          indexData.push_back(indexBase + Face.mIndices[0]);
+          indexData.push_back(indexBase + Face.mIndices[1]);
+          indexData.push_back(indexBase + Face.mIndices[2]);
           parts[i].indexCount += 3;
           indexCount += 3;
         }
@@ -349,64 +369,6 @@ struct Model {
       //                    vertexBuffer[10 * i+9] << " ";
       //				}
 
-      uint32_t vBufferSize =
-          static_cast<uint32_t>(vertexBuffer.size()) * sizeof(float);
-      uint32_t iBufferSize =
-          static_cast<uint32_t>(indexBuffer.size()) * sizeof(uint32_t);
-
-      // Use staging buffer to move vertex and index buffer to device local
-      // memory Create staging buffers
-      vks::Buffer vertexStaging, indexStaging;
-
-      // Vertex buffer
-      VK_CHECK_RESULT(device->createBuffer(
-          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-          &vertexStaging, vBufferSize, vertexBuffer.data()));
-
-      // Index buffer
-      VK_CHECK_RESULT(
-          device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                               &indexStaging, iBufferSize, indexBuffer.data()));
-
-      // Create device local target buffers
-      // Vertex buffer
-      VK_CHECK_RESULT(device->createBuffer(
-          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-              createInfo->memoryPropertyFlags,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vertices, vBufferSize));
-
-      // Index buffer
-      VK_CHECK_RESULT(device->createBuffer(
-          VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-              createInfo->memoryPropertyFlags,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indices, iBufferSize));
-
-      // Copy from staging buffers
-      VkCommandBuffer copyCmd =
-          device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-      VkBufferCopy copyRegion{};
-
-      copyRegion.size = vertices.size;
-      vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1,
-                      &copyRegion);
-
-      copyRegion.size = indices.size;
-      vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1,
-                      &copyRegion);
-
-      device->flushCommandBuffer(copyCmd, copyQueue);
-
-      // Destroy staging resources
-      vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-      vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-      vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-      vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
-
       return true;
     } else {
       printf("Error parsing '%s': '%s'\n", filename.c_str(),
@@ -419,6 +381,87 @@ struct Model {
     }
   };
 
+  /**
+   * Loads a 3D model from a file into Vulkan buffers
+   *
+   * @param device Pointer to the Vulkan device used to generated the vertex and
+   * index buffers on
+   * @param filename File to load (must be a model format supported by ASSIMP)
+   * @param layout Vertex layout components (position, normals, tangents, etc.)
+   * @param createInfo MeshCreateInfo structure for load time settings like
+   * scale, center, etc.
+   * @param copyQueue Queue used for the memory staging copy commands (must
+   * support transfer)
+   */
+  bool loadFromFile(std::string const& filename, vks::VertexLayout layout,
+                    vks::ModelCreateInfo* createInfo, vks::VulkanDevice* device,
+                    VkQueue copyQueue, AAssetManager* manager) {
+    this->device = device->logicalDevice;
+    if (!loadGeometry(filename, layout, createInfo, manager)) return false;
+
+    uint32_t vBufferSize =
+        static_cast<uint32_t>(vertexData.size()) * sizeof(float);
+    uint32_t iBufferSize =
+        static_cast<uint32_t>(indexData.size()) * sizeof(uint32_t);
+
+    // Use staging buffer to move vertex and index buffer to device local
+    // memory Create staging buffers
+    vks::Buffer vertexStaging, indexStaging;
+
+    // Vertex buffer
+    VK_CHECK_RESULT(device->createBuffer(
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &vertexStaging, vBufferSize, vertexData.data()));
+
+    // Index buffer
+    VK_CHECK_RESULT(
+        device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                             &indexStaging, iBufferSize, indexData.data()));
+
+    // Create device local target buffers
+    // Vertex buffer
+    VK_CHECK_RESULT(device->createBuffer(
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+            createInfo->memoryPropertyFlags,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vertices, vBufferSize));
+
+    // Index buffer
+    VK_CHECK_RESULT(device->createBuffer(
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+            createInfo->memoryPropertyFlags,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indices, iBufferSize));
+
+    // Copy from staging buffers
+    VkCommandBuffer copyCmd =
+        device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+    VkBufferCopy copyRegion{};
+
+    copyRegion.size = vertices.size;
+    vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1,
+                    &copyRegion);
+
+    copyRegion.size = indices.size;
+    vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1,
+                    &copyRegion);
+
+    device->flushCommandBuffer(copyCmd, copyQueue);
+
+    // Destroy staging resources
+    vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
+    VulkanEngine::VulkanMemoryTracker::get().free(device->logicalDevice,
+                                                  vertexStaging.memory);
+    vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
+    VulkanEngine::VulkanMemoryTracker::get().free(device->logicalDevice,
+                                                  indexStaging.memory);
+
+    return true;
+  }
+
   /**
    * Loads a 3D model from a file into Vulkan buffers
    *
@@ -46,10 +46,13 @@ namespace vks
 		VkSampleCountFlagBits rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 		uint32_t subpass = 0;
 
-		vks::Buffer vertexBuffer;
-		vks::Buffer indexBuffer;
-		int32_t vertexCount = 0;
-		int32_t indexCount = 0;
+		// Geometry of one frame in flight. The buffers only grow, to the next
+		// power of two, so a changing UI doesn't reallocate every frame.
+		struct FrameGeometry {
+			vks::Buffer vertexBuffer;
+			vks::Buffer indexBuffer;
+		};
+		std::vector<FrameGeometry> frames;
 
 		std::vector<VkPipelineShaderStageCreateInfo> shaders;
 
@@ -79,8 +82,9 @@ namespace vks
 		void preparePipeline(const VkPipelineCache pipelineCache, const VkRenderPass renderPass);
 		void prepareResources();
 
-		bool update();
-		void draw(const VkCommandBuffer commandBuffer);
+		void setFrameCount(uint32_t count);
+		bool update(uint32_t frame);
+		void draw(const VkCommandBuffer commandBuffer, uint32_t frame);
 		void resize(uint32_t width, uint32_t height);
 
 		void freeResources();
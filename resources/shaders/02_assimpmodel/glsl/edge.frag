@@ -0,0 +1,21 @@
+#version 450
+
+// one byte per edge, four to a word, as AssimpObject::EdgeState
+layout(std430, set = 0, binding = 4) readonly buffer EdgeStates {
+  uint states[];
+}
+edges;
+
+layout(location = 0) out vec4 outFragColor;
+
+// flat, cut, mountain fold, valley fold
+const vec4 STATE_COLORS[4] =
+    vec4[](vec4(0.55, 0.55, 0.55, 1.0), vec4(1.0, 1.0, 1.0, 1.0),
+           vec4(0.9, 0.3, 0.2, 1.0), vec4(0.2, 0.45, 0.9, 1.0));
+
+void main() {
+  // lines are drawn one per edge, in edge order
+  uint edge = uint(gl_PrimitiveID);
+  uint state = (edges.states[edge >> 2] >> ((edge & 3u) * 8u)) & 0xffu;
+  outFragColor = STATE_COLORS[min(state, 3u)];
+}
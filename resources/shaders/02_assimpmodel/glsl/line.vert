@@ -1,18 +1,28 @@
 #version 450
 
 layout(location = 0) in vec3 inPos;
-layout(binding = 0) uniform UBO {
+layout(set = 0, binding = 0) uniform UBO {
   mat4 projection;
   mat4 model;
   mat4 view;
   mat4 normal;
   vec4 lightpos;
+  mat4 modelView;
+  mat4 modelViewProjection;
 }
 ubo;
 
+// the drawn object's transform, pushed per draw
+layout(push_constant) uniform PushConsts { mat4 model; }
+object;
+
+// edges lie on the surface, so they are pulled towards the camera to win
+// the depth test against it. Depth bias only applies to polygons.
+const float DEPTH_OFFSET = 0.0002;
+
 out gl_PerVertex { vec4 gl_Position; };
 
 void main() {
-  vec3 worldPos = vec3(ubo.model * vec4(inPos, 1.0));
-  gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPos.xyz, 1.0);
-}
\ No newline at end of file
+  gl_Position = ubo.modelViewProjection * object.model * vec4(inPos, 1.0);
+  gl_Position.z -= DEPTH_OFFSET * gl_Position.w;
+}
@@ -0,0 +1,6 @@
+#version 450
+
+// index of the triangle within the drawn mesh, plus one so 0 means nothing
+layout(location = 0) out uint outId;
+
+void main() { outId = uint(gl_PrimitiveID) + 1u; }
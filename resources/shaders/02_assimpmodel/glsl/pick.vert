@@ -0,0 +1,24 @@
+#version 450
+
+layout(location = 0) in vec3 inPos;
+
+layout(set = 0, binding = 0) uniform UBO {
+  mat4 projection;
+  mat4 model;
+  mat4 view;
+  mat4 normal;
+  vec4 lightpos;
+  mat4 modelView;
+  mat4 modelViewProjection;
+}
+ubo;
+
+// the drawn object's transform, pushed per draw
+layout(push_constant) uniform PushConsts { mat4 model; }
+object;
+
+out gl_PerVertex { vec4 gl_Position; };
+
+void main() {
+  gl_Position = ubo.modelViewProjection * object.model * vec4(inPos, 1.0);
+}
@@ -1,6 +1,7 @@
 #version 450
 
-layout(binding = 3) uniform sampler2D shadowMap;
+// the shadow map again, through a sampler that returns depths
+layout(set = 0, binding = 3) uniform sampler2D shadowMap;
 
 layout(location = 0) in vec3 inUV;
 
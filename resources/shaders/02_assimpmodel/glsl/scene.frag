@@ -1,86 +1,103 @@
 #version 450
 
-layout(binding = 1) uniform sampler2D samplerTextureA;
-
-layout(binding = 2) uniform sampler2D samplerTextureB;
-
-layout(binding = 3) uniform sampler2D shadowMap;
-
-layout(location = 0) in vec3 inUV;
-layout(location = 1) in float inLodBias;
-layout(location = 2) in vec3 inNormal;
-layout(location = 3) in vec3 inViewVec;
-layout(location = 4) in vec3 inLightVec;
-layout(location = 5) in vec3 inPos;
-layout(location = 7) in mat4 inInvModelView;
-layout(location = 11) in float inDistance;
-layout(location = 12) in vec4 inShadowCoord;
+// variants picked by the performance tier, see VulkanShader::setConstant
+// shadow filter, each tap being a hardware-filtered 2x2 compare
+// 0: one unfiltered compare, 1: four taps, 2: sixteen taps on a Poisson disk
+layout(constant_id = 0) const int SHADOW_FILTER = 1;
+layout(constant_id = 1) const bool SHADOWS = true;
+// 0: average of textures A and B, 1: texture A only
+layout(constant_id = 2) const int TEXTURE_BLEND = 0;
+// 0: Lambert, 1: Phong, 2: Phong with distance attenuation
+layout(constant_id = 3) const int LIGHTING = 1;
+
+layout(set = 1, binding = 0) uniform sampler2D samplerTextureA;
+
+layout(set = 1, binding = 1) uniform sampler2D samplerTextureB;
+
+layout(set = 0, binding = 2) uniform sampler2DShadow shadowMap;
+// the same map through a nearest compare sampler, for hard shadows
+layout(set = 0, binding = 5) uniform sampler2DShadow shadowMapNearest;
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inViewVec;
+layout(location = 3) in vec3 inLightVec;
+layout(location = 4) in vec4 inShadowCoord;
 
 layout(location = 0) out vec4 outFragColor;
 
-float textureProj(vec4 shadowCoord, vec2 off, float angle) {
-  float ambient = 0.8f;
-  float shadow = 1.0;
-  float bias = 0.005f * tan(acos(angle));
-  if (shadowCoord.z > -1.0 && shadowCoord.z < 1.0) {
-    float dist = texture(shadowMap, shadowCoord.st + off).r;
-    if (shadowCoord.w > 0.0 && dist < shadowCoord.z - bias) {
-      shadow = ambient;
+const vec2 poissonDisk[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590),
+    vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790));
+
+// radius of the Poisson disk, in shadow map texels
+const float POISSON_RADIUS = 2.0;
+
+float filterShadow(vec4 sc, float cosTheta) {
+  if (sc.w <= 0.0 || sc.z <= -1.0 || sc.z >= 1.0) return 1.0;
+  // slope-scaled bias, tan(acos(cosTheta)) without the trigonometry
+  float tangent = sqrt(1.0 - cosTheta * cosTheta) / max(cosTheta, 0.05);
+  vec3 coord = vec3(sc.st, sc.z - clamp(0.005 * tangent, 0.0, 0.01));
+  vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
+
+  float lit = 0.0;
+  if (SHADOW_FILTER == 0) {
+    lit = texture(shadowMapNearest, coord);
+  } else if (SHADOW_FILTER == 1) {
+    // four bilinear compares cover a 4x4 texel footprint
+    for (int x = 0; x < 2; x++) {
+      for (int y = 0; y < 2; y++) {
+        vec2 offset = (vec2(x, y) * 2.0 - 1.0) * texel;
+        lit += texture(shadowMap, vec3(coord.st + offset, coord.z));
+      }
     }
-  }
-  return shadow;
-}
-
-float filterPCF(vec4 sc, float angle) {
-  ivec2 texDim = textureSize(shadowMap, 0);
-  float scale = 1.5;
-  float dx = scale * 1.0 / float(texDim.x);
-  float dy = scale * 1.0 / float(texDim.y);
-
-  float shadowFactor = 0.0;
-  int count = 0;
-  int range = 1;
-
-  for (int x = -range; x <= range; x++) {
-    for (int y = -range; y <= range; y++) {
-      shadowFactor += textureProj(sc, vec2(dx * x, dy * y), angle);
-      count++;
+    lit *= 0.25;
+  } else {
+    for (int i = 0; i < 16; i++) {
+      vec2 offset = poissonDisk[i] * POISSON_RADIUS * texel;
+      lit += texture(shadowMap, vec3(coord.st + offset, coord.z));
     }
+    lit /= 16.0;
   }
-  return shadowFactor / count;
+  float ambient = 0.8f;
+  return mix(ambient, 1.0, lit);
 }
 
 void main() {
-  // Reflect SkyBox
-  vec3 cI = normalize(inPos);
-  vec3 cR = reflect(cI, normalize(inNormal));
-
-  cR = vec3(inInvModelView * vec4(cR, 0.0));
-  cR.x *= -1.0;
-  cR.y = -cR.y;
-  cR.z = -cR.z;
-
   // Texture
-  vec4 colorA = texture(samplerTextureA, inUV.xy, 1.0f);
-  vec4 colorB = texture(samplerTextureB, inUV.xy, 1.0f);
-  vec4 color = (colorA * 0.5 + colorB * 0.5);
+  vec4 color = texture(samplerTextureA, inUV, 1.0f);
+  if (TEXTURE_BLEND == 0)
+    color = color * 0.5 + texture(samplerTextureB, inUV, 1.0f) * 0.5;
 
   // Phong
   float ambient = 0.2f;
   vec3 N = normalize(inNormal);
   vec3 L = normalize(inLightVec);
   vec3 V = normalize(inViewVec);
-  vec3 R = reflect(-L, N);
   vec3 diffuse = max(dot(N, L), 0.0) * vec3(1.0);
-  float specular = pow(max(dot(R, V), 0.0), 16.0) * color.a;
-
-  float attenuation =
-      1.0f / (1.0f + 0.09f * inDistance + 0.032f * (inDistance * inDistance));
+  float specular = 0.f;
+  if (LIGHTING > 0) {
+    vec3 R = reflect(-L, N);
+    specular = pow(max(dot(R, V), 0.0), 16.0) * color.a;
+  }
 
-  attenuation = 1.f;
+  float attenuation = 1.f;
+  if (LIGHTING > 1) {
+    float distance = length(inLightVec);
+    attenuation =
+        1.0f / (1.0f + 0.09f * distance + 0.032f * (distance * distance));
+  }
 
-  float shadow =
-      filterPCF(inShadowCoord / inShadowCoord.w, max(dot(N, L), 0.f));
+  float shadow = 1.f;
+  if (SHADOWS)
+    shadow =
+        filterShadow(inShadowCoord / inShadowCoord.w, max(dot(N, L), 0.f));
 
   outFragColor = vec4(ambient * color.rgb * shadow +
                           diffuse * shadow * attenuation * color.rgb +
@@ -4,55 +4,52 @@ layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec4 inUV;
 layout(location = 2) in vec3 inNormal;
 
-layout(binding = 0) uniform UBO {
+// the derived matrices are computed once per frame by UniformCamera
+layout(set = 0, binding = 0) uniform UBO {
   mat4 projection;
   mat4 model;
   mat4 view;
   mat4 normal;
   vec4 lightpos;
+  mat4 modelView;
+  mat4 modelViewProjection;
+  vec4 lightPosView;
 }
 ubo;
 
-layout(binding = 4) uniform UBOShadow { mat4 depthMVP; }
+layout(set = 0, binding = 1) uniform UBOShadow { mat4 depthMVP; }
 uboShadow;
 
+// the drawn object's transform, pushed per draw
+layout(push_constant) uniform PushConsts { mat4 model; }
+object;
+
 const mat4 biasMat = mat4(0.5, 0.0, 0.0, 0.0, 0.0, 0.5, 0.0, 0.0, 0.0, 0.0, 1.0,
                           0.0, 0.5, 0.5, 0.0, 1.0);
 
-layout(location = 0) out vec3 outUV;
-layout(location = 1) out float outLodBias;
-layout(location = 2) out vec3 outNormal;
-layout(location = 3) out vec3 outViewVec;
-layout(location = 4) out vec3 outLightVec;
-layout(location = 5) out vec3 outPos;
-layout(location = 7) out mat4 outInvModelView;
-layout(location = 11) out float outDistance;
-layout(location = 12) out vec4 outShadowCoord;
+// lighting vectors are in view space
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec3 outViewVec;
+layout(location = 3) out vec3 outLightVec;
+layout(location = 4) out vec4 outShadowCoord;
+// bindless draws pass the model part as their first instance
+layout(location = 5) flat out uint outPartIndex;
 
 out gl_PerVertex { vec4 gl_Position; };
 
 void main() {
-  outUV = inUV.xyz;
-
-  vec3 worldPos = vec3(ubo.model * vec4(inPos, 1.0));
-
-  gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPos.xyz, 1.0);
-
-  vec4 pos = ubo.view * ubo.model * vec4(inPos, 1.0);
-  outNormal =
-      mat3(inverse(transpose(ubo.view * ubo.model))) * normalize(inNormal);
-  vec4 lightPos = ubo.lightpos;
-  vec3 lPos = (ubo.view * ubo.model * lightPos).xyz;
-  outLightVec = lPos - pos.xyz;
+  outUV = inUV.xy;
+  outPartIndex = gl_InstanceIndex;
 
-  vec3 viewPos = vec3(0.0, 0.0, 0.0);
-  outViewVec = viewPos - pos.xyz;
+  vec4 worldPos = object.model * vec4(inPos, 1.0);
+  gl_Position = ubo.modelViewProjection * worldPos;
 
-  outPos = pos.xyz;
+  vec4 pos = ubo.modelView * worldPos;
+  // exact as long as object transforms don't scale non-uniformly
+  outNormal = mat3(ubo.normal) * mat3(object.model) * inNormal;
+  outLightVec = ubo.lightPosView.xyz - pos.xyz;
+  outViewVec = -pos.xyz;
 
-  outInvModelView = inverse(ubo.view * ubo.model);
-
-  outDistance = length(lightPos.xyz - pos.xyz);
-
-  outShadowCoord = (biasMat * uboShadow.depthMVP) * vec4(inPos, 1.0);
-}
\ No newline at end of file
+  outShadowCoord = (biasMat * uboShadow.depthMVP) * worldPos;
+}
@@ -0,0 +1,108 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// variants picked by the performance tier, see VulkanShader::setConstant
+// shadow filter, each tap being a hardware-filtered 2x2 compare
+// 0: one unfiltered compare, 1: four taps, 2: sixteen taps on a Poisson disk
+layout(constant_id = 0) const int SHADOW_FILTER = 1;
+layout(constant_id = 1) const bool SHADOWS = true;
+// constant 2, texture blending, does not apply to bindless draws
+// 0: Lambert, 1: Phong, 2: Phong with distance attenuation
+layout(constant_id = 3) const int LIGHTING = 1;
+
+// texture index of every model part, and every texture of the scene
+layout(set = 1, binding = 0) readonly buffer PartTextures { uint partTextures[]; };
+
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+layout(set = 0, binding = 2) uniform sampler2DShadow shadowMap;
+// the same map through a nearest compare sampler, for hard shadows
+layout(set = 0, binding = 5) uniform sampler2DShadow shadowMapNearest;
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inViewVec;
+layout(location = 3) in vec3 inLightVec;
+layout(location = 4) in vec4 inShadowCoord;
+layout(location = 5) flat in uint inPartIndex;
+
+layout(location = 0) out vec4 outFragColor;
+
+const vec2 poissonDisk[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590),
+    vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790));
+
+// radius of the Poisson disk, in shadow map texels
+const float POISSON_RADIUS = 2.0;
+
+float filterShadow(vec4 sc, float cosTheta) {
+  if (sc.w <= 0.0 || sc.z <= -1.0 || sc.z >= 1.0) return 1.0;
+  // slope-scaled bias, tan(acos(cosTheta)) without the trigonometry
+  float tangent = sqrt(1.0 - cosTheta * cosTheta) / max(cosTheta, 0.05);
+  vec3 coord = vec3(sc.st, sc.z - clamp(0.005 * tangent, 0.0, 0.01));
+  vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
+
+  float lit = 0.0;
+  if (SHADOW_FILTER == 0) {
+    lit = texture(shadowMapNearest, coord);
+  } else if (SHADOW_FILTER == 1) {
+    // four bilinear compares cover a 4x4 texel footprint
+    for (int x = 0; x < 2; x++) {
+      for (int y = 0; y < 2; y++) {
+        vec2 offset = (vec2(x, y) * 2.0 - 1.0) * texel;
+        lit += texture(shadowMap, vec3(coord.st + offset, coord.z));
+      }
+    }
+    lit *= 0.25;
+  } else {
+    for (int i = 0; i < 16; i++) {
+      vec2 offset = poissonDisk[i] * POISSON_RADIUS * texel;
+      lit += texture(shadowMap, vec3(coord.st + offset, coord.z));
+    }
+    lit /= 16.0;
+  }
+  float ambient = 0.8f;
+  return mix(ambient, 1.0, lit);
+}
+
+void main() {
+  // Texture
+  // parts of one multi-draw may share a subgroup, hence nonuniformEXT
+  uint textureIndex = partTextures[inPartIndex];
+  vec4 color = texture(textures[nonuniformEXT(textureIndex)], inUV, 1.0f);
+
+  // Phong
+  float ambient = 0.2f;
+  vec3 N = normalize(inNormal);
+  vec3 L = normalize(inLightVec);
+  vec3 V = normalize(inViewVec);
+  vec3 diffuse = max(dot(N, L), 0.0) * vec3(1.0);
+  float specular = 0.f;
+  if (LIGHTING > 0) {
+    vec3 R = reflect(-L, N);
+    specular = pow(max(dot(R, V), 0.0), 16.0) * color.a;
+  }
+
+  float attenuation = 1.f;
+  if (LIGHTING > 1) {
+    float distance = length(inLightVec);
+    attenuation =
+        1.0f / (1.0f + 0.09f * distance + 0.032f * (distance * distance));
+  }
+
+  float shadow = 1.f;
+  if (SHADOWS)
+    shadow =
+        filterShadow(inShadowCoord / inShadowCoord.w, max(dot(N, L), 0.f));
+
+  outFragColor = vec4(ambient * color.rgb * shadow +
+                          diffuse * shadow * attenuation * color.rgb +
+                          specular * shadow * attenuation,
+                      1.0);
+}
\ No newline at end of file
@@ -4,9 +4,15 @@ layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec4 inUV;
 layout(location = 2) in vec3 inNormal;
 
-layout(binding = 4) uniform UBO { mat4 depthMVP; }
+layout(set = 0, binding = 1) uniform UBO { mat4 depthMVP; }
 ubo;
 
+// the drawn object's transform, pushed per draw
+layout(push_constant) uniform PushConsts { mat4 model; }
+object;
+
 out gl_PerVertex { vec4 gl_Position; };
 
-void main() { gl_Position = ubo.depthMVP * vec4(inPos, 1.0); }
\ No newline at end of file
+void main() {
+  gl_Position = ubo.depthMVP * object.model * vec4(inPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec3 inLightVec;
+
+layout(location = 0) out vec4 outFragColor;
+
+void main() {
+  vec3 N = normalize(inNormal);
+  vec3 L = normalize(inLightVec);
+  vec3 color = vec3(0.9, 0.85, 0.75);
+  outFragColor = vec4(color * (0.2 + max(dot(N, L), 0.0)), 1.0);
+}
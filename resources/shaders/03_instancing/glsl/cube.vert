@@ -0,0 +1,31 @@
+#version 450
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec4 inUV;
+layout(location = 2) in vec3 inNormal;
+
+layout(set = 0, binding = 0) uniform UBO {
+  mat4 projection;
+  mat4 model;
+  mat4 view;
+  mat4 normal;
+  vec4 lightpos;
+}
+ubo;
+
+// the drawn object's transform, pushed per draw
+layout(push_constant) uniform PushConsts { mat4 model; }
+object;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec3 outLightVec;
+
+out gl_PerVertex { vec4 gl_Position; };
+
+void main() {
+  mat4 modelView = ubo.view * ubo.model * object.model;
+  vec4 pos = modelView * vec4(inPos, 1.0);
+  gl_Position = ubo.projection * pos;
+  outNormal = mat3(modelView) * inNormal;
+  outLightVec = (ubo.view * ubo.model * ubo.lightpos).xyz - pos.xyz;
+}
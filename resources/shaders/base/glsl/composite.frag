@@ -0,0 +1,18 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D scene;
+
+layout(push_constant) uniform PushConstants {
+  // part of the target the scene was drawn into
+  vec2 uvScale;
+  vec2 uvMax;
+} pushConstants;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outFragColor;
+
+void main() {
+  vec2 uv = min(inUV * pushConstants.uvScale, pushConstants.uvMax);
+  outFragColor = texture(scene, uv);
+}
@@ -0,0 +1,11 @@
+#version 450
+
+layout(location = 0) out vec2 outUV;
+
+out gl_PerVertex { vec4 gl_Position; };
+
+// one triangle covering the viewport, with uvs from 0 to 1 over it
+void main() {
+  outUV = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+  gl_Position = vec4(outUV * 2.0 - 1.0, 0.0, 1.0);
+}
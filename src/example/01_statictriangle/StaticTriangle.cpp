@@ -37,9 +37,9 @@ void StaticTriangle::createTriangle() {
 
 void StaticTriangle::setDescriptorSet() {
   m_vulkanDescriptorSet->addBinding(
-    0, &(m_triangleUniform->m_uniformBuffer.descriptor),
-    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0);
-  m_vulkanDescriptorSet->GenPipelineLayout(&m_pipelineLayout);
+    0, m_triangleUniform.get(), VK_SHADER_STAGE_VERTEX_BIT, 0);
+  m_vulkanDescriptorSet->build();
+  preparePipelineLayout({m_vulkanDescriptorSet->getLayout()});
 }
 
 void StaticTriangle::createPipelines() {
@@ -14,27 +14,9 @@ void Triangle::generateVertex() {
 
   // setup indices
   std::vector<uint32_t> indices = { 0, 1, 2 };
-  m_indexCount = static_cast<uint32_t>(indices.size());
 
-  // create the buffers
-  // for sake of simplicity, we don't stage the vertex data to GPU memory
-
-  // vertex buffer
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-    &m_vertexBuffer,
-    vertices.size() * sizeof(VertexTexVec4),
-    vertices.data()
-  ));
-  // index buffer
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-    VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-    &m_indexBuffer,
-    indices.size() * sizeof(uint32_t),
-    indices.data()
-  ));
+  // copy into device-local memory in the geometry arena
+  uploadGeometry(vertices, indices);
 }
 
 }
\ No newline at end of file
@@ -1,8 +1,34 @@
 #include "02_assimpmodel/AssimpModel.h"
 
+#include <cfloat>
+
 namespace VulkanEngine {
 
-AssimpModel::~AssimpModel() noexcept { destroyObjects(); }
+namespace {
+
+// shadow map sizes, the largest one reserved for the high tier
+constexpr int MIN_SHADOW_MAP_SIZE = 512;
+constexpr int MAX_SHADOW_MAP_SIZE = 4096;
+
+// halves the largest size for each tier below high
+int maxShadowMapSize(int32_t quality) {
+  return MAX_SHADOW_MAP_SIZE >>
+         (static_cast<int>(PerformanceTier::HIGH) - quality);
+}
+
+}  // namespace
+
+AssimpModel::~AssimpModel() noexcept {
+  if (!m_shadowCmdBuffers.empty())
+    vkFreeCommandBuffers(m_device, m_cmdPool,
+                         static_cast<uint32_t>(m_shadowCmdBuffers.size()),
+                         m_shadowCmdBuffers.data());
+  destroyObjects();
+  delete_ptr(m_picker);
+  delete_ptr(m_sceneTimer);
+  delete_ptr(m_materialDescriptorSet);
+  delete_ptr(m_bindlessTextures);
+}
 
 void AssimpModel::prepareFunctions() {
   m_functions.emplace_back([this] { seeDebugQuad(); });
@@ -10,75 +36,370 @@ void AssimpModel::prepareFunctions() {
 
 void AssimpModel::prepareMyObjects() {
   m_camera.m_zoom = -4.f;
+  m_layoutCamera.m_zoom = -4.f;
+  // looking down on the model
+  m_layoutCamera.m_rotation.x = -90.f;
   createCube();
   createShadowFrameBuffer();
   createDebugQuad();
+  createPicker();
   setDescriptorSet();
   createPipelines();
 }
 
 void AssimpModel::buildMyObjects(VkCommandBuffer& cmd) {
-  m_assimpObject->build(cmd, m_cubeShader);
-  m_assimpObject->build(cmd, m_lineShader);
+  m_assimpObject->build(cmd, m_cubeShader.get(), m_recordingBuffer,
+                        AssimpObject::CULL_CAMERA);
+  if (m_showEdges) m_assimpObject->buildEdges(cmd, m_edgeShader.get());
   if (m_seeDebug) {
     m_debugPlane->build(cmd, m_debugShader);
   }
 }
 
+/**
+ * @brief The objects of the split view's layout view: the model and its
+ * edges, without the debug quad
+ *
+ * Stands in for the unfolded pieces until the model can be unfolded.
+ */
+void AssimpModel::buildLayoutObjects(VkCommandBuffer& cmd) {
+  m_assimpObject->build(cmd, m_cubeShader.get(), m_recordingBuffer,
+                        AssimpObject::CULL_LAYOUT);
+  if (m_showEdges) m_assimpObject->buildEdges(cmd, m_edgeShader.get());
+}
+
+/**
+ * @brief Updates the uniforms, and renders the shadow map first if the light
+ * moved or the scene was re-recorded since it was last rendered
+ *
+ * The shadow pass goes in its own submission ahead of the frame's, and the
+ * depth render pass's external dependency orders its writes before the
+ * scene's reads. Otherwise the cached depth image is sampled as is. With
+ * shadows off, nothing samples it, so it stays out of date until they are
+ * turned back on.
+ *
+ * The model's parts are culled against the camera every frame, and against
+ * the light whenever the shadow map is rendered. In the split view, each
+ * view is culled and drawn only when its camera moved or the shadow map
+ * changed, so the idle one costs nothing.
+ */
 void AssimpModel::render() {
-  updateCamera();
+  updateViewCameras();
   m_cubeUniform->update();
+  if (m_splitView) m_layoutUniform->update();
   m_shadowCamera->update();
+  updatePicking();
+  if (m_shadowCamera->getVersion() != m_shadowVersion) {
+    m_shadowVersion = m_shadowCamera->getVersion();
+    m_shadowDirty = true;
+  }
+  if (m_shadowDirty && m_shadowFilter != SHADOW_OFF) {
+    m_visibleParts[AssimpObject::CULL_SHADOW] = m_assimpObject->cull(
+        m_shadowCamera->m_uboVS.depthMVP, m_currentBuffer,
+        AssimpObject::CULL_SHADOW);
+    m_frameCmdBuffers.push_back(m_shadowCmdBuffers[m_currentBuffer]);
+    m_shadowDirty = false;
+    // both views sample the new shadow map
+    markSceneChanged();
+  }
+  if (!m_splitView) {
+    m_visibleParts[AssimpObject::CULL_CAMERA] = m_assimpObject->cull(
+        m_cubeUniform->m_uboVS.modelViewProjection, m_currentBuffer,
+        AssimpObject::CULL_CAMERA);
+    return;
+  }
+  m_sceneView->updateView(m_cubeUniform->m_uboVS.modelViewProjection);
+  m_layoutView->updateView(m_layoutUniform->m_uboVS.modelViewProjection);
+  if (m_sceneView->isDirty())
+    m_visibleParts[AssimpObject::CULL_CAMERA] = m_assimpObject->cull(
+        m_cubeUniform->m_uboVS.modelViewProjection, m_currentBuffer,
+        AssimpObject::CULL_CAMERA);
+  if (m_layoutView->isDirty())
+    m_visibleParts[AssimpObject::CULL_LAYOUT] = m_assimpObject->cull(
+        m_layoutUniform->m_uboVS.modelViewProjection, m_currentBuffer,
+        AssimpObject::CULL_LAYOUT);
+  submitViewports();
+}
+
+/**
+ * @brief Applies the mouse to the camera of the view under it
+ *
+ * In the split view, the view is picked when no button is held, so a drag
+ * keeps driving the view it started in. The layout view pans instead of
+ * orbiting, by as much as the cursor moved across it.
+ */
+void AssimpModel::updateViewCameras() {
+  if (!m_splitView) {
+    updateCamera();
+    return;
+  }
+  if (!m_mouseButtons.left && !m_mouseButtons.right)
+    m_layoutFocus = m_layoutView->contains(m_mousePos);
+  if (!m_layoutFocus) {
+    updateCamera();
+    return;
+  }
+  // the orthographic view is 2 * halfHeight units over the view's height
+  float halfHeight =
+      std::abs(m_layoutCamera.m_zoom) * std::tan(glm::radians(30.f));
+  updateCamera(m_layoutCamera, 2.f * halfHeight /
+                                   static_cast<float>(std::max(
+                                       1u, m_layoutView->getExtent().height)));
+}
+
+/**
+ * @brief Splits the window between the orbit and the layout view, or goes
+ * back to the orbit view alone
+ *
+ * @param split
+ */
+void AssimpModel::setSplitView(bool split) {
+  removeViewports();
+  m_sceneView = nullptr;
+  m_layoutView = nullptr;
+  m_splitView = split;
+  m_cubeUniform->m_aspect = 0.f;
+  if (split) {
+    m_sceneView = addViewport(glm::vec2(0.f), glm::vec2(0.5f, 1.f), 0,
+                              [this](VkCommandBuffer& cmd) {
+                                buildMyObjects(cmd);
+                              });
+    m_layoutView = addViewport(glm::vec2(0.5f, 0.f), glm::vec2(0.5f, 1.f), 1,
+                               [this](VkCommandBuffer& cmd) {
+                                 buildLayoutObjects(cmd);
+                               });
+    m_cubeUniform->m_aspect = m_sceneView->getAspect();
+    m_layoutUniform->m_aspect = m_layoutView->getAspect();
+  }
+  m_rebuild = true;
+}
+
+/**
+ * @brief The part of the window the orbit view covers
+ */
+VkRect2D AssimpModel::getSceneRect() const {
+  if (m_sceneView) return m_sceneView->getRect();
+  return vks::initializers::rect2D(m_width, m_height, 0, 0);
+}
+
+/**
+ * @brief Fits the shadow map to the model before the command buffers are
+ * brought up to date
+ */
+void AssimpModel::updateCommand() {
+  updateShadowMapSize();
+  ThirdPersonEngine::updateCommand();
+}
+
+/**
+ * @brief Marks the scene and the shadow pass for recording again
+ *
+ * Anything that makes the scene need recording again (geometry moving in the
+ * arena, transforms, newly built pipelines) can change the shadow map too, so
+ * it is marked for rendering.
+ */
+void AssimpModel::buildCommandBuffers() {
+  uint32_t frameCount = static_cast<uint32_t>(m_drawCmdBuffers.size());
+  if (!m_sceneTimer || m_sceneTimer->getFrameCount() != frameCount) {
+    delete_ptr(m_sceneTimer);
+    m_sceneTimer = new VulkanGpuTimer(
+        m_vulkanDevice, m_vulkanDevice->queueFamilyIndices.graphics,
+        frameCount);
+  }
+  m_recordedFilters.resize(frameCount, SHADOW_UNTIMED);
+  // every image culls into commands of its own
+  m_assimpObject->setFrameCount(frameCount);
+  m_pickDirty = true;
+  ThirdPersonEngine::buildCommandBuffers();
+  // the views were sized for the window, which may have been resized
+  if (m_splitView) {
+    m_cubeUniform->m_aspect = m_sceneView->getAspect();
+    m_layoutUniform->m_aspect = m_layoutView->getAspect();
+  }
+  if (m_shadowCmdBuffers.size() != m_drawCmdBuffers.size()) {
+    // the number of swap chain images changed, and every frame is done
+    if (!m_shadowCmdBuffers.empty())
+      vkFreeCommandBuffers(m_device, m_cmdPool,
+                           static_cast<uint32_t>(m_shadowCmdBuffers.size()),
+                           m_shadowCmdBuffers.data());
+    m_shadowCmdBuffers.resize(m_drawCmdBuffers.size());
+    VkCommandBufferAllocateInfo allocateInfo =
+        vks::initializers::commandBufferAllocateInfo(
+            m_cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            static_cast<uint32_t>(m_shadowCmdBuffers.size()));
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(m_device, &allocateInfo,
+                                             m_shadowCmdBuffers.data()));
+  }
+  m_shadowDirty = true;
+}
+
+/**
+ * @brief Counts the image's last frame against the filter it was recorded
+ * with, before the image is recorded again
+ */
+void AssimpModel::frameCompleted() {
+  float milliseconds = 0.f;
+  if (m_sceneTimer->collect(m_currentBuffer, milliseconds) &&
+      m_recordedFilters[m_currentBuffer] != SHADOW_UNTIMED) {
+    float& cost = m_shadowFilterCost[m_recordedFilters[m_currentBuffer]];
+    cost = cost == 0.f ? milliseconds : cost * 0.95f + milliseconds * 0.05f;
+  }
+  ThirdPersonEngine::frameCompleted();
+}
+
+/**
+ * @brief Records an image's scene, then its shadow pass into a command
+ * buffer of its own
+ *
+ * @param frame - The swap chain image, whose fence has been waited on
+ */
+void AssimpModel::recordCommandBuffer(uint32_t frame) {
+  // until the filter's variant is built the previous one draws, and its
+  // time would be counted against the wrong filter
+  m_cubeShader->getPipeline();
+  m_recordedFilters[frame] =
+      m_cubeShader->isPipelinePending() ? SHADOW_UNTIMED : m_shadowFilter;
+  ThirdPersonEngine::recordCommandBuffer(frame);
+  // the shadow pass reads the light's uniforms from the same ring slot
+  VkCommandBufferBeginInfo cmdBufInfo =
+      vks::initializers::commandBufferBeginInfo();
+  VK_CHECK_RESULT(vkBeginCommandBuffer(m_shadowCmdBuffers[frame], &cmdBufInfo));
+  recordShadowPass(m_shadowCmdBuffers[frame]);
+  VK_CHECK_RESULT(vkEndCommandBuffer(m_shadowCmdBuffers[frame]));
+}
+
+void AssimpModel::buildCommandBuffersBeforeMainRenderPass(
+    VkCommandBuffer& cmd) {
+  m_sceneTimer->begin(cmd, m_recordingBuffer);
+}
+
+void AssimpModel::buildCommandBuffersAfterMainRenderPass(VkCommandBuffer& cmd) {
+  m_sceneTimer->end(cmd, m_recordingBuffer);
 }
 
 void AssimpModel::setDescriptorSet() {
+  // set 0: per frame
+  m_vulkanDescriptorSet->addBinding(0, m_cubeUniform.get(),
+                                    VK_SHADER_STAGE_VERTEX_BIT, 0);
+  m_vulkanDescriptorSet->addBinding(1, m_shadowCamera.get(),
+                                    VK_SHADER_STAGE_VERTEX_BIT, 0);
   m_vulkanDescriptorSet->addBinding(
-      0, &(m_cubeUniform->m_uniformBuffer.descriptor),
-      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0);
-  m_vulkanDescriptorSet->addBinding(1, &(m_cubeTextureA->descriptor),
-                                    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                    VK_SHADER_STAGE_FRAGMENT_BIT, 0);
-  m_vulkanDescriptorSet->addBinding(2, &(m_cubeTextureB->descriptor),
+      2, &(m_frameBuffer->getCompareDescriptor()),
+      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT,
+      0);
+  // the debug quad shows the depths themselves
+  m_vulkanDescriptorSet->addBinding(3, &(m_frameBuffer->getDescriptor()),
                                     VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                     VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+  m_vulkanDescriptorSet->addBinding(
+      4, &(m_assimpObject->getEdgeStateDescriptor()),
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+  m_vulkanDescriptorSet->addBinding(
+      5, &(m_frameBuffer->getNearestCompareDescriptor()),
+      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT,
+      0);
+  // the split view's layout view: the same, seen from its own camera
+  m_vulkanDescriptorSet->addBinding(0, m_layoutUniform.get(),
+                                    VK_SHADER_STAGE_VERTEX_BIT, 1);
+  m_vulkanDescriptorSet->addBinding(1, m_shadowCamera.get(),
+                                    VK_SHADER_STAGE_VERTEX_BIT, 1);
+  m_vulkanDescriptorSet->addBinding(
+      2, &(m_frameBuffer->getCompareDescriptor()),
+      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT,
+      1);
   m_vulkanDescriptorSet->addBinding(3, &(m_frameBuffer->getDescriptor()),
                                     VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                    VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+                                    VK_SHADER_STAGE_FRAGMENT_BIT, 1);
   m_vulkanDescriptorSet->addBinding(
-      4, &(m_shadowCamera->m_uniformBuffer.descriptor),
-      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0);
-  m_vulkanDescriptorSet->GenPipelineLayout(&m_pipelineLayout);
+      4, &(m_assimpObject->getEdgeStateDescriptor()),
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
+  m_vulkanDescriptorSet->addBinding(
+      5, &(m_frameBuffer->getNearestCompareDescriptor()),
+      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT,
+      1);
+  m_vulkanDescriptorSet->build();
+
+  // set 1: every texture of the model, indexed per part
+  if (m_bindlessTextures) {
+    preparePipelineLayout({m_vulkanDescriptorSet->getLayout(),
+                           m_bindlessTextures->getLayout()});
+    return;
+  }
+
+  // set 1: the model's material
+  m_materialDescriptorSet = new VulkanDescriptorSet(
+      m_device, m_descriptorLayoutCache, m_descriptorAllocator,
+      VulkanDescriptorSet::PER_MATERIAL);
+  m_materialDescriptorSet->addBinding(0, &(m_cubeTextureA->descriptor),
+                                      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                      VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+  m_materialDescriptorSet->addBinding(1, &(m_cubeTextureB->descriptor),
+                                      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                      VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+  m_materialDescriptorSet->build();
+  m_assimpObject->setMaterial(m_materialDescriptorSet);
+
+  preparePipelineLayout({m_vulkanDescriptorSet->getLayout(),
+                         m_materialDescriptorSet->getLayout()});
 }
 
 void AssimpModel::createPipelines() {
   m_pipelines->createBasePipelineInfo(m_pipelineLayout, m_renderPass);
   m_pipelines->createPipeline(m_cubeShader);
-  m_pipelines->createPipeline(m_lineShader, VK_POLYGON_MODE_LINE);
+  m_pipelines->createPipeline(m_edgeShader);
   m_pipelines->createPipeline(m_debugShader);
   m_pipelines->createPipeline(m_shadowShader,
                               m_frameBuffer->getRenderPass()->get());
+  if (m_picker)
+    m_pipelines->createPipeline(m_pickShader, m_picker->getRenderPass());
 }
 
 void AssimpModel::createCube() {
+  // shared with the other windows, which load the same files
+  m_cubeTextureA = m_deviceContext->loadTexture(
+      "/Users/evan/Desktop/evan/paperarium/paperarium-designer/test/textures/"
+      "sobj_hnw_rent.png",
+      VK_FORMAT_R8G8B8A8_UNORM);
+
+  m_cubeTextureB = m_deviceContext->loadTexture(
+      "/Users/evan/Desktop/evan/paperarium/paperarium-designer/test/textures/"
+      "container.png",
+      VK_FORMAT_R8G8B8A8_UNORM);
+
   REGISTER_OBJECT<AssimpObject>(m_assimpObject);
   m_assimpObject->setModelPath(
       "/Users/evan/Desktop/evan/paperarium/paperarium-designer/test/models/"
       "lloid.obj");
+  if (m_capabilities.descriptorIndexing) {
+    // parts without a texture of their own fall back to texture A
+    m_bindlessTextures =
+        new VulkanBindlessTextures(m_vulkanDevice, m_descriptorLayoutCache);
+    uint32_t defaultTexture =
+        m_bindlessTextures->addTexture(m_cubeTextureA->descriptor);
+    m_assimpObject->setBindless(m_bindlessTextures, defaultTexture,
+                                m_capabilities.multiDrawIndirect);
+  }
   m_assimpObject->prepare();
 
   REGISTER_OBJECT<VulkanVertFragShader>(m_cubeShader);
-  m_cubeShader->setShaderObjPath(":/shaders/02_assimpmodel/scene.vert.spv",
-                                 ":/shaders/02_assimpmodel/scene.frag.spv");
+  m_cubeShader->setShaderObjPath(
+      ":/shaders/02_assimpmodel/scene.vert.spv",
+      m_bindlessTextures ? ":/shaders/02_assimpmodel/scene_bindless.frag.spv"
+                         : ":/shaders/02_assimpmodel/scene.frag.spv");
   m_cubeShader->setCullFlag(VK_CULL_MODE_NONE);
   m_cubeShader->setFrontFace(VK_FRONT_FACE_CLOCKWISE);
+  applyPerformanceTier(m_capabilities.performanceTier);
   m_cubeShader->prepare();
 
-  REGISTER_OBJECT<VulkanVertFragShader>(m_lineShader);
-  m_lineShader->setShaderObjPath(":/shaders/02_assimpmodel/line.vert.spv",
-                                 ":/shaders/02_assimpmodel/line.frag.spv");
-  m_lineShader->setCullFlag(VK_CULL_MODE_NONE);
-  m_lineShader->setFrontFace(VK_FRONT_FACE_CLOCKWISE);
-  m_lineShader->prepare();
+  // edge states are found by primitive id, without it edges are plain
+  REGISTER_OBJECT<VulkanVertFragShader>(m_edgeShader);
+  m_edgeShader->setShaderObjPath(
+      ":/shaders/02_assimpmodel/line.vert.spv",
+      m_capabilities.primitiveId ? ":/shaders/02_assimpmodel/edge.frag.spv"
+                                 : ":/shaders/02_assimpmodel/line.frag.spv");
+  m_edgeShader->setTopology(VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
+  m_edgeShader->setCullFlag(VK_CULL_MODE_NONE);
+  m_edgeShader->prepare();
 
   REGISTER_OBJECT<UniformCamera>(m_cubeUniform);
   m_cubeUniform->m_uboVS.lightpos = glm::vec4(10.0f, -10.0f, 10.0f, 1.0f);
@@ -87,24 +408,26 @@ void AssimpModel::createCube() {
   m_cubeUniform->m_pZoom = &m_camera.m_zoom;
   m_cubeUniform->prepare();
 
-  REGISTER_OBJECT<VulkanTexture2D>(m_cubeTextureA);
-  m_cubeTextureA->loadFromFile(
-      "/Users/evan/Desktop/evan/paperarium/paperarium-designer/test/textures/"
-      "sobj_hnw_rent.png",
-      VK_FORMAT_R8G8B8A8_UNORM);
-
-  REGISTER_OBJECT<VulkanTexture2D>(m_cubeTextureB);
-  m_cubeTextureB->loadFromFile(
-      "/Users/evan/Desktop/evan/paperarium/paperarium-designer/test/textures/"
-      "container.png",
-      VK_FORMAT_R8G8B8A8_UNORM);
+  REGISTER_OBJECT<UniformCamera>(m_layoutUniform);
+  m_layoutUniform->m_uboVS.lightpos = m_cubeUniform->m_uboVS.lightpos;
+  m_layoutUniform->m_pCameraPos = m_assimpObject->getCenter();
+  m_layoutUniform->m_pRotation = &m_layoutCamera.m_rotation;
+  m_layoutUniform->m_pZoom = &m_layoutCamera.m_zoom;
+  m_layoutUniform->m_pPan = &m_layoutCamera.m_pan;
+  m_layoutUniform->m_orthographic = true;
+  m_layoutUniform->prepare();
 }
 
 void AssimpModel::createShadowFrameBuffer() {
   m_frameBuffer = std::make_shared<VulkanFrameBuffer>();
   m_frameBuffer->setVulkanDevice(m_vulkanDevice);
   m_frameBuffer->setFormat(VK_FORMAT_D16_UNORM);
-  m_frameBuffer->setSize(4096, 4096);
+  // shared with the other windows, along with the shadow pipeline
+  m_frameBuffer->setRenderPass(
+      m_deviceContext->getRenderPassCache()->get(
+          VulkanRenderPassCache::Type::DEPTH, VK_FORMAT_D16_UNORM));
+  int size = chooseShadowMapSize();
+  m_frameBuffer->setSize(size, size);
   m_frameBuffer->createWithDepth();
 
   REGISTER_OBJECT<VulkanVertFragShader>(m_shadowShader);
@@ -117,6 +440,8 @@ void AssimpModel::createShadowFrameBuffer() {
 
   REGISTER_OBJECT<ShadowCamera>(m_shadowCamera);
   m_shadowCamera->m_lightPos = m_cubeUniform->m_uboVS.lightpos;
+  auto const& bounds = m_assimpObject->getBounds();
+  m_shadowCamera->setBounds(bounds.min, bounds.max);
   m_shadowCamera->prepare();
 }
 
@@ -132,8 +457,55 @@ void AssimpModel::createDebugQuad() {
   m_debugShader->prepare();
 }
 
-void AssimpModel::buildCommandBuffersBeforeMainRenderPass(
-    VkCommandBuffer& cmd) {
+void AssimpModel::createPicker() {
+  if (!m_capabilities.primitiveId) return;
+  m_picker = new VulkanPicker(m_vulkanDevice, m_queue, m_cmdPool,
+                              m_deviceContext->getRenderPassCache());
+  m_picker->resize(m_width, m_height);
+
+  REGISTER_OBJECT<VulkanVertFragShader>(m_pickShader);
+  m_pickShader->setShaderObjPath(":/shaders/02_assimpmodel/pick.vert.spv",
+                                 ":/shaders/02_assimpmodel/pick.frag.spv");
+  m_pickShader->setCullFlag(VK_CULL_MODE_NONE);
+  m_pickShader->setFrontFace(VK_FRONT_FACE_CLOCKWISE);
+  // integer attachments can't be blended
+  m_pickShader->setBlendEnable(false);
+  m_pickShader->prepare();
+}
+
+/**
+ * @brief Reads back what is under the cursor, drawing the ids again first if
+ * the view or the scene changed
+ *
+ * Only the orbit view is picked; in the split view, the ids cover its part
+ * of the window. The result arrives a frame later, read from
+ * m_picker->getResult().
+ */
+void AssimpModel::updatePicking() {
+  if (!m_picker) return;
+  VkRect2D rect = getSceneRect();
+  m_picker->resize(rect.extent.width, rect.extent.height);
+  glm::mat4 const& view = m_cubeUniform->m_uboVS.modelViewProjection;
+  if (view != m_pickView) {
+    m_pickView = view;
+    m_pickDirty = true;
+  }
+  // ids drawn before the pipeline is built would all be 0
+  bool redraw = m_pickDirty && m_pickShader->getPipeline() != VK_NULL_HANDLE;
+  // the pass reads the camera from this frame's slot of the uniform ring
+  m_recordingBuffer = m_currentBuffer;
+  glm::vec2 mouse = m_mousePos - glm::vec2(rect.offset.x, rect.offset.y);
+  bool submitted =
+      m_picker->pick(mouse, redraw, [this](VkCommandBuffer cmd) {
+        bindDescriptorSets(cmd);
+        m_geometryArena->bind(cmd);
+        // a single draw, so primitive ids count the whole mesh's triangles
+        m_assimpObject->MeshObject::build(cmd, m_pickShader.get());
+      });
+  if (submitted && redraw) m_pickDirty = false;
+}
+
+void AssimpModel::recordShadowPass(VkCommandBuffer& cmd) {
   VkClearValue clearValues[2];
   clearValues[0].depthStencil = {1.0f, 0};
 
@@ -169,21 +541,183 @@ void AssimpModel::buildCommandBuffersBeforeMainRenderPass(
   vkCmdSetDepthBias(cmd, depthBiasConstant, 0.0f, depthBiasSlope);
 
   // bind the descriptor sets
-  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          m_pipelineLayout, 0, 1,
-                          &(m_vulkanDescriptorSet->get(0)), 0, NULL);
+  bindDescriptorSets(cmd);
+  m_geometryArena->bind(cmd);
   // attach the ASSIMP object to the scene
-  m_assimpObject->build(cmd, m_shadowShader);
+  m_assimpObject->build(cmd, m_shadowShader.get(), m_recordingBuffer,
+                        AssimpObject::CULL_SHADOW);
   vkCmdEndRenderPass(cmd);
 }
 
+/**
+ * @brief Picks the shadow map's size from the quality setting and how large
+ * the model is on screen
+ *
+ * The light's frustum is fitted to the model, so about one texel per screen
+ * pixel the model covers is enough. Sizes are powers of two, capped at 1024
+ * on low quality, 2048 on medium and 4096 on high.
+ */
+int AssimpModel::chooseShadowMapSize() const {
+  int maxSize = maxShadowMapSize(m_quality);
+  auto const& bounds = m_assimpObject->getBounds();
+  glm::mat4 const& mvp = m_cubeUniform->m_uboVS.modelViewProjection;
+  glm::vec2 ndcMin(FLT_MAX);
+  glm::vec2 ndcMax(-FLT_MAX);
+  bool behindCamera = false;
+  for (int i = 0; i < 8; i++) {
+    glm::vec4 clip = mvp * glm::vec4((i & 1) ? bounds.max.x : bounds.min.x,
+                                     (i & 2) ? bounds.max.y : bounds.min.y,
+                                     (i & 4) ? bounds.max.z : bounds.min.z,
+                                     1.f);
+    if (clip.w <= 0.f) {
+      behindCamera = true;
+      break;
+    }
+    glm::vec2 ndc = glm::vec2(clip) / clip.w;
+    ndcMin = glm::min(ndcMin, ndc);
+    ndcMax = glm::max(ndcMax, ndc);
+  }
+  // the model can't cover more than the screen
+  float screen = static_cast<float>(std::max(m_width, m_height));
+  float pixels = screen;
+  if (!behindCamera) {
+    glm::vec2 extent = (ndcMax - ndcMin) * 0.5f;
+    pixels = std::min(screen, std::max(extent.x * m_width,
+                                       extent.y * m_height));
+  }
+  int size = MIN_SHADOW_MAP_SIZE;
+  while (size < pixels && size < maxSize) size *= 2;
+  return std::min(size, maxSize);
+}
+
+/**
+ * @brief Reallocates the shadow map when the model's size on screen or the
+ * quality setting calls for another size
+ *
+ * It only shrinks once it is four times too large, so zooming back and forth
+ * across a size doesn't reallocate it every frame. The render pass and
+ * samplers survive the reallocation, so the shadow pipeline does too. Frames
+ * in flight may still sample the old map through the scene's sets, so both
+ * are retired rather than idling the queue: the map moves to new sets and
+ * the command buffers are recorded again.
+ */
+void AssimpModel::updateShadowMapSize() {
+  int size = chooseShadowMapSize();
+  int current = m_frameBuffer->getWidth();
+  if (size == current) return;
+  if (size < current && size * 4 > current &&
+      current <= maxShadowMapSize(m_quality))
+    return;
+  m_frameBuffer->resizeDepth(size, size, &m_retireQueue);
+  // the sets point at the frame buffer's descriptors, which now hold the new
+  // image view
+  VulkanDescriptorSet* descriptorSet = m_vulkanDescriptorSet;
+  std::vector<VkDescriptorSet> replaced = descriptorSet->reallocate();
+  m_retireQueue.retire(
+      [descriptorSet, replaced]() { descriptorSet->recycle(replaced); });
+  LOGI("AssimpModel|updateShadowMapSize| %dx%d", size, size);
+  m_rebuild = true;
+}
+
 void AssimpModel::seeDebugQuad() {
   m_seeDebug = !m_seeDebug;
   m_rebuild = true;
 }
 
-// void AssimpModel::OnUpdateUIOverlay(vks::UIOverlay* overlay) {
-//   // if (m_UIOverlay.button(""))
-// }
+/**
+ * @brief Picks the scene shader's variant for a performance tier
+ *
+ * Low drops shadows, specular and the second texture, medium filters shadows
+ * with four taps and high with a Poisson disk. Takes effect the next time
+ * the shader's pipeline is requested.
+ */
+void AssimpModel::applyPerformanceTier(PerformanceTier tier) {
+  m_quality = static_cast<int32_t>(tier);
+  bool low = tier == PerformanceTier::LOW;
+  applyShadowFilter(low                             ? SHADOW_OFF
+                    : tier == PerformanceTier::HIGH ? SHADOW_POISSON
+                                                    : SHADOW_FOUR_TAP);
+  m_cubeShader->setConstant(TEXTURE_BLEND, low ? 1 : 0);
+  m_cubeShader->setConstant(LIGHTING, low ? 0 : 1);
+}
+
+/**
+ * @brief Picks the scene shader's shadow variant
+ *
+ * Hard shadows are a single unfiltered compare. The filtered ones take taps
+ * the hardware filters from four depth compares each. Takes effect the next
+ * time the shader's pipeline is requested.
+ */
+void AssimpModel::applyShadowFilter(int32_t filter) {
+  m_shadowFilter = filter;
+  m_cubeShader->setConstant(SHADOWS, filter != SHADOW_OFF ? VK_TRUE : VK_FALSE);
+  if (filter != SHADOW_OFF)
+    m_cubeShader->setConstant(SHADOW_FILTER,
+                              static_cast<uint32_t>(filter - SHADOW_HARD));
+}
+
+void AssimpModel::OnUpdateUIOverlay(vks::UIOverlay* overlay) {
+  // every variant stays in the pipeline map, so switching back is free
+  if (overlay->comboBox("Quality", &m_quality, {"Low", "Medium", "High"})) {
+    applyPerformanceTier(static_cast<PerformanceTier>(m_quality));
+    m_pipelines->recreatePipeline(m_cubeShader.get());
+    m_rebuild = true;
+  }
+  std::vector<std::string> filters = {"Off", "Hard", "4-tap PCF",
+                                      "Poisson PCF"};
+  if (overlay->comboBox("Shadows", &m_shadowFilter, filters)) {
+    applyShadowFilter(m_shadowFilter);
+    m_pipelines->recreatePipeline(m_cubeShader.get());
+    m_rebuild = true;
+  }
+  // GPU time of the main pass with each filter that has been drawn
+  if (m_sceneTimer && m_sceneTimer->isSupported()) {
+    for (int32_t i = 0; i < SHADOW_FILTER_COUNT; i++) {
+      if (m_shadowFilterCost[i] == 0.f) continue;
+      overlay->text("%s: %.3f ms", filters[i].c_str(), m_shadowFilterCost[i]);
+    }
+  }
+  overlay->text("Parts drawn: %u / %u, shadow %u",
+                m_visibleParts[AssimpObject::CULL_CAMERA],
+                m_assimpObject->getPartCount(),
+                m_visibleParts[AssimpObject::CULL_SHADOW]);
+  if (overlay->checkBox("Split view", &m_splitView))
+    setSplitView(m_splitView);
+  if (m_picker) {
+    VulkanPicker::Result const& hover = m_picker->getResult();
+    static char const* const states[] = {"flat", "cut", "mountain", "valley"};
+    // within a pick texel and a half of another face, its edge is hovered
+    uint32_t edge = AssimpObject::INVALID_EDGE;
+    if (hover.id != 0 && hover.neighborId != 0 &&
+        hover.neighborDistance <= 1.5f)
+      edge = m_assimpObject->getEdgeOfTriangles(hover.id - 1,
+                                                hover.neighborId - 1);
+    if (edge != AssimpObject::INVALID_EDGE) {
+      overlay->text(
+          "Edge: faces %u and %u, %s", hover.id - 1, hover.neighborId - 1,
+          states[static_cast<int>(m_assimpObject->getEdgeState(edge))]);
+    } else if (hover.id != 0) {
+      overlay->text("Face: %u (part %u)", hover.id - 1,
+                    m_assimpObject->getPartOfTriangle(hover.id - 1));
+    }
+  }
+  // without the ID pass, the face under the cursor comes from the BVH
+  ModelBVH::Hit hit;
+  if (!m_picker &&
+      m_assimpObject->getBVH().intersect(
+          getMouseRay(m_cubeUniform->m_uboVS.modelViewProjection,
+                      getSceneRect()),
+          hit)) {
+    overlay->text("Face: %u (part %u)", hit.triangle,
+                  m_assimpObject->getPartOfTriangle(hit.triangle));
+  }
+  if (overlay->checkBox("Edges", &m_showEdges)) m_rebuild = true;
+  if (!m_capabilities.wireframe) return;
+  if (overlay->checkBox("Wireframe", &m_wireframe)) {
+    m_pipelines->createPipeline(
+        m_cubeShader, m_wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL);
+    m_rebuild = true;
+  }
+}
 
 }  // namespace VulkanEngine
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "03_instancing/InstancingBenchmark.h"
+
+#include <chrono>
+
+namespace VulkanEngine {
+
+InstancingBenchmark::~InstancingBenchmark() noexcept {
+  destroyObjects();
+  delete_ptr(m_instances);
+}
+
+void InstancingBenchmark::prepareMyObjects() {
+  m_camera.m_zoom = -40.f;
+  m_camera.m_rotation.x = -45.f;
+  createCubes();
+  setDescriptorSet();
+  createPipelines();
+}
+
+void InstancingBenchmark::buildMyObjects(VkCommandBuffer& cmd) {
+  if (m_instanced) {
+    m_cube->buildInstanced(cmd, m_instancedShader, m_instances);
+    return;
+  }
+  // one draw per cube, each placed by its own push constant
+  if (!m_shader->getPipeline()) return;
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    m_shader->getPipeline());
+  for (auto const& transform : m_transforms) {
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                       sizeof(glm::mat4), &transform);
+    m_geometryArena->draw(cmd, m_cube->m_mesh);
+  }
+}
+
+/**
+ * @brief Times the recording of a frame's command buffer for the overlay
+ *
+ * @param frame - The swap chain image being recorded
+ */
+void InstancingBenchmark::recordCommandBuffer(uint32_t frame) {
+  auto start = std::chrono::high_resolution_clock::now();
+  ThirdPersonEngine::recordCommandBuffer(frame);
+  auto end = std::chrono::high_resolution_clock::now();
+  m_recordTime =
+      std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void InstancingBenchmark::render() {
+  updateCamera();
+  m_uniform->update();
+}
+
+void InstancingBenchmark::OnUpdateUIOverlay(vks::UIOverlay* overlay) {
+  overlay->text("%u cubes", static_cast<uint32_t>(m_transforms.size()));
+  overlay->checkBox("Instanced", &m_instanced);
+  overlay->text("Record: %.2f ms", m_recordTime);
+}
+
+void InstancingBenchmark::createCubes() {
+  REGISTER_OBJECT<VulkanCube>(m_cube);
+  m_cube->setSize(0.1f, 0.1f, 0.1f);
+  m_cube->prepare();
+
+  // a grid of cubes, each with its own turn and height
+  float const spacing = 0.3f;
+  float const offset = spacing * (GRID_SIZE - 1) * 0.5f;
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+  for (uint32_t x = 0; x < GRID_SIZE; x++) {
+    for (uint32_t z = 0; z < GRID_SIZE; z++) {
+      glm::mat4 transform = glm::translate(
+          glm::mat4(1.f), glm::vec3(x * spacing - offset, unit(random) * 0.5f,
+                                    z * spacing - offset));
+      transform = glm::rotate(transform, glm::radians(unit(random) * 360.f),
+                              glm::vec3(0.f, 1.f, 0.f));
+      m_transforms.push_back(transform);
+    }
+  }
+  m_instances = new VulkanInstanceBuffer(m_vulkanDevice, m_queue);
+  m_instances->setTransforms(m_transforms);
+
+  REGISTER_OBJECT<VulkanVertFragShader>(m_shader);
+  m_shader->setShaderObjPath(":/shaders/03_instancing/cube.vert.spv",
+                             ":/shaders/03_instancing/cube.frag.spv");
+  m_shader->setCullFlag(VK_CULL_MODE_NONE);
+  m_shader->prepare();
+
+  REGISTER_OBJECT<VulkanVertFragShader>(m_instancedShader);
+  m_instancedShader->setShaderObjPath(
+      ":/shaders/03_instancing/cube_instanced.vert.spv",
+      ":/shaders/03_instancing/cube.frag.spv");
+  m_instancedShader->setCullFlag(VK_CULL_MODE_NONE);
+  m_instancedShader->setVertexInputState(
+      m_instancedVertexDescriptions->m_inputState);
+  m_instancedShader->prepare();
+
+  REGISTER_OBJECT<UniformCamera>(m_uniform);
+  m_uniform->m_uboVS.lightpos = glm::vec4(10.0f, -10.0f, 10.0f, 1.0f);
+  m_uniform->m_pCameraPos = &m_camera.m_cameraPos;
+  m_uniform->m_pRotation = &m_camera.m_rotation;
+  m_uniform->m_pZoom = &m_camera.m_zoom;
+  m_uniform->prepare();
+}
+
+void InstancingBenchmark::setDescriptorSet() {
+  m_vulkanDescriptorSet->addBinding(0, m_uniform.get(),
+                                    VK_SHADER_STAGE_VERTEX_BIT, 0);
+  m_vulkanDescriptorSet->build();
+  preparePipelineLayout({m_vulkanDescriptorSet->getLayout()});
+}
+
+void InstancingBenchmark::createPipelines() {
+  m_pipelines->createBasePipelineInfo(m_pipelineLayout, m_renderPass);
+  m_pipelines->createPipeline(m_shader);
+  m_pipelines->createPipeline(m_instancedShader);
+}
+
+}  // namespace VulkanEngine
@@ -6,18 +6,62 @@ namespace VulkanEngine {
 /**
  * @brief Update the camera based on mouse input
  */
-void ThirdPersonEngine::updateCamera() {
-  if (m_mouseButtons.left) {
-    m_camera.m_rotation.y +=
+void ThirdPersonEngine::updateCamera() { updateCamera(m_camera); }
+
+/**
+ * @brief Update a camera based on mouse input, for engines with more than one
+ *
+ * Dragging orbits the camera, or with a pan scale moves the view across the
+ * screen, which suits orthographic views.
+ *
+ * @param camera
+ * @param panScale - View units moved per pixel dragged, 0 to orbit instead
+ */
+void ThirdPersonEngine::updateCamera(ThirdPersonCamera& camera,
+                                     float panScale) {
+  if (m_mouseButtons.left && panScale > 0.f) {
+    camera.m_pan += (m_mousePos - m_mousePosOld) * panScale;
+  } else if (m_mouseButtons.left) {
+    camera.m_rotation.y +=
         (m_mousePos.x - m_mousePosOld.x) / m_viewportSensitivity;
-    m_camera.m_rotation.x +=
+    camera.m_rotation.x +=
         (m_mousePos.y - m_mousePosOld.y) / m_viewportSensitivity;
   }
   m_distance += m_scroll / m_scrollSensitivity;
-  m_camera.m_zoom += m_distance;
+  camera.m_zoom += m_distance;
   m_distance = 0.f;
   m_scroll = 0.f;
   m_mousePosOld = m_mousePos;
 }
 
+/**
+ * @brief The ray from the camera through the mouse cursor
+ *
+ * @param modelViewProjection - Of the model to cast into, which puts the ray
+ * in the model's space
+ * @return ModelBVH::Ray
+ */
+ModelBVH::Ray ThirdPersonEngine::getMouseRay(
+    glm::mat4 const& modelViewProjection) const {
+  return getMouseRay(modelViewProjection,
+                     vks::initializers::rect2D(m_width, m_height, 0, 0));
+}
+
+/**
+ * @brief The ray from the camera through the mouse cursor, for a camera
+ * drawn into part of the window
+ *
+ * @param modelViewProjection - Of the model to cast into
+ * @param region - The part of the window the camera's view covers
+ * @return ModelBVH::Ray
+ */
+ModelBVH::Ray ThirdPersonEngine::getMouseRay(
+    glm::mat4 const& modelViewProjection, VkRect2D const& region) const {
+  return ModelBVH::Ray::fromScreen(
+      m_mousePos - glm::vec2(region.offset.x, region.offset.y),
+      glm::vec2(static_cast<float>(region.extent.width),
+                static_cast<float>(region.extent.height)),
+      modelViewProjection);
+}
+
 }  // namespace VulkanEngine
\ No newline at end of file
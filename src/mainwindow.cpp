@@ -30,6 +30,12 @@ MainWindow::MainWindow(QWidget *parent)
     vulkanWidget->setMouseTracking(true);
     ui->horizontalLayout->addWidget(vulkanWidget);
     vulkanWidget->show();
+
+    // another window on the same model, rendering with the same device
+    QAction* newWindowAction = ui->menuFile->addAction(tr("New Window"));
+    newWindowAction->setShortcut(QKeySequence::New);
+    connect(newWindowAction, &QAction::triggered, this,
+            &MainWindow::openWindow);
 }
 
 MainWindow::~MainWindow()
@@ -37,3 +43,17 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+/**
+ * Opens another main window. Its Vulkan window joins the device context of
+ * the windows already open, so it shares their pipelines, textures and
+ * geometry, and is freed when closed.
+ *
+ * @brief MainWindow::openWindow
+ */
+void MainWindow::openWindow()
+{
+    MainWindow* window = new MainWindow();
+    window->setAttribute(Qt::WA_DeleteOnClose);
+    window->show();
+}
+
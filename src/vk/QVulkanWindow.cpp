@@ -1,9 +1,16 @@
 #include "QVulkanWindow.h"
+#include <QCoreApplication>
 #include "02_assimpmodel/AssimpModel.h"
+#include "03_instancing/InstancingBenchmark.h"
 
 QVulkanWindow::QVulkanWindow(QWidget* parent) : QWindow() {
   setSurfaceType(QSurface::VulkanSurface);
-  m_vulkan = std::make_unique<VulkanEngine::AssimpModel>();
+  // the model viewer, unless the instancing benchmark is asked for
+  if (QCoreApplication::arguments().contains("--instancing-benchmark")) {
+    m_vulkan = std::make_unique<VulkanEngine::InstancingBenchmark>();
+  } else {
+    m_vulkan = std::make_unique<VulkanEngine::AssimpModel>();
+  }
   m_vulkan->setWindow(winId());
 }
 
@@ -54,7 +61,6 @@ void QVulkanWindow::showEvent(QShowEvent* event) {
 }
 
 void QVulkanWindow::resizeEvent(QResizeEvent* event) {
-  m_vulkan->m_destWidth = width();
-  m_vulkan->m_destHeight = height();
+  m_vulkan->requestResize(width(), height());
   QWindow::resizeEvent(event);
 }
@@ -14,263 +14,52 @@
 
 namespace VulkanEngine {
 
+namespace {
+
+// how long the window has to keep its size before the swap chain follows it
+constexpr std::chrono::milliseconds RESIZE_DEBOUNCE(100);
+// depth stencils of previous window sizes kept for reuse
+constexpr size_t MAX_POOLED_DEPTH_STENCILS = 3;
+
+}  // namespace
+
 /* -------------------------------------------------------------------------- */
 /*                            VULKAN INITIALIZATION                           */
 /* -------------------------------------------------------------------------- */
 // Process:
-//   1. createInstance
-//   2. pickPhysicalDevice
-//   3. createLogicalDevice
+//   1. acquire the process's device context
+//   2. connect the swap chain
 
 /**
  * @brief Initializes the Vulkan instance
  *
- * Creates the instance and picks a physical device to use for Vulkan, reading
- * it as a logical device so we can easily access information about it.
+ * Gets the instance and device shared by every window, creating them if this
+ * is the first window, and creates what this window submits with.
  */
 void VulkanBase::initVulkan() {
-  createInstance();
-  pickPhysicalDevice();
-  createLogicalDevice();
-}
-
-/* ----------------------------- IMPLEMENTATION ----------------------------- */
-
-/**
- * @brief Builds the Vulkan instance itself
- *
- * Applies platform-specific extensions as well as validation layers (if we
- * are using debug mode) that enable easy cross-platform Vulkan development.
- */
-void VulkanBase::createInstance() {
-  VkApplicationInfo appInfo = {};
-  appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-  appInfo.pApplicationName = "Paperarium Design";
-  appInfo.pEngineName = "Paperarium Design";
-  appInfo.apiVersion = VK_API_VERSION_1_0;
-  std::vector<char const*> instanceExtensions = {VK_KHR_SURFACE_EXTENSION_NAME};
-
-  // enable surface extensions depending on OS
-#if defined(_WIN32)
-  instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
-#elif defined(_DIRECT2DISPLAY)
-  instanceExtensions.push_back(VK_KHR_DISPLAY_EXTENSION_NAME);
-#elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
-  instanceExtensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
-#elif defined(VK_USE_PLATFORM_XCB_KHR)
-  instanceExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
-#elif defined(VK_USE_PLATFORM_MACOS_MVK)
-  instanceExtensions.push_back(VK_MVK_MACOS_SURFACE_EXTENSION_NAME);
-#elif defined(VK_USE_PLATFORM_HEADLESS_EXT)
-  instanceExtensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
-#endif
-
-  // get extensions supported by the instance and store for later use
-  uint32_t extCount = 0;
-  vkEnumerateInstanceExtensionProperties(nullptr, &extCount, nullptr);
-  if (extCount > 0) {
-    std::vector<VkExtensionProperties> extensions(extCount);
-    if (vkEnumerateInstanceExtensionProperties(
-            nullptr, &extCount, &extensions.front()) == VK_SUCCESS) {
-      for (VkExtensionProperties extension : extensions) {
-        m_supportedInstanceExtensions.push_back(extension.extensionName);
-      }
-    }
-  }
-
-  // SRS - When running on iOS/macOS with MoltenVK, enable
-  // VK_KHR_get_physical_device_properties2 if not already enabled
-  // (required by VK_KHR_portability_subset)
-#if defined(VK_USE_PLATFORM_MACOS_MVK)
-  if (std::find(m_enabledInstanceExtensions.begin(),
-                m_enabledInstanceExtensions.end(),
-                VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) ==
-      m_enabledInstanceExtensions.end()) {
-    m_enabledInstanceExtensions.push_back(
-        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
-  }
-#endif
-
-  // enable requested instance extensions
-  if (m_enabledInstanceExtensions.size() > 0) {
-    for (char const* enabledExtension : m_enabledInstanceExtensions) {
-      instanceExtensions.push_back(enabledExtension);
-    }
-  }
-
-  // build the Vulkan instance create struct
-  VkInstanceCreateInfo instanceCreateInfo = {};
-  instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-  instanceCreateInfo.pNext = NULL;
-  instanceCreateInfo.pApplicationInfo = &appInfo;
-
-#if defined(VK_USE_PLATFORM_MACOS_MVK)
-  // SRS - When running on iOS/macOS with MoltenVK and
-  // VK_KHR_portability_enumeration is defined and supported by the instance,
-  // enable the extension and the flag
-  if (std::find(m_supportedInstanceExtensions.begin(),
-                m_supportedInstanceExtensions.end(),
-                VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME) !=
-      m_supportedInstanceExtensions.end()) {
-    instanceExtensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
-    instanceCreateInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
-  }
-#endif
-
-  // add extensions
-  if (instanceExtensions.size() > 0) {
-    if (m_debug) {
-      instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-      instanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
-    }
-    instanceCreateInfo.enabledExtensionCount =
-        (uint32_t)instanceExtensions.size();
-    instanceCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
-  }
-  // if debugging, add validation layer
-  if (m_debug) {
-    // the VK_LAYER_KHRONOS_validation contains all current validation
-    // functionality
-    char const* validationLayerName = "VK_LAYER_KHRONOS_validation";
-    // check if this layer is available at instance level
-    uint32_t instanceLayerCount;
-    vkEnumerateInstanceLayerProperties(&instanceLayerCount, nullptr);
-    std::vector<VkLayerProperties> instanceLayerProperties(instanceLayerCount);
-    vkEnumerateInstanceLayerProperties(&instanceLayerCount,
-                                       instanceLayerProperties.data());
-    bool validationLayerPresent = false;
-    for (VkLayerProperties layer : instanceLayerProperties) {
-      if (strcmp(layer.layerName, validationLayerName) == 0) {
-        validationLayerPresent = true;
-        break;
-      }
-    }
-    // if the layer is available, add it to the instance
-    if (validationLayerPresent) {
-      instanceCreateInfo.ppEnabledLayerNames = &validationLayerName;
-      instanceCreateInfo.enabledLayerCount = 1;
-    } else {
-      LOGI(
-          "Validation layer VK_LAYER_KHRONOS_validation not present, "
-          "validation is disabled");
-    }
-  }
-  // finally, attempt to create the instance.
-  m_result = vkCreateInstance(&instanceCreateInfo, nullptr, &m_instance);
-  VK_CHECK_RESULT(m_result);
-}
-
-/**
- * @brief Selects a GPU to render the Vulkan instance with.
- *
- * Defaults to the first encountered device.
- */
-void VulkanBase::pickPhysicalDevice() {
-  uint32_t gpuCount = 0;
-  VK_CHECK_RESULT(vkEnumeratePhysicalDevices(m_instance, &gpuCount, nullptr));
-  assert(gpuCount > 0);
-  // enumerate Vulkan-capable devices
-  std::vector<VkPhysicalDevice> physicalDevices(gpuCount);
-  m_result =
-      vkEnumeratePhysicalDevices(m_instance, &gpuCount, physicalDevices.data());
-
-  // GPU selection
-
-  // select physical device to be used for the Vulkan instance.
-  // defaults to the first device unless specified by command line.
-  uint32_t selectedDevice = 0;
-  m_physicalDevice = physicalDevices[selectedDevice];
-
-  // store properties (including limits), features, and memory properties of
-  // the physical device
-  vkGetPhysicalDeviceProperties(m_physicalDevice, &m_deviceProperties);
-  vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_deviceFeatures);
-  vkGetPhysicalDeviceMemoryProperties(m_physicalDevice,
-                                      &m_deviceMemoryProperties);
-
-  // get extensions supported by the device and store for later use
-  uint32_t extCount = 0;
-  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extCount,
-                                       nullptr);
-  if (extCount > 0) {
-    std::vector<VkExtensionProperties> extensions(extCount);
-    if (vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr,
-                                             &extCount, &extensions.front()) ==
-        VK_SUCCESS) {
-      for (VkExtensionProperties extension : extensions) {
-        m_supportedDeviceExtensions.push_back(extension.extensionName);
-      }
-    }
-  }
-
-#if defined(VK_USE_PLATFORM_MACOS_MVK)
-  // SRS - When running on iOS/macOS with MoltenVK and VK_KHR_portability_subset
-  // is defined and supported by the instance, enable the extension
-  if (std::find(m_supportedDeviceExtensions.begin(),
-                m_supportedDeviceExtensions.end(),
-                "VK_KHR_portability_subset") !=
-      m_supportedInstanceExtensions.end()) {
-    m_enabledDeviceExtensions.push_back("VK_KHR_portability_subset");
-  }
-#endif
-
-  // we can override actual features to enable for logical device creation,
-  // if we want to do some testing.
-  getDeviceFeatures();
-}
-
-/**
- * @brief Create logical representation of our physical device.
- *
- * Reads information from the physical device to create a logical
- * representation. This is then used to find a valid depth format and allows us
- * to create our presentation and command semaphores for synchronizing draw
- * calls and command consumption so that:
- *  - the image is displayed before we start submitting new commands to the
- * queue
- *  - the image is not presented until all commands have been submitted and
- * executed
- */
-void VulkanBase::createLogicalDevice() {
-  // initialize a VulkanDevice from the physical device data
-  m_vulkanDevice = new vks::VulkanDevice(m_physicalDevice);
-  m_result = m_vulkanDevice->createLogicalDevice(
-      m_enabledFeatures, m_enabledDeviceExtensions, m_deviceCreatepNextChain);
-  m_device = m_vulkanDevice->logicalDevice;
-  vkGetDeviceQueue(m_device, m_vulkanDevice->queueFamilyIndices.graphics, 0,
-                   &m_queue);
-
-  // find a suitable depth format
-  VkBool32 validDepthFormat =
-      vks::tools::getSupportedDepthFormat(m_physicalDevice, &m_depthFormat);
-  assert(validDepthFormat);
+  m_deviceContext = VulkanDeviceContext::acquire(m_debug);
+  m_instance = m_deviceContext->getInstance();
+  m_physicalDevice = m_deviceContext->getPhysicalDevice();
+  m_vulkanDevice = m_deviceContext->getVulkanDevice();
+  m_device = m_deviceContext->getDevice();
+  m_queue = m_deviceContext->getQueue();
+  m_deviceProperties = m_deviceContext->getProperties();
+  m_deviceFeatures = m_deviceContext->getFeatures();
+  m_deviceMemoryProperties = m_deviceContext->getMemoryProperties();
+  m_capabilities = m_deviceContext->getCapabilities();
+  m_depthFormat = m_deviceContext->getDepthFormat();
 
   // link the Vulkan instance's swap chain from the logical to the physical
   // device
   m_swapChain.connect(m_instance, m_physicalDevice, m_device);
 
-  // create synchronization objects
-  VkSemaphoreCreateInfo semaphoreCreateInfo =
-      vks::initializers::semaphoreCreateInfo();
-  // create a semaphore used to synchronize image presentations
-  // ensures that the image is displayed before we start submitting new commands
-  // to the queue
-  VK_CHECK_RESULT(vkCreateSemaphore(m_device, &semaphoreCreateInfo, nullptr,
-                                    &m_semaphores.presentComplete));
-  // create a semaphore used to synchronize command submission
-  // ensures that the image is not presented until all commands have been
-  // submitted and executed
-  VK_CHECK_RESULT(vkCreateSemaphore(m_device, &semaphoreCreateInfo, nullptr,
-                                    &m_semaphores.renderComplete));
-
   // set up submit info structure
-  // semaphores will stay the same during application lifetime
+  // each frame waits for its image's acquire and signals its render complete
+  // semaphore, which are picked per frame
   m_submitInfo = vks::initializers::submitInfo();
   m_submitInfo.pWaitDstStageMask = &m_submitPipelineStages;
   m_submitInfo.waitSemaphoreCount = 1;
-  m_submitInfo.pWaitSemaphores = &m_semaphores.presentComplete;
   m_submitInfo.signalSemaphoreCount = 1;
-  m_submitInfo.pSignalSemaphores = &m_semaphores.renderComplete;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -385,12 +174,13 @@ void VulkanBase::createCommandBuffers() {
 }
 
 /**
- * @brief Creates the Vulkan fences
+ * @brief Creates the Vulkan fences and semaphores
  *
  * Fences are used in Vulkan to synchronize code across the CPU and GPU. We
  * implement a fence for each command buffer, and thus for each swap chain
  * image. They serve to inform the CPU when the GPU has finished drawing each
- * image, i.e. when an image in the swapchain is ready to be displayed.
+ * image, i.e. when an image in the swapchain is ready to be displayed. The
+ * acquire semaphores are created as acquires need them, see prepareFrame().
  */
 void VulkanBase::createSynchronizationPrimitives() {
   VkFenceCreateInfo fenceCreateInfo =
@@ -399,6 +189,29 @@ void VulkanBase::createSynchronizationPrimitives() {
   for (auto& fence : m_waitFences) {
     VK_CHECK_RESULT(vkCreateFence(m_device, &fenceCreateInfo, nullptr, &fence));
   }
+  m_semaphores.imageAcquired.assign(m_waitFences.size(), VK_NULL_HANDLE);
+  m_retireQueue.setFrameCount(static_cast<uint32_t>(m_waitFences.size()));
+  createRenderSemaphores();
+}
+
+/**
+ * @brief Creates a render complete semaphore for each swap chain image
+ *
+ * Replaced ones are retired rather than destroyed, as presents of the old
+ * swap chain may still be waiting on them.
+ */
+void VulkanBase::createRenderSemaphores() {
+  VkDevice device = m_device;
+  for (VkSemaphore semaphore : m_semaphores.renderComplete)
+    m_retireQueue.retire([device, semaphore]() {
+      vkDestroySemaphore(device, semaphore, nullptr);
+    });
+  VkSemaphoreCreateInfo semaphoreCreateInfo =
+      vks::initializers::semaphoreCreateInfo();
+  m_semaphores.renderComplete.resize(m_waitFences.size());
+  for (auto& semaphore : m_semaphores.renderComplete)
+    VK_CHECK_RESULT(vkCreateSemaphore(m_device, &semaphoreCreateInfo, nullptr,
+                                      &semaphore));
 }
 
 /**
@@ -415,6 +228,8 @@ void VulkanBase::createSynchronizationPrimitives() {
  * used for depth testing our swapchain images.
  */
 void VulkanBase::createDepthStencil() {
+  m_depthStencil.width = m_width;
+  m_depthStencil.height = m_height;
   VkImageCreateInfo imageCI{};
   imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageCI.imageType = VK_IMAGE_TYPE_2D;
@@ -437,8 +252,9 @@ void VulkanBase::createDepthStencil() {
   memAllloc.allocationSize = memReqs.size;
   memAllloc.memoryTypeIndex = m_vulkanDevice->getMemoryType(
       memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  VK_CHECK_RESULT(
-      vkAllocateMemory(m_device, &memAllloc, nullptr, &m_depthStencil.mem));
+  VK_CHECK_RESULT(VulkanMemoryTracker::get().allocate(
+      m_device, &memAllloc, &m_depthStencil.mem,
+      VulkanMemoryTracker::Category::RENDER_TARGET, "Depth stencil"));
   VK_CHECK_RESULT(
       vkBindImageMemory(m_device, m_depthStencil.image, m_depthStencil.mem, 0));
 
@@ -461,84 +277,51 @@ void VulkanBase::createDepthStencil() {
 }
 
 /**
- * @brief Creates the Vulkan render pass
+ * @brief Switches the depth stencil to the window's current size
+ *
+ * The previous one goes into a small pool, and one of the requested size is
+ * taken from it if the window had that size before, so that resizing back and
+ * forth doesn't allocate. The least recently used ones are destroyed past
+ * MAX_POOLED_DEPTH_STENCILS.
+ */
+void VulkanBase::resizeDepthStencil() {
+  if (m_depthStencil.width == m_width && m_depthStencil.height == m_height)
+    return;
+  m_depthStencilPool.push_back(m_depthStencil);
+  auto it = std::find_if(m_depthStencilPool.begin(), m_depthStencilPool.end(),
+                         [this](DepthStencil const& depthStencil) {
+                           return depthStencil.width == m_width &&
+                                  depthStencil.height == m_height;
+                         });
+  if (it != m_depthStencilPool.end()) {
+    m_depthStencil = *it;
+    m_depthStencilPool.erase(it);
+  } else {
+    m_depthStencil = DepthStencil();
+    createDepthStencil();
+  }
+  while (m_depthStencilPool.size() > MAX_POOLED_DEPTH_STENCILS) {
+    destroyDepthStencil(m_depthStencilPool.front());
+    m_depthStencilPool.erase(m_depthStencilPool.begin());
+  }
+}
+
+/**
+ * @brief Gets the Vulkan render pass
  *
  * A render pass tells Vulkan about the framebuffer attachments that will be
  * used while rendering. We need to specify how many color and depth buffers
  * there will be, how many samples to use for each of them, and how their
- * contents should be handled throughout the rendering operations.
+ * contents should be handled throughout the rendering operations. Windows
+ * with the same formats get the same pass from the device context, which
+ * keeps it until the last window closes.
  */
 void VulkanBase::createRenderPass() {
-  std::array<VkAttachmentDescription, 2> attachments = {};
-
-  // color attachment
-  attachments[0].format = m_swapChain.colorFormat;
-  attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
-  attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-  attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-  attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-  VkAttachmentReference colorReference = {};
-  colorReference.attachment = 0;
-  colorReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-  // depth attachment
-  attachments[1].format = m_depthFormat;
-  attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
-  attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-  attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-  VkAttachmentReference depthReference = {};
-  depthReference.attachment = 1;
-  depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-  // create our subpass with color and depth attachments
-  VkSubpassDescription subpassDescription = {};
-  subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-  subpassDescription.colorAttachmentCount = 1;
-  subpassDescription.pColorAttachments = &colorReference;
-  subpassDescription.pDepthStencilAttachment = &depthReference;
-  subpassDescription.inputAttachmentCount = 0;
-  subpassDescription.pInputAttachments = nullptr;
-  subpassDescription.preserveAttachmentCount = 0;
-  subpassDescription.pPreserveAttachments = nullptr;
-  subpassDescription.pResolveAttachments = nullptr;
-
-  // Subpass dependencies for layout transitions
-  std::array<VkSubpassDependency, 2> dependencies;
-  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-  dependencies[0].dstSubpass = 0;
-  dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-  dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-  dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
-                                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-  dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-  dependencies[1].srcSubpass = 0;
-  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-  dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-  dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
-                                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-  dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-  dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-  // finally build the render pass with a single subpass, the one created above
-  VkRenderPassCreateInfo renderPassInfo = {};
-  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-  renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-  renderPassInfo.pAttachments = attachments.data();
-  renderPassInfo.subpassCount = 1;
-  renderPassInfo.pSubpasses = &subpassDescription;
-  renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
-  renderPassInfo.pDependencies = dependencies.data();
-  VK_CHECK_RESULT(
-      vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass));
+  // shared with the other windows, so their pipelines are compatible
+  m_renderPass = m_deviceContext->getRenderPassCache()
+                     ->get(VulkanRenderPassCache::Type::PRESENT,
+                           m_swapChain.colorFormat, m_depthFormat)
+                     ->get();
 }
 
 /**
@@ -551,12 +334,13 @@ void VulkanBase::createRenderPass() {
  * retrieving pipeline cache contents in one run of an application, saving the
  * contents, and using them to preinitialize a pipeline cache on a subsequent
  * run.
+ *
+ * We do the latter through a file in the user's cache directory, which is
+ * written back when the last window is closed. The cache belongs to the
+ * device context, so every window's pipelines go through the same one.
  */
 void VulkanBase::createPipelineCache() {
-  VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-  pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-  VK_CHECK_RESULT(vkCreatePipelineCache(m_device, &pipelineCacheCreateInfo,
-                                        nullptr, &m_pipelineCache));
+  m_pipelineCache = m_deviceContext->getPipelineCache();
 }
 
 /**
@@ -607,29 +391,29 @@ void VulkanBase::createFramebuffers() {
  * Vulkan instance.
  */
 VulkanBase::~VulkanBase() {
-  VK_CHECK_RESULT(vkQueueWaitIdle(m_queue));
-  vkDeviceWaitIdle(m_device);
+  if (m_deviceContext) {
+    // other windows may still be submitting to the queue
+    std::lock_guard<std::mutex> lock(m_deviceContext->getQueueMutex());
+    VK_CHECK_RESULT(vkQueueWaitIdle(m_queue));
+  }
+  m_retireQueue.flush();
   destroySurface();
   VK_SAFE_DELETE(m_descriptorPool,
                  vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr));
-  VK_SAFE_DELETE(m_renderPass,
-                 vkDestroyRenderPass(m_device, m_renderPass, nullptr));
   for (auto& shaderModule : m_shaderModules)
     VK_SAFE_DELETE(shaderModule,
                    vkDestroyShaderModule(m_device, shaderModule, nullptr));
-  VK_SAFE_DELETE(m_pipelineCache,
-                 vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr));
-  VK_SAFE_DELETE(
-      m_semaphores.presentComplete,
-      vkDestroySemaphore(m_device, m_semaphores.presentComplete, nullptr));
-  VK_SAFE_DELETE(
-      m_semaphores.renderComplete,
-      vkDestroySemaphore(m_device, m_semaphores.renderComplete, nullptr));
+  for (auto& semaphore : m_semaphores.imageAcquired)
+    VK_SAFE_DELETE(semaphore, vkDestroySemaphore(m_device, semaphore, nullptr));
+  for (auto& semaphore : m_semaphores.free)
+    VK_SAFE_DELETE(semaphore, vkDestroySemaphore(m_device, semaphore, nullptr));
+  for (auto& semaphore : m_semaphores.renderComplete)
+    VK_SAFE_DELETE(semaphore, vkDestroySemaphore(m_device, semaphore, nullptr));
   for (auto& fence : m_waitFences)
     VK_SAFE_DELETE(fence, vkDestroyFence(m_device, fence, nullptr));
   VK_SAFE_DELETE(m_cmdPool, vkDestroyCommandPool(m_device, m_cmdPool, nullptr));
-  delete_ptr(m_vulkanDevice);
-  VK_SAFE_DELETE(m_instance, vkDestroyInstance(m_instance, nullptr));
+  // the device goes with the last window holding it
+  m_deviceContext.reset();
 }
 
 /* ----------------------------- IMPLEMENTATION ----------------------------- */
@@ -647,12 +431,10 @@ void VulkanBase::destroySurface() {
   if (!m_prepared) return;
   m_swapChain.cleanup();
   destroyCommandBuffers();
-  VK_SAFE_DELETE(m_depthStencil.view,
-                 vkDestroyImageView(m_device, m_depthStencil.view, nullptr));
-  VK_SAFE_DELETE(m_depthStencil.image,
-                 vkDestroyImage(m_device, m_depthStencil.image, nullptr));
-  VK_SAFE_DELETE(m_depthStencil.mem,
-                 vkFreeMemory(m_device, m_depthStencil.mem, nullptr));
+  destroyDepthStencil(m_depthStencil);
+  for (auto& depthStencil : m_depthStencilPool)
+    destroyDepthStencil(depthStencil);
+  m_depthStencilPool.clear();
   for (uint32_t i = 0; i < m_frameBuffers.size(); i++)
     VK_SAFE_DELETE(m_frameBuffers[i],
                    vkDestroyFramebuffer(m_device, m_frameBuffers[i], nullptr));
@@ -673,6 +455,20 @@ void VulkanBase::destroyCommandBuffers() {
   m_drawCmdBuffers.resize(0);
 }
 
+/**
+ * @brief Destroys a depth stencil's view, image and memory
+ *
+ * @param depthStencil
+ */
+void VulkanBase::destroyDepthStencil(DepthStencil& depthStencil) {
+  VK_SAFE_DELETE(depthStencil.view,
+                 vkDestroyImageView(m_device, depthStencil.view, nullptr));
+  VK_SAFE_DELETE(depthStencil.image,
+                 vkDestroyImage(m_device, depthStencil.image, nullptr));
+  VK_SAFE_DELETE(depthStencil.mem,
+                 VulkanMemoryTracker::get().free(m_device, depthStencil.mem));
+}
+
 /* -------------------------------------------------------------------------- */
 /*                        VULKAN SWAP CHAIN RECREATION                        */
 /* -------------------------------------------------------------------------- */
@@ -683,44 +479,184 @@ void VulkanBase::destroyCommandBuffers() {
 /**
  * @brief Handles swap chain recreation on window resize
  *
- * First, waits for the device to enter an idle state. Then, rebuilds the swap
- * chain, recreates the attachments and frame buffers, and then recreates
- * the command buffers. Idles once prepared.
+ * Runs on the render thread between frames, so only this window's frames
+ * still in flight can use what is replaced: waits for their fences rather
+ * than for the whole device, and the other windows keep rendering. The new
+ * swap chain is created from the old one (oldSwapchain), the depth stencil
+ * comes from the pool when the window had this size before, and the command
+ * buffers and fences are only reallocated if the number of images changed.
+ * Everything retired so far is destroyed, as no frame is in flight, and every
+ * acquire semaphore is free. Then the command buffers are recorded again for
+ * the new frame buffers.
  */
 void VulkanBase::windowResize() {
+  {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_width = m_destWidth;
+    m_height = m_destHeight;
+    m_resizePending = false;
+  }
   if (!m_prepared) return;
   m_prepared = false;
 
-  // ensure all operations on the device have been finished before destroying
-  // resources
-  vkDeviceWaitIdle(m_device);
+  // ensure this window's frames are done with the resources we replace
+  if (!m_waitFences.empty())
+    VK_CHECK_RESULT(vkWaitForFences(
+        m_device, static_cast<uint32_t>(m_waitFences.size()),
+        m_waitFences.data(), VK_TRUE, UINT64_MAX));
+  m_retireQueue.flush();
+  for (auto& semaphore : m_semaphores.imageAcquired) {
+    if (semaphore != VK_NULL_HANDLE) m_semaphores.free.push_back(semaphore);
+    semaphore = VK_NULL_HANDLE;
+  }
 
-  // recreate the swap chain
-  m_width = m_destWidth;
-  m_height = m_destHeight;
+  // recreate the swap chain, retiring the old one
+  uint32_t const imageCount = m_swapChain.imageCount;
   createSwapChain();
 
   // recreate the frame buffers
-  vkDestroyImageView(m_device, m_depthStencil.view, nullptr);
-  vkDestroyImage(m_device, m_depthStencil.image, nullptr);
-  vkFreeMemory(m_device, m_depthStencil.mem, nullptr);
-  createDepthStencil();
+  resizeDepthStencil();
   for (uint32_t i = 0; i < m_frameBuffers.size(); i++)
     vkDestroyFramebuffer(m_device, m_frameBuffers[i], nullptr);
   createFramebuffers();
 
-  // command buffers need to be recreated as they may store references to the
-  // recreated frame buffer
-  destroyCommandBuffers();
-  createCommandBuffers();
+  // the command buffers and fences are per swap chain image
+  if (m_swapChain.imageCount != imageCount) {
+    destroyCommandBuffers();
+    createCommandBuffers();
+    for (auto& fence : m_waitFences) vkDestroyFence(m_device, fence, nullptr);
+    createSynchronizationPrimitives();
+  } else {
+    createRenderSemaphores();
+  }
+  // command buffers need to be recorded again as they store references to
+  // the recreated frame buffers
   buildCommandBuffers();
+  m_prepared = true;
+}
 
-  // recreate fences in case number of swapchain images has changed on resize
-  for (auto& fence : m_waitFences) vkDestroyFence(m_device, fence, nullptr);
-  createSynchronizationPrimitives();
+/* -------------------------------------------------------------------------- */
+/*                           RENDER THREAD CONTROL                            */
+/* -------------------------------------------------------------------------- */
+// The window's thread asks for state changes, and the render thread picks them
+// up between frames. Changes are made under m_stateMutex and announced on
+// m_stateChanged, which the render thread sleeps on while paused and the
+// window's thread sleeps on while waiting for a frame to finish.
 
-  vkDeviceWaitIdle(m_device);
-  m_prepared = true;
+/**
+ * @brief Stops rendering, returning once the frame in progress is done
+ *
+ * Afterwards the render thread is asleep and the engine's resources can be
+ * touched from the calling thread. Must not be called from the render thread.
+ */
+void VulkanBase::pause() {
+  std::unique_lock<std::mutex> lock(m_stateMutex);
+  if (m_renderState == RenderState::QUITTING) return;
+  m_renderState = RenderState::PAUSED;
+  m_stateChanged.wait(lock, [this] { return !m_inFrame; });
+}
+
+/**
+ * @brief Starts rendering again after pause(), first applying any resize
+ * requested in the meantime
+ */
+void VulkanBase::resume() { setRenderState(RenderState::RUNNING); }
+
+/**
+ * @brief Ends the render loop after the frame in progress. Join the render
+ * thread to wait for it.
+ */
+void VulkanBase::quit() { setRenderState(RenderState::QUITTING); }
+
+/**
+ * @brief Asks for the swap chain to be recreated for a new window size,
+ * before the next frame
+ *
+ * @param width - In pixels
+ * @param height - In pixels
+ */
+void VulkanBase::requestResize(uint32_t width, uint32_t height) {
+  {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_destWidth = width;
+    m_destHeight = height;
+    m_resizeRequested = std::chrono::steady_clock::now();
+  }
+  scheduleResize();
+}
+
+/* ----------------------------- IMPLEMENTATION ----------------------------- */
+
+/**
+ * @brief Moves the render thread to a new state and wakes it
+ *
+ * QUITTING is final. A pending resize turns RUNNING into RESIZING, and only
+ * a running thread starts resizing, so a paused one stays paused until
+ * resumed.
+ *
+ * @param state
+ */
+void VulkanBase::setRenderState(RenderState state) {
+  {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    RenderState current = m_renderState;
+    if (current == RenderState::QUITTING) return;
+    if (state == RenderState::RUNNING && m_resizePending)
+      state = RenderState::RESIZING;
+    if (state == RenderState::RESIZING && current == RenderState::PAUSED)
+      return;
+    m_renderState = state;
+  }
+  m_stateChanged.notify_all();
+}
+
+/**
+ * @brief Marks the swap chain for recreation at the window's last requested
+ * size
+ *
+ * Doesn't restart the debounce, so a swap chain that keeps reporting itself
+ * as suboptimal is still recreated once the window settles.
+ */
+void VulkanBase::scheduleResize() {
+  {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_resizePending = true;
+  }
+  setRenderState(RenderState::RESIZING);
+}
+
+/**
+ * @brief Sleeps while paused, then marks a frame as in progress
+ *
+ * While the window is being dragged, a resize is put off until its size has
+ * held for RESIZE_DEBOUNCE, and frames keep rendering at the old size.
+ *
+ * @return RenderState - What the frame should do: render, resize or quit
+ */
+RenderState VulkanBase::beginFrame() {
+  std::unique_lock<std::mutex> lock(m_stateMutex);
+  m_stateChanged.wait(
+      lock, [this] { return m_renderState != RenderState::PAUSED; });
+  RenderState state = m_renderState;
+  if (state == RenderState::RESIZING &&
+      std::chrono::steady_clock::now() - m_resizeRequested < RESIZE_DEBOUNCE)
+    state = RenderState::RUNNING;
+  m_inFrame = state != RenderState::QUITTING;
+  return state;
+}
+
+/**
+ * @brief Marks the frame as done, waking a pause() waiting for it. A finished
+ * resize goes back to running, unless another one arrived meanwhile.
+ */
+void VulkanBase::endFrame() {
+  {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_inFrame = false;
+    if (m_renderState == RenderState::RESIZING && !m_resizePending)
+      m_renderState = RenderState::RUNNING;
+  }
+  m_stateChanged.notify_all();
 }
 
 /* -------------------------------------------------------------------------- */
@@ -734,41 +670,80 @@ void VulkanBase::windowResize() {
 /**
  * @brief Calls the render function until the Vulkan instance is quit
  *
- * Continually polls for quit events while rendering frames and updating the
- * overlay. Once a quit event is received, vkDeviceWaitIdle.
+ * Renders frames and updates the overlay while running, recreates the swap
+ * chain when a resize was requested, and sleeps while paused. The queue is
+ * shared with the other windows' render loops, so only the submits and the
+ * present take the device context's queue lock. Once quit, waits for the
+ * queue to idle.
  */
 void VulkanBase::renderLoop() {
-  while (!m_quit) {
-    renderFrame();
-    updateOverlay();
+  for (RenderState state = beginFrame(); state != RenderState::QUITTING;
+       state = beginFrame()) {
+    if (state == RenderState::RESIZING) {
+      windowResize();
+    } else {
+      renderFrame();
+      updateOverlay();
+    }
+    endFrame();
   }
-  // once we have quit, just idle the Vulkan instance
-  if (m_device != VK_NULL_HANDLE) {
-    vkDeviceWaitIdle(m_device);
+  // once we have quit, just idle our part of the Vulkan instance
+  if (m_queue != VK_NULL_HANDLE) {
+    std::lock_guard<std::mutex> lock(m_deviceContext->getQueueMutex());
+    vkQueueWaitIdle(m_queue);
   }
 }
 
 /**
  * @brief Renders a single frame to the device
  *
- * Calls render() and draw(), and then updates the Vulkan state based on
- * commands. Measures frame render timing and stores frame times in
- * m_frameTimer.
+ * Acquires the next swap chain image first, so that render() knows which
+ * frame's uniforms it is writing, and prepareFrame() waits on that image's
+ * fence so the GPU is done with the previous frame that used them. What only
+ * that frame could still use is destroyed then, and frameCompleted() brings
+ * the image's command buffers up to date. Then calls render(), and submits the
+ * passes it queued in m_frameCmdBuffers, followed by the image's command
+ * buffer and the overlay's, if any, all under the image's fence, so nothing
+ * idles the queue. frameSubmitted() follows right after the submit. Finally
+ * updates the Vulkan state based on commands. Measures frame render timing
+ * and stores frame times in m_frameTimer.
  */
 void VulkanBase::renderFrame() {
   auto tStart = std::chrono::high_resolution_clock::now();
+  if (!prepareFrame()) return;
+  m_retireQueue.frameCompleted(m_currentBuffer);
+  frameCompleted();
   render();
-  prepareFrame();
-  m_submitInfo.commandBufferCount = 1;
-  m_submitInfo.pCommandBuffers = &m_drawCmdBuffers[m_currentBuffer];
-  VK_CHECK_RESULT(vkQueueSubmit(m_queue, 1, &m_submitInfo, VK_NULL_HANDLE));
+  // the passes render() queued go in a batch of their own, which doesn't
+  // wait for the image, but the same fence covers them
+  std::array<VkSubmitInfo, 2> submitInfos = {vks::initializers::submitInfo(),
+                                             m_submitInfo};
+  submitInfos[0].commandBufferCount =
+      static_cast<uint32_t>(m_frameCmdBuffers.size());
+  submitInfos[0].pCommandBuffers = m_frameCmdBuffers.data();
+  submitInfos[1].pWaitSemaphores = &m_semaphores.imageAcquired[m_currentBuffer];
+  submitInfos[1].pSignalSemaphores =
+      &m_semaphores.renderComplete[m_currentBuffer];
+  std::array<VkCommandBuffer, 2> cmdBuffers = {
+      m_drawCmdBuffers[m_currentBuffer], recordOverlay()};
+  submitInfos[1].commandBufferCount = cmdBuffers[1] != VK_NULL_HANDLE ? 2 : 1;
+  submitInfos[1].pCommandBuffers = cmdBuffers.data();
+  uint32_t first = m_frameCmdBuffers.empty() ? 1 : 0;
+  // the fence is reset only right before the submit that signals it, so
+  // waits on it in between, like a rebuild's, return at once
+  VK_CHECK_RESULT(vkResetFences(m_device, 1, &m_waitFences[m_currentBuffer]));
+  {
+    std::lock_guard<std::mutex> lock(m_deviceContext->getQueueMutex());
+    VK_CHECK_RESULT(vkQueueSubmit(m_queue, 2 - first, &submitInfos[first],
+                                  m_waitFences[m_currentBuffer]));
+  }
+  frameSubmitted();
+  m_frameCmdBuffers.clear();
   submitFrame();
   updateCommand();
   auto tEnd = std::chrono::high_resolution_clock::now();
   auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
   m_frameTimer = (float)tDiff / 1000.0f;
-  // now wait for queue to become idle
-  VK_CHECK_RESULT(vkQueueWaitIdle(m_queue));
 }
 
 /* ----------------------------- IMPLEMENTATION ----------------------------- */
@@ -788,63 +763,108 @@ void VulkanBase::render() {}
  * the surface!
  */
 void VulkanBase::draw() {
-  if (m_stop || m_pause) return;
-  m_signalFrame = false;
-  prepareFrame();
+  if (m_renderState != RenderState::RUNNING) return;
+  if (!prepareFrame()) return;
 
   // command buffer to be submitted to the queue
   m_submitInfo.commandBufferCount = 1;
   m_submitInfo.pCommandBuffers = &m_drawCmdBuffers[m_currentBuffer];
-
-  // now submit to ithe queue
-  if (m_prepared)
-    VK_CHECK_RESULT(vkQueueSubmit(m_queue, 1, &m_submitInfo, VK_NULL_HANDLE));
+  m_submitInfo.pWaitSemaphores = &m_semaphores.imageAcquired[m_currentBuffer];
+  m_submitInfo.pSignalSemaphores =
+      &m_semaphores.renderComplete[m_currentBuffer];
+
+  // now submit to ithe queue, under the image's fence like any frame
+  VK_CHECK_RESULT(vkResetFences(m_device, 1, &m_waitFences[m_currentBuffer]));
+  {
+    std::lock_guard<std::mutex> lock(m_deviceContext->getQueueMutex());
+    VK_CHECK_RESULT(vkQueueSubmit(m_queue, 1, &m_submitInfo,
+                                  m_waitFences[m_currentBuffer]));
+  }
 
   submitFrame();
-  m_signalFrame = true;
 }
 
 /* --------------------------- DEEP IMPLEMENTATION -------------------------- */
 
 /**
- * @brief Acquires the next image in the Vulkan swap chain.
+ * @brief Acquires the next image in the Vulkan swap chain, and waits until
+ * the GPU is done with the image's previous frame
+ *
+ * If the swap chain is no longer compatible with the surface (resized), no
+ * image was acquired, so we recreate it right away and skip the frame. If it
+ * still works but no longer matches the surface (suboptimal), we render into
+ * it and leave the recreation to the debounced resize.
+ *
+ * The acquire signals a free semaphore. Once the image's fence was waited on,
+ * the submission that waited on the image's previous acquire semaphore is
+ * done, so that semaphore is free again. The images sharing the image's slot
+ * of the per-frame resources are waited on as well, see m_frameSlots. The
+ * image's fence is left signaled, the submission under it resets it.
  *
- * If the swap chain is no longer compatible with the surface (resized), we also
- * handle recreation here, as m_swapChain.acquireNextImage will error out in
- * that case. Otherwise, we are ready to submit the image from the swap chain
- * to the surface.
+ * @return Whether an image was acquired and the frame can be rendered
  */
-void VulkanBase::prepareFrame() {
-  if (m_pause || !m_prepared) return;
+bool VulkanBase::prepareFrame() {
+  if (!m_prepared) return false;
   // acquire the next image from the swap chain
-  VkResult err = m_swapChain.acquireNextImage(m_semaphores.presentComplete,
-                                              &m_currentBuffer);
-  // recreate the swapchain if it's no longer compatible with the surface
-  // (OUT_OF_DATE) or no longer optimal for presentation (SUBOPTIMAL)
-  if ((err == VK_ERROR_OUT_OF_DATE_KHR) || (err = VK_SUBOPTIMAL_KHR)) {
-    if (err == VK_ERROR_OUT_OF_DATE_KHR) windowResize();
-    return;
+  VkSemaphore acquired = VK_NULL_HANDLE;
+  if (m_semaphores.free.empty()) {
+    VkSemaphoreCreateInfo semaphoreCreateInfo =
+        vks::initializers::semaphoreCreateInfo();
+    VK_CHECK_RESULT(vkCreateSemaphore(m_device, &semaphoreCreateInfo, nullptr,
+                                      &acquired));
+  } else {
+    acquired = m_semaphores.free.back();
+    m_semaphores.free.pop_back();
+  }
+  VkResult err = m_swapChain.acquireNextImage(acquired, &m_currentBuffer);
+  if (err == VK_ERROR_OUT_OF_DATE_KHR) {
+    // nothing was signaled
+    m_semaphores.free.push_back(acquired);
+    windowResize();
+    return false;
+  }
+  if (err == VK_SUBOPTIMAL_KHR) {
+    scheduleResize();
   } else {
     VK_CHECK_RESULT(err);
   }
+
+  uint32_t const imageCount = static_cast<uint32_t>(m_waitFences.size());
+  uint32_t const slots = m_frameSlots == 0 ? imageCount
+                                           : std::min(m_frameSlots, imageCount);
+  std::vector<VkFence> fences;
+  for (uint32_t i = m_currentBuffer % slots; i < imageCount; i += slots)
+    fences.push_back(m_waitFences[i]);
+  VK_CHECK_RESULT(vkWaitForFences(m_device,
+                                  static_cast<uint32_t>(fences.size()),
+                                  fences.data(), VK_TRUE, UINT64_MAX));
+  VkSemaphore& imageAcquired = m_semaphores.imageAcquired[m_currentBuffer];
+  if (imageAcquired != VK_NULL_HANDLE)
+    m_semaphores.free.push_back(imageAcquired);
+  imageAcquired = acquired;
+  return true;
 }
 
 /**
  * @brief Submits an image from the Vulkan swap chain to the surface
  *
  * This function actually presents the swap chain's image to the configured
- * surface. We also listen for window resize events here. This function
- * is predicated on the render complete semaphore, which lets us know when
- * the image is completed and ready to show.
+ * surface. We also listen for window resize events here: an out of date swap
+ * chain is recreated right away, a suboptimal one once the window settles.
+ * This function is predicated on the render complete semaphore, which lets us
+ * know when the image is completed and ready to show.
  */
 void VulkanBase::submitFrame() {
-  VkResult err = m_swapChain.queuePresent(m_queue, m_currentBuffer,
-                                          m_semaphores.renderComplete);
-  // recreate the swapchain if it's no longer compatible with the surface
-  // (OUT_OF_DATE) or no longer optimal for presentation (SUBOPTIMAL)
-  if ((err == VK_ERROR_OUT_OF_DATE_KHR) || (err = VK_SUBOPTIMAL_KHR)) {
+  VkResult err;
+  {
+    std::lock_guard<std::mutex> lock(m_deviceContext->getQueueMutex());
+    err = m_swapChain.queuePresent(
+        m_queue, m_currentBuffer, m_semaphores.renderComplete[m_currentBuffer]);
+  }
+  if (err == VK_ERROR_OUT_OF_DATE_KHR) {
     windowResize();
-    if (err == VK_ERROR_OUT_OF_DATE_KHR) return;
+  } else if (err == VK_SUBOPTIMAL_KHR) {
+    scheduleResize();
   } else {
     VK_CHECK_RESULT(err);
   }
@@ -875,17 +895,4 @@ void VulkanBase::runFunction(int i) {
   }
 }
 
-/**
- * @brief Waits for the current frame to be rendered.
- *
- * Sleeps the thread until the frame has been drawn. This frees up resources for
- * other processes, preventing the thread from blocking.
- */
-void VulkanBase::waitForCurrentFrameComplete() {
-  m_pause = true;
-  while (m_signalFrame == false) {
-    std::this_thread::sleep_for(std::chrono::microseconds(1));
-  }
-}
-
 }  // namespace VulkanEngine
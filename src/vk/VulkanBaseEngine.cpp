@@ -10,24 +10,36 @@ namespace VulkanEngine {
 //  2. prepareDescriptorSets
 //  3. prepareVertexDescriptions
 //  4. prepareBasePipelines
-//  5. prepareContext
-//  6. prepareImGUI
-//  7. prepareMyObjects
-//  8. buildCommandBuffers
+//  5. prepareUniformRing
+//  6. prepareGeometryArena
+//  7. prepareContext
+//  8. prepareImGUI
+//  9. prepareCompositor
+//  10. prepareDynamicResolution
+//  11. prepareMyObjects
+//  12. buildCommandBuffers
 
 /**
  * @brief Sets up the base engine for rendering
  *
  * Builds the base Vulkan instance, the descriptor sets and vertex descriptions,
  * the base pipelines, context, and the objects. Also builds command buffers.
+ * Pipelines are still compiling on the build queue when this returns; once
+ * they are all done, updateCommand reports how long startup took against the
+ * last start without a saved pipeline cache.
  */
 void VulkanBaseEngine::prepare() {
+  m_startTime = std::chrono::high_resolution_clock::now();
   prepareBase();
   prepareDescriptorSets();
   prepareVertexDescriptions();
   prepareBasePipelines();
+  prepareUniformRing();
+  prepareGeometryArena();
   prepareContext();
   prepareImGui();
+  prepareCompositor();
+  prepareDynamicResolution();
   prepareMyObjects();  // <-- this is overridden on a per-engine basis
   buildCommandBuffers();
   m_prepared = true;
@@ -48,7 +60,28 @@ void VulkanBaseEngine::prepare() {
  * or image / sampler information.
  */
 void VulkanBaseEngine::prepareDescriptorSets() {
-  m_vulkanDescriptorSet = new VulkanDescriptorSet(m_device, m_maxSets);
+  m_descriptorLayoutCache = m_deviceContext->getDescriptorLayoutCache();
+  m_descriptorAllocator = new VulkanDescriptorAllocator(m_device);
+  m_vulkanDescriptorSet = new VulkanDescriptorSet(
+      m_device, m_descriptorLayoutCache, m_descriptorAllocator,
+      VulkanDescriptorSet::PER_FRAME, m_maxSets);
+}
+
+/**
+ * @brief Looks up the pipeline layout shared by all of the engine's pipelines
+ *
+ * Per-object data doesn't take a set: the model matrix is a push constant,
+ * or comes from the instance buffer.
+ *
+ * @param setLayouts - The layouts of the sets in use, in set order: per
+ * frame, per material
+ */
+void VulkanBaseEngine::preparePipelineLayout(
+    std::vector<VkDescriptorSetLayout> const& setLayouts) {
+  VkPushConstantRange pushConstantRange = vks::initializers::pushConstantRange(
+      VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), 0);
+  m_pipelineLayout =
+      m_descriptorLayoutCache->getPipelineLayout(setLayouts, {pushConstantRange});
 }
 
 /**
@@ -58,10 +91,16 @@ void VulkanBaseEngine::prepareDescriptorSets() {
  * descriptor sets, i.e. where to look for vertex positions, uvs, and normals.
  * This allows us to allocate the correct amount of memory for our descriptor
  * pool by combining our descriptor sets with our vertex descriptions.
+ *
+ * Instanced shaders use a second description that also reads a model matrix
+ * per instance from the instance buffer binding.
  */
 void VulkanBaseEngine::prepareVertexDescriptions() {
   m_vulkanVertexDescriptions = new VulkanVertexDescriptions();
   m_vulkanVertexDescriptions->GenerateTexVec4Descriptions();
+  m_instancedVertexDescriptions = new VulkanVertexDescriptions();
+  m_instancedVertexDescriptions->GenerateTexVec4Descriptions();
+  m_instancedVertexDescriptions->AddInstanceTransformDescriptions(3);
 }
 
 /**
@@ -73,11 +112,47 @@ void VulkanBaseEngine::prepareVertexDescriptions() {
  *
  * By putting vertex data into the descriptor sets, we enable the pipeline to
  * read from it and rasterize it into what you see on screen.
+ *
+ * Pipelines are compiled in parallel by the build queue, so the first frames
+ * can be drawn before every pipeline is ready. The queue's workers and the
+ * pipelines themselves are shared with the other windows.
  */
 void VulkanBaseEngine::prepareBasePipelines() {
+  m_pipelineBuildQueue = m_deviceContext->getPipelineBuildQueue();
   m_pipelines = new VulkanPipelines(m_device);
   m_pipelines->m_vertexInputState = m_vulkanVertexDescriptions->m_inputState;
   m_pipelines->m_pipelineCache = m_pipelineCache;
+  m_pipelines->m_buildQueue = m_pipelineBuildQueue;
+  m_pipelines->m_pipelineMap = m_deviceContext->getPipelineMap();
+#ifdef PAPERARIUM_SHADER_HOT_RELOAD
+  m_shaderReloader = new VulkanShaderReloader(
+      m_pipelines, m_deviceContext->getShaderModuleCache());
+#endif
+}
+
+/**
+ * @brief Creates the per-frame uniform ring
+ *
+ * Each swap chain image gets its own copy of every uniform block, so the
+ * uniforms of the next frame can be written while the GPU is still reading
+ * those of the previous one. The ring can't grow, so if a resize adds swap
+ * chain images, the images sharing a slot are kept from overlapping instead.
+ */
+void VulkanBaseEngine::prepareUniformRing() {
+  m_uniformRing = new VulkanUniformRing();
+  m_uniformRing->create(m_vulkanDevice, m_swapChain.imageCount);
+  m_frameSlots = m_uniformRing->getFrameCount();
+}
+
+/**
+ * @brief Takes the geometry arena from the device context
+ *
+ * All meshes are uploaded into the arena's device-local vertex and index
+ * buffers, which each render pass binds only once. Every window shares them,
+ * so a model open in several windows is only uploaded once.
+ */
+void VulkanBaseEngine::prepareGeometryArena() {
+  m_geometryArena = m_deviceContext->getGeometryArena();
 }
 
 /**
@@ -96,6 +171,13 @@ void VulkanBaseEngine::prepareContext() {
   m_context->queue = m_queue;
   m_context->pScreenWidth = &m_width;
   m_context->pScreenHeight = &m_height;
+  m_context->uniformRing = m_uniformRing;
+  m_context->pCurrentFrame = &m_currentBuffer;
+  m_context->geometryArena = m_geometryArena;
+  m_context->deviceContext = m_deviceContext.get();
+  m_context->descriptorLayoutCache = m_descriptorLayoutCache;
+  m_context->descriptorAllocator = m_descriptorAllocator;
+  m_context->sceneChanged = [this]() { markSceneChanged(); };
 }
 
 /**
@@ -115,81 +197,380 @@ void VulkanBaseEngine::prepareImGui() {
                    VK_SHADER_STAGE_FRAGMENT_BIT),
     };
     m_UIOverlay.prepareResources();
+    // the UI pass is compatible with the main one, so the pipeline fits both
     m_UIOverlay.preparePipeline(m_pipelineCache, m_renderPass);
+    prepareUIRenderPass();
   }
 }
 
 /**
- * @brief Builds a command buffer containing our render pass
+ * @brief Creates the render pass the UI is drawn in, after the main pass
  *
- * This command buffer defines the instructions to correctly draw our scene from
- * the descriptor sets we bind.
+ * It has the main pass's attachments, so it uses the same frame buffers, but
+ * loads the color the main pass stored instead of clearing it. This way the
+ * UI lives in command buffers of its own, recorded every frame, and the
+ * scene's are only recorded again when the scene changes.
+ */
+void VulkanBaseEngine::prepareUIRenderPass() {
+  std::array<VkAttachmentDescription, 2> attachments = {};
+  attachments[0].format = m_swapChain.colorFormat;
+  attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+  attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+  attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[0].initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  VkAttachmentReference colorReference = {
+      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+  // the UI doesn't test depth, but the pass needs the attachment to stay
+  // compatible with the frame buffers
+  attachments[1].format = m_depthFormat;
+  attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+  attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  VkAttachmentReference depthReference = {
+      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+  VkSubpassDescription subpassDescription = {};
+  subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpassDescription.colorAttachmentCount = 1;
+  subpassDescription.pColorAttachments = &colorReference;
+  subpassDescription.pDepthStencilAttachment = &depthReference;
+
+  // wait for the main pass's color and depth writes, as the depth is
+  // discarded, and finish before presenting
+  std::array<VkSubpassDependency, 2> dependencies;
+  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass = 0;
+  dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                 VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                 VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[0].dependencyFlags = 0;
+  dependencies[1].srcSubpass = 0;
+  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+  dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+  VkRenderPassCreateInfo renderPassInfo = {};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+  renderPassInfo.pAttachments = attachments.data();
+  renderPassInfo.subpassCount = 1;
+  renderPassInfo.pSubpasses = &subpassDescription;
+  renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+  renderPassInfo.pDependencies = dependencies.data();
+  VK_CHECK_RESULT(
+      vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_uiRenderPass));
+}
+
+/**
+ * @brief Creates the pipeline that draws offscreen targets into the main pass
+ */
+void VulkanBaseEngine::prepareCompositor() {
+  m_compositor = new VulkanCompositor(m_device, m_descriptorLayoutCache,
+                                      m_descriptorAllocator);
+  m_compositor->preparePipeline(
+      m_pipelineCache, m_renderPass,
+      {loadShader(":/shaders/base/composite.vert.spv",
+                  VK_SHADER_STAGE_VERTEX_BIT),
+       loadShader(":/shaders/base/composite.frag.spv",
+                  VK_SHADER_STAGE_FRAGMENT_BIT)});
+}
+
+/**
+ * @brief Creates the dynamic resolution's pass
+ *
+ * Its target has the formats of the main render pass, so the scene's
+ * pipelines draw into it too. The target itself is only allocated once the
+ * mode is enabled.
+ */
+void VulkanBaseEngine::prepareDynamicResolution() {
+  m_dynamicResolution =
+      new VulkanDynamicResolution(m_vulkanDevice, m_compositor, &m_retireQueue,
+                                  m_swapChain.colorFormat, m_depthFormat);
+}
+
+/**
+ * @brief Marks every swap chain image's command buffers for recording again
+ *
+ * Sizes what the recordings share first: the dynamic resolution's target and
+ * the views. Each image is then recorded by recordCommandBuffer() the next
+ * time it comes up, once its fence shows the GPU is done with its previous
+ * recording, so nothing waits for the queue. Anything replaced here is
+ * retired, as no later submission can use it.
  */
 void VulkanBaseEngine::buildCommandBuffers() {
+  m_geometryGeneration = m_geometryArena->getGeneration();
+  m_pipelinesCompleted = m_pipelineBuildQueue->getCompleted();
+  m_scaled = m_settings.dynamicResolution && m_dynamicResolution &&
+             m_viewports.empty();
+  if (m_scaled) m_dynamicResolution->resize(m_width, m_height);
+  for (auto* viewport : m_viewports) {
+    viewport->resize(m_width, m_height);
+    viewport->allocateCommandBuffers(
+        static_cast<uint32_t>(m_drawCmdBuffers.size()));
+    // whatever made this recording necessary may show in every view
+    viewport->markDirty();
+  }
+  m_staleCommandBuffers.assign(m_drawCmdBuffers.size(), true);
+  // shaders that swapped in their reloaded pipelines never record the old ones
+  if (m_shaderReloader) m_shaderReloader->retire(m_retireQueue);
+}
+
+/**
+ * @brief Records the current image's command buffers if they were marked
+ * for recording again, now that its fence was waited on
+ *
+ * The geometry arena is shared with the other windows, so it is held from
+ * here until the frame is submitted, and meshes they upload in the meantime
+ * can't move what this frame draws. A move made before shows in the arena's
+ * generation, and every image is recorded again.
+ */
+void VulkanBaseEngine::frameCompleted() {
+  m_geometryArena->lockShared();
+  if (m_geometryArena->getGeneration() != m_geometryGeneration)
+    buildCommandBuffers();
+  if (m_currentBuffer >= m_staleCommandBuffers.size() ||
+      !m_staleCommandBuffers[m_currentBuffer])
+    return;
+  recordCommandBuffer(m_currentBuffer);
+  m_staleCommandBuffers[m_currentBuffer] = false;
+}
+
+/**
+ * @brief Lets the other windows change the geometry arena again
+ */
+void VulkanBaseEngine::frameSubmitted() { m_geometryArena->unlockShared(); }
+
+/**
+ * @brief Records a command buffer containing our render pass, for one swap
+ * chain image
+ *
+ * This command buffer defines the instructions to correctly draw our scene from
+ * the descriptor sets we bind. With dynamic resolution, the scene is drawn
+ * into an offscreen target first, and the main pass upscales it. With
+ * viewports, each view is recorded into command buffers of its own, and the
+ * main pass only composites their targets; dynamic resolution is then off.
+ * The UI is not part of it, see recordOverlay().
+ *
+ * @param frame - The swap chain image, whose fence has been waited on
+ */
+void VulkanBaseEngine::recordCommandBuffer(uint32_t frame) {
   VkCommandBufferBeginInfo cmdBufInfo =
       vks::initializers::commandBufferBeginInfo();
-  for (size_t i = 0; i < m_drawCmdBuffers.size(); i++) {
-    VK_CHECK_RESULT(vkBeginCommandBuffer(m_drawCmdBuffers[i], &cmdBufInfo));
-    buildCommandBuffersBeforeMainRenderPass(m_drawCmdBuffers[i]);
-    {
-      VkClearValue clearValues[2];
-      clearValues[0].color = {{0.f, 0.f, 0.f, 0.0f}};
-      clearValues[1].depthStencil = {1.0f, 0};
-      // set target frame buffer
-      VkRenderPassBeginInfo renderPassBeginInfo =
-          vks::initializers::renderPassBeginInfo();
-      renderPassBeginInfo.renderPass = m_renderPass;
-      renderPassBeginInfo.renderArea.offset.x = 0;
-      renderPassBeginInfo.renderArea.offset.y = 0;
-      renderPassBeginInfo.renderArea.extent.width = m_width;
-      renderPassBeginInfo.renderArea.extent.height = m_height;
-      renderPassBeginInfo.clearValueCount = 2;
-      renderPassBeginInfo.pClearValues = clearValues;
-      renderPassBeginInfo.framebuffer = m_frameBuffers[i];
-      // begin the render pass
-      vkCmdBeginRenderPass(m_drawCmdBuffers[i], &renderPassBeginInfo,
-                           VK_SUBPASS_CONTENTS_INLINE);
-      VkDeviceSize offsets[1] = {0};
-      // bing our vertice descriptor sets to the pipeline
-      vkCmdBindDescriptorSets(m_drawCmdBuffers[i],
-                              VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-                              0, 1, &(m_vulkanDescriptorSet->get(0)), 0, NULL);
-
-      /* ---------------------------- RENDER PASS --------------------------- */
-
-      // 1. Set viewport and scissor
-      setViewPorts(m_drawCmdBuffers[i]);
-      // 2. Draw the objects in the scene
-      buildMyObjects(m_drawCmdBuffers[i]);
-      // 3. Draw the ImGUI interface on the surface
-      drawUI(m_drawCmdBuffers[i]);
-
-      /* ------------------------- END RENDER PASS -------------------------- */
-
-      // end the render pass
-      vkCmdEndRenderPass(m_drawCmdBuffers[i]);
+  VkCommandBuffer cmd = m_drawCmdBuffers[frame];
+  m_recordingBuffer = frame;
+  std::array<VkClearValue, 2> clearValues;
+  clearValues[0].color = {{0.f, 0.f, 0.f, 0.0f}};
+  clearValues[1].depthStencil = {1.0f, 0};
+  for (auto* viewport : m_viewports)
+    recordViewport(viewport, m_recordingBuffer, clearValues);
+  m_sceneExtent = m_scaled ? m_dynamicResolution->getExtent()
+                           : VkExtent2D{m_width, m_height};
+  VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &cmdBufInfo));
+  buildCommandBuffersBeforeMainRenderPass(cmd);
+  if (m_scaled) {
+    // the scene goes into the offscreen target, at a fraction of the size
+    m_dynamicResolution->beginRenderPass(cmd, clearValues);
+    drawScene(cmd);
+    vkCmdEndRenderPass(cmd);
+  }
+  {
+    // set target frame buffer
+    VkRenderPassBeginInfo renderPassBeginInfo =
+        vks::initializers::renderPassBeginInfo();
+    renderPassBeginInfo.renderPass = m_renderPass;
+    renderPassBeginInfo.renderArea.offset.x = 0;
+    renderPassBeginInfo.renderArea.offset.y = 0;
+    renderPassBeginInfo.renderArea.extent.width = m_width;
+    renderPassBeginInfo.renderArea.extent.height = m_height;
+    renderPassBeginInfo.clearValueCount =
+        static_cast<uint32_t>(clearValues.size());
+    renderPassBeginInfo.pClearValues = clearValues.data();
+    renderPassBeginInfo.framebuffer = m_frameBuffers[frame];
+    // begin the render pass
+    vkCmdBeginRenderPass(cmd, &renderPassBeginInfo,
+                         VK_SUBPASS_CONTENTS_INLINE);
+
+    /* ----------------------------- RENDER PASS ---------------------------- */
+
+    // Draw the scene, or the views or upscaled scene drawn offscreen
+    if (!m_viewports.empty()) {
+      for (auto* viewport : m_viewports) viewport->composite(cmd);
+    } else if (m_scaled) {
+      m_dynamicResolution->draw(cmd);
+    } else {
+      drawScene(cmd);
     }
-    buildCommandBuffersAfterMainRenderPass(m_drawCmdBuffers[i]);
-    VK_CHECK_RESULT(vkEndCommandBuffer(m_drawCmdBuffers[i]));
+
+    /* --------------------------- END RENDER PASS -------------------------- */
+
+    // end the render pass
+    vkCmdEndRenderPass(cmd);
   }
-  vkQueueWaitIdle(m_queue);
+  buildCommandBuffersAfterMainRenderPass(cmd);
+  VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
 }
 
 /* ----------------------------- DRAW FUNCTIONS ----------------------------- */
 
+/**
+ * @brief Adds commands to draw the scene to a command buffer, inside the main
+ * render pass, the offscreen one of the dynamic resolution or a view's
+ *
+ * @param commandBuffer - The command buffer being recorded
+ */
+void VulkanBaseEngine::drawScene(VkCommandBuffer& commandBuffer) {
+  // bind our vertex descriptor sets to the pipeline
+  bindDescriptorSets(commandBuffer);
+  m_geometryArena->bind(commandBuffer);
+  // 1. Set viewport and scissor
+  setViewPorts(commandBuffer);
+  // 2. Draw the objects in the scene, or in the view
+  if (m_recordingViewport) {
+    m_recordingViewport->draw(commandBuffer);
+  } else {
+    buildMyObjects(commandBuffer);
+  }
+}
+
+/**
+ * @brief Binds the engine's descriptor set to a command buffer, with its
+ * dynamic uniform buffers pointing at the slot of the frame being recorded
+ *
+ * A view being recorded gets its own copy of the set, holding its camera.
+ *
+ * @param commandBuffer - The command buffer being recorded
+ */
+void VulkanBaseEngine::bindDescriptorSets(VkCommandBuffer& commandBuffer) {
+  m_vulkanDescriptorSet->bind(
+      commandBuffer, m_pipelineLayout, m_recordingBuffer,
+      m_recordingViewport ? m_recordingViewport->getDescriptorIndex() : 0);
+}
+
+/* -------------------------------- VIEWPORTS ------------------------------- */
+
+/**
+ * @brief Adds a view of the scene in part of the window
+ *
+ * Takes effect at the next recording of the command buffers, which this
+ * asks for. The caller keeps the view's camera up to date, marks the view
+ * dirty when anything it shows changes, and calls submitViewports() from
+ * render().
+ *
+ * @param offset - Top-left corner, as fractions of the window's size
+ * @param size - As fractions of the window's size
+ * @param descriptorIndex - Copy of the per-frame set holding its camera, below
+ * m_maxSets
+ * @param draw - Records the view's objects
+ * @return VulkanViewport* - Owned by the engine
+ */
+VulkanViewport* VulkanBaseEngine::addViewport(
+    glm::vec2 const& offset, glm::vec2 const& size, uint32_t descriptorIndex,
+    VulkanViewport::DrawFunction const& draw) {
+  assert(descriptorIndex < static_cast<uint32_t>(m_maxSets));
+  auto* viewport = new VulkanViewport(
+      m_vulkanDevice, m_cmdPool, m_compositor, &m_retireQueue,
+      m_swapChain.colorFormat, m_depthFormat, descriptorIndex);
+  viewport->setRegion(offset, size);
+  viewport->setDraw(draw);
+  viewport->resize(m_width, m_height);
+  m_viewports.push_back(viewport);
+  m_rebuild = true;
+  return viewport;
+}
+
+/**
+ * @brief Marks every view for drawing again, for changes to the scene that
+ * no camera move or recording shows
+ */
+void VulkanBaseEngine::markSceneChanged() {
+  for (auto* viewport : m_viewports) viewport->markDirty();
+}
+
+/**
+ * @brief Removes every view, going back to one scene over the whole window
+ */
+void VulkanBaseEngine::removeViewports() {
+  if (m_viewports.empty()) return;
+  // their command buffers and targets may still be in use by frames in
+  // flight, and the images' command buffers composite them until recorded
+  for (auto* viewport : m_viewports)
+    m_retireQueue.retire([viewport]() { delete viewport; });
+  m_viewports.clear();
+  m_staleCommandBuffers.assign(m_drawCmdBuffers.size(), true);
+  m_rebuild = true;
+}
+
+/**
+ * @brief Records a view's pass into its command buffer for one frame
+ *
+ * @param viewport
+ * @param frame - Swap chain image, whose uniform ring slot is read
+ * @param clearValues - Color and depth clear values
+ */
+void VulkanBaseEngine::recordViewport(
+    VulkanViewport* viewport, uint32_t frame,
+    std::array<VkClearValue, 2> const& clearValues) {
+  VkCommandBuffer cmd = viewport->getCommandBuffer(frame);
+  VkCommandBufferBeginInfo cmdBufInfo =
+      vks::initializers::commandBufferBeginInfo();
+  VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &cmdBufInfo));
+  viewport->beginRenderPass(cmd, clearValues);
+  m_recordingViewport = viewport;
+  m_sceneExtent = viewport->getExtent();
+  drawScene(cmd);
+  m_recordingViewport = nullptr;
+  vkCmdEndRenderPass(cmd);
+  VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+}
+
+/**
+ * @brief Draws the dirty views again, in the batch ahead of the frame's
+ *
+ * Each view's render pass orders its writes before the main pass samples
+ * its target. Views that are not dirty keep their last image, so a view
+ * that did not change costs nothing but its composite.
+ */
+void VulkanBaseEngine::submitViewports() {
+  for (auto* viewport : m_viewports) {
+    if (!viewport->isDirty()) continue;
+    m_frameCmdBuffers.push_back(viewport->getCommandBuffer(m_currentBuffer));
+    viewport->clearDirty();
+  }
+}
+
 /**
  * @brief Adds commands to set the viewport and scissor to a command buffer
  *
  * These are used to set the dimensions of Vulkan's output at the beginning of
- * a command buffer.
+ * a command buffer. With dynamic resolution, the scene covers only part of
+ * its target; in a view, it covers the view's target.
  *
  * @param commandBuffer - The command buffer being recorded
  */
 void VulkanBaseEngine::setViewPorts(VkCommandBuffer& commandBuffer) {
   VkViewport viewports[1];
   VkRect2D scissorRects[1];
-  viewports[0] = {0, 0, float(m_width), float(m_height), 0.0, 1.0};
-  scissorRects[0] = vks::initializers::rect2D(m_width, m_height, 0, 0);
+  viewports[0] = {0, 0, float(m_sceneExtent.width),
+                  float(m_sceneExtent.height), 0.0, 1.0};
+  scissorRects[0] = vks::initializers::rect2D(m_sceneExtent.width,
+                                              m_sceneExtent.height, 0, 0);
   vkCmdSetViewport(commandBuffer, 0, 1, viewports);
   vkCmdSetScissor(commandBuffer, 0, 1, scissorRects);
 }
@@ -206,32 +587,95 @@ void VulkanBaseEngine::drawUI(const VkCommandBuffer commandBuffer) {
     const VkRect2D scissor = vks::initializers::rect2D(m_width, m_height, 0, 0);
     vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-    m_UIOverlay.draw(commandBuffer);
+    m_UIOverlay.draw(commandBuffer, m_currentBuffer);
   }
 }
 
+/**
+ * @brief Records the current frame's UI pass into its own command buffer,
+ * submitted after the frame's scene
+ *
+ * Runs every frame, once the frame's fence was waited on: uploads the UI into
+ * the frame's buffers, which only grow, and records the UI pass over the
+ * frame buffer. The scene's command buffers are left alone.
+ *
+ * @return VkCommandBuffer - The UI pass, or VK_NULL_HANDLE if there is no UI
+ */
+VkCommandBuffer VulkanBaseEngine::recordOverlay() {
+  if (!m_settings.overlay) return VK_NULL_HANDLE;
+  uint32_t const frameCount = static_cast<uint32_t>(m_drawCmdBuffers.size());
+  if (m_uiCmdBuffers.size() != frameCount) {
+    // the number of swap chain images changed, and every frame is done
+    if (!m_uiCmdBuffers.empty())
+      vkFreeCommandBuffers(m_device, m_cmdPool,
+                           static_cast<uint32_t>(m_uiCmdBuffers.size()),
+                           m_uiCmdBuffers.data());
+    m_uiCmdBuffers.resize(frameCount);
+    VkCommandBufferAllocateInfo allocateInfo =
+        vks::initializers::commandBufferAllocateInfo(
+            m_cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, frameCount);
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(m_device, &allocateInfo,
+                                             m_uiCmdBuffers.data()));
+    m_UIOverlay.setFrameCount(frameCount);
+  }
+  if (!m_UIOverlay.update(m_currentBuffer)) return VK_NULL_HANDLE;
+
+  VkCommandBuffer cmd = m_uiCmdBuffers[m_currentBuffer];
+  VkCommandBufferBeginInfo cmdBufInfo =
+      vks::initializers::commandBufferBeginInfo();
+  cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &cmdBufInfo));
+  VkRenderPassBeginInfo renderPassBeginInfo =
+      vks::initializers::renderPassBeginInfo();
+  renderPassBeginInfo.renderPass = m_uiRenderPass;
+  renderPassBeginInfo.renderArea.extent.width = m_width;
+  renderPassBeginInfo.renderArea.extent.height = m_height;
+  renderPassBeginInfo.framebuffer = m_frameBuffers[m_currentBuffer];
+  vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+  drawUI(cmd);
+  vkCmdEndRenderPass(cmd);
+  VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+  return cmd;
+}
+
 /* ------------------------ META-LEVEL IMPLEMENTATION ----------------------- */
 
 /* -------------------------------------------------------------------------- */
 /*                             VULKAN DESTRUCTION                             */
 /* -------------------------------------------------------------------------- */
 // Vulkan engine components are all managed with RAII, so we are safe to delete
-// them. Only thing we need to worry about is pipeline layout.
+// them. Descriptor set and pipeline layouts go away with the layout cache.
 
 /**
  * @brief Destroy the Vulkan Base Engine:: Vulkan Base Engine object
  *
  * Frees the descriptor set, vertex, descriptions, pipelines, and context
- * pointers. Then deletes the pipeline layout from Vulkan.
+ * pointers, along with the descriptor allocator. The layout cache, the build
+ * queue, the pipelines and the geometry arena belong to the device context.
  */
 VulkanBaseEngine::~VulkanBaseEngine() {
+  // the render loop idled the queue when it quit
+  m_retireQueue.flush();
+  // meshes give their ranges back to the arena, so release them first
+  destroyObjects();
   if (m_settings.overlay) m_UIOverlay.freeResources();
+  if (!m_uiCmdBuffers.empty())
+    vkFreeCommandBuffers(m_device, m_cmdPool,
+                         static_cast<uint32_t>(m_uiCmdBuffers.size()),
+                         m_uiCmdBuffers.data());
+  VK_SAFE_DELETE(m_uiRenderPass,
+                 vkDestroyRenderPass(m_device, m_uiRenderPass, nullptr));
+  for (auto*& viewport : m_viewports) delete_ptr(viewport);
+  delete_ptr(m_dynamicResolution);
+  delete_ptr(m_compositor);
   delete_ptr(m_vulkanDescriptorSet);
+  delete_ptr(m_descriptorAllocator);
   delete_ptr(m_vulkanVertexDescriptions);
+  delete_ptr(m_instancedVertexDescriptions);
+  delete_ptr(m_shaderReloader);
   delete_ptr(m_pipelines);
   delete_ptr(m_context);
-  VK_SAFE_DELETE(m_pipelineLayout,
-                 vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr));
+  delete_ptr(m_uniformRing);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -263,6 +707,7 @@ void VulkanBaseEngine::renderAsyncThread() {
  * Deletes the now-joined thread as well.
  */
 void VulkanBaseEngine::renderJoin() {
+  if (!m_thread) return;
   m_thread->join();
   delete_ptr(m_thread);
 }
@@ -298,6 +743,13 @@ void VulkanBaseEngine::updateOverlay() {
   ImGui::TextUnformatted(m_deviceProperties.deviceName);
   ImGui::Text("%.2f ms/frame (%.1d fps)", m_frameTimer * 1000,
               int(1.f / m_frameTimer));
+  if (ImGui::CollapsingHeader("GPU memory")) drawMemoryReport();
+  if (ImGui::CollapsingHeader("Dynamic resolution")) drawDynamicResolution();
+  if (m_shaderReloader) {
+    for (auto const& error : m_shaderReloader->getErrors())
+      ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "%s\n%s",
+                         error.first.c_str(), error.second.c_str());
+  }
   ImGui::PushItemWidth(110.0f * m_UIOverlay.scale);
   OnUpdateUIOverlay(&m_UIOverlay);
   ImGui::PopItemWidth();
@@ -306,7 +758,9 @@ void VulkanBaseEngine::updateOverlay() {
   ImGui::PopStyleVar();
   ImGui::Render();
 
-  if (m_UIOverlay.update() || m_UIOverlay.updated) {
+  // the UI itself is recorded every frame by recordOverlay(); only settings
+  // changed through it may need the scene recorded again
+  if (m_UIOverlay.updated) {
     buildCommandBuffers();
     m_UIOverlay.updated = false;
   }
@@ -316,6 +770,55 @@ void VulkanBaseEngine::updateOverlay() {
   // DO STUFF FOR IMGUI
 }
 
+/**
+ * @brief Toggles dynamic resolution and sets its frame time budget
+ */
+void VulkanBaseEngine::drawDynamicResolution() {
+  if (!m_viewports.empty()) {
+    ImGui::TextUnformatted("Not used with split views");
+    return;
+  }
+  if (m_UIOverlay.checkBox("Enabled", &m_settings.dynamicResolution))
+    m_dynamicResolution->reset();
+  float targetMs = m_dynamicResolution->getTargetFrameTime();
+  if (ImGui::SliderFloat("Budget (ms)", &targetMs, 8.f, 100.f, "%.1f"))
+    m_dynamicResolution->setTargetFrameTime(targetMs);
+  if (m_settings.dynamicResolution) {
+    ImGui::Text("Scene: %ux%u (%.0f%%), %.2f ms", m_sceneExtent.width,
+                m_sceneExtent.height, m_dynamicResolution->getScale() * 100.f,
+                m_dynamicResolution->getAverageFrameTime());
+  }
+}
+
+/**
+ * @brief Lists current / peak GPU memory per subsystem and per heap
+ *
+ * Heap usage comes from VK_EXT_memory_budget when the device supports it, in
+ * which case it also includes memory we did not allocate ourselves.
+ */
+void VulkanBaseEngine::drawMemoryReport() {
+  double const MiB = 1024.0 * 1024.0;
+  VulkanMemoryTracker& tracker = VulkanMemoryTracker::get();
+  for (uint32_t i = 0;
+       i < static_cast<uint32_t>(VulkanMemoryTracker::Category::COUNT); i++) {
+    auto category = static_cast<VulkanMemoryTracker::Category>(i);
+    VulkanMemoryTracker::Usage usage = tracker.getUsage(category);
+    if (usage.peak == 0) continue;
+    ImGui::Text("%-13s %7.2f MiB (peak %.2f)",
+                VulkanMemoryTracker::getCategoryName(category),
+                usage.current / MiB, usage.peak / MiB);
+  }
+  ImGui::Text("%-13s %7.2f MiB (peak %.2f)", "Total",
+              tracker.getTotal() / MiB, tracker.getPeak() / MiB);
+
+  std::vector<VulkanMemoryTracker::HeapBudget> heaps = tracker.getHeapBudgets();
+  for (size_t i = 0; i < heaps.size(); i++) {
+    ImGui::Text("Heap %zu%s: %.1f / %.1f MiB%s", i,
+                heaps[i].deviceLocal ? " (device)" : "", heaps[i].usage / MiB,
+                heaps[i].budget / MiB, tracker.hasBudget() ? "" : " (est.)");
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                MISCELLANEOUS                               */
 /* -------------------------------------------------------------------------- */
@@ -339,10 +842,32 @@ void VulkanBaseEngine::initWindow() {
 }
 
 void VulkanBaseEngine::updateCommand() {
+  // draws were skipped for pipelines that have been built since the last
+  // recording. The arena's moves are caught in frameCompleted().
+#ifdef PAPERARIUM_SHADER_HOT_RELOAD
+  // reloaded shaders keep drawing with their old pipelines until the new ones
+  // are built, which then triggers the rebuild below. Each image is recorded
+  // again after its own fence, so the swap never waits for the queue.
+  if (m_shaderReloader->poll(m_objs)) m_rebuild = true;
+#endif
+  uint32_t pipelinesCompleted = m_pipelineBuildQueue->getCompleted();
+  if (pipelinesCompleted != m_pipelinesCompleted) m_rebuild = true;
+  if (m_settings.dynamicResolution && m_viewports.empty() &&
+      m_dynamicResolution->update()) {
+    // the scaled viewport is recorded into the command buffers
+    m_rebuild = true;
+  }
   if (m_rebuild) {
     buildCommandBuffers();
     m_rebuild = false;
   }
+  // startup ends once every pipeline queued during prepare is ready
+  if (!m_startupReported && m_pipelineBuildQueue->isIdle()) {
+    auto now = std::chrono::high_resolution_clock::now();
+    m_deviceContext->getPipelineCacheFile().reportStartup(
+        std::chrono::duration<float, std::milli>(now - m_startTime).count());
+    m_startupReported = true;
+  }
 }
 
 /**
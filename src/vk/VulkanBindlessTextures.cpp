@@ -0,0 +1,212 @@
+#include "VulkanBindlessTextures.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanMemoryTracker.h"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+namespace {
+
+// upper bound of the layout's texture array, whatever the device allows;
+// sets only allocate the part of it they use
+constexpr uint32_t MAX_TEXTURES = 65536;
+
+}  // namespace
+
+constexpr uint32_t VulkanBindlessTextures::INVALID_INDEX;
+
+/**
+ * @brief Creates the part buffer and allocates the set with room for
+ * `capacity` textures
+ *
+ * @param vulkanDevice - The device to create the set on
+ * @param layoutCache - Where the set layout is looked up
+ * @param capacity - Textures the table starts with room for, clamped to the
+ * device limits
+ * @param partCapacity - Model parts the table starts with room for
+ */
+VulkanBindlessTextures::VulkanBindlessTextures(
+    vks::VulkanDevice* vulkanDevice, VulkanDescriptorLayoutCache* layoutCache,
+    uint32_t capacity, uint32_t partCapacity)
+    : m_vulkanDevice(vulkanDevice) {
+  // leave one sampler for the shadow map in set 0
+  VkPhysicalDeviceLimits const& limits = vulkanDevice->properties.limits;
+  m_maxCapacity = std::min({MAX_TEXTURES,
+                            limits.maxPerStageDescriptorSamplers - 1,
+                            limits.maxPerStageDescriptorSampledImages - 1,
+                            limits.maxDescriptorSetSamplers - 1});
+  growParts(std::max(partCapacity, 1u));
+
+  // the texture array is the last binding, so its size can vary per set
+  std::vector<VkDescriptorSetLayoutBinding> bindings = {
+      vks::initializers::descriptorSetLayoutBinding(
+          VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0),
+      vks::initializers::descriptorSetLayoutBinding(
+          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          VK_SHADER_STAGE_FRAGMENT_BIT, 1, m_maxCapacity),
+  };
+  std::vector<VkDescriptorBindingFlagsEXT> bindingFlags = {
+      0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+             VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT};
+  m_layout = layoutCache->getLayout(bindings, bindingFlags);
+
+  allocateSet(std::max(std::min(capacity, m_maxCapacity), 1u));
+}
+
+/**
+ * @brief Destroys the set's pool and the part buffer
+ *
+ * The textures themselves belong to whoever added them.
+ */
+VulkanBindlessTextures::~VulkanBindlessTextures() {
+  vkDestroyDescriptorPool(m_vulkanDevice->logicalDevice, m_pool, nullptr);
+  m_parts.unmap();
+  m_parts.destroy();
+}
+
+/**
+ * @brief Replaces the set with one holding `capacity` textures, copying the
+ * textures added so far
+ */
+void VulkanBindlessTextures::allocateSet(uint32_t capacity) {
+  VkDevice device = m_vulkanDevice->logicalDevice;
+
+  // a pool of our own, since the array is far bigger than the shared pools
+  std::vector<VkDescriptorPoolSize> poolSizes = {
+      vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                            1),
+      vks::initializers::descriptorPoolSize(
+          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity),
+  };
+  VkDescriptorPoolCreateInfo descriptorPoolInfo =
+      vks::initializers::descriptorPoolCreateInfo(
+          static_cast<uint32_t>(poolSizes.size()), poolSizes.data(), 1);
+  VkDescriptorPool pool = VK_NULL_HANDLE;
+  VK_CHECK_RESULT(
+      vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &pool));
+
+  VkDescriptorSetVariableDescriptorCountAllocateInfoEXT variableCount = {};
+  variableCount.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+  variableCount.descriptorSetCount = 1;
+  variableCount.pDescriptorCounts = &capacity;
+  VkDescriptorSetAllocateInfo allocInfo =
+      vks::initializers::descriptorSetAllocateInfo(pool, &m_layout, 1);
+  allocInfo.pNext = &variableCount;
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &set));
+
+  if (m_textureCount > 0) {
+    VkCopyDescriptorSet copy = {};
+    copy.sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    copy.srcSet = m_set;
+    copy.srcBinding = 1;
+    copy.dstSet = set;
+    copy.dstBinding = 1;
+    copy.descriptorCount = m_textureCount;
+    vkUpdateDescriptorSets(device, 0, nullptr, 1, &copy);
+  }
+  if (m_pool != VK_NULL_HANDLE)
+    vkDestroyDescriptorPool(device, m_pool, nullptr);
+  m_pool = pool;
+  m_set = set;
+  m_capacity = capacity;
+  writeParts();
+}
+
+/**
+ * @brief Moves the part slots to a buffer with room for `partCapacity` parts
+ */
+void VulkanBindlessTextures::growParts(uint32_t partCapacity) {
+  vks::Buffer parts;
+  {
+    VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::TEXTURE,
+                                     "Bindless parts");
+    VK_CHECK_RESULT(m_vulkanDevice->createBuffer(
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &parts, sizeof(uint32_t) * partCapacity));
+  }
+  VK_CHECK_RESULT(parts.map());
+  if (m_parts.buffer != VK_NULL_HANDLE) {
+    memcpy(parts.mapped, m_parts.mapped, sizeof(uint32_t) * m_partCount);
+    m_parts.unmap();
+    m_parts.destroy();
+  }
+  m_parts = parts;
+  m_parts.setupDescriptor(sizeof(uint32_t) * partCapacity);
+  m_partCapacity = partCapacity;
+  if (m_set != VK_NULL_HANDLE) writeParts();
+}
+
+/**
+ * @brief Points the set's part binding at the part buffer
+ */
+void VulkanBindlessTextures::writeParts() {
+  VkWriteDescriptorSet write = vks::initializers::writeDescriptorSet(
+      m_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &m_parts.descriptor);
+  vkUpdateDescriptorSets(m_vulkanDevice->logicalDevice, 1, &write, 0, nullptr);
+}
+
+/**
+ * @brief Writes a texture into the next free slot of the array, growing the
+ * array when it is full
+ *
+ * @param imageInfo - Sampler, view and layout of the texture
+ * @return uint32_t - The texture's index in the array, or INVALID_INDEX when
+ * the array is at the device's limits. The caller should then draw with a
+ * texture it already added, or without the table.
+ */
+uint32_t VulkanBindlessTextures::addTexture(
+    VkDescriptorImageInfo const& imageInfo) {
+  if (m_textureCount >= m_capacity) {
+    if (m_capacity >= m_maxCapacity) {
+      LOGI("VulkanBindlessTextures|addTexture| Out of texture slots (%u)",
+           m_capacity);
+      return INVALID_INDEX;
+    }
+    allocateSet(std::min(m_capacity * 2, m_maxCapacity));
+  }
+  VkDescriptorImageInfo descriptor = imageInfo;
+  VkWriteDescriptorSet write = vks::initializers::writeDescriptorSet(
+      m_set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &descriptor);
+  write.dstArrayElement = m_textureCount;
+  vkUpdateDescriptorSets(m_vulkanDevice->logicalDevice, 1, &write, 0, nullptr);
+  return m_textureCount++;
+}
+
+/**
+ * @brief Registers the parts of a model, each sampling the texture at the
+ * given index. The part buffer grows when they don't fit.
+ *
+ * @param textureIndices - Texture index of each part, from addTexture()
+ * @return uint32_t - Slot of the first part, which its draw passes as first
+ * instance; the following parts take the following slots
+ */
+uint32_t VulkanBindlessTextures::addParts(
+    std::vector<uint32_t> const& textureIndices) {
+  uint32_t count = static_cast<uint32_t>(textureIndices.size());
+  if (m_partCount + count > m_partCapacity) {
+    uint32_t partCapacity = m_partCapacity;
+    while (m_partCount + count > partCapacity) partCapacity *= 2;
+    growParts(partCapacity);
+  }
+  uint32_t firstPart = m_partCount;
+  memcpy(static_cast<uint32_t*>(m_parts.mapped) + firstPart,
+         textureIndices.data(), sizeof(uint32_t) * count);
+  m_partCount += count;
+  return firstPart;
+}
+
+/**
+ * @brief Binds the table at the given set number
+ */
+void VulkanBindlessTextures::bind(VkCommandBuffer commandBuffer,
+                                  VkPipelineLayout pipelineLayout,
+                                  uint32_t set) const {
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          pipelineLayout, set, 1, &m_set, 0, nullptr);
+}
+
+}  // namespace VulkanEngine
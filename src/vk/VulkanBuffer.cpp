@@ -2,13 +2,36 @@
 
 namespace VulkanEngine {
 
-VulkanBuffer::~VulkanBuffer() {
-  m_uniformBuffer.unmap();
-  m_uniformBuffer.destroy();
-}
-
 void VulkanBuffer::prepare() { prepareUniformBuffers(); }
 
 void VulkanBuffer::update() { updateUniformBuffers(); }
 
-}  // namespace VulkanEngine
\ No newline at end of file
+/**
+ * @brief Reserves the uniform block in the ring and seeds every frame's copy
+ *
+ * @param size - Size of the uniform block
+ * @param data - Initial contents of the block
+ */
+void VulkanBuffer::createUniformBuffer(VkDeviceSize size, void const* data) {
+  m_allocation = m_context->uniformRing->allocate(size);
+  m_descriptor = m_context->uniformRing->getDescriptor(m_allocation);
+  m_context->uniformRing->writeAll(m_allocation, data);
+}
+
+/**
+ * @brief Writes the uniform block for the frame currently being rendered
+ *
+ * Other frames' copies are left alone, so the GPU may still be reading them.
+ */
+void VulkanBuffer::writeUniformBuffer(void const* data) {
+  m_context->uniformRing->write(m_allocation, data, *m_context->pCurrentFrame);
+}
+
+/**
+ * @brief Returns the dynamic offset of this block in the given frame's slot
+ */
+uint32_t VulkanBuffer::getDynamicOffset(uint32_t frame) const {
+  return m_context->uniformRing->getDynamicOffset(m_allocation, frame);
+}
+
+}  // namespace VulkanEngine
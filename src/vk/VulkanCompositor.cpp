@@ -0,0 +1,159 @@
+#include "VulkanCompositor.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanPipelineBuildQueue.h"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+namespace {
+
+struct CompositeConstants {
+  // drawn extent over target size, and the furthest texel center sampled
+  glm::vec2 uvScale;
+  glm::vec2 uvMax;
+};
+
+}  // namespace
+
+/**
+ * @brief Creates the layouts shared by every composited target. The pipeline
+ * is created by preparePipeline().
+ *
+ * @param device
+ * @param layoutCache
+ * @param allocator
+ */
+VulkanCompositor::VulkanCompositor(VkDevice device,
+                                   VulkanDescriptorLayoutCache* layoutCache,
+                                   VulkanDescriptorAllocator* allocator) {
+  m_device = device;
+  m_allocator = allocator;
+  m_setLayout = layoutCache->getLayout(
+      {vks::initializers::descriptorSetLayoutBinding(
+          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          VK_SHADER_STAGE_FRAGMENT_BIT, 0)});
+  m_pipelineLayout = layoutCache->getPipelineLayout(
+      {m_setLayout},
+      {vks::initializers::pushConstantRange(VK_SHADER_STAGE_FRAGMENT_BIT,
+                                            sizeof(CompositeConstants), 0)});
+}
+
+VulkanCompositor::~VulkanCompositor() {
+  VK_SAFE_DELETE(m_pipeline, vkDestroyPipeline(m_device, m_pipeline, nullptr));
+}
+
+/**
+ * @brief Creates the composite pipeline
+ *
+ * @param pipelineCache
+ * @param renderPass - The main render pass, which the targets are drawn into
+ * @param shaders - Vertex and fragment stages of the composite
+ */
+void VulkanCompositor::preparePipeline(
+    VkPipelineCache pipelineCache, VkRenderPass renderPass,
+    std::vector<VkPipelineShaderStageCreateInfo> const& shaders) {
+  PipelineDescription description;
+  description.stages = shaders;
+  // the triangle's corners come from the vertex index
+  description.inputAssemblyState =
+      vks::initializers::pipelineInputAssemblyStateCreateInfo(
+          VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+  description.rasterizationState =
+      vks::initializers::pipelineRasterizationStateCreateInfo(
+          VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE,
+          VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+  description.blendAttachmentState =
+      vks::initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
+  description.colorBlendState =
+      vks::initializers::pipelineColorBlendStateCreateInfo(
+          1, &description.blendAttachmentState);
+  description.depthStencilState =
+      vks::initializers::pipelineDepthStencilStateCreateInfo(
+          VK_FALSE, VK_FALSE, VK_COMPARE_OP_ALWAYS);
+  description.viewportState =
+      vks::initializers::pipelineViewportStateCreateInfo(1, 1, 0);
+  description.multisampleState =
+      vks::initializers::pipelineMultisampleStateCreateInfo(
+          VK_SAMPLE_COUNT_1_BIT, 0);
+  description.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT,
+                               VK_DYNAMIC_STATE_SCISSOR};
+  description.layout = m_pipelineLayout;
+  description.renderPass = renderPass;
+  m_pipeline = description.create(m_device, pipelineCache);
+}
+
+/**
+ * @brief Allocates a descriptor set for one target, reusing a released one
+ * if there is any
+ */
+VkDescriptorSet VulkanCompositor::allocate() {
+  if (!m_freeSets.empty()) {
+    VkDescriptorSet descriptorSet = m_freeSets.back();
+    m_freeSets.pop_back();
+    return descriptorSet;
+  }
+  VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+  VK_CHECK_RESULT(m_allocator->allocate(m_setLayout, &descriptorSet));
+  return descriptorSet;
+}
+
+/**
+ * @brief Gives a target's set back, once no frame in flight reads it
+ *
+ * @param descriptorSet
+ */
+void VulkanCompositor::release(VkDescriptorSet descriptorSet) {
+  m_freeSets.push_back(descriptorSet);
+}
+
+/**
+ * @brief Points a target's descriptor set at its color image, after the
+ * target was (re)created
+ *
+ * @param descriptorSet
+ * @param image
+ */
+void VulkanCompositor::write(VkDescriptorSet descriptorSet,
+                             VkDescriptorImageInfo const* image) const {
+  VkWriteDescriptorSet write = vks::initializers::writeDescriptorSet(
+      descriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, image);
+  vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+}
+
+/**
+ * @brief Draws the top-left part of a target into a rectangle of the current
+ * render pass
+ *
+ * @param cmd
+ * @param descriptorSet - The target's set
+ * @param rect - Where to draw, in pixels of the render pass
+ * @param drawn - The part of the target that was drawn into
+ * @param size - The target's size
+ */
+void VulkanCompositor::draw(VkCommandBuffer cmd, VkDescriptorSet descriptorSet,
+                            VkRect2D const& rect, VkExtent2D const& drawn,
+                            VkExtent2D const& size) const {
+  if (m_pipeline == VK_NULL_HANDLE) return;
+  VkViewport viewport = vks::initializers::viewport(
+      static_cast<float>(rect.extent.width),
+      static_cast<float>(rect.extent.height), 0.f, 1.f);
+  viewport.x = static_cast<float>(rect.offset.x);
+  viewport.y = static_cast<float>(rect.offset.y);
+  vkCmdSetViewport(cmd, 0, 1, &viewport);
+  vkCmdSetScissor(cmd, 0, 1, &rect);
+  CompositeConstants constants;
+  constants.uvScale = glm::vec2(drawn.width, drawn.height) /
+                      glm::vec2(size.width, size.height);
+  // stop half a texel short of the edge, past which bilinear filtering would
+  // read what was not drawn this frame
+  constants.uvMax = (glm::vec2(drawn.width, drawn.height) - 0.5f) /
+                    glm::vec2(size.width, size.height);
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          m_pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+  vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                     sizeof(constants), &constants);
+  vkCmdDraw(cmd, 3, 1, 0, 0);
+}
+
+}  // namespace VulkanEngine
@@ -0,0 +1,79 @@
+#include "VulkanDescriptorAllocator.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Construct a new Vulkan Descriptor Allocator
+ *
+ * @param device - The device the pools are created on
+ * @param setsPerPool - How many sets each pool holds before a new one is taken
+ */
+VulkanDescriptorAllocator::VulkanDescriptorAllocator(VkDevice device,
+                                                     uint32_t setsPerPool)
+    : m_device(device), m_setsPerPool(setsPerPool) {}
+
+/**
+ * @brief Destroys every pool, and with them every set allocated from them
+ */
+VulkanDescriptorAllocator::~VulkanDescriptorAllocator() {
+  for (auto& pool : m_pools) vkDestroyDescriptorPool(m_device, pool, nullptr);
+}
+
+/**
+ * @brief Allocates a descriptor set, taking a new pool if the current one is
+ * full
+ *
+ * @param layout - Layout of the set
+ * @param descriptorSet - Receives the allocated set
+ * @return VkResult
+ */
+VkResult VulkanDescriptorAllocator::allocate(VkDescriptorSetLayout layout,
+                                             VkDescriptorSet* descriptorSet) {
+  if (m_currentPool == VK_NULL_HANDLE) {
+    m_currentPool = createPool();
+    m_pools.push_back(m_currentPool);
+  }
+  VkDescriptorSetAllocateInfo allocInfo =
+      vks::initializers::descriptorSetAllocateInfo(m_currentPool, &layout, 1);
+  VkResult result = vkAllocateDescriptorSets(m_device, &allocInfo, descriptorSet);
+  if (result == VK_ERROR_FRAGMENTED_POOL ||
+      result == VK_ERROR_OUT_OF_POOL_MEMORY) {
+    // the pool is full, try once more with a fresh one
+    m_currentPool = createPool();
+    m_pools.push_back(m_currentPool);
+    allocInfo.descriptorPool = m_currentPool;
+    result = vkAllocateDescriptorSets(m_device, &allocInfo, descriptorSet);
+  }
+  return result;
+}
+
+/**
+ * @brief Creates a new pool
+ *
+ * Pools hold m_setsPerPool sets, with descriptor counts scaled by how often
+ * each type shows up in our sets.
+ */
+VkDescriptorPool VulkanDescriptorAllocator::createPool() {
+  std::vector<VkDescriptorPoolSize> poolSizes = {
+      vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                            m_setsPerPool),
+      vks::initializers::descriptorPoolSize(
+          VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, m_setsPerPool),
+      vks::initializers::descriptorPoolSize(
+          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_setsPerPool * 4),
+      vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                            m_setsPerPool),
+      vks::initializers::descriptorPoolSize(
+          VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, m_setsPerPool),
+  };
+  VkDescriptorPoolCreateInfo descriptorPoolInfo =
+      vks::initializers::descriptorPoolCreateInfo(
+          static_cast<uint32_t>(poolSizes.size()), poolSizes.data(),
+          m_setsPerPool);
+  VkDescriptorPool pool;
+  VK_CHECK_RESULT(
+      vkCreateDescriptorPool(m_device, &descriptorPoolInfo, nullptr, &pool));
+  return pool;
+}
+
+}  // namespace VulkanEngine
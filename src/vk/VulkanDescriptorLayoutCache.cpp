@@ -0,0 +1,113 @@
+#include "VulkanDescriptorLayoutCache.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Destroys every pipeline layout and set layout the cache created
+ */
+VulkanDescriptorLayoutCache::~VulkanDescriptorLayoutCache() {
+  for (auto& entry : m_pipelineLayouts)
+    vkDestroyPipelineLayout(m_device, entry.second, nullptr);
+  for (auto& entry : m_layouts)
+    vkDestroyDescriptorSetLayout(m_device, entry.second, nullptr);
+}
+
+/**
+ * @brief Returns the set layout for the given bindings, creating it the first
+ * time the signature is seen
+ *
+ * Binding flags need VK_EXT_descriptor_indexing and are left out when empty.
+ *
+ * @param bindings - The bindings of the set, in any order
+ * @param bindingFlags - Flags of each binding, in the same order, or empty
+ * @return VkDescriptorSetLayout
+ */
+VkDescriptorSetLayout VulkanDescriptorLayoutCache::getLayout(
+    std::vector<VkDescriptorSetLayoutBinding> bindings,
+    std::vector<VkDescriptorBindingFlagsEXT> bindingFlags) {
+  assert(bindingFlags.empty() || bindingFlags.size() == bindings.size());
+  // sort the bindings, carrying their flags along
+  std::vector<size_t> order(bindings.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&bindings](size_t a, size_t b) {
+    return bindings[a].binding < bindings[b].binding;
+  });
+  std::vector<VkDescriptorSetLayoutBinding> sortedBindings;
+  std::vector<VkDescriptorBindingFlagsEXT> sortedFlags;
+  for (size_t i : order) {
+    sortedBindings.push_back(bindings[i]);
+    if (!bindingFlags.empty()) sortedFlags.push_back(bindingFlags[i]);
+  }
+
+  std::vector<uint64_t> key;
+  for (size_t i = 0; i < sortedBindings.size(); i++) {
+    auto const& binding = sortedBindings[i];
+    key.push_back(uint64_t(binding.binding) << 32 | binding.descriptorType);
+    key.push_back(uint64_t(binding.descriptorCount) << 32 |
+                  binding.stageFlags);
+    if (!sortedFlags.empty()) key.push_back(sortedFlags[i]);
+  }
+  // flagged and unflagged layouts of the same bindings must not collide
+  key.push_back(sortedFlags.empty() ? 0 : 1);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_layouts.find(key);
+  if (it != m_layouts.end()) return it->second;
+
+  VkDescriptorSetLayoutCreateInfo descriptorLayout =
+      vks::initializers::descriptorSetLayoutCreateInfo(
+          sortedBindings.data(), static_cast<uint32_t>(sortedBindings.size()));
+  VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+  if (!sortedFlags.empty()) {
+    bindingFlagsInfo.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(sortedFlags.size());
+    bindingFlagsInfo.pBindingFlags = sortedFlags.data();
+    descriptorLayout.pNext = &bindingFlagsInfo;
+  }
+  VkDescriptorSetLayout layout;
+  VK_CHECK_RESULT(
+      vkCreateDescriptorSetLayout(m_device, &descriptorLayout, nullptr, &layout));
+  m_layouts[key] = layout;
+  return layout;
+}
+
+/**
+ * @brief Returns the pipeline layout for the given sets and push constants,
+ * creating it the first time the combination is seen
+ *
+ * @param setLayouts - One layout per set, in set order
+ * @param pushConstantRanges - Push constant ranges of the pipelines
+ * @return VkPipelineLayout
+ */
+VkPipelineLayout VulkanDescriptorLayoutCache::getPipelineLayout(
+    std::vector<VkDescriptorSetLayout> const& setLayouts,
+    std::vector<VkPushConstantRange> const& pushConstantRanges) {
+  std::vector<uint64_t> key;
+  for (auto const& setLayout : setLayouts)
+    key.push_back((uint64_t)setLayout);
+  // separates the sets from the ranges, so the key is unambiguous
+  key.push_back(~0ull);
+  for (auto const& range : pushConstantRanges) {
+    key.push_back(range.stageFlags);
+    key.push_back(uint64_t(range.offset) << 32 | range.size);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_pipelineLayouts.find(key);
+  if (it != m_pipelineLayouts.end()) return it->second;
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
+      vks::initializers::pipelineLayoutCreateInfo(
+          setLayouts.data(), static_cast<uint32_t>(setLayouts.size()));
+  pipelineLayoutCreateInfo.pushConstantRangeCount =
+      static_cast<uint32_t>(pushConstantRanges.size());
+  pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+  VkPipelineLayout pipelineLayout;
+  VK_CHECK_RESULT(vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo,
+                                         nullptr, &pipelineLayout));
+  m_pipelineLayouts[key] = pipelineLayout;
+  return pipelineLayout;
+}
+
+}  // namespace VulkanEngine
@@ -1,4 +1,5 @@
 #include "VulkanDescriptorSet.h"
+#include "VulkanBuffer.h"
 
 namespace VulkanEngine {
 
@@ -6,31 +7,21 @@ namespace VulkanEngine {
  * @brief Construct a new Vulkan Descriptor Set:: Vulkan Descriptor Set object
  *
  * @param device The device which will read from the descriptor
+ * @param layoutCache Where the set layout is looked up
+ * @param allocator Where the sets are allocated from
+ * @param set The set number this descriptor set is bound to
  * @param maxSets The maximum number of sets in this descriptor
  */
-VulkanDescriptorSet::VulkanDescriptorSet(VkDevice device, int maxSets) {
+VulkanDescriptorSet::VulkanDescriptorSet(
+    VkDevice device, VulkanDescriptorLayoutCache* layoutCache,
+    VulkanDescriptorAllocator* allocator, uint32_t set, int maxSets) {
   m_device = device;
+  m_layoutCache = layoutCache;
+  m_allocator = allocator;
+  m_set = set;
   m_descriptorSets.resize(maxSets);
 }
 
-/**
- * @brief Destroy the Vulkan Descriptor Set:: Vulkan Descriptor Set object
- *
- * Deallocates the descriptor sets, descriptor pool, and descriptor set layout
- * referenced in this object.
- */
-VulkanDescriptorSet::~VulkanDescriptorSet() {
-  for (auto& descriptorSet : m_descriptorSets)
-    VK_SAFE_DELETE(
-        descriptorSet,
-        vkFreeDescriptorSets(m_device, m_descriptorPool, 1, &descriptorSet));
-  VK_SAFE_DELETE(m_descriptorPool,
-                 vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr));
-  VK_SAFE_DELETE(
-      m_descriptorSetLayout,
-      vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr));
-}
-
 /**
  * @brief Adds an image (sampler) binding to the descriptor set
  *
@@ -82,79 +73,52 @@ void VulkanDescriptorSet::addBinding(uint32_t binding,
 }
 
 /**
- * @brief Generates a pipeline layout for the descriptor sets
- *
- * Read more:
- * https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineLayout.html
- * "Zero or more descriptor set layouts and zero or more push constant ranges
- * are combined to form a pipeline layout object describing the complete set of
- * resources that *can* be accessed by a pipeline. The pipeline layout
- * represents a sequence of descriptor sets with each having a specific layout.
- * This sequence of layouts is used to determine the interface between shader
- * stages and shader resources. Each pipeline is created using a pipeline
- * layout."
- *
- * @param pipelineLayout
+ * @brief Adds a uniform block from the per-frame uniform ring to the
+ * descriptor set
+ *
+ * The binding is a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, whose offset
+ * into the ring is supplied by bind() for the frame being recorded.
+ *
+ * @param binding
+ * @param uniformBuffer
+ * @param stageFlags
+ * @param descriptorIndex
+ */
+void VulkanDescriptorSet::addBinding(uint32_t binding,
+                                     VulkanBuffer* uniformBuffer,
+                                     VkShaderStageFlags stageFlags,
+                                     int descriptorIndex) {
+  addBinding(binding, &uniformBuffer->getDescriptor(),
+             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stageFlags,
+             descriptorIndex);
+  m_descriptorInfos.back().dynamicBuffer = uniformBuffer;
+}
+
+/**
+ * @brief Looks up the set layout and allocates and writes the descriptor sets
+ *
+ * The layout is shared with every other set of the same signature, so
+ * building a set does not invalidate pipelines created from another one.
  */
-void VulkanDescriptorSet::GenPipelineLayout(VkPipelineLayout* pipelineLayout) {
-  // initialize all of our descriptor set layouts
-  std::vector<VkDescriptorPoolSize> poolSizes;
+void VulkanDescriptorSet::build() {
   std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings;
   std::vector<std::vector<VkWriteDescriptorSet>> writeDescriptorSets(
       m_descriptorSets.size());
   for (auto& descriptorInfo : m_descriptorInfos) {
-    poolSizes.push_back(vks::initializers::descriptorPoolSize(
-        descriptorInfo.descriptorType, 1));
     if (descriptorInfo.descriptorIndex == 0) {
       setLayoutBindings.push_back(vks::initializers::descriptorSetLayoutBinding(
           descriptorInfo.descriptorType, descriptorInfo.stageFlags,
           descriptorInfo.binding));
     }
-    if (descriptorInfo.type == DescriptorType::IMAGE) {
-      writeDescriptorSets[descriptorInfo.descriptorIndex].push_back(
-          vks::initializers::writeDescriptorSet(
-              nullptr, descriptorInfo.descriptorType, descriptorInfo.binding,
-              descriptorInfo.descriptorImageInfo));
-    } else {
-      writeDescriptorSets[descriptorInfo.descriptorIndex].push_back(
-          vks::initializers::writeDescriptorSet(
-              nullptr, descriptorInfo.descriptorType, descriptorInfo.binding,
-              descriptorInfo.descriptorBufferInfo));
-    }
+    writeDescriptorSets[descriptorInfo.descriptorIndex].push_back(
+        getWrite(descriptorInfo));
   }
-  // initialize a descriptor pool for all of our descriptor sets
-  VkDescriptorPoolCreateInfo descriptorPoolInfo =
-      vks::initializers::descriptorPoolCreateInfo(
-          static_cast<uint32_t>(poolSizes.size()), poolSizes.data(),
-          m_descriptorSets.size());
-  descriptorPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-  VK_CHECK_RESULT(vkCreateDescriptorPool(m_device, &descriptorPoolInfo, nullptr,
-                                         &m_descriptorPool));
-  // determine a descriptor set layout based on the descriptor pool
-  VkDescriptorSetLayoutCreateInfo descriptorLayout =
-      vks::initializers::descriptorSetLayoutCreateInfo(
-          setLayoutBindings.data(),
-          static_cast<uint32_t>(setLayoutBindings.size()));
-  VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_device, &descriptorLayout,
-                                              nullptr, &m_descriptorSetLayout));
-  // now use descriptor set layout to build our pipeline layout
-  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
-      vks::initializers::pipelineLayoutCreateInfo(&m_descriptorSetLayout, 1);
-  VkPushConstantRange pushConstantRange = vks::initializers::pushConstantRange(
-      VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), 0);
-  pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-  pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
-  VK_CHECK_RESULT(vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo,
-                                         nullptr, pipelineLayout));
-
-  // now, using our pipeline layoutm, allocate our descriptor sets
-  for (int i = 0; i < m_descriptorSets.size(); i++) {
-    VkDescriptorSetAllocateInfo allocInfo =
-        vks::initializers::descriptorSetAllocateInfo(m_descriptorPool,
-                                                     &m_descriptorSetLayout, 1);
+  m_descriptorSetLayout = m_layoutCache->getLayout(setLayoutBindings);
+
+  // now allocate our descriptor sets and point them at their resources
+  for (size_t i = 0; i < m_descriptorSets.size(); i++) {
     VK_CHECK_RESULT(
-        vkAllocateDescriptorSets(m_device, &allocInfo, &m_descriptorSets[i]));
-    // save the locations of the descriptor sets for later use
+        m_allocator->allocate(m_descriptorSetLayout, &m_descriptorSets[i]));
     for (size_t j = 0; j < writeDescriptorSets[i].size(); j++)
       writeDescriptorSets[i][j].dstSet = m_descriptorSets[i];
     vkUpdateDescriptorSets(m_device,
@@ -163,6 +127,94 @@ void VulkanDescriptorSet::GenPipelineLayout(VkPipelineLayout* pipelineLayout) {
   }
 }
 
+/**
+ * @brief Points an image binding at a new resource, rewriting only that
+ * descriptor
+ *
+ * The set must not be in use by a command buffer in flight.
+ *
+ * @param binding
+ * @param descriptorInfo
+ * @param descriptorIndex
+ */
+void VulkanDescriptorSet::update(uint32_t binding,
+                                 VkDescriptorImageInfo* descriptorInfo,
+                                 int descriptorIndex) {
+  for (auto& info : m_descriptorInfos) {
+    if (info.binding != binding || info.descriptorIndex != descriptorIndex)
+      continue;
+    info.descriptorImageInfo = descriptorInfo;
+    VkWriteDescriptorSet write = getWrite(info);
+    write.dstSet = m_descriptorSets[descriptorIndex];
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, NULL);
+  }
+}
+
+/**
+ * @brief Points a buffer binding at a new resource, rewriting only that
+ * descriptor
+ *
+ * The set must not be in use by a command buffer in flight.
+ *
+ * @param binding
+ * @param descriptorInfo
+ * @param descriptorIndex
+ */
+void VulkanDescriptorSet::update(uint32_t binding,
+                                 VkDescriptorBufferInfo* descriptorInfo,
+                                 int descriptorIndex) {
+  for (auto& info : m_descriptorInfos) {
+    if (info.binding != binding || info.descriptorIndex != descriptorIndex)
+      continue;
+    info.descriptorBufferInfo = descriptorInfo;
+    VkWriteDescriptorSet write = getWrite(info);
+    write.dstSet = m_descriptorSets[descriptorIndex];
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, NULL);
+  }
+}
+
+/**
+ * @brief Moves the bindings to other descriptor sets, written from their
+ * current resources, and returns the sets they replaced
+ *
+ * Unlike update(), this may be called while command buffers in flight use
+ * the sets. Those must be recorded again, and the replaced sets given to
+ * recycle() once the frames using them are done.
+ *
+ * @return std::vector<VkDescriptorSet> - The replaced sets
+ */
+std::vector<VkDescriptorSet> VulkanDescriptorSet::reallocate() {
+  std::vector<VkDescriptorSet> replaced = m_descriptorSets;
+  for (auto& descriptorSet : m_descriptorSets) {
+    if (m_spareSets.empty()) {
+      VK_CHECK_RESULT(
+          m_allocator->allocate(m_descriptorSetLayout, &descriptorSet));
+    } else {
+      descriptorSet = m_spareSets.back();
+      m_spareSets.pop_back();
+    }
+  }
+  std::vector<VkWriteDescriptorSet> writes;
+  for (auto const& descriptorInfo : m_descriptorInfos) {
+    writes.push_back(getWrite(descriptorInfo));
+    writes.back().dstSet = m_descriptorSets[descriptorInfo.descriptorIndex];
+  }
+  vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()),
+                         writes.data(), 0, NULL);
+  return replaced;
+}
+
+/**
+ * @brief Takes back sets reallocate() replaced, for its next call
+ *
+ * @param descriptorSets - Sets no command buffer in flight uses anymore
+ */
+void VulkanDescriptorSet::recycle(
+    std::vector<VkDescriptorSet> const& descriptorSets) {
+  m_spareSets.insert(m_spareSets.end(), descriptorSets.begin(),
+                     descriptorSets.end());
+}
+
 /**
  * @brief Retrieves the descriptor set at index i
  *
@@ -185,4 +237,51 @@ VkDescriptorSet& VulkanDescriptorSet::get(int index) {
  */
 size_t VulkanDescriptorSet::getSize() { return m_descriptorSets.size(); }
 
+/**
+ * @brief Binds the descriptor set at index i, pointing its dynamic uniform
+ * buffers at the given frame's slot of the uniform ring
+ *
+ * @param commandBuffer - The command buffer being recorded
+ * @param pipelineLayout - Layout the set is bound to, at its set number
+ * @param frame - Swap chain image the command buffer renders to
+ * @param index - Which descriptor set to bind
+ */
+void VulkanDescriptorSet::bind(VkCommandBuffer commandBuffer,
+                               VkPipelineLayout pipelineLayout, uint32_t frame,
+                               int index) {
+  // dynamic offsets are consumed in binding order
+  std::vector<std::pair<uint32_t, uint32_t>> dynamicOffsets;
+  for (auto const& descriptorInfo : m_descriptorInfos) {
+    if (descriptorInfo.dynamicBuffer &&
+        descriptorInfo.descriptorIndex == index) {
+      dynamicOffsets.emplace_back(
+          descriptorInfo.binding,
+          descriptorInfo.dynamicBuffer->getDynamicOffset(frame));
+    }
+  }
+  std::sort(dynamicOffsets.begin(), dynamicOffsets.end());
+  std::vector<uint32_t> offsets;
+  for (auto const& dynamicOffset : dynamicOffsets)
+    offsets.push_back(dynamicOffset.second);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          pipelineLayout, m_set, 1, &get(index),
+                          static_cast<uint32_t>(offsets.size()),
+                          offsets.data());
+}
+
+/**
+ * @brief Builds the write for a single binding, without a destination set
+ */
+VkWriteDescriptorSet VulkanDescriptorSet::getWrite(
+    DescriptorInfo const& descriptorInfo) {
+  if (descriptorInfo.type == DescriptorType::IMAGE) {
+    return vks::initializers::writeDescriptorSet(
+        nullptr, descriptorInfo.descriptorType, descriptorInfo.binding,
+        descriptorInfo.descriptorImageInfo);
+  }
+  return vks::initializers::writeDescriptorSet(
+      nullptr, descriptorInfo.descriptorType, descriptorInfo.binding,
+      descriptorInfo.descriptorBufferInfo);
+}
+
 }  // namespace VulkanEngine
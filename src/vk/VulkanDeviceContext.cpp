@@ -0,0 +1,413 @@
+#include "VulkanDeviceContext.h"
+#include "VulkanMemoryTracker.h"
+#include "VulkanTools.h"
+#include "texture/VulkanTexture2D.h"
+#include "vertex_struct.h"
+
+namespace VulkanEngine {
+
+namespace {
+
+// the context of the windows open now, if any
+std::mutex g_contextMutex;
+std::weak_ptr<VulkanDeviceContext> g_context;
+
+}  // namespace
+
+/**
+ * @brief Gives the calling window the process's device context, creating it
+ * if no other window holds one
+ *
+ * @param debug - Whether to enable the validation layer, if the context is
+ * created by this call
+ * @return std::shared_ptr<VulkanDeviceContext>
+ */
+std::shared_ptr<VulkanDeviceContext> VulkanDeviceContext::acquire(
+    bool debug) {
+  std::lock_guard<std::mutex> lock(g_contextMutex);
+  std::shared_ptr<VulkanDeviceContext> context = g_context.lock();
+  if (context) return context;
+  // the constructor is protected, so make_shared can't reach it
+  context.reset(new VulkanDeviceContext());
+  context->createInstance(debug);
+  context->pickPhysicalDevice();
+  context->createLogicalDevice();
+  LOGI("VulkanDeviceContext|acquire| %s",
+       context->m_deviceProperties.deviceName);
+  g_context = context;
+  return context;
+}
+
+/**
+ * @brief Destroys the device once the last window let go of it
+ *
+ * Saves the pipeline cache first, and reports any device memory that was not
+ * freed by the windows.
+ */
+VulkanDeviceContext::~VulkanDeviceContext() {
+  if (m_device != VK_NULL_HANDLE) vkDeviceWaitIdle(m_device);
+  // let the workers finish before the pipeline cache goes away
+  delete_ptr(m_pipelineBuildQueue);
+  // pipelines, then what they were built from
+  delete_ptr(m_shaderModuleCache);
+  delete_ptr(m_pipelineMap);
+  delete_ptr(m_renderPassCache);
+  delete_ptr(m_descriptorLayoutCache);
+  delete_ptr(m_geometryArena);
+  m_pipelineCacheFile.save(m_device, m_pipelineCache);
+  VK_SAFE_DELETE(m_pipelineCache,
+                 vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr));
+  // everything allocated from the device should have been freed by now
+  VulkanMemoryTracker::get().reportLeaks();
+  VulkanMemoryTracker::get().detach();
+  delete_ptr(m_vulkanDevice);
+  VK_SAFE_DELETE(m_instance, vkDestroyInstance(m_instance, nullptr));
+}
+
+/**
+ * @brief Loads a texture from a file, or shares the one a window already
+ * loaded from it
+ *
+ * The texture is destroyed with the last window's reference to it, so
+ * release it only once the window's frames that sample it are done.
+ *
+ * @param path - Image file, read with stb_image
+ * @param format - Format of the texture's image
+ * @return std::shared_ptr<VulkanTexture2D>
+ */
+std::shared_ptr<VulkanTexture2D> VulkanDeviceContext::loadTexture(
+    std::string const& path, VkFormat format) {
+  std::lock_guard<std::mutex> lock(m_textureMutex);
+  std::weak_ptr<VulkanTexture2D>& cached = m_textures[{path, format}];
+  std::shared_ptr<VulkanTexture2D> texture = cached.lock();
+  if (texture) return texture;
+  texture = VkObject::New<VulkanTexture2D>(nullptr);
+  texture->loadFromFile(path, format, m_vulkanDevice, m_queue);
+  cached = texture;
+  return texture;
+}
+
+/* ----------------------------- IMPLEMENTATION ----------------------------- */
+
+/**
+ * @brief Builds the Vulkan instance itself
+ *
+ * Applies platform-specific extensions as well as validation layers (if we
+ * are using debug mode) that enable easy cross-platform Vulkan development.
+ */
+void VulkanDeviceContext::createInstance(bool debug) {
+  VkApplicationInfo appInfo = {};
+  appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  appInfo.pApplicationName = "Paperarium Design";
+  appInfo.pEngineName = "Paperarium Design";
+  appInfo.apiVersion = VK_API_VERSION_1_0;
+  std::vector<char const*> instanceExtensions = {VK_KHR_SURFACE_EXTENSION_NAME};
+
+  // enable surface extensions depending on OS
+#if defined(_WIN32)
+  instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#elif defined(_DIRECT2DISPLAY)
+  instanceExtensions.push_back(VK_KHR_DISPLAY_EXTENSION_NAME);
+#elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
+  instanceExtensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
+#elif defined(VK_USE_PLATFORM_XCB_KHR)
+  instanceExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
+#elif defined(VK_USE_PLATFORM_MACOS_MVK)
+  instanceExtensions.push_back(VK_MVK_MACOS_SURFACE_EXTENSION_NAME);
+#elif defined(VK_USE_PLATFORM_HEADLESS_EXT)
+  instanceExtensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+#endif
+
+  // get extensions supported by the instance and store for later use
+  uint32_t extCount = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &extCount, nullptr);
+  if (extCount > 0) {
+    std::vector<VkExtensionProperties> extensions(extCount);
+    if (vkEnumerateInstanceExtensionProperties(
+            nullptr, &extCount, &extensions.front()) == VK_SUCCESS) {
+      for (VkExtensionProperties extension : extensions) {
+        m_supportedInstanceExtensions.push_back(extension.extensionName);
+      }
+    }
+  }
+
+  // SRS - When running on iOS/macOS with MoltenVK, enable
+  // VK_KHR_get_physical_device_properties2 if not already enabled
+  // (required by VK_KHR_portability_subset)
+#if defined(VK_USE_PLATFORM_MACOS_MVK)
+  if (std::find(m_enabledInstanceExtensions.begin(),
+                m_enabledInstanceExtensions.end(),
+                VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) ==
+      m_enabledInstanceExtensions.end()) {
+    m_enabledInstanceExtensions.push_back(
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  }
+#endif
+
+  // VK_KHR_get_physical_device_properties2 lets us query extended device
+  // properties like the memory budget, so enable it wherever it's available
+  if (std::find(m_supportedInstanceExtensions.begin(),
+                m_supportedInstanceExtensions.end(),
+                VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) !=
+          m_supportedInstanceExtensions.end() &&
+      !isInstanceExtensionEnabled(
+          VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+    m_enabledInstanceExtensions.push_back(
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  }
+
+  // enable requested instance extensions
+  if (m_enabledInstanceExtensions.size() > 0) {
+    for (char const* enabledExtension : m_enabledInstanceExtensions) {
+      instanceExtensions.push_back(enabledExtension);
+    }
+  }
+
+  // build the Vulkan instance create struct
+  VkInstanceCreateInfo instanceCreateInfo = {};
+  instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  instanceCreateInfo.pNext = NULL;
+  instanceCreateInfo.pApplicationInfo = &appInfo;
+
+#if defined(VK_USE_PLATFORM_MACOS_MVK)
+  // SRS - When running on iOS/macOS with MoltenVK and
+  // VK_KHR_portability_enumeration is defined and supported by the instance,
+  // enable the extension and the flag
+  if (std::find(m_supportedInstanceExtensions.begin(),
+                m_supportedInstanceExtensions.end(),
+                VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME) !=
+      m_supportedInstanceExtensions.end()) {
+    instanceExtensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
+    instanceCreateInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+  }
+#endif
+
+  // add extensions
+  if (instanceExtensions.size() > 0) {
+    if (debug) {
+      instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+      instanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+    }
+    instanceCreateInfo.enabledExtensionCount =
+        (uint32_t)instanceExtensions.size();
+    instanceCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
+  }
+  // if debugging, add validation layer
+  if (debug) {
+    // the VK_LAYER_KHRONOS_validation contains all current validation
+    // functionality
+    char const* validationLayerName = "VK_LAYER_KHRONOS_validation";
+    // check if this layer is available at instance level
+    uint32_t instanceLayerCount;
+    vkEnumerateInstanceLayerProperties(&instanceLayerCount, nullptr);
+    std::vector<VkLayerProperties> instanceLayerProperties(instanceLayerCount);
+    vkEnumerateInstanceLayerProperties(&instanceLayerCount,
+                                       instanceLayerProperties.data());
+    bool validationLayerPresent = false;
+    for (VkLayerProperties layer : instanceLayerProperties) {
+      if (strcmp(layer.layerName, validationLayerName) == 0) {
+        validationLayerPresent = true;
+        break;
+      }
+    }
+    // if the layer is available, add it to the instance
+    if (validationLayerPresent) {
+      instanceCreateInfo.ppEnabledLayerNames = &validationLayerName;
+      instanceCreateInfo.enabledLayerCount = 1;
+    } else {
+      LOGI(
+          "Validation layer VK_LAYER_KHRONOS_validation not present, "
+          "validation is disabled");
+    }
+  }
+  // finally, attempt to create the instance.
+  VK_CHECK_RESULT(vkCreateInstance(&instanceCreateInfo, nullptr, &m_instance));
+}
+
+/**
+ * @brief Selects a GPU to render the Vulkan instance with.
+ *
+ * Defaults to the first encountered device.
+ */
+void VulkanDeviceContext::pickPhysicalDevice() {
+  uint32_t gpuCount = 0;
+  VK_CHECK_RESULT(vkEnumeratePhysicalDevices(m_instance, &gpuCount, nullptr));
+  assert(gpuCount > 0);
+  // enumerate Vulkan-capable devices
+  std::vector<VkPhysicalDevice> physicalDevices(gpuCount);
+  VK_CHECK_RESULT(vkEnumeratePhysicalDevices(m_instance, &gpuCount,
+                                             physicalDevices.data()));
+
+  // GPU selection
+
+  // select physical device to be used for the Vulkan instance.
+  // defaults to the first device unless specified by command line.
+  uint32_t selectedDevice = 0;
+  m_physicalDevice = physicalDevices[selectedDevice];
+
+  // store properties (including limits), features, and memory properties of
+  // the physical device
+  vkGetPhysicalDeviceProperties(m_physicalDevice, &m_deviceProperties);
+  vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_deviceFeatures);
+  vkGetPhysicalDeviceMemoryProperties(m_physicalDevice,
+                                      &m_deviceMemoryProperties);
+
+  // get extensions supported by the device and store for later use
+  uint32_t extCount = 0;
+  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extCount,
+                                       nullptr);
+  if (extCount > 0) {
+    std::vector<VkExtensionProperties> extensions(extCount);
+    if (vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr,
+                                             &extCount, &extensions.front()) ==
+        VK_SUCCESS) {
+      for (VkExtensionProperties extension : extensions) {
+        m_supportedDeviceExtensions.push_back(extension.extensionName);
+      }
+    }
+  }
+
+#if defined(VK_USE_PLATFORM_MACOS_MVK)
+  // SRS - When running on iOS/macOS with MoltenVK and VK_KHR_portability_subset
+  // is defined and supported by the instance, enable the extension
+  if (std::find(m_supportedDeviceExtensions.begin(),
+                m_supportedDeviceExtensions.end(),
+                "VK_KHR_portability_subset") !=
+      m_supportedInstanceExtensions.end()) {
+    m_enabledDeviceExtensions.push_back("VK_KHR_portability_subset");
+  }
+#endif
+
+  // the memory budget extension gives us the driver's view of each heap's
+  // budget and usage, which we show alongside our own memory bookkeeping
+  if (isInstanceExtensionEnabled(
+          VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) &&
+      isDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+    m_enabledDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    m_capabilities.memoryBudget = true;
+  }
+
+  // descriptor indexing lets a whole model sample from one texture array,
+  // with each part picking its texture by index. The part index reaches the
+  // shader through the draw's first instance.
+  if (isInstanceExtensionEnabled(
+          VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) &&
+      isDeviceExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+      isDeviceExtensionSupported(VK_KHR_MAINTENANCE3_EXTENSION_NAME) &&
+      m_deviceFeatures.drawIndirectFirstInstance) {
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    VkPhysicalDeviceFeatures2KHR deviceFeatures2 = {};
+    deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    deviceFeatures2.pNext = &indexingFeatures;
+    auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+        vkGetInstanceProcAddr(m_instance, "vkGetPhysicalDeviceFeatures2KHR"));
+    if (getFeatures2) getFeatures2(m_physicalDevice, &deviceFeatures2);
+
+    if (indexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+        indexingFeatures.descriptorBindingPartiallyBound &&
+        indexingFeatures.descriptorBindingVariableDescriptorCount &&
+        indexingFeatures.runtimeDescriptorArray) {
+      m_enabledDeviceExtensions.push_back(
+          VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+      m_enabledDeviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+      m_descriptorIndexingFeatures.sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+      m_descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing =
+          VK_TRUE;
+      m_descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+      m_descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount =
+          VK_TRUE;
+      m_descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+      m_descriptorIndexingFeatures.pNext = m_deviceCreatepNextChain;
+      m_deviceCreatepNextChain = &m_descriptorIndexingFeatures;
+      m_enabledFeatures.drawIndirectFirstInstance = VK_TRUE;
+      m_enabledFeatures.multiDrawIndirect = m_deviceFeatures.multiDrawIndirect;
+      m_capabilities.descriptorIndexing = true;
+      m_capabilities.multiDrawIndirect = m_deviceFeatures.multiDrawIndirect;
+    }
+  }
+
+  // software rasterizers get the cheapest shader variants, integrated GPUs the
+  // default ones
+  switch (m_deviceProperties.deviceType) {
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      m_capabilities.performanceTier = PerformanceTier::LOW;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      m_capabilities.performanceTier = PerformanceTier::HIGH;
+      break;
+    default:
+      m_capabilities.performanceTier = PerformanceTier::MEDIUM;
+      break;
+  }
+
+  // line polygon mode, for wireframe pipeline variants
+  m_enabledFeatures.fillModeNonSolid = m_deviceFeatures.fillModeNonSolid;
+  m_capabilities.wireframe = m_deviceFeatures.fillModeNonSolid;
+  // fragment shaders can only read gl_PrimitiveID with geometry shaders on
+  m_enabledFeatures.geometryShader = m_deviceFeatures.geometryShader;
+  m_capabilities.primitiveId = m_deviceFeatures.geometryShader;
+}
+
+/**
+ * @brief Checks whether an instance extension was enabled on creation
+ */
+bool VulkanDeviceContext::isInstanceExtensionEnabled(
+    char const* extension) const {
+  return std::find_if(m_enabledInstanceExtensions.begin(),
+                      m_enabledInstanceExtensions.end(),
+                      [extension](char const* enabled) {
+                        return strcmp(enabled, extension) == 0;
+                      }) != m_enabledInstanceExtensions.end();
+}
+
+/**
+ * @brief Checks whether the physical device supports a device extension
+ */
+bool VulkanDeviceContext::isDeviceExtensionSupported(
+    char const* extension) const {
+  return std::find(m_supportedDeviceExtensions.begin(),
+                   m_supportedDeviceExtensions.end(),
+                   extension) != m_supportedDeviceExtensions.end();
+}
+
+/**
+ * @brief Create logical representation of our physical device.
+ *
+ * Reads information from the physical device to create a logical
+ * representation, gets its graphics queue and finds a valid depth format.
+ * Also creates what is shared along with the device: the pipeline cache, the
+ * pipeline build queue, the descriptor layout, render pass and shader module
+ * caches, the pipeline map and the geometry arena.
+ */
+void VulkanDeviceContext::createLogicalDevice() {
+  // initialize a VulkanDevice from the physical device data
+  m_vulkanDevice = new vks::VulkanDevice(m_physicalDevice);
+  VK_CHECK_RESULT(m_vulkanDevice->createLogicalDevice(
+      m_enabledFeatures, m_enabledDeviceExtensions, m_deviceCreatepNextChain));
+  m_device = m_vulkanDevice->logicalDevice;
+  vkGetDeviceQueue(m_device, m_vulkanDevice->queueFamilyIndices.graphics, 0,
+                   &m_queue);
+  VulkanMemoryTracker::get().attach(m_instance, m_physicalDevice,
+                                    m_capabilities.memoryBudget);
+
+  // find a suitable depth format
+  VkBool32 validDepthFormat =
+      vks::tools::getSupportedDepthFormat(m_physicalDevice, &m_depthFormat);
+  assert(validDepthFormat);
+
+  m_pipelineCache =
+      m_pipelineCacheFile.create(m_device, m_vulkanDevice->properties);
+  m_pipelineBuildQueue =
+      new VulkanPipelineBuildQueue(m_device, m_pipelineCache);
+  m_descriptorLayoutCache = new VulkanDescriptorLayoutCache(m_device);
+  m_renderPassCache = new VulkanRenderPassCache(m_device);
+  m_pipelineMap = new VulkanPipelineMap(m_device);
+  m_shaderModuleCache = new VulkanShaderModuleCache(m_device, m_pipelineMap);
+  m_geometryArena =
+      new VulkanGeometryArena(m_vulkanDevice, m_queue, sizeof(VertexTexVec4));
+}
+
+}  // namespace VulkanEngine
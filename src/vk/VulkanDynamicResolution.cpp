@@ -0,0 +1,181 @@
+#include "VulkanDynamicResolution.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+namespace {
+
+// weight of the newest frame in the average frame time
+constexpr float SMOOTHING = 0.1f;
+// frames to measure after a change before the next one, so the average
+// reflects the new scale
+constexpr uint32_t SETTLE_FRAMES = 30;
+// a step up must be expected to leave this much of the budget free
+constexpr float HEADROOM = 0.9f;
+// longer frames (resizes, pipeline builds) are counted as this many budgets
+constexpr float MAX_FRAME_BUDGETS = 4.f;
+
+}  // namespace
+
+// std::min and glm::clamp take references, which odr-use these
+constexpr float VulkanDynamicResolution::MIN_SCALE;
+constexpr float VulkanDynamicResolution::MAX_SCALE;
+constexpr float VulkanDynamicResolution::STEP;
+
+/**
+ * @brief Allocates the upscale's descriptor set. The target is created by
+ * the first resize().
+ *
+ * @param vulkanDevice
+ * @param compositor - Draws the target into the main pass, not owned
+ * @param retireQueue - Destroys replaced targets, not owned
+ * @param colorFormat - Color format of the main render pass
+ * @param depthFormat - Depth format of the main render pass
+ */
+VulkanDynamicResolution::VulkanDynamicResolution(
+    vks::VulkanDevice* vulkanDevice, VulkanCompositor* compositor,
+    VulkanRetireQueue* retireQueue, VkFormat colorFormat,
+    VkFormat depthFormat) {
+  m_vulkanDevice = vulkanDevice;
+  m_device = vulkanDevice->logicalDevice;
+  m_compositor = compositor;
+  m_retireQueue = retireQueue;
+  m_colorFormat = colorFormat;
+  m_depthFormat = depthFormat;
+  m_descriptorSet = m_compositor->allocate();
+}
+
+VulkanDynamicResolution::~VulkanDynamicResolution() {
+  delete_ptr(m_target);
+  m_compositor->release(m_descriptorSet);
+}
+
+/**
+ * @brief Sizes the target for a window of the given size, replacing it if
+ * that changed
+ *
+ * The old target and its set are retired, as frames in flight may still draw
+ * into or upscale them, so the command buffers must be recorded again before
+ * the next submission.
+ *
+ * @param width - Window width, in pixels
+ * @param height - Window height, in pixels
+ */
+void VulkanDynamicResolution::resize(uint32_t width, uint32_t height) {
+  width = std::max(1u, width);
+  height = std::max(1u, height);
+  if (m_target && width == m_width && height == m_height) return;
+  m_width = width;
+  m_height = height;
+  if (m_target) {
+    VulkanFrameBuffer* target = m_target;
+    VkDescriptorSet descriptorSet = m_descriptorSet;
+    VulkanCompositor* compositor = m_compositor;
+    m_retireQueue->retire([target, descriptorSet, compositor]() {
+      delete target;
+      compositor->release(descriptorSet);
+    });
+    m_descriptorSet = m_compositor->allocate();
+  }
+  m_target = new VulkanFrameBuffer();
+  m_target->setVulkanDevice(m_vulkanDevice);
+  m_target->setSize(width, height);
+  m_target->setFormat(m_colorFormat);
+  m_target->setDepthFormat(m_depthFormat);
+  m_target->createWithColorDepth();
+  m_compositor->write(m_descriptorSet, &m_target->getDescriptor());
+}
+
+/**
+ * @brief Measures the time since the last call and moves the scale towards
+ * the budget
+ *
+ * @return Whether the scale changed, in which case the command buffers need
+ * recording again
+ */
+bool VulkanDynamicResolution::update() {
+  auto now = std::chrono::steady_clock::now();
+  bool measuring = m_measuring;
+  float frameMs =
+      std::chrono::duration<float, std::milli>(now - m_lastUpdate).count();
+  m_lastUpdate = now;
+  m_measuring = true;
+  if (!measuring) return false;
+
+  frameMs = std::min(frameMs, m_targetMs * MAX_FRAME_BUDGETS);
+  m_averageMs = m_averageMs == 0.f
+                    ? frameMs
+                    : m_averageMs + SMOOTHING * (frameMs - m_averageMs);
+  if (++m_settledFrames < SETTLE_FRAMES) return false;
+
+  // the scene's cost follows its pixel count, the square of the scale
+  float scale = m_scale;
+  if (m_averageMs > m_targetMs) {
+    float fitting = m_scale * std::sqrt(m_targetMs / m_averageMs);
+    scale = std::floor(fitting / STEP) * STEP;
+  } else {
+    float up = std::min(m_scale + STEP, MAX_SCALE);
+    float expected = m_averageMs * (up * up) / (m_scale * m_scale);
+    if (expected < m_targetMs * HEADROOM) scale = up;
+  }
+  scale = glm::clamp(scale, MIN_SCALE, MAX_SCALE);
+  if (std::abs(scale - m_scale) < STEP * 0.5f) return false;
+
+  // start the new scale from the time it is expected to take
+  m_averageMs *= (scale * scale) / (m_scale * m_scale);
+  m_scale = scale;
+  m_settledFrames = 0;
+  return true;
+}
+
+/**
+ * @brief Forgets the measured frame times, e.g. when the mode was off for a
+ * while. The scale is kept.
+ */
+void VulkanDynamicResolution::reset() {
+  m_measuring = false;
+  m_averageMs = 0.f;
+  m_settledFrames = 0;
+}
+
+/**
+ * @brief Begins the offscreen pass over the scaled part of the target
+ *
+ * @param cmd
+ * @param clearValues - Color and depth clear values
+ */
+void VulkanDynamicResolution::beginRenderPass(
+    VkCommandBuffer cmd, std::array<VkClearValue, 2> const& clearValues) const {
+  VkRenderPassBeginInfo renderPassBeginInfo =
+      vks::initializers::renderPassBeginInfo();
+  renderPassBeginInfo.renderPass = m_target->getRenderPass()->get();
+  renderPassBeginInfo.framebuffer = m_target->get();
+  renderPassBeginInfo.renderArea.extent = getExtent();
+  renderPassBeginInfo.clearValueCount =
+      static_cast<uint32_t>(clearValues.size());
+  renderPassBeginInfo.pClearValues = clearValues.data();
+  vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+/**
+ * @brief Draws the scaled scene over the whole window, in the main pass
+ *
+ * @param cmd
+ */
+void VulkanDynamicResolution::draw(VkCommandBuffer cmd) const {
+  if (!m_target) return;
+  m_compositor->draw(cmd, m_descriptorSet,
+                     vks::initializers::rect2D(m_width, m_height, 0, 0),
+                     getExtent(), {m_width, m_height});
+}
+
+/**
+ * @brief The size the scene is drawn at, for the current scale
+ */
+VkExtent2D VulkanDynamicResolution::getExtent() const {
+  return {std::max(1u, static_cast<uint32_t>(m_width * m_scale + 0.5f)),
+          std::max(1u, static_cast<uint32_t>(m_height * m_scale + 0.5f))};
+}
+
+}  // namespace VulkanEngine
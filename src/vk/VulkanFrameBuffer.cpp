@@ -1,33 +1,126 @@
 #include "VulkanFrameBuffer.h"
 #include "VulkanInitializers.hpp"
+#include "VulkanMemoryTracker.h"
 #include "VulkanTools.h"
 
 namespace VulkanEngine {
 
 VulkanFrameBuffer::~VulkanFrameBuffer() {
-  delete_ptr(m_renderPass);
-  // frame buffer
+  if (m_ownsRenderPass) delete_ptr(m_renderPass);
+  // samplers
+  VK_SAFE_DELETE(m_colorSampler,
+                 vkDestroySampler(m_device, m_colorSampler, nullptr));
   VK_SAFE_DELETE(m_depthSampler,
                  vkDestroySampler(m_device, m_depthSampler, nullptr));
+  VK_SAFE_DELETE(m_depthCompareSampler,
+                 vkDestroySampler(m_device, m_depthCompareSampler, nullptr));
+  VK_SAFE_DELETE(
+      m_depthNearestCompareSampler,
+      vkDestroySampler(m_device, m_depthNearestCompareSampler, nullptr));
   // color attachment
   VK_SAFE_DELETE(m_color.view,
                  vkDestroyImageView(m_device, m_color.view, nullptr));
   VK_SAFE_DELETE(m_color.image,
                  vkDestroyImage(m_device, m_color.image, nullptr));
   VK_SAFE_DELETE(m_color.memory,
-                 vkFreeMemory(m_device, m_color.memory, nullptr));
+                 VulkanMemoryTracker::get().free(m_device, m_color.memory));
   // depth attachment
   VK_SAFE_DELETE(m_depth.view,
                  vkDestroyImageView(m_device, m_depth.view, nullptr));
   VK_SAFE_DELETE(m_depth.image,
                  vkDestroyImage(m_device, m_depth.image, nullptr));
   VK_SAFE_DELETE(m_depth.memory,
-                 vkFreeMemory(m_device, m_depth.memory, nullptr));
+                 VulkanMemoryTracker::get().free(m_device, m_depth.memory));
   // frame buffer
   vkDestroyFramebuffer(m_device, m_frameBuffer, nullptr);
 }
 
 void VulkanFrameBuffer::createWithDepth() {
+  // create a sampler from the depth attachment
+  // used to sample in the fragment shader for shadowed rendering
+  VkFilter shadowmap_filter = VK_FILTER_LINEAR;
+  VkSamplerCreateInfo sampler = vks::initializers::samplerCreateInfo();
+  sampler.magFilter = shadowmap_filter;
+  sampler.minFilter = shadowmap_filter;
+  sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+  sampler.addressModeV = sampler.addressModeU;
+  sampler.addressModeW = sampler.addressModeU;
+  sampler.mipLodBias = 0.0f;
+  sampler.maxAnisotropy = 1.0f;
+  sampler.minLod = 0.0f;
+  sampler.maxLod = 1.0f;
+  sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+  VK_CHECK_RESULT(
+      vkCreateSampler(m_device, &sampler, nullptr, &m_depthSampler));
+  // and one comparing against the depth, for sampler2DShadow lookups that
+  // filter four compares into one fetch
+  sampler.compareEnable = VK_TRUE;
+  sampler.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+  VK_CHECK_RESULT(
+      vkCreateSampler(m_device, &sampler, nullptr, &m_depthCompareSampler));
+  // and one that compares a single texel, for hard shadows
+  sampler.magFilter = VK_FILTER_NEAREST;
+  sampler.minFilter = VK_FILTER_NEAREST;
+  sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  VK_CHECK_RESULT(vkCreateSampler(m_device, &sampler, nullptr,
+                                  &m_depthNearestCompareSampler));
+
+  // build the render pass, unless a shared one was set
+  if (!m_renderPass) {
+    m_renderPass = new VulkanRenderPass();
+    m_renderPass->setDevice(m_device);
+    m_renderPass->setFormat(m_format);
+    m_renderPass->createDepthPass();
+    m_ownsRenderPass = true;
+  }
+
+  createDepthTarget();
+}
+
+/**
+ * @brief Reallocates a depth-only frame buffer at another size
+ *
+ * The render pass and samplers are kept, so pipelines built for this frame
+ * buffer stay valid. The image view changes, so descriptor sets sampling the
+ * attachment must be rewritten from its descriptors, and command buffers
+ * using the frame buffer recorded again. Without a retire queue the device
+ * must not be using it; with one, the old image is destroyed once the frames
+ * using it are done.
+ *
+ * @param width
+ * @param height
+ * @param retireQueue - Destroys the old image, view and frame buffer later
+ * @return Whether the frame buffer was reallocated
+ */
+bool VulkanFrameBuffer::resizeDepth(int width, int height,
+                                    VulkanRetireQueue* retireQueue) {
+  if (width == m_width && height == m_height) return false;
+  if (retireQueue) {
+    VkDevice device = m_device;
+    VkFramebuffer frameBuffer = m_frameBuffer;
+    Attachment depth = m_depth;
+    retireQueue->retire([device, frameBuffer, depth]() {
+      vkDestroyFramebuffer(device, frameBuffer, nullptr);
+      vkDestroyImageView(device, depth.view, nullptr);
+      vkDestroyImage(device, depth.image, nullptr);
+      VulkanMemoryTracker::get().free(device, depth.memory);
+    });
+    m_frameBuffer = VK_NULL_HANDLE;
+    m_depth = Attachment();
+  } else {
+    destroyDepthTarget();
+  }
+  setSize(width, height);
+  createDepthTarget();
+  return true;
+}
+
+/**
+ * @brief Creates the depth image at the current size, and the frame buffer
+ * and descriptor around it
+ */
+void VulkanFrameBuffer::createDepthTarget() {
   // for shadow mapping we only need a depth attachment
   VkImageCreateInfo image = vks::initializers::imageCreateInfo();
   image.imageType = VK_IMAGE_TYPE_2D;
@@ -50,8 +143,9 @@ void VulkanFrameBuffer::createWithDepth() {
   memAlloc.allocationSize = memReqs.size;
   memAlloc.memoryTypeIndex = m_vulkanDevice->getMemoryType(
       memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  VK_CHECK_RESULT(
-      vkAllocateMemory(m_device, &memAlloc, nullptr, &m_depth.memory));
+  VK_CHECK_RESULT(VulkanMemoryTracker::get().allocate(
+      m_device, &memAlloc, &m_depth.memory,
+      VulkanMemoryTracker::Category::SHADOW_MAP, "Depth framebuffer"));
   VK_CHECK_RESULT(
       vkBindImageMemory(m_device, m_depth.image, m_depth.memory, 0));
 
@@ -70,30 +164,6 @@ void VulkanFrameBuffer::createWithDepth() {
   VK_CHECK_RESULT(
       vkCreateImageView(m_device, &depthStencilView, nullptr, &m_depth.view));
 
-  // create a sampler from the depth attachment
-  // used to sample in the fragment shader for shadowed rendering
-  VkFilter shadowmap_filter = VK_FILTER_LINEAR;
-  VkSamplerCreateInfo sampler = vks::initializers::samplerCreateInfo();
-  sampler.magFilter = shadowmap_filter;
-  sampler.minFilter = shadowmap_filter;
-  sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
-  sampler.addressModeV = sampler.addressModeU;
-  sampler.addressModeW = sampler.addressModeU;
-  sampler.mipLodBias = 0.0f;
-  sampler.maxAnisotropy = 1.0f;
-  sampler.minLod = 0.0f;
-  sampler.maxLod = 1.0f;
-  sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-  VK_CHECK_RESULT(
-      vkCreateSampler(m_device, &sampler, nullptr, &m_depthSampler));
-
-  // build the render pass
-  m_renderPass = new VulkanRenderPass();
-  m_renderPass->setDevice(m_device);
-  m_renderPass->setFormat(m_format);
-  m_renderPass->createDepthPass();
-
   // create frame buffer
   VkFramebufferCreateInfo fbufCreateInfo =
       vks::initializers::framebufferCreateInfo();
@@ -110,59 +180,45 @@ void VulkanFrameBuffer::createWithDepth() {
   m_descriptor = vks::initializers::descriptorImageInfo(
       m_depthSampler, m_depth.view,
       VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+  m_compareDescriptor = vks::initializers::descriptorImageInfo(
+      m_depthCompareSampler, m_depth.view,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+  m_nearestCompareDescriptor = vks::initializers::descriptorImageInfo(
+      m_depthNearestCompareSampler, m_depth.view,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
 }
 
-void VulkanFrameBuffer::createWithColorDepth() {
-  // find a suitable depth format
-  VkFormat fbDepthFormat;
-  VkBool32 validDepthFormat = vks::tools::getSupportedDepthFormat(
-      m_context->getPhysicalDevice(), &fbDepthFormat);
-  assert(validDepthFormat);
-
-  // color attachment
-  VkImageCreateInfo image = vks::initializers::imageCreateInfo();
-  image.imageType = VK_IMAGE_TYPE_2D;
-  image.format = m_format;
-  image.extent.width = m_width;
-  image.extent.height = m_height;
-  image.extent.depth = 1;
-  image.mipLevels = 1;
-  image.arrayLayers = 1;
-  image.samples = VK_SAMPLE_COUNT_1_BIT;
-  image.tiling = VK_IMAGE_TILING_OPTIMAL;
-  // We will sample directly from the color attachment
-  image.usage =
-      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-  // allocate and bind memory for the color attachment image
-  VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
-  VkMemoryRequirements memReqs;
-  VK_CHECK_RESULT(vkCreateImage(m_device, &image, nullptr, &m_color.image));
-  vkGetImageMemoryRequirements(m_device, m_color.image, &memReqs);
-  memAlloc.allocationSize = memReqs.size;
-  memAlloc.memoryTypeIndex = m_vulkanDevice->getMemoryType(
-      memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  VK_CHECK_RESULT(
-      vkAllocateMemory(m_device, &memAlloc, nullptr, &m_color.memory));
-  VK_CHECK_RESULT(
-      vkBindImageMemory(m_device, m_color.image, m_color.memory, 0));
+/**
+ * @brief Destroys what createDepthTarget created
+ */
+void VulkanFrameBuffer::destroyDepthTarget() {
+  VK_SAFE_DELETE(m_frameBuffer,
+                 vkDestroyFramebuffer(m_device, m_frameBuffer, nullptr));
+  VK_SAFE_DELETE(m_depth.view,
+                 vkDestroyImageView(m_device, m_depth.view, nullptr));
+  VK_SAFE_DELETE(m_depth.image,
+                 vkDestroyImage(m_device, m_depth.image, nullptr));
+  VK_SAFE_DELETE(m_depth.memory,
+                 VulkanMemoryTracker::get().free(m_device, m_depth.memory));
+}
 
-  // create the color attachment image view
-  VkImageViewCreateInfo colorImageView =
-      vks::initializers::imageViewCreateInfo();
-  colorImageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  colorImageView.format = m_format;
-  colorImageView.subresourceRange = {};
-  colorImageView.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  colorImageView.subresourceRange.baseMipLevel = 0;
-  colorImageView.subresourceRange.levelCount = 1;
-  colorImageView.subresourceRange.baseArrayLayer = 0;
-  colorImageView.subresourceRange.layerCount = 1;
-  colorImageView.image = m_color.image;
-  VK_CHECK_RESULT(
-      vkCreateImageView(m_device, &colorImageView, nullptr, &m_color.view));
+/**
+ * @brief Creates a color + depth frame buffer whose color is sampled
+ * afterwards, e.g. to draw a scene offscreen and composite it
+ *
+ * The color attachment has the format set with setFormat(). The depth format
+ * is the one set with setDepthFormat(), or the best one the device supports.
+ * Giving both the formats of another color + depth pass keeps this one
+ * compatible with it, so the same pipelines can draw into either.
+ */
+void VulkanFrameBuffer::createWithColorDepth() {
+  if (m_depthFormat == VK_FORMAT_UNDEFINED) {
+    VkBool32 validDepthFormat = vks::tools::getSupportedDepthFormat(
+        m_vulkanDevice->physicalDevice, &m_depthFormat);
+    assert(validDepthFormat);
+  }
 
-  // Create sampler to sample from the attachment in the fragment shader
+  // create sampler to sample from the attachment in the fragment shader
   VkSamplerCreateInfo samplerInfo = vks::initializers::samplerCreateInfo();
   samplerInfo.magFilter = VK_FILTER_LINEAR;
   samplerInfo.minFilter = VK_FILTER_LINEAR;
@@ -178,116 +234,105 @@ void VulkanFrameBuffer::createWithColorDepth() {
   VK_CHECK_RESULT(
       vkCreateSampler(m_device, &samplerInfo, nullptr, &m_colorSampler));
 
-  // depth stencil attachment
-  image.format = fbDepthFormat;
-  image.usage =
-      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-  // allocate and bind memory for the depth stencil attachment image
-  VK_CHECK_RESULT(vkCreateImage(m_device, &image, nullptr, &m_depth.image));
-  vkGetImageMemoryRequirements(m_device, m_depth.image, &memReqs);
-  memAlloc.allocationSize = memReqs.size;
-  memAlloc.memoryTypeIndex = m_vulkanDevice->getMemoryType(
-      memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  VK_CHECK_RESULT(
-      vkAllocateMemory(m_device, &memAlloc, nullptr, &m_depth.memory));
-  VK_CHECK_RESULT(
-      vkBindImageMemory(m_device, m_depth.image, m_depth.memory, 0));
-
-  // create the depth stencil attachment image view
-  VkImageViewCreateInfo depthStencilView =
-      vks::initializers::imageViewCreateInfo();
-  depthStencilView.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  depthStencilView.format = fbDepthFormat;
-  // depthStencilView.flags = 0;
-  depthStencilView.subresourceRange = {};
-  depthStencilView.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-  depthStencilView.subresourceRange.baseMipLevel = 0;
-  depthStencilView.subresourceRange.levelCount = 1;
-  depthStencilView.subresourceRange.baseArrayLayer = 0;
-  depthStencilView.subresourceRange.layerCount = 1;
-  depthStencilView.image = m_depth.image;
-  VK_CHECK_RESULT(
-      vkCreateImageView(m_device, &depthStencilView, nullptr, &m_depth.view));
+  // build the render pass, leaving the color ready to be sampled, unless a
+  // shared one was set
+  if (!m_renderPass) {
+    m_renderPass = new VulkanRenderPass();
+    m_renderPass->setDevice(m_device);
+    m_renderPass->setFormat(m_format);
+    m_renderPass->setDepthFormat(m_depthFormat);
+    m_renderPass->createColorDepthPass();
+    m_ownsRenderPass = true;
+  }
 
-  // create a separate render pass for offscreen rendering as it may
-  // differ from the one used for on screen rendering
-  std::array<VkAttachmentDescription, 2> attachmentDescriptions = {};
-  // Color attachment
-  attachmentDescriptions[0].format = m_format;
-  attachmentDescriptions[0].samples = VK_SAMPLE_COUNT_1_BIT;
-  attachmentDescriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  attachmentDescriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-  attachmentDescriptions[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-  attachmentDescriptions[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  attachmentDescriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  attachmentDescriptions[0].finalLayout =
-      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  // Depth attachment
-  attachmentDescriptions[1].format = fbDepthFormat;
-  attachmentDescriptions[1].samples = VK_SAMPLE_COUNT_1_BIT;
-  attachmentDescriptions[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  attachmentDescriptions[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-  attachmentDescriptions[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-  attachmentDescriptions[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  attachmentDescriptions[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  attachmentDescriptions[1].finalLayout =
-      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-  // create our attachment references
-  VkAttachmentReference colorReference = {
-      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-  VkAttachmentReference depthReference = {
-      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+  createColorDepthTarget();
+}
 
-  // create the subpass description for the color + depth stencil attachments
-  VkSubpassDescription subpassDescription = {};
-  subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-  subpassDescription.colorAttachmentCount = 1;
-  subpassDescription.pColorAttachments = &colorReference;
-  subpassDescription.pDepthStencilAttachment = &depthReference;
+/**
+ * @brief Reallocates a color + depth frame buffer at another size
+ *
+ * Like resizeDepth(), the render pass and sampler are kept, but descriptor
+ * sets sampling the color must be rewritten and command buffers recorded
+ * again. The device must not be using the frame buffer.
+ *
+ * @param width
+ * @param height
+ * @return Whether the frame buffer was reallocated
+ */
+bool VulkanFrameBuffer::resizeColorDepth(int width, int height) {
+  if (width == m_width && height == m_height) return false;
+  destroyColorDepthTarget();
+  setSize(width, height);
+  createColorDepthTarget();
+  return true;
+}
 
-  // use subpass dependencies for layout transitions
-  std::array<VkSubpassDependency, 2> dependencies;
-  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-  dependencies[0].dstSubpass = 0;
-  dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-  dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-                                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-  dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-  dependencies[1].srcSubpass = 0;
-  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-  dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-                                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-  dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+/**
+ * @brief Creates the color and depth images at the current size, and the
+ * frame buffer and descriptor around them
+ */
+void VulkanFrameBuffer::createColorDepthTarget() {
+  // the depth is only tested against, so only the color is sampled
+  VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+  if (m_depthFormat >= VK_FORMAT_D16_UNORM_S8_UINT)
+    depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+  struct AttachmentInfo {
+    Attachment* attachment;
+    VkFormat format;
+    VkImageUsageFlags usage;
+    VkImageAspectFlags aspect;
+    char const* name;
+  };
+  AttachmentInfo infos[2] = {
+      {&m_color, m_format,
+       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+       VK_IMAGE_ASPECT_COLOR_BIT, "Framebuffer color"},
+      {&m_depth, m_depthFormat,
+       VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, depthAspect,
+       "Framebuffer depth"}};
+  for (auto const& info : infos) {
+    VkImageCreateInfo image = vks::initializers::imageCreateInfo();
+    image.imageType = VK_IMAGE_TYPE_2D;
+    image.format = info.format;
+    image.extent.width = m_width;
+    image.extent.height = m_height;
+    image.extent.depth = 1;
+    image.mipLevels = 1;
+    image.arrayLayers = 1;
+    image.samples = VK_SAMPLE_COUNT_1_BIT;
+    image.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image.usage = info.usage;
+    VK_CHECK_RESULT(
+        vkCreateImage(m_device, &image, nullptr, &info.attachment->image));
 
-  // create the actual render pass
-  VkRenderPassCreateInfo renderPassInfo = {};
-  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-  renderPassInfo.attachmentCount =
-      static_cast<uint32_t>(attachmentDescriptions.size());
-  renderPassInfo.pAttachments = attachmentDescriptions.data();
-  renderPassInfo.subpassCount = 1;
-  renderPassInfo.pSubpasses = &subpassDescription;
-  renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
-  renderPassInfo.pDependencies = dependencies.data();
-  VK_CHECK_RESULT(
-      vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_pRenderPass));
+    // allocate and bind memory for the attachment image
+    VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
+    VkMemoryRequirements memReqs;
+    vkGetImageMemoryRequirements(m_device, info.attachment->image, &memReqs);
+    memAlloc.allocationSize = memReqs.size;
+    memAlloc.memoryTypeIndex = m_vulkanDevice->getMemoryType(
+        memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VK_CHECK_RESULT(VulkanMemoryTracker::get().allocate(
+        m_device, &memAlloc, &info.attachment->memory,
+        VulkanMemoryTracker::Category::RENDER_TARGET, info.name));
+    VK_CHECK_RESULT(vkBindImageMemory(m_device, info.attachment->image,
+                                      info.attachment->memory, 0));
 
-  // group image views for each attachment
-  VkImageView attachments[2];
-  attachments[0] = m_color.view;
-  attachments[1] = m_depth.view;
+    // create the attachment image view
+    VkImageViewCreateInfo view = vks::initializers::imageViewCreateInfo();
+    view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view.format = info.format;
+    view.subresourceRange = {info.aspect, 0, 1, 0, 1};
+    view.image = info.attachment->image;
+    VK_CHECK_RESULT(
+        vkCreateImageView(m_device, &view, nullptr, &info.attachment->view));
+  }
 
   // create the frame buffer
+  VkImageView attachments[2] = {m_color.view, m_depth.view};
   VkFramebufferCreateInfo fbufCreateInfo =
       vks::initializers::framebufferCreateInfo();
-  fbufCreateInfo.renderPass = m_pRenderPass;
+  fbufCreateInfo.renderPass = m_renderPass->get();
   fbufCreateInfo.attachmentCount = 2;
   fbufCreateInfo.pAttachments = attachments;
   fbufCreateInfo.width = m_width;
@@ -296,25 +341,22 @@ void VulkanFrameBuffer::createWithColorDepth() {
   VK_CHECK_RESULT(
       vkCreateFramebuffer(m_device, &fbufCreateInfo, nullptr, &m_frameBuffer));
 
-  // create the sampler for the depth stencil
-  VkSamplerCreateInfo samplerInfoDepth = vks::initializers::samplerCreateInfo();
-  samplerInfoDepth.magFilter = VK_FILTER_LINEAR;
-  samplerInfoDepth.minFilter = VK_FILTER_LINEAR;
-  samplerInfoDepth.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  samplerInfoDepth.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfoDepth.addressModeV = samplerInfoDepth.addressModeU;
-  samplerInfoDepth.addressModeW = samplerInfoDepth.addressModeU;
-  samplerInfoDepth.mipLodBias = 0.0f;
-  samplerInfoDepth.maxAnisotropy = 1.0f;
-  samplerInfoDepth.minLod = 0.0f;
-  samplerInfoDepth.maxLod = 1.0f;
-  samplerInfoDepth.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-  VK_CHECK_RESULT(
-      vkCreateSampler(m_device, &samplerInfoDepth, nullptr, &m_depthSampler));
-
   // fill a descriptor for later use in a descriptor set
   m_descriptor = vks::initializers::descriptorImageInfo(
       m_colorSampler, m_color.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
-}  // namespace VulkanEngine
\ No newline at end of file
+/**
+ * @brief Destroys what createColorDepthTarget created
+ */
+void VulkanFrameBuffer::destroyColorDepthTarget() {
+  VK_SAFE_DELETE(m_color.view,
+                 vkDestroyImageView(m_device, m_color.view, nullptr));
+  VK_SAFE_DELETE(m_color.image,
+                 vkDestroyImage(m_device, m_color.image, nullptr));
+  VK_SAFE_DELETE(m_color.memory,
+                 VulkanMemoryTracker::get().free(m_device, m_color.memory));
+  destroyDepthTarget();
+}
+
+}  // namespace VulkanEngine
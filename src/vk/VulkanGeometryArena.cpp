@@ -0,0 +1,465 @@
+#include "VulkanGeometryArena.h"
+#include "VulkanMemoryTracker.h"
+
+namespace VulkanEngine {
+
+/* -------------------------------------------------------------------------- */
+/*                                  FREE LIST                                 */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Marks everything past the first `used` elements as free
+ */
+void VulkanGeometryArena::FreeList::reset(uint32_t capacity, uint32_t used) {
+  m_blocks.clear();
+  m_capacity = capacity;
+  m_free = capacity - used;
+  if (m_free > 0) m_blocks[used] = m_free;
+}
+
+/**
+ * @brief Takes `count` elements from the first free block large enough
+ *
+ * @return bool - Whether a block was found
+ */
+bool VulkanGeometryArena::FreeList::allocate(uint32_t count,
+                                             uint32_t& offset) {
+  if (count == 0) {
+    offset = 0;
+    return true;
+  }
+  for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+    if (it->second < count) continue;
+    offset = it->first;
+    uint32_t remaining = it->second - count;
+    m_blocks.erase(it);
+    if (remaining > 0) m_blocks[offset + count] = remaining;
+    m_free -= count;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Returns a range to the free list, merging it with its neighbours
+ */
+void VulkanGeometryArena::FreeList::release(uint32_t offset, uint32_t count) {
+  if (count == 0) return;
+  m_free += count;
+  auto next = m_blocks.lower_bound(offset);
+  if (next != m_blocks.end() && offset + count == next->first) {
+    count += next->second;
+    next = m_blocks.erase(next);
+  }
+  if (next != m_blocks.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += count;
+      return;
+    }
+  }
+  m_blocks[offset] = count;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    ARENA                                   */
+/* -------------------------------------------------------------------------- */
+
+constexpr VulkanGeometryArena::Handle VulkanGeometryArena::INVALID_HANDLE;
+
+/**
+ * @brief Creates the arena's buffers
+ *
+ * @param vulkanDevice - The device to allocate the buffers on
+ * @param queue - Queue used for uploads and compaction copies, which every
+ * window submits its frames to
+ * @param vertexStride - Size of one vertex; all meshes share the same layout
+ * @param vertexCapacity - Initial number of vertices the arena can hold
+ * @param indexCapacity - Initial number of indices the arena can hold
+ */
+VulkanGeometryArena::VulkanGeometryArena(vks::VulkanDevice* vulkanDevice,
+                                         VkQueue queue, uint32_t vertexStride,
+                                         uint32_t vertexCapacity,
+                                         uint32_t indexCapacity)
+    : m_vulkanDevice(vulkanDevice),
+      m_queue(queue),
+      m_vertexStride(vertexStride) {
+  createBuffers(vertexCapacity, indexCapacity, m_vertices, m_indices);
+  m_vertexFreeList.reset(vertexCapacity);
+  m_indexFreeList.reset(indexCapacity);
+  m_commandPool = m_vulkanDevice->createCommandPool(
+      m_vulkanDevice->queueFamilyIndices.graphics);
+}
+
+VulkanGeometryArena::~VulkanGeometryArena() {
+  collectRetired(true);
+  vkDestroyCommandPool(m_vulkanDevice->logicalDevice, m_commandPool, nullptr);
+  m_vertices.destroy();
+  m_indices.destroy();
+}
+
+/**
+ * @brief Copies a mesh into the arena through a staging buffer
+ *
+ * If a mesh was already uploaded under the same key, it is shared instead,
+ * and each upload must be matched by a release.
+ *
+ * @param vertices - vertexCount vertices of getVertexStride() bytes each
+ * @param indices - Indices relative to the mesh's own first vertex
+ * @param key - Identifies the mesh between windows, or empty to never share it
+ * @return Handle - Refers to the mesh until it is released
+ */
+VulkanGeometryArena::Handle VulkanGeometryArena::upload(
+    void const* vertices, uint32_t vertexCount, uint32_t const* indices,
+    uint32_t indexCount, std::string const& key) {
+  ExclusiveLock lock(*this);
+  if (!key.empty()) {
+    auto it = m_keys.find(key);
+    if (it != m_keys.end()) {
+      m_meshes[it->second].users++;
+      return it->second;
+    }
+  }
+
+  Mesh mesh;
+  if (!tryAllocate(vertexCount, indexCount, mesh)) {
+    // compaction is enough if the free space is only fragmented, otherwise
+    // grow the buffers to at least twice their size
+    if (m_vertexFreeList.getFree() >= vertexCount &&
+        m_indexFreeList.getFree() >= indexCount) {
+      reallocate(m_vertexFreeList.getCapacity(),
+                 m_indexFreeList.getCapacity());
+    } else {
+      uint32_t vertexCapacity = m_vertexFreeList.getCapacity();
+      uint32_t indexCapacity = m_indexFreeList.getCapacity();
+      reallocate(std::max(vertexCapacity * 2,
+                          vertexCapacity - m_vertexFreeList.getFree() +
+                              vertexCount),
+                 std::max(indexCapacity * 2,
+                          indexCapacity - m_indexFreeList.getFree() +
+                              indexCount));
+    }
+    bool allocated = tryAllocate(vertexCount, indexCount, mesh);
+    assert(allocated);
+  }
+
+  // stage vertices and indices together, then copy both ranges at once
+  VkDeviceSize vertexBytes = VkDeviceSize(vertexCount) * m_vertexStride;
+  VkDeviceSize indexBytes = VkDeviceSize(indexCount) * sizeof(uint32_t);
+  if (vertexBytes + indexBytes > 0) {
+    vks::Buffer staging;
+    VK_CHECK_RESULT(m_vulkanDevice->createBuffer(
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &staging, vertexBytes + indexBytes));
+    VK_CHECK_RESULT(staging.map());
+    memcpy(staging.mapped, vertices, vertexBytes);
+    memcpy(static_cast<char*>(staging.mapped) + vertexBytes, indices,
+           indexBytes);
+    staging.unmap();
+
+    // the range may have been released by a window whose frames are still in
+    // flight, so wait for their vertex reads before overwriting it
+    VkCommandBuffer copyCmd = m_vulkanDevice->createCommandBuffer(
+        VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+    VkMemoryBarrier barrier = vks::initializers::memoryBarrier();
+    vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+    VkBufferCopy copyRegion = {};
+    if (vertexBytes > 0) {
+      copyRegion.srcOffset = 0;
+      copyRegion.dstOffset = VkDeviceSize(mesh.vertexOffset) * m_vertexStride;
+      copyRegion.size = vertexBytes;
+      vkCmdCopyBuffer(copyCmd, staging.buffer, m_vertices.buffer, 1,
+                      &copyRegion);
+    }
+    if (indexBytes > 0) {
+      copyRegion.srcOffset = vertexBytes;
+      copyRegion.dstOffset = VkDeviceSize(mesh.firstIndex) * sizeof(uint32_t);
+      copyRegion.size = indexBytes;
+      vkCmdCopyBuffer(copyCmd, staging.buffer, m_indices.buffer, 1,
+                      &copyRegion);
+    }
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+    m_vulkanDevice->flushCommandBuffer(copyCmd, m_queue);
+    staging.destroy();
+  }
+
+  mesh.users = 1;
+  mesh.key = key;
+  Handle handle;
+  if (!m_freeHandles.empty()) {
+    handle = m_freeHandles.back();
+    m_freeHandles.pop_back();
+    m_meshes[handle] = mesh;
+  } else {
+    handle = static_cast<Handle>(m_meshes.size());
+    m_meshes.push_back(mesh);
+  }
+  if (!key.empty()) m_keys[key] = handle;
+  return handle;
+}
+
+/**
+ * @brief Gives a mesh's ranges back to the free lists, once its last user
+ * released it
+ *
+ * The data stays in place until a later upload reuses the range, so command
+ * buffers that still draw the mesh must be rebuilt before then.
+ */
+void VulkanGeometryArena::release(Handle handle) {
+  ExclusiveLock lock(*this);
+  if (handle == INVALID_HANDLE || handle >= m_meshes.size()) return;
+  Mesh& mesh = m_meshes[handle];
+  if (!mesh.live || --mesh.users > 0) return;
+  if (!mesh.key.empty()) m_keys.erase(mesh.key);
+  m_vertexFreeList.release(mesh.vertexOffset, mesh.vertexCount);
+  m_indexFreeList.release(mesh.firstIndex, mesh.indexCount);
+  mesh.live = false;
+  m_freeHandles.push_back(handle);
+}
+
+/**
+ * @brief Packs all live meshes to the front of new buffers of the same size,
+ * leaving a single free block behind them
+ */
+void VulkanGeometryArena::compact() {
+  ExclusiveLock lock(*this);
+  reallocate(m_vertexFreeList.getCapacity(), m_indexFreeList.getCapacity());
+}
+
+/**
+ * @brief Keeps the arena from changing until unlockShared()
+ *
+ * A window holds it from recording a frame until its submission, so the
+ * buffers and ranges it recorded stay valid, and any reallocation after that
+ * is caught by the generation before the next recording. Must not be held by
+ * the thread that changes the arena. Buffers replaced since are destroyed
+ * here once the frames reading them are done.
+ */
+void VulkanGeometryArena::lockShared() {
+  std::unique_lock<std::mutex> lock(m_lockMutex);
+  m_lockReleased.wait(
+      lock, [this] { return !m_exclusive && m_exclusiveWaiting == 0; });
+  m_sharedCount++;
+  collectRetired();
+}
+
+void VulkanGeometryArena::unlockShared() {
+  std::lock_guard<std::mutex> lock(m_lockMutex);
+  if (--m_sharedCount == 0) m_lockReleased.notify_all();
+}
+
+/**
+ * @brief Binds the arena's vertex and index buffers, once per render pass
+ */
+void VulkanGeometryArena::bind(VkCommandBuffer commandBuffer) const {
+  VkDeviceSize offsets[1] = {0};
+  vkCmdBindVertexBuffers(commandBuffer, VERTEX_BUFFER_BIND_ID, 1,
+                         &m_vertices.buffer, offsets);
+  vkCmdBindIndexBuffer(commandBuffer, m_indices.buffer, 0,
+                       VK_INDEX_TYPE_UINT32);
+}
+
+/**
+ * @brief Draws a mesh from the bound arena buffers
+ */
+void VulkanGeometryArena::draw(VkCommandBuffer commandBuffer, Handle handle,
+                               uint32_t instanceCount,
+                               uint32_t firstInstance) const {
+  Mesh const& mesh = m_meshes[handle];
+  vkCmdDrawIndexed(commandBuffer, mesh.indexCount, instanceCount,
+                   mesh.firstIndex, static_cast<int32_t>(mesh.vertexOffset),
+                   firstInstance);
+}
+
+/**
+ * @brief Draws one mesh's indices over another's vertices
+ *
+ * For index-only meshes, uploaded without vertices, such as the edges of a
+ * triangle mesh drawn as lines.
+ */
+void VulkanGeometryArena::draw(VkCommandBuffer commandBuffer, Handle indices,
+                               Handle vertices) const {
+  Mesh const& indexMesh = m_meshes[indices];
+  vkCmdDrawIndexed(commandBuffer, indexMesh.indexCount, 1,
+                   indexMesh.firstIndex,
+                   static_cast<int32_t>(m_meshes[vertices].vertexOffset), 0);
+}
+
+/* ----------------------------- IMPLEMENTATION ----------------------------- */
+
+VulkanGeometryArena::ExclusiveLock::ExclusiveLock(VulkanGeometryArena& arena)
+    : m_arena(arena) {
+  std::unique_lock<std::mutex> lock(m_arena.m_lockMutex);
+  m_arena.m_exclusiveWaiting++;
+  m_arena.m_lockReleased.wait(lock, [this] {
+    return !m_arena.m_exclusive && m_arena.m_sharedCount == 0;
+  });
+  m_arena.m_exclusiveWaiting--;
+  m_arena.m_exclusive = true;
+}
+
+VulkanGeometryArena::ExclusiveLock::~ExclusiveLock() {
+  std::lock_guard<std::mutex> lock(m_arena.m_lockMutex);
+  m_arena.m_exclusive = false;
+  m_arena.m_lockReleased.notify_all();
+}
+
+/**
+ * @brief Creates a pair of device-local buffers for the arena
+ *
+ * Transfer source is needed as well, so compaction can copy out of them.
+ */
+void VulkanGeometryArena::createBuffers(uint32_t vertexCapacity,
+                                        uint32_t indexCapacity,
+                                        vks::Buffer& vertices,
+                                        vks::Buffer& indices) {
+  VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::MESH,
+                                   "Geometry arena");
+  VK_CHECK_RESULT(m_vulkanDevice->createBuffer(
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vertices,
+      VkDeviceSize(vertexCapacity) * m_vertexStride));
+  VK_CHECK_RESULT(m_vulkanDevice->createBuffer(
+      VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indices,
+      VkDeviceSize(indexCapacity) * sizeof(uint32_t)));
+}
+
+/**
+ * @brief Moves every live mesh, packed, into new buffers of the given size
+ *
+ * Command buffers in flight, from any window, may still read from the old
+ * buffers. The copy only reads them too, so it is queued behind those frames
+ * without waiting for them, and the buffers are retired with its fence: fence
+ * signals cover every earlier submission to the queue. Frames submitted
+ * after the copy see its writes through its closing barrier.
+ */
+void VulkanGeometryArena::reallocate(uint32_t vertexCapacity,
+                                     uint32_t indexCapacity) {
+  vks::Buffer vertices, indices;
+  createBuffers(vertexCapacity, indexCapacity, vertices, indices);
+
+  std::vector<VkBufferCopy> vertexCopies, indexCopies;
+  uint32_t vertexHead = 0, indexHead = 0;
+  for (auto& mesh : m_meshes) {
+    if (!mesh.live) continue;
+    if (mesh.vertexCount > 0) {
+      VkBufferCopy copy = {};
+      copy.srcOffset = VkDeviceSize(mesh.vertexOffset) * m_vertexStride;
+      copy.dstOffset = VkDeviceSize(vertexHead) * m_vertexStride;
+      copy.size = VkDeviceSize(mesh.vertexCount) * m_vertexStride;
+      vertexCopies.push_back(copy);
+    }
+    if (mesh.indexCount > 0) {
+      VkBufferCopy copy = {};
+      copy.srcOffset = VkDeviceSize(mesh.firstIndex) * sizeof(uint32_t);
+      copy.dstOffset = VkDeviceSize(indexHead) * sizeof(uint32_t);
+      copy.size = VkDeviceSize(mesh.indexCount) * sizeof(uint32_t);
+      indexCopies.push_back(copy);
+    }
+    mesh.vertexOffset = vertexHead;
+    mesh.firstIndex = indexHead;
+    vertexHead += mesh.vertexCount;
+    indexHead += mesh.indexCount;
+  }
+
+  Retired retired;
+  retired.vertices = m_vertices;
+  retired.indices = m_indices;
+  retired.copyCmd = m_vulkanDevice->createCommandBuffer(
+      VK_COMMAND_BUFFER_LEVEL_PRIMARY, m_commandPool, true);
+  // the uploads' writes are read by the copy, not only by vertex input
+  VkMemoryBarrier barrier = vks::initializers::memoryBarrier();
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(retired.copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+  if (!vertexCopies.empty())
+    vkCmdCopyBuffer(retired.copyCmd, m_vertices.buffer, vertices.buffer,
+                    static_cast<uint32_t>(vertexCopies.size()),
+                    vertexCopies.data());
+  if (!indexCopies.empty())
+    vkCmdCopyBuffer(retired.copyCmd, m_indices.buffer, indices.buffer,
+                    static_cast<uint32_t>(indexCopies.size()),
+                    indexCopies.data());
+  barrier.dstAccessMask =
+      VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+  vkCmdPipelineBarrier(retired.copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+  VK_CHECK_RESULT(vkEndCommandBuffer(retired.copyCmd));
+  VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo();
+  VK_CHECK_RESULT(vkCreateFence(m_vulkanDevice->logicalDevice, &fenceInfo,
+                                nullptr, &retired.fence));
+  VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &retired.copyCmd;
+  {
+    // the queue is shared with the other windows
+    std::lock_guard<std::mutex> lock(m_vulkanDevice->queueMutex);
+    VK_CHECK_RESULT(vkQueueSubmit(m_queue, 1, &submitInfo, retired.fence));
+  }
+  m_retired.push_back(retired);
+
+  m_vertices = vertices;
+  m_indices = indices;
+  m_vertexFreeList.reset(vertexCapacity, vertexHead);
+  m_indexFreeList.reset(indexCapacity, indexHead);
+  m_generation++;
+  LOGI("VulkanGeometryArena|reallocate| %u vertices / %u indices in use\n",
+       vertexHead, indexHead);
+}
+
+/**
+ * @brief Destroys the replaced buffers whose copy's fence has signaled
+ *
+ * @param wait - Whether to wait for every fence, when the arena is destroyed
+ */
+void VulkanGeometryArena::collectRetired(bool wait) {
+  VkDevice device = m_vulkanDevice->logicalDevice;
+  auto done = [&](Retired& retired) {
+    if (wait) {
+      VK_CHECK_RESULT(vkWaitForFences(device, 1, &retired.fence, VK_TRUE,
+                                      DEFAULT_FENCE_TIMEOUT));
+    } else if (vkGetFenceStatus(device, retired.fence) != VK_SUCCESS) {
+      return false;
+    }
+    retired.vertices.destroy();
+    retired.indices.destroy();
+    vkFreeCommandBuffers(device, m_commandPool, 1, &retired.copyCmd);
+    vkDestroyFence(device, retired.fence, nullptr);
+    return true;
+  };
+  m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), done),
+                  m_retired.end());
+}
+
+/**
+ * @brief Takes ranges for a mesh from both free lists, or neither
+ */
+bool VulkanGeometryArena::tryAllocate(uint32_t vertexCount,
+                                      uint32_t indexCount, Mesh& mesh) {
+  if (!m_vertexFreeList.allocate(vertexCount, mesh.vertexOffset)) return false;
+  if (!m_indexFreeList.allocate(indexCount, mesh.firstIndex)) {
+    m_vertexFreeList.release(mesh.vertexOffset, vertexCount);
+    return false;
+  }
+  mesh.vertexCount = vertexCount;
+  mesh.indexCount = indexCount;
+  mesh.live = true;
+  return true;
+}
+
+}  // namespace VulkanEngine
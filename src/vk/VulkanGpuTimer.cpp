@@ -0,0 +1,84 @@
+#include "VulkanGpuTimer.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Creates two timestamp queries per frame, if the queue supports them
+ *
+ * @param vulkanDevice
+ * @param queueFamily - Family of the queue the command buffers go to
+ * @param frameCount - Number of draw command buffers
+ */
+VulkanGpuTimer::VulkanGpuTimer(vks::VulkanDevice* vulkanDevice,
+                               uint32_t queueFamily, uint32_t frameCount) {
+  m_device = vulkanDevice->logicalDevice;
+  m_frameCount = frameCount;
+  uint32_t validBits =
+      vulkanDevice->queueFamilyProperties[queueFamily].timestampValidBits;
+  if (validBits == 0) {
+    LOGI("VulkanGpuTimer| Timestamps not supported on this queue");
+    return;
+  }
+  if (validBits < 64) m_timestampMask = (1ull << validBits) - 1;
+  m_timestampPeriod = vulkanDevice->properties.limits.timestampPeriod;
+  m_submitted.resize(frameCount, false);
+
+  VkQueryPoolCreateInfo queryPoolInfo = {};
+  queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  queryPoolInfo.queryCount = frameCount * 2;
+  VK_CHECK_RESULT(
+      vkCreateQueryPool(m_device, &queryPoolInfo, nullptr, &m_queryPool));
+}
+
+VulkanGpuTimer::~VulkanGpuTimer() {
+  VK_SAFE_DELETE(m_queryPool,
+                 vkDestroyQueryPool(m_device, m_queryPool, nullptr));
+}
+
+/**
+ * @brief Starts the span, outside of a render pass
+ */
+void VulkanGpuTimer::begin(VkCommandBuffer cmd, uint32_t frame) const {
+  if (!isSupported() || frame >= m_submitted.size()) return;
+  vkCmdResetQueryPool(cmd, m_queryPool, frame * 2, 2);
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool,
+                      frame * 2);
+}
+
+/**
+ * @brief Ends the span, once everything recorded since begin() is done
+ */
+void VulkanGpuTimer::end(VkCommandBuffer cmd, uint32_t frame) const {
+  if (!isSupported() || frame >= m_submitted.size()) return;
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool,
+                      frame * 2 + 1);
+}
+
+/**
+ * @brief Reads the span of the frame's last submission, then expects the
+ * frame to be submitted again
+ *
+ * Call it right before the frame's command buffer is submitted, once its
+ * fence has been waited on.
+ *
+ * @param frame
+ * @param milliseconds - Receives the time between begin() and end()
+ * @return Whether a time was read
+ */
+bool VulkanGpuTimer::collect(uint32_t frame, float& milliseconds) {
+  if (!isSupported() || frame >= m_submitted.size()) return false;
+  bool submitted = m_submitted[frame];
+  m_submitted[frame] = true;
+  if (!submitted) return false;
+  uint64_t timestamps[2] = {};
+  VkResult result = vkGetQueryPoolResults(
+      m_device, m_queryPool, frame * 2, 2, sizeof(timestamps), timestamps,
+      sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  if (result != VK_SUCCESS) return false;
+  uint64_t ticks = (timestamps[1] - timestamps[0]) & m_timestampMask;
+  milliseconds = static_cast<float>(ticks) * m_timestampPeriod / 1e6f;
+  return true;
+}
+
+}  // namespace VulkanEngine
@@ -0,0 +1,138 @@
+#include "VulkanInstanceBuffer.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanMemoryTracker.h"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Construct a new, empty Vulkan Instance Buffer
+ *
+ * @param vulkanDevice - The device to allocate the buffer on
+ * @param queue - Queue the uploads are submitted to
+ */
+VulkanInstanceBuffer::VulkanInstanceBuffer(vks::VulkanDevice* vulkanDevice,
+                                           VkQueue queue)
+    : m_vulkanDevice(vulkanDevice), m_queue(queue) {}
+
+VulkanInstanceBuffer::~VulkanInstanceBuffer() {
+  retireUploads(true);
+  m_buffer.destroy();
+}
+
+/**
+ * @brief Replaces every instance's model matrix
+ *
+ * Does not wait: the copy is submitted after the frames already queued, and
+ * its barriers make it wait for their vertex reads and the frames after it
+ * wait for its write.
+ *
+ * @param transforms - One model matrix per instance
+ * @return true - The buffer had to grow, so command buffers that bind it
+ * must be rebuilt
+ */
+bool VulkanInstanceBuffer::setTransforms(
+    std::vector<glm::mat4> const& transforms) {
+  retireUploads(false);
+  uint32_t count = static_cast<uint32_t>(transforms.size());
+  VkDeviceSize size = sizeof(glm::mat4) * count;
+  m_count = count;
+  if (size == 0) return false;
+
+  Upload upload;
+  bool grown = false;
+  if (count > m_capacity) {
+    upload.replaced = m_buffer;
+    m_buffer = vks::Buffer();
+    m_capacity = std::max(count, m_capacity * 2);
+    VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::MESH,
+                                     "Instance transforms");
+    VK_CHECK_RESULT(m_vulkanDevice->createBuffer(
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_buffer,
+        sizeof(glm::mat4) * m_capacity));
+    grown = true;
+  }
+
+  {
+    VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::STAGING,
+                                     "Instance staging");
+    VK_CHECK_RESULT(m_vulkanDevice->createBuffer(
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &upload.staging, size, (void*)transforms.data()));
+  }
+  // the buffer may be freed on another thread, so remember whose pool it is
+  upload.cmdPool = m_vulkanDevice->getCommandPool();
+  upload.cmdBuffer = m_vulkanDevice->createCommandBuffer(
+      VK_COMMAND_BUFFER_LEVEL_PRIMARY, upload.cmdPool, true);
+  // frames submitted earlier finish reading before the copy overwrites
+  VkMemoryBarrier barrier = vks::initializers::memoryBarrier();
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(upload.cmdBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+  VkBufferCopy copyRegion = {};
+  copyRegion.size = size;
+  vkCmdCopyBuffer(upload.cmdBuffer, upload.staging.buffer, m_buffer.buffer, 1,
+                  &copyRegion);
+  // and frames submitted later read what it wrote
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+  vkCmdPipelineBarrier(upload.cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+  VK_CHECK_RESULT(vkEndCommandBuffer(upload.cmdBuffer));
+
+  VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo();
+  VK_CHECK_RESULT(vkCreateFence(m_vulkanDevice->logicalDevice, &fenceInfo,
+                                nullptr, &upload.fence));
+  VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &upload.cmdBuffer;
+  {
+    std::lock_guard<std::mutex> lock(m_vulkanDevice->queueMutex);
+    VK_CHECK_RESULT(vkQueueSubmit(m_queue, 1, &submitInfo, upload.fence));
+  }
+  m_uploads.push_back(upload);
+  return grown;
+}
+
+/**
+ * @brief Frees what the completed uploads kept alive
+ *
+ * The copy waited for the frames submitted before it, so once its fence
+ * signals nothing reads the buffer it replaced either.
+ *
+ * @param wait - Whether to wait for the uploads still in flight
+ */
+void VulkanInstanceBuffer::retireUploads(bool wait) {
+  VkDevice device = m_vulkanDevice->logicalDevice;
+  auto it = m_uploads.begin();
+  while (it != m_uploads.end()) {
+    if (wait) {
+      VK_CHECK_RESULT(vkWaitForFences(device, 1, &it->fence, VK_TRUE,
+                                      DEFAULT_FENCE_TIMEOUT));
+    } else if (vkGetFenceStatus(device, it->fence) != VK_SUCCESS) {
+      ++it;
+      continue;
+    }
+    vkDestroyFence(device, it->fence, nullptr);
+    vkFreeCommandBuffers(device, it->cmdPool, 1, &it->cmdBuffer);
+    it->staging.destroy();
+    it->replaced.destroy();
+    it = m_uploads.erase(it);
+  }
+}
+
+/**
+ * @brief Binds the matrices to the instance buffer binding
+ */
+void VulkanInstanceBuffer::bind(VkCommandBuffer commandBuffer) const {
+  VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(commandBuffer, INSTANCE_BUFFER_BIND_ID, 1,
+                         &m_buffer.buffer, &offset);
+}
+
+}  // namespace VulkanEngine
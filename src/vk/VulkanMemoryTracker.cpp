@@ -0,0 +1,265 @@
+#include "VulkanMemoryTracker.h"
+#include "render_common.h"
+
+namespace VulkanEngine {
+
+// category overrides are per-thread, so loading on a worker thread never
+// mislabels allocations made by the render thread
+static thread_local bool s_scopeActive = false;
+static thread_local VulkanMemoryTracker::Category s_scopeCategory =
+    VulkanMemoryTracker::Category::OTHER;
+static thread_local char const* s_scopeName = nullptr;
+
+/* -------------------------------------------------------------------------- */
+/*                                   SCOPES                                   */
+/* -------------------------------------------------------------------------- */
+
+VulkanMemoryTracker::Scope::Scope(Category category, char const* name)
+    : m_previousActive(s_scopeActive),
+      m_previousCategory(s_scopeCategory),
+      m_previousName(s_scopeName) {
+  s_scopeActive = true;
+  s_scopeCategory = category;
+  s_scopeName = name;
+}
+
+VulkanMemoryTracker::Scope::~Scope() {
+  s_scopeActive = m_previousActive;
+  s_scopeCategory = m_previousCategory;
+  s_scopeName = m_previousName;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   SETUP                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Returns the process-wide tracker
+ */
+VulkanMemoryTracker& VulkanMemoryTracker::get() {
+  static VulkanMemoryTracker tracker;
+  return tracker;
+}
+
+/**
+ * @brief Links the tracker to the physical device memory is allocated from
+ *
+ * @param instance - Used to look up vkGetPhysicalDeviceMemoryProperties2KHR
+ * @param physicalDevice - The device whose heaps we report on
+ * @param memoryBudget - Whether VK_EXT_memory_budget was enabled on the device
+ */
+void VulkanMemoryTracker::attach(VkInstance instance,
+                                 VkPhysicalDevice physicalDevice,
+                                 bool memoryBudget) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_physicalDevice = physicalDevice;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+  m_getMemoryProperties2 = nullptr;
+  if (memoryBudget) {
+    m_getMemoryProperties2 =
+        reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+            vkGetInstanceProcAddr(instance,
+                                  "vkGetPhysicalDeviceMemoryProperties2KHR"));
+  }
+}
+
+/**
+ * @brief Unlinks the tracker from its physical device. Allocations stay in
+ * the ledger so leaks remain visible.
+ */
+void VulkanMemoryTracker::detach() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_physicalDevice = VK_NULL_HANDLE;
+  m_getMemoryProperties2 = nullptr;
+}
+
+/**
+ * @brief Human-readable name of an allocation category
+ */
+char const* VulkanMemoryTracker::getCategoryName(Category category) {
+  switch (category) {
+    case Category::MESH:
+      return "Mesh";
+    case Category::TEXTURE:
+      return "Texture";
+    case Category::SHADOW_MAP:
+      return "Shadow map";
+    case Category::RENDER_TARGET:
+      return "Render target";
+    case Category::UNIFORM:
+      return "Uniform";
+    case Category::UI:
+      return "UI";
+    case Category::STAGING:
+      return "Staging";
+    default:
+      return "Other";
+  }
+}
+
+/**
+ * @brief Derives the category of a buffer allocation from its usage flags,
+ * unless a Scope on this thread overrides it.
+ */
+VulkanMemoryTracker::Category VulkanMemoryTracker::categorize(
+    VkBufferUsageFlags usage) {
+  if (s_scopeActive) return s_scopeCategory;
+  if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+               VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+    return Category::MESH;
+  if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT))
+    return Category::UNIFORM;
+  if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT) return Category::STAGING;
+  return Category::OTHER;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          ALLOCATION BOOKKEEPING                            */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Allocates device memory and records it in the ledger
+ *
+ * Drop-in replacement for vkAllocateMemory.
+ *
+ * @param category - Subsystem the memory belongs to
+ * @param name - Optional label shown in leak reports (a Scope's name wins)
+ */
+VkResult VulkanMemoryTracker::allocate(VkDevice device,
+                                       VkMemoryAllocateInfo const* allocateInfo,
+                                       VkDeviceMemory* memory,
+                                       Category category, char const* name) {
+  VkResult result = vkAllocateMemory(device, allocateInfo, nullptr, memory);
+  if (result != VK_SUCCESS) return result;
+  if (s_scopeActive && s_scopeName) name = s_scopeName;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Allocation allocation;
+  allocation.size = allocateInfo->allocationSize;
+  allocation.heapIndex =
+      m_physicalDevice
+          ? m_memoryProperties.memoryTypes[allocateInfo->memoryTypeIndex]
+                .heapIndex
+          : 0;
+  allocation.category = category;
+  allocation.name = name ? name : "";
+  m_allocations[*memory] = allocation;
+
+  Usage& usage = m_usage[static_cast<size_t>(category)];
+  usage.current += allocation.size;
+  usage.peak = std::max(usage.peak, usage.current);
+  usage.allocations++;
+  m_heapUsage[allocation.heapIndex] += allocation.size;
+  m_total += allocation.size;
+  m_peak = std::max(m_peak, m_total);
+  return result;
+}
+
+/**
+ * @brief Frees device memory and removes it from the ledger
+ *
+ * Drop-in replacement for vkFreeMemory, safe to call with VK_NULL_HANDLE.
+ */
+void VulkanMemoryTracker::free(VkDevice device, VkDeviceMemory memory) {
+  if (memory == VK_NULL_HANDLE) return;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_allocations.find(memory);
+    if (it != m_allocations.end()) {
+      Allocation const& allocation = it->second;
+      Usage& usage = m_usage[static_cast<size_t>(allocation.category)];
+      usage.current -= allocation.size;
+      usage.allocations--;
+      m_heapUsage[allocation.heapIndex] -= allocation.size;
+      m_total -= allocation.size;
+      m_allocations.erase(it);
+    }
+  }
+  vkFreeMemory(device, memory, nullptr);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 REPORTING                                  */
+/* -------------------------------------------------------------------------- */
+
+VulkanMemoryTracker::Usage VulkanMemoryTracker::getUsage(
+    Category category) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_usage[static_cast<size_t>(category)];
+}
+
+VkDeviceSize VulkanMemoryTracker::getTotal() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_total;
+}
+
+VkDeviceSize VulkanMemoryTracker::getPeak() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_peak;
+}
+
+/**
+ * @brief Returns the state of every memory heap on the device
+ *
+ * With VK_EXT_memory_budget the driver's budget and usage (which include
+ * other processes and driver-internal allocations) are filled in; otherwise
+ * the budget falls back to the heap size and the usage to our own sum.
+ */
+std::vector<VulkanMemoryTracker::HeapBudget>
+VulkanMemoryTracker::getHeapBudgets() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<HeapBudget> heaps;
+  if (!m_physicalDevice) return heaps;
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+  budgetProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  if (m_getMemoryProperties2) {
+    VkPhysicalDeviceMemoryProperties2KHR memoryProperties2 = {};
+    memoryProperties2.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+    memoryProperties2.pNext = &budgetProperties;
+    m_getMemoryProperties2(m_physicalDevice, &memoryProperties2);
+  }
+
+  heaps.resize(m_memoryProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++) {
+    VkMemoryHeap const& heap = m_memoryProperties.memoryHeaps[i];
+    heaps[i].deviceLocal = heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    heaps[i].size = heap.size;
+    heaps[i].tracked = m_heapUsage[i];
+    heaps[i].budget =
+        m_getMemoryProperties2 ? budgetProperties.heapBudget[i] : heap.size;
+    heaps[i].usage =
+        m_getMemoryProperties2 ? budgetProperties.heapUsage[i] : m_heapUsage[i];
+  }
+  return heaps;
+}
+
+/**
+ * @brief Logs every allocation still in the ledger
+ *
+ * Call right before the device is destroyed, once everything that should have
+ * been freed has been.
+ *
+ * @return size_t - The number of leaked allocations
+ */
+size_t VulkanMemoryTracker::reportLeaks() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_allocations.empty()) {
+    LOGI("GPU memory: no leaks, peak usage %.2f MiB\n",
+         m_peak / (1024.0 * 1024.0));
+    return 0;
+  }
+  LOGI("GPU memory: %zu allocation(s) totalling %.2f MiB were never freed\n",
+       m_allocations.size(), m_total / (1024.0 * 1024.0));
+  for (auto const& entry : m_allocations) {
+    Allocation const& allocation = entry.second;
+    LOGI("  [%s] %llu bytes %s\n", getCategoryName(allocation.category),
+         static_cast<unsigned long long>(allocation.size),
+         allocation.name.c_str());
+  }
+  return m_allocations.size();
+}
+
+}  // namespace VulkanEngine
@@ -0,0 +1,330 @@
+#include "VulkanPicker.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanMemoryTracker.h"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+namespace {
+
+constexpr uint32_t REGION_SIZE = 2 * VulkanPicker::RADIUS + 1;
+
+}  // namespace
+
+/**
+ * @brief Gets the pick pass and creates the readback ring. The target is
+ * created by the first resize().
+ *
+ * @param vulkanDevice
+ * @param queue - Queue the picks are submitted to
+ * @param cmdPool - Pool allowing its command buffers to be reset
+ * @param renderPasses - Shares the pick pass, and so the pick pipeline, with
+ * the other windows
+ */
+VulkanPicker::VulkanPicker(vks::VulkanDevice* vulkanDevice, VkQueue queue,
+                           VkCommandPool cmdPool,
+                           VulkanRenderPassCache* renderPasses) {
+  m_vulkanDevice = vulkanDevice;
+  m_device = vulkanDevice->logicalDevice;
+  m_queue = queue;
+  m_cmdPool = cmdPool;
+  VkBool32 validDepthFormat = vks::tools::getSupportedDepthFormat(
+      vulkanDevice->physicalDevice, &m_depthFormat);
+  assert(validDepthFormat);
+
+  m_renderPass = renderPasses->get(VulkanRenderPassCache::Type::PICK,
+                                   VK_FORMAT_R32_UINT, m_depthFormat);
+
+  VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::STAGING,
+                                   "Pick readback");
+  VkCommandBufferAllocateInfo allocateInfo =
+      vks::initializers::commandBufferAllocateInfo(
+          m_cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+  VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo(0);
+  for (auto& slot : m_slots) {
+    VK_CHECK_RESULT(m_vulkanDevice->createBuffer(
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &slot.buffer, REGION_SIZE * REGION_SIZE * sizeof(uint32_t)));
+    // stays mapped, reading it is all a pick costs on the CPU
+    VK_CHECK_RESULT(slot.buffer.map());
+    VK_CHECK_RESULT(
+        vkAllocateCommandBuffers(m_device, &allocateInfo, &slot.cmd));
+    VK_CHECK_RESULT(vkCreateFence(m_device, &fenceInfo, nullptr, &slot.fence));
+  }
+}
+
+/**
+ * @brief Waits for the picks still in flight, then frees everything
+ */
+VulkanPicker::~VulkanPicker() {
+  for (auto& slot : m_slots) {
+    if (slot.inFlight)
+      vkWaitForFences(m_device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+    slot.buffer.destroy();
+    vkFreeCommandBuffers(m_device, m_cmdPool, 1, &slot.cmd);
+    VK_SAFE_DELETE(slot.fence, vkDestroyFence(m_device, slot.fence, nullptr));
+  }
+  destroyTarget();
+}
+
+/**
+ * @brief Sizes the target for a screen of the given size, reallocating it if
+ * that changed
+ *
+ * Waits for the picks in flight when it does, which only happens when the
+ * window is resized.
+ *
+ * @param width - Screen width, in pixels
+ * @param height - Screen height, in pixels
+ */
+void VulkanPicker::resize(uint32_t width, uint32_t height) {
+  width = std::max(1u, width / SCALE);
+  height = std::max(1u, height / SCALE);
+  if (width == m_width && height == m_height) return;
+  for (auto& slot : m_slots) {
+    if (!slot.inFlight) continue;
+    VK_CHECK_RESULT(
+        vkWaitForFences(m_device, 1, &slot.fence, VK_TRUE, UINT64_MAX));
+    slot.inFlight = false;
+  }
+  destroyTarget();
+  m_width = width;
+  m_height = height;
+  createTarget();
+}
+
+/**
+ * @brief Reads back the region under the cursor, drawing the ids first if
+ * asked to
+ *
+ * @param mousePos - Cursor position, in screen pixels
+ * @param redraw - Whether the view or the scene changed since the last draw
+ * @param draw - Records the id draws, inside the pick render pass. The
+ * viewport and scissor are set already.
+ * @return Whether a pick was submitted. If not and redraw was asked for, ask
+ * again next frame.
+ */
+bool VulkanPicker::pick(glm::vec2 const& mousePos, bool redraw,
+                        std::function<void(VkCommandBuffer)> const& draw) {
+  collect();
+  if (m_frameBuffer == VK_NULL_HANDLE) return false;
+  glm::ivec2 cursor = glm::ivec2(mousePos / static_cast<float>(SCALE));
+  if (cursor.x < 0 || cursor.y < 0 || cursor.x >= static_cast<int>(m_width) ||
+      cursor.y >= static_cast<int>(m_height)) {
+    m_result = Result();
+    m_lastCursor = glm::ivec2(-1);
+    return false;
+  }
+  redraw = redraw || !m_drawn;
+  if (!redraw && cursor == m_lastCursor) return false;
+
+  Slot* slot = nullptr;
+  for (auto& candidate : m_slots) {
+    if (!candidate.inFlight) {
+      slot = &candidate;
+      break;
+    }
+  }
+  if (!slot) return false;
+
+  // the region around the cursor, clamped to the target
+  int32_t x0 = std::max(cursor.x - RADIUS, 0);
+  int32_t y0 = std::max(cursor.y - RADIUS, 0);
+  int32_t x1 = std::min(cursor.x + RADIUS, static_cast<int32_t>(m_width) - 1);
+  int32_t y1 = std::min(cursor.y + RADIUS, static_cast<int32_t>(m_height) - 1);
+  slot->origin = {x0, y0};
+  slot->extent = {static_cast<uint32_t>(x1 - x0 + 1),
+                  static_cast<uint32_t>(y1 - y0 + 1)};
+  slot->cursor = cursor;
+
+  VkCommandBufferBeginInfo beginInfo =
+      vks::initializers::commandBufferBeginInfo();
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  VK_CHECK_RESULT(vkBeginCommandBuffer(slot->cmd, &beginInfo));
+  if (redraw) {
+    VkClearValue clearValues[2];
+    clearValues[0].color.uint32[0] = 0;
+    clearValues[0].color.uint32[1] = 0;
+    clearValues[0].color.uint32[2] = 0;
+    clearValues[0].color.uint32[3] = 0;
+    clearValues[1].depthStencil = {1.0f, 0};
+    VkRenderPassBeginInfo renderPassBeginInfo =
+        vks::initializers::renderPassBeginInfo();
+    renderPassBeginInfo.renderPass = m_renderPass->get();
+    renderPassBeginInfo.framebuffer = m_frameBuffer;
+    renderPassBeginInfo.renderArea.extent.width = m_width;
+    renderPassBeginInfo.renderArea.extent.height = m_height;
+    renderPassBeginInfo.clearValueCount = 2;
+    renderPassBeginInfo.pClearValues = clearValues;
+    vkCmdBeginRenderPass(slot->cmd, &renderPassBeginInfo,
+                         VK_SUBPASS_CONTENTS_INLINE);
+    VkViewport viewport = vks::initializers::viewport(
+        static_cast<float>(m_width), static_cast<float>(m_height), 0.f, 1.f);
+    vkCmdSetViewport(slot->cmd, 0, 1, &viewport);
+    VkRect2D scissor = vks::initializers::rect2D(m_width, m_height, 0, 0);
+    vkCmdSetScissor(slot->cmd, 0, 1, &scissor);
+    draw(slot->cmd);
+    vkCmdEndRenderPass(slot->cmd);
+    m_drawn = true;
+  }
+
+  // the render pass leaves the ids ready to be copied
+  VkBufferImageCopy region = {};
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {slot->origin.x, slot->origin.y, 0};
+  region.imageExtent = {slot->extent.width, slot->extent.height, 1};
+  vkCmdCopyImageToBuffer(slot->cmd, m_ids.image,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         slot->buffer.buffer, 1, &region);
+  VkBufferMemoryBarrier barrier = vks::initializers::bufferMemoryBarrier();
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = slot->buffer.buffer;
+  barrier.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(slot->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier,
+                       0, nullptr);
+  VK_CHECK_RESULT(vkEndCommandBuffer(slot->cmd));
+
+  VK_CHECK_RESULT(vkResetFences(m_device, 1, &slot->fence));
+  VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &slot->cmd;
+  {
+    std::lock_guard<std::mutex> lock(m_vulkanDevice->queueMutex);
+    VK_CHECK_RESULT(vkQueueSubmit(m_queue, 1, &submitInfo, slot->fence));
+  }
+  slot->inFlight = true;
+  slot->sequence = ++m_sequence;
+  m_lastCursor = cursor;
+  return true;
+}
+
+/**
+ * @brief Takes the newest result among the picks that have finished, without
+ * waiting for the others
+ */
+void VulkanPicker::collect() {
+  Slot const* newest = nullptr;
+  for (auto& slot : m_slots) {
+    if (!slot.inFlight || vkGetFenceStatus(m_device, slot.fence) != VK_SUCCESS)
+      continue;
+    slot.inFlight = false;
+    if (!newest || slot.sequence > newest->sequence) newest = &slot;
+  }
+  if (newest && newest->sequence > m_resultSequence) {
+    read(*newest);
+    m_resultSequence = newest->sequence;
+  }
+}
+
+/**
+ * @brief Decodes a slot's region into the result
+ */
+void VulkanPicker::read(Slot const& slot) {
+  uint32_t const* ids = static_cast<uint32_t const*>(slot.buffer.mapped);
+  glm::ivec2 center = slot.cursor - glm::ivec2(slot.origin.x, slot.origin.y);
+  Result result;
+  result.id = ids[center.y * slot.extent.width + center.x];
+  for (uint32_t y = 0; y < slot.extent.height; y++) {
+    for (uint32_t x = 0; x < slot.extent.width; x++) {
+      uint32_t id = ids[y * slot.extent.width + x];
+      if (id == result.id) continue;
+      float distance = glm::length(glm::vec2(glm::ivec2(x, y) - center));
+      if (distance < result.neighborDistance) {
+        result.neighborId = id;
+        result.neighborDistance = distance;
+      }
+    }
+  }
+  m_result = result;
+}
+
+/**
+ * @brief Creates the id and depth images at the current size, and the frame
+ * buffer around them
+ */
+void VulkanPicker::createTarget() {
+  struct AttachmentInfo {
+    Attachment* attachment;
+    VkFormat format;
+    VkImageUsageFlags usage;
+    VkImageAspectFlags aspect;
+  };
+  AttachmentInfo infos[2] = {
+      {&m_ids, VK_FORMAT_R32_UINT,
+       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+       VK_IMAGE_ASPECT_COLOR_BIT},
+      {&m_depth, m_depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+       VK_IMAGE_ASPECT_DEPTH_BIT}};
+  for (auto const& info : infos) {
+    VkImageCreateInfo image = vks::initializers::imageCreateInfo();
+    image.imageType = VK_IMAGE_TYPE_2D;
+    image.format = info.format;
+    image.extent = {m_width, m_height, 1};
+    image.mipLevels = 1;
+    image.arrayLayers = 1;
+    image.samples = VK_SAMPLE_COUNT_1_BIT;
+    image.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image.usage = info.usage;
+    VK_CHECK_RESULT(
+        vkCreateImage(m_device, &image, nullptr, &info.attachment->image));
+
+    VkMemoryRequirements memReqs;
+    vkGetImageMemoryRequirements(m_device, info.attachment->image, &memReqs);
+    VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
+    memAlloc.allocationSize = memReqs.size;
+    memAlloc.memoryTypeIndex = m_vulkanDevice->getMemoryType(
+        memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VK_CHECK_RESULT(VulkanMemoryTracker::get().allocate(
+        m_device, &memAlloc, &info.attachment->memory,
+        VulkanMemoryTracker::Category::RENDER_TARGET, "Pick target"));
+    VK_CHECK_RESULT(vkBindImageMemory(m_device, info.attachment->image,
+                                      info.attachment->memory, 0));
+
+    VkImageViewCreateInfo view = vks::initializers::imageViewCreateInfo();
+    view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view.format = info.format;
+    view.subresourceRange = {info.aspect, 0, 1, 0, 1};
+    view.image = info.attachment->image;
+    VK_CHECK_RESULT(
+        vkCreateImageView(m_device, &view, nullptr, &info.attachment->view));
+  }
+
+  VkImageView attachments[2] = {m_ids.view, m_depth.view};
+  VkFramebufferCreateInfo fbufCreateInfo =
+      vks::initializers::framebufferCreateInfo();
+  fbufCreateInfo.renderPass = m_renderPass->get();
+  fbufCreateInfo.attachmentCount = 2;
+  fbufCreateInfo.pAttachments = attachments;
+  fbufCreateInfo.width = m_width;
+  fbufCreateInfo.height = m_height;
+  fbufCreateInfo.layers = 1;
+  VK_CHECK_RESULT(
+      vkCreateFramebuffer(m_device, &fbufCreateInfo, nullptr, &m_frameBuffer));
+  m_drawn = false;
+}
+
+/**
+ * @brief Destroys what createTarget created
+ */
+void VulkanPicker::destroyTarget() {
+  VK_SAFE_DELETE(m_frameBuffer,
+                 vkDestroyFramebuffer(m_device, m_frameBuffer, nullptr));
+  for (Attachment* attachment : {&m_ids, &m_depth}) {
+    VK_SAFE_DELETE(attachment->view,
+                   vkDestroyImageView(m_device, attachment->view, nullptr));
+    VK_SAFE_DELETE(attachment->image,
+                   vkDestroyImage(m_device, attachment->image, nullptr));
+    VK_SAFE_DELETE(
+        attachment->memory,
+        VulkanMemoryTracker::get().free(m_device, attachment->memory));
+  }
+}
+
+}  // namespace VulkanEngine
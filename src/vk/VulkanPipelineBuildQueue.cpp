@@ -0,0 +1,153 @@
+#include "VulkanPipelineBuildQueue.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Points a create info at the description's own state and creates the
+ * pipeline
+ *
+ * @return VkPipeline - VK_NULL_HANDLE if creation failed
+ */
+VkPipeline PipelineDescription::create(VkDevice device,
+                                       VkPipelineCache pipelineCache) {
+  VkPipelineVertexInputStateCreateInfo vertexInputState =
+      vks::initializers::pipelineVertexInputStateCreateInfo();
+  vertexInputState.vertexBindingDescriptionCount =
+      static_cast<uint32_t>(vertexBindings.size());
+  vertexInputState.pVertexBindingDescriptions = vertexBindings.data();
+  vertexInputState.vertexAttributeDescriptionCount =
+      static_cast<uint32_t>(vertexAttributes.size());
+  vertexInputState.pVertexAttributeDescriptions = vertexAttributes.data();
+  VkSpecializationInfo specializationInfo =
+      vks::initializers::specializationInfo(
+          static_cast<uint32_t>(specializationEntries.size()),
+          specializationEntries.data(),
+          specializationData.size() * sizeof(uint32_t),
+          specializationData.data());
+  for (auto& stage : stages)
+    stage.pSpecializationInfo =
+        specializationEntries.empty() ? nullptr : &specializationInfo;
+  colorBlendState.pAttachments = &blendAttachmentState;
+  VkPipelineDynamicStateCreateInfo dynamicState =
+      vks::initializers::pipelineDynamicStateCreateInfo(
+          dynamicStates.data(), static_cast<uint32_t>(dynamicStates.size()),
+          0);
+  VkGraphicsPipelineCreateInfo pipelineCreateInfo =
+      vks::initializers::pipelineCreateInfo(layout, renderPass, 0);
+  pipelineCreateInfo.subpass = subpass;
+  pipelineCreateInfo.stageCount = static_cast<uint32_t>(stages.size());
+  pipelineCreateInfo.pStages = stages.data();
+  pipelineCreateInfo.pVertexInputState = &vertexInputState;
+  pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
+  pipelineCreateInfo.pRasterizationState = &rasterizationState;
+  pipelineCreateInfo.pColorBlendState = &colorBlendState;
+  pipelineCreateInfo.pMultisampleState = &multisampleState;
+  pipelineCreateInfo.pViewportState = &viewportState;
+  pipelineCreateInfo.pDepthStencilState = &depthStencilState;
+  pipelineCreateInfo.pDynamicState = &dynamicState;
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1,
+                                              &pipelineCreateInfo, nullptr,
+                                              &pipeline);
+  if (result != VK_SUCCESS) {
+    LOGI("Pipeline creation failed: %s",
+         vks::tools::errorString(result).c_str());
+    return VK_NULL_HANDLE;
+  }
+  return pipeline;
+}
+
+/**
+ * @brief Starts the workers
+ *
+ * @param device - The device pipelines are created on
+ * @param pipelineCache - Cache shared by every build
+ * @param workerCount - Number of threads, or 0 to leave one core to the
+ * render thread
+ */
+VulkanPipelineBuildQueue::VulkanPipelineBuildQueue(
+    VkDevice device, VkPipelineCache pipelineCache, uint32_t workerCount)
+    : m_device(device), m_pipelineCache(pipelineCache) {
+  if (workerCount == 0) {
+    uint32_t cores = std::thread::hardware_concurrency();
+    workerCount = std::max(cores, 2u) - 1;
+  }
+  for (uint32_t i = 0; i < workerCount; i++)
+    m_workers.emplace_back(&VulkanPipelineBuildQueue::work, this);
+}
+
+/**
+ * @brief Finishes the queued builds, then stops the workers
+ */
+VulkanPipelineBuildQueue::~VulkanPipelineBuildQueue() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_jobAdded.notify_all();
+  for (auto& worker : m_workers) worker.join();
+}
+
+/**
+ * @brief Queues a pipeline build
+ *
+ * @param description - The pipeline to build
+ * @return std::shared_future<VkPipeline> - Ready once the pipeline is built
+ */
+std::shared_future<VkPipeline> VulkanPipelineBuildQueue::submit(
+    PipelineDescription description) {
+  Job job;
+  job.description = std::move(description);
+  std::shared_future<VkPipeline> future = job.promise.get_future().share();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back(std::move(job));
+  }
+  m_jobAdded.notify_one();
+  return future;
+}
+
+/**
+ * @brief Blocks until every submitted build has finished
+ */
+void VulkanPipelineBuildQueue::waitIdle() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_jobDone.wait(lock, [this] { return m_jobs.empty() && m_running == 0; });
+}
+
+/**
+ * @brief Whether every submitted build has finished
+ */
+bool VulkanPipelineBuildQueue::isIdle() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_jobs.empty() && m_running == 0;
+}
+
+/**
+ * @brief Worker loop, building pipelines until the queue is stopped and empty
+ */
+void VulkanPipelineBuildQueue::work() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_jobAdded.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+      if (m_jobs.empty()) return;
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+      m_running++;
+    }
+    job.promise.set_value(job.description.create(m_device, m_pipelineCache));
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running--;
+      m_completed++;
+    }
+    m_jobDone.notify_all();
+  }
+}
+
+}  // namespace VulkanEngine
@@ -0,0 +1,143 @@
+#include "VulkanPipelineCacheFile.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Returns the path of the cache file in the user's cache directory
+ */
+std::string VulkanPipelineCacheFile::getDefaultPath() {
+  QString directory =
+      QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+      "/paperarium-designer";
+  return (directory + "/pipeline_cache.bin").toStdString();
+}
+
+/**
+ * @brief Creates a pipeline cache, seeded from the file if it was written by
+ * the same driver on the same device
+ *
+ * @param device - The device to create the cache on
+ * @param properties - Properties of the device, to validate the file against
+ * @return VkPipelineCache
+ */
+VkPipelineCache VulkanPipelineCacheFile::create(
+    VkDevice device, VkPhysicalDeviceProperties const& properties) {
+  m_path = getDefaultPath();
+  m_warm = false;
+  m_coldStartTime = 0.f;
+
+  std::vector<char> data;
+  QFile file(QString::fromStdString(m_path));
+  if (file.open(QIODevice::ReadOnly)) {
+    QByteArray bytes = file.readAll();
+    FileHeader header;
+    if (static_cast<size_t>(bytes.size()) > sizeof(header)) {
+      memcpy(&header, bytes.constData(), sizeof(header));
+      data.assign(bytes.constData() + sizeof(header),
+                  bytes.constData() + bytes.size());
+    }
+    if (header.magic == MAGIC && header.version == VERSION &&
+        isValid(data, properties)) {
+      m_warm = true;
+      m_coldStartTime = header.coldStartTime;
+    } else {
+      LOGI("Pipeline cache in %s is stale, starting with an empty cache",
+           m_path.c_str());
+      data.clear();
+    }
+  }
+
+  VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+  pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  pipelineCacheCreateInfo.initialDataSize = data.size();
+  pipelineCacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+  VkPipelineCache pipelineCache;
+  VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo,
+                                        nullptr, &pipelineCache));
+  return pipelineCache;
+}
+
+/**
+ * @brief Writes the cache's current contents to the file, replacing the old
+ * file only once the new one is complete
+ *
+ * @param device - The device the cache was created on
+ * @param pipelineCache - The cache to save
+ */
+void VulkanPipelineCacheFile::save(VkDevice device,
+                                   VkPipelineCache pipelineCache) const {
+  if (m_path.empty() || pipelineCache == VK_NULL_HANDLE) return;
+  size_t size = 0;
+  if (vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) !=
+          VK_SUCCESS ||
+      size == 0)
+    return;
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(device, pipelineCache, &size, data.data()) !=
+      VK_SUCCESS)
+    return;
+
+  FileHeader header;
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.coldStartTime = m_coldStartTime;
+
+  QString path = QString::fromStdString(m_path);
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly) ||
+      file.write(reinterpret_cast<char const*>(&header), sizeof(header)) !=
+          static_cast<qint64>(sizeof(header)) ||
+      file.write(data.data(), static_cast<qint64>(size)) !=
+          static_cast<qint64>(size) ||
+      !file.commit()) {
+    LOGI("Failed to save the pipeline cache to %s", m_path.c_str());
+  }
+}
+
+/**
+ * @brief Logs how long startup took and, on a warm start, how much the cache
+ * saved compared to the last cold one
+ *
+ * @param milliseconds - Duration of the startup, pipeline creation included
+ */
+void VulkanPipelineCacheFile::reportStartup(float milliseconds) {
+  if (!m_warm) {
+    m_coldStartTime = milliseconds;
+    LOGI("Started in %.1f ms with an empty pipeline cache", milliseconds);
+  } else if (m_coldStartTime > 0.f) {
+    LOGI("Started in %.1f ms with the saved pipeline cache, %.1f ms faster "
+         "than without it",
+         milliseconds, m_coldStartTime - milliseconds);
+  }
+}
+
+/**
+ * @brief Checks the Vulkan header at the start of the cache data against the
+ * current device
+ */
+bool VulkanPipelineCacheFile::isValid(
+    std::vector<char> const& data,
+    VkPhysicalDeviceProperties const& properties) const {
+  // headerLength, headerVersion, vendorID, deviceID, pipelineCacheUUID
+  size_t const headerSize = sizeof(uint32_t) * 4 + VK_UUID_SIZE;
+  if (data.size() < headerSize) return false;
+  uint32_t header[4];
+  memcpy(header, data.data(), sizeof(header));
+  return header[0] >= headerSize &&
+         header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header[2] == properties.vendorID &&
+         header[3] == properties.deviceID &&
+         memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID,
+                VK_UUID_SIZE) == 0;
+}
+
+}  // namespace VulkanEngine
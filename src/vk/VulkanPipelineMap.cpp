@@ -0,0 +1,142 @@
+#include "VulkanPipelineMap.h"
+
+namespace VulkanEngine {
+
+namespace {
+
+void hashCombine(size_t& seed, uint64_t value) {
+  seed ^= std::hash<uint64_t>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+uint64_t handle(void const* object) {
+  return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(object));
+}
+
+}  // namespace
+
+/**
+ * @brief Compares every field that can change the created pipeline
+ */
+bool PipelineKey::operator==(PipelineKey const& other) const {
+  if (stages.size() != other.stages.size() ||
+      vertexBindings.size() != other.vertexBindings.size() ||
+      vertexAttributes.size() != other.vertexAttributes.size())
+    return false;
+  for (size_t i = 0; i < stages.size(); i++) {
+    if (stages[i].stage != other.stages[i].stage ||
+        stages[i].module != other.stages[i].module ||
+        strcmp(stages[i].pName, other.stages[i].pName) != 0)
+      return false;
+  }
+  for (size_t i = 0; i < vertexBindings.size(); i++) {
+    auto const& a = vertexBindings[i];
+    auto const& b = other.vertexBindings[i];
+    if (a.binding != b.binding || a.stride != b.stride ||
+        a.inputRate != b.inputRate)
+      return false;
+  }
+  for (size_t i = 0; i < vertexAttributes.size(); i++) {
+    auto const& a = vertexAttributes[i];
+    auto const& b = other.vertexAttributes[i];
+    if (a.location != b.location || a.binding != b.binding ||
+        a.format != b.format || a.offset != b.offset)
+      return false;
+  }
+  return constants == other.constants && layout == other.layout &&
+         renderPass == other.renderPass && topology == other.topology &&
+         polygonMode == other.polygonMode && cullMode == other.cullMode &&
+         frontFace == other.frontFace &&
+         colorAttachmentCount == other.colorAttachmentCount &&
+         blendEnable == other.blendEnable && depthBias == other.depthBias;
+}
+
+size_t PipelineKey::Hash::operator()(PipelineKey const& key) const {
+  size_t seed = 0;
+  for (auto const& stage : key.stages) {
+    hashCombine(seed, stage.stage);
+    hashCombine(seed, handle(stage.module));
+  }
+  hashCombine(seed, handle(key.layout));
+  hashCombine(seed, handle(key.renderPass));
+  hashCombine(seed, key.topology);
+  hashCombine(seed, key.polygonMode);
+  hashCombine(seed, key.cullMode);
+  hashCombine(seed, key.frontFace);
+  hashCombine(seed, key.colorAttachmentCount);
+  hashCombine(seed, key.blendEnable);
+  hashCombine(seed, key.depthBias);
+  for (auto const& binding : key.vertexBindings) {
+    hashCombine(seed, binding.binding);
+    hashCombine(seed, binding.stride);
+    hashCombine(seed, binding.inputRate);
+  }
+  for (auto const& attribute : key.vertexAttributes) {
+    hashCombine(seed, attribute.location);
+    hashCombine(seed, attribute.binding);
+    hashCombine(seed, attribute.format);
+    hashCombine(seed, attribute.offset);
+  }
+  for (auto const& constant : key.constants) {
+    hashCombine(seed, constant.first);
+    hashCombine(seed, constant.second);
+  }
+  return seed;
+}
+
+/**
+ * @brief Destroys every pipeline left, waiting for any still building
+ */
+VulkanPipelineMap::~VulkanPipelineMap() {
+  for (auto& entry : m_pipelines) {
+    VkPipeline pipeline = entry.second.get();
+    VK_SAFE_DELETE(pipeline, vkDestroyPipeline(m_device, pipeline, nullptr));
+  }
+}
+
+/**
+ * @brief Returns the pipeline for a key, building it on the first request
+ *
+ * @param key
+ * @param build - Called under the map's lock, so it should only queue the
+ * build when another window may be waiting
+ * @return std::shared_future<VkPipeline> - VK_NULL_HANDLE if creation failed
+ */
+std::shared_future<VkPipeline> VulkanPipelineMap::get(PipelineKey const& key,
+                                                      Build const& build) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_pipelines.find(key);
+  if (found != m_pipelines.end()) return found->second;
+  std::shared_future<VkPipeline> pipeline = build();
+  m_pipelines.emplace(key, pipeline);
+  return pipeline;
+}
+
+/**
+ * @brief Takes every pipeline built from a shader module out of the map
+ *
+ * New requests no longer get them. The caller owns them from then on, and
+ * destroys them once nothing draws with them and they are done building.
+ *
+ * @param shaderModule
+ * @return std::vector<std::shared_future<VkPipeline>> - The pipelines, some
+ * maybe still building
+ */
+std::vector<std::shared_future<VkPipeline>> VulkanPipelineMap::releaseModule(
+    VkShaderModule shaderModule) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<std::shared_future<VkPipeline>> released;
+  for (auto it = m_pipelines.begin(); it != m_pipelines.end();) {
+    bool uses = false;
+    for (auto const& stage : it->first.stages)
+      uses = uses || stage.module == shaderModule;
+    if (uses) {
+      released.push_back(it->second);
+      it = m_pipelines.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return released;
+}
+
+}  // namespace VulkanEngine
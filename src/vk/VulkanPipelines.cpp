@@ -12,6 +12,8 @@ VulkanPipelines::VulkanPipelines(VkDevice& device) { m_device = device; }
  */
 void VulkanPipelines::createBasePipelineInfo(
     VkPipelineLayout const& pipelineLayout, VkRenderPass const& renderPass) {
+  m_pipelineLayout = pipelineLayout;
+  m_renderPass = renderPass;
   m_inputAssemblyState =
       vks::initializers::pipelineInputAssemblyStateCreateInfo(
           VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
@@ -30,22 +32,6 @@ void VulkanPipelines::createBasePipelineInfo(
       VK_SAMPLE_COUNT_1_BIT, 0);
   m_multisampleState.sampleShadingEnable = VK_FALSE;
   // m_multisampleState.minSampleShading = 0.2f;
-  m_dynamicState = vks::initializers::pipelineDynamicStateCreateInfo(
-      m_dynamicStateEnables.data(),
-      static_cast<uint32_t>(m_dynamicStateEnables.size()), 0);
-  m_pipelineCreateInfo =
-      vks::initializers::pipelineCreateInfo(pipelineLayout, renderPass, 0);
-  m_pipelineCreateInfo.pVertexInputState = &m_vertexInputState;
-  m_pipelineCreateInfo.pInputAssemblyState = &m_inputAssemblyState;
-  m_pipelineCreateInfo.pRasterizationState = &m_rasterizationState;
-  m_pipelineCreateInfo.pColorBlendState = &m_colorBlendState;
-  m_pipelineCreateInfo.pMultisampleState = &m_multisampleState;
-  m_pipelineCreateInfo.pViewportState = &m_viewportState;
-  m_pipelineCreateInfo.pDepthStencilState = &m_depthStencilState;
-  m_pipelineCreateInfo.pDynamicState = &m_dynamicState;
-  m_pipelineCreateInfo.stageCount =
-      static_cast<uint32_t>(m_shaderStages.size());
-  m_pipelineCreateInfo.pStages = m_shaderStages.data();
   m_blendAttachmentState.blendEnable = VK_TRUE;
   m_blendAttachmentState.colorWriteMask =
       VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
@@ -60,48 +46,22 @@ void VulkanPipelines::createBasePipelineInfo(
 }
 
 /**
- * @brief Creates a pipeline from a shader module.
+ * @brief Gives a shader the pipeline for its current settings.
+ *
+ * With a build queue set, a new pipeline is compiled on a worker thread and
+ * the shader picks it up once it is ready. Calling this again with another
+ * mode switches the shader to that variant.
  *
  * @param shader
  * @param mode
  */
 void VulkanPipelines::createPipeline(VulkanShader* shader, VkPolygonMode mode) {
-  if (shader) {
-    // if the shader already has a pipeline, destroy that pipeline
-    if (shader->getPipeline())
-      vkDestroyPipeline(m_device, shader->getPipeline(), nullptr);
-    m_rasterizationState.polygonMode = mode;
-    m_rasterizationState.cullMode = shader->getCullFlag();
-    m_rasterizationState.frontFace = shader->getFrontFace();
-    // enable depth bias if required
-    if (shader->getDepthBiasEnabled()) {
-      m_rasterizationState.depthBiasEnable = VK_TRUE;
-      m_dynamicStateEnables.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
-      m_dynamicState = vks::initializers::pipelineDynamicStateCreateInfo(
-          m_dynamicStateEnables.data(), m_dynamicStateEnables.size(), 0);
-    }
-    // if the shader only has one stage, tell that to our pipeline
-    if (shader->isOneStage()) {
-      m_pipelineCreateInfo.stageCount = 1;
-      m_colorBlendState.attachmentCount = 0;
-      m_shaderStages[0] = shader->getShaderStages()[0];
-    } else {
-      m_shaderStages[0] = shader->getShaderStages()[0];
-      m_shaderStages[1] = shader->getShaderStages()[1];
-    }
-    if (shader->isInstanceShader()) {
-      LOGI("Detected instance shader.");
-      m_vertexInputState = shader->getVertexInputState();
-    }
-    // build the shader's pipeline
-    VK_CHECK_RESULT(vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1,
-                                              &m_pipelineCreateInfo, nullptr,
-                                              &(shader->getPipeline())));
-  }
+  createPipeline(shader, m_renderPass, mode);
 }
 
 /**
- * @brief Creates a pipeline from a shader module with an added render pass.
+ * @brief Gives a shader the pipeline for its current settings, in another
+ * render pass.
  *
  * @param shader
  * @param renderPass
@@ -110,8 +70,124 @@ void VulkanPipelines::createPipeline(VulkanShader* shader, VkPolygonMode mode) {
 void VulkanPipelines::createPipeline(VulkanShader* shader,
                                      VkRenderPass renderPass,
                                      VkPolygonMode mode) {
-  m_pipelineCreateInfo.renderPass = renderPass;
-  createPipeline(shader, mode);
+  if (!shader) return;
+  shader->setPipelineRequest(renderPass, mode);
+  shader->setPendingPipeline(getPipeline(makeKey(shader, renderPass, mode)));
+}
+
+/**
+ * @brief Requests a shader's pipeline again, with the render pass and mode it
+ * was last requested with, after its stages changed
+ *
+ * @param shader
+ */
+void VulkanPipelines::recreatePipeline(VulkanShader* shader) {
+  createPipeline(shader, shader->getRenderPass(), shader->getPolygonMode());
+}
+
+/**
+ * @brief Builds the key of a shader's pipeline from the shader's settings
+ *
+ * @param shader
+ * @param renderPass
+ * @param mode
+ * @return PipelineKey
+ */
+PipelineKey VulkanPipelines::makeKey(VulkanShader* shader,
+                                     VkRenderPass renderPass,
+                                     VkPolygonMode mode) const {
+  PipelineKey key;
+  // one-stage shaders only have a vertex stage, for depth-only passes
+  auto const& stages = shader->getShaderStages();
+  size_t stageCount =
+      std::min<size_t>(stages.size(), shader->isOneStage() ? 1 : 2);
+  key.stages.assign(stages.begin(), stages.begin() + stageCount);
+  key.layout = m_pipelineLayout;
+  key.renderPass = renderPass;
+  key.topology = shader->getTopology();
+  key.polygonMode = mode;
+  key.cullMode = shader->getCullFlag();
+  key.frontFace = shader->getFrontFace();
+  key.colorAttachmentCount = shader->isOneStage() ? 0 : 1;
+  key.blendEnable = shader->getBlendEnabled();
+  key.depthBias = shader->getDepthBiasEnabled();
+  key.constants.assign(shader->getConstants().begin(),
+                       shader->getConstants().end());
+  // instance shaders bring their own vertex input
+  VkPipelineVertexInputStateCreateInfo const& inputState =
+      shader->isInstanceShader() ? shader->getVertexInputState()
+                                 : m_vertexInputState;
+  key.vertexBindings.assign(inputState.pVertexBindingDescriptions,
+                            inputState.pVertexBindingDescriptions +
+                                inputState.vertexBindingDescriptionCount);
+  key.vertexAttributes.assign(inputState.pVertexAttributeDescriptions,
+                              inputState.pVertexAttributeDescriptions +
+                                  inputState.vertexAttributeDescriptionCount);
+  return key;
+}
+
+/**
+ * @brief Returns the pipeline for a key from the shared map, creating it on
+ * the first request of any window
+ *
+ * @param key
+ * @return std::shared_future<VkPipeline> - VK_NULL_HANDLE if creation failed
+ */
+std::shared_future<VkPipeline> VulkanPipelines::getPipeline(
+    PipelineKey const& key) {
+  auto build = [this, &key]() -> std::shared_future<VkPipeline> {
+    if (m_buildQueue) return m_buildQueue->submit(describePipeline(key));
+    std::promise<VkPipeline> promise;
+    promise.set_value(
+        describePipeline(key).create(m_device, m_pipelineCache));
+    return promise.get_future().share();
+  };
+  return m_pipelineMap->get(key, build);
+}
+
+/**
+ * @brief Combines the base state with a key into a full pipeline description
+ *
+ * @param key
+ * @return PipelineDescription
+ */
+PipelineDescription VulkanPipelines::describePipeline(
+    PipelineKey const& key) const {
+  PipelineDescription description;
+  description.stages = key.stages;
+  description.vertexBindings = key.vertexBindings;
+  description.vertexAttributes = key.vertexAttributes;
+  for (auto const& constant : key.constants) {
+    description.specializationEntries.push_back(
+        vks::initializers::specializationMapEntry(
+            constant.first,
+            static_cast<uint32_t>(description.specializationData.size() *
+                                  sizeof(uint32_t)),
+            sizeof(uint32_t)));
+    description.specializationData.push_back(constant.second);
+  }
+  description.inputAssemblyState = m_inputAssemblyState;
+  description.inputAssemblyState.topology = key.topology;
+  description.rasterizationState = m_rasterizationState;
+  description.rasterizationState.polygonMode = key.polygonMode;
+  description.rasterizationState.cullMode = key.cullMode;
+  description.rasterizationState.frontFace = key.frontFace;
+  description.rasterizationState.depthBiasEnable =
+      key.depthBias ? VK_TRUE : VK_FALSE;
+  description.blendAttachmentState = m_blendAttachmentState;
+  description.blendAttachmentState.blendEnable =
+      key.blendEnable ? VK_TRUE : VK_FALSE;
+  description.colorBlendState = m_colorBlendState;
+  description.colorBlendState.attachmentCount = key.colorAttachmentCount;
+  description.depthStencilState = m_depthStencilState;
+  description.viewportState = m_viewportState;
+  description.multisampleState = m_multisampleState;
+  description.dynamicStates = m_dynamicStateEnables;
+  if (key.depthBias)
+    description.dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
+  description.layout = key.layout;
+  description.renderPass = key.renderPass;
+  return description;
 }
 
-}  // namespace VulkanEngine
\ No newline at end of file
+}  // namespace VulkanEngine
@@ -0,0 +1,45 @@
+#include "VulkanRenderPassCache.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Destroys every render pass the cache created
+ */
+VulkanRenderPassCache::~VulkanRenderPassCache() {
+  for (auto& entry : m_passes) delete_ptr(entry.second);
+}
+
+/**
+ * @brief Returns the render pass of a type for the given formats, creating it
+ * the first time they are asked for
+ *
+ * @param type
+ * @param format - The color format, or the depth format of DEPTH passes
+ * @param depthFormat - The depth format of passes with a color attachment
+ * @return VulkanRenderPass* - Owned by the cache
+ */
+VulkanRenderPass* VulkanRenderPassCache::get(Type type, VkFormat format,
+                                             VkFormat depthFormat) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  VulkanRenderPass*& renderPass =
+      m_passes[std::make_tuple(type, format, depthFormat)];
+  if (renderPass) return renderPass;
+  renderPass = new VulkanRenderPass();
+  renderPass->setDevice(m_device);
+  renderPass->setFormat(format);
+  renderPass->setDepthFormat(depthFormat);
+  switch (type) {
+    case Type::PRESENT:
+      renderPass->createPresentPass();
+      break;
+    case Type::DEPTH:
+      renderPass->createDepthPass();
+      break;
+    case Type::PICK:
+      renderPass->createPickPass();
+      break;
+  }
+  return renderPass;
+}
+
+}  // namespace VulkanEngine
@@ -0,0 +1,72 @@
+#include "VulkanRetireQueue.h"
+
+#include <cassert>
+
+namespace VulkanEngine {
+
+/**
+ * @brief Destroys what is left. Only once the GPU is idle.
+ */
+VulkanRetireQueue::~VulkanRetireQueue() { flush(); }
+
+/**
+ * @brief Sets the number of swap chain images that can be in flight
+ *
+ * Only call this with no frame in flight, after flush(), as the bits of
+ * entries already queued are per image.
+ *
+ * @param frameCount - At most 64
+ */
+void VulkanRetireQueue::setFrameCount(uint32_t frameCount) {
+  assert(frameCount <= 64);
+  m_frameCount = frameCount;
+}
+
+/**
+ * @brief Queues a resource to be destroyed once every frame in flight is done
+ *
+ * Destroys it right away if no frame can be in flight.
+ *
+ * @param destroy - Destroys the resource, called on the render thread
+ */
+void VulkanRetireQueue::retire(Destroy const& destroy) {
+  if (m_frameCount == 0) {
+    destroy();
+    return;
+  }
+  Entry entry;
+  entry.destroy = destroy;
+  entry.pendingFrames =
+      m_frameCount == 64 ? ~0ull : (1ull << m_frameCount) - 1;
+  m_entries.push_back(entry);
+}
+
+/**
+ * @brief Reports that a swap chain image's fence was waited on, destroying
+ * what no frame in flight can use anymore
+ *
+ * @param frame - The swap chain image
+ */
+void VulkanRetireQueue::frameCompleted(uint32_t frame) {
+  size_t kept = 0;
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    m_entries[i].pendingFrames &= ~(1ull << frame);
+    if (m_entries[i].pendingFrames == 0) {
+      m_entries[i].destroy();
+    } else {
+      if (kept != i) m_entries[kept] = std::move(m_entries[i]);
+      kept++;
+    }
+  }
+  m_entries.resize(kept);
+}
+
+/**
+ * @brief Destroys everything queued, once every fence has been waited on
+ */
+void VulkanRetireQueue::flush() {
+  for (auto& entry : m_entries) entry.destroy();
+  m_entries.clear();
+}
+
+}  // namespace VulkanEngine
@@ -1,26 +1,57 @@
 #include "VulkanShader.h"
+#include "VulkanDeviceContext.h"
 
 namespace VulkanEngine {
 
 /**
  * @brief Destroy the Vulkan Shader:: Vulkan Shader object
  *
- * Frees this shader's pipeline and all of its shader modules.
+ * Releases all of this shader's modules, which the device context destroys
+ * with their pipelines once no other window's shader holds them. The window
+ * must be done drawing with them.
  */
 VulkanShader::~VulkanShader() {
-  VK_SAFE_DELETE(m_pipeline, vkDestroyPipeline(m_context->getDevice(),
-                                               m_pipeline, nullptr));
-  for (auto& shaderModule : m_shaderModules) {
-    VK_SAFE_DELETE(shaderModule, vkDestroyShaderModule(m_context->getDevice(),
-                                                       shaderModule, nullptr));
-  }
+  VulkanShaderModuleCache* modules =
+      m_context->deviceContext->getShaderModuleCache();
+  for (auto& shaderModule : m_shaderModules) modules->release(shaderModule);
 }
 
 void VulkanShader::prepare() { prepareShaders(); }
+
+/**
+ * @brief Returns the shader's pipeline, swapping in a finished build first
+ *
+ * Until the first build finishes this is VK_NULL_HANDLE, and draws using the
+ * shader are skipped. While a new variant builds, the previous pipeline stays
+ * in use.
+ *
+ * @return VkPipeline&
+ */
+VkPipeline& VulkanShader::getPipeline() {
+  if (m_pendingPipeline.valid() &&
+      m_pendingPipeline.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+    VkPipeline pipeline = m_pendingPipeline.get();
+    m_pendingPipeline = std::shared_future<VkPipeline>();
+    // keep the old pipeline if the new one failed to build
+    if (pipeline != VK_NULL_HANDLE) m_pipeline = pipeline;
+  }
+  return m_pipeline;
+}
+
+/**
+ * @brief Hands the shader a pipeline that may still be building
+ *
+ * @param pipeline - Future for the new pipeline
+ */
+void VulkanShader::setPendingPipeline(std::shared_future<VkPipeline> pipeline) {
+  m_pendingPipeline = std::move(pipeline);
+}
 void VulkanShader::update() {}
 
 /**
- * @brief Loads a shader from a file
+ * @brief Loads a shader from a file, or shares the module another shader of
+ * any window loaded from it
  *
  * @param fileName The path to the shader file
  * @param stage Which stage this shader should be a component in
@@ -32,11 +63,31 @@ VkPipelineShaderStageCreateInfo VulkanShader::loadShader(
   shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
   shaderStage.stage = stage;
   shaderStage.module =
-      vks::tools::loadShader(fileName.c_str(), m_context->getDevice());
+      m_context->deviceContext->getShaderModuleCache()->acquire(fileName);
   shaderStage.pName = "main";  // make this a param in the future
   // assert(shaderStage.module != VK_NULL_HANDLE);
   m_shaderModules.push_back(shaderStage.module);
+  m_stagePaths.push_back(fileName);
   return shaderStage;
 }
 
+/**
+ * @brief Swaps a stage's module for a newly compiled one
+ *
+ * The old module goes to the caller, who releases it to the device
+ * context's module cache once the shader no longer draws with its pipelines.
+ *
+ * @param stage Index of the stage to replace
+ * @param shaderModule The new module, acquired for this shader
+ * @return VkShaderModule The old module, no longer held by this shader
+ */
+VkShaderModule VulkanShader::replaceShaderModule(size_t stage,
+                                                 VkShaderModule shaderModule) {
+  VkShaderModule oldModule = m_shaderStages[stage].module;
+  m_shaderStages[stage].module = shaderModule;
+  std::replace(m_shaderModules.begin(), m_shaderModules.end(), oldModule,
+               shaderModule);
+  return oldModule;
+}
+
 }  // namespace VulkanEngine
\ No newline at end of file
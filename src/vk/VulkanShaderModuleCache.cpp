@@ -0,0 +1,117 @@
+#include "VulkanShaderModuleCache.h"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Destroys the modules still held, which only a leak leaves behind
+ */
+VulkanShaderModuleCache::~VulkanShaderModuleCache() {
+  for (auto const& entry : m_modules)
+    vkDestroyShaderModule(m_device, entry.first, nullptr);
+}
+
+/**
+ * @brief Returns the current module for a path, loading it on first use
+ *
+ * @param path - A compiled shader resource
+ * @return VkShaderModule - To be released once the stage goes away
+ */
+VkShaderModule VulkanShaderModuleCache::acquire(std::string const& path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto current = m_current.find(path);
+  if (current != m_current.end()) {
+    m_modules[current->second].users++;
+    return current->second;
+  }
+  VkShaderModule shaderModule = vks::tools::loadShader(path.c_str(), m_device);
+  Entry& entry = m_modules[shaderModule];
+  entry.path = path;
+  entry.users = 1;
+  m_current[path] = shaderModule;
+  return shaderModule;
+}
+
+/**
+ * @brief Returns the current module for a path if it was made from the given
+ * version of its source, so the source isn't compiled again
+ *
+ * @param path - A compiled shader resource
+ * @param version - The source's modification time
+ * @return VkShaderModule - VK_NULL_HANDLE if no window made that version yet
+ */
+VkShaderModule VulkanShaderModuleCache::acquire(std::string const& path,
+                                                int64_t version) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto current = m_current.find(path);
+  if (current == m_current.end()) return VK_NULL_HANDLE;
+  Entry& entry = m_modules[current->second];
+  if (entry.version != version) return VK_NULL_HANDLE;
+  entry.users++;
+  return current->second;
+}
+
+/**
+ * @brief Makes a module from reloaded code the path's current one
+ *
+ * Stages still holding the previous module keep it until they release it.
+ * If another window made the same version in the meantime, that module is
+ * returned instead.
+ *
+ * @param path - A compiled shader resource
+ * @param version - The source's modification time
+ * @param spirv - The compiled code
+ * @param shaderModule - Receives the module, to be released like any other
+ * @return VkResult - Of vkCreateShaderModule
+ */
+VkResult VulkanShaderModuleCache::create(std::string const& path,
+                                         int64_t version,
+                                         std::vector<uint32_t> const& spirv,
+                                         VkShaderModule& shaderModule) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto current = m_current.find(path);
+  if (current != m_current.end() &&
+      m_modules[current->second].version == version) {
+    m_modules[current->second].users++;
+    shaderModule = current->second;
+    return VK_SUCCESS;
+  }
+  VkShaderModuleCreateInfo moduleCreateInfo = {};
+  moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  moduleCreateInfo.codeSize = spirv.size() * sizeof(uint32_t);
+  moduleCreateInfo.pCode = spirv.data();
+  VkResult result =
+      vkCreateShaderModule(m_device, &moduleCreateInfo, nullptr, &shaderModule);
+  if (result != VK_SUCCESS) return result;
+  Entry& entry = m_modules[shaderModule];
+  entry.path = path;
+  entry.version = version;
+  entry.users = 1;
+  m_current[path] = shaderModule;
+  return VK_SUCCESS;
+}
+
+/**
+ * @brief Lets go of a module, destroying it and its pipelines with its last
+ * user
+ *
+ * Only call it once no frame of the caller's can still draw with the
+ * module's pipelines. Other users, which may still draw with them, keep the
+ * module alive.
+ */
+void VulkanShaderModuleCache::release(VkShaderModule shaderModule) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_modules.find(shaderModule);
+  if (found == m_modules.end() || --found->second.users > 0) return;
+  auto current = m_current.find(found->second.path);
+  if (current != m_current.end() && current->second == shaderModule)
+    m_current.erase(current);
+  m_modules.erase(found);
+  for (auto const& future : m_pipelineMap->releaseModule(shaderModule)) {
+    VkPipeline pipeline = future.get();
+    VK_SAFE_DELETE(pipeline, vkDestroyPipeline(m_device, pipeline, nullptr));
+  }
+  vkDestroyShaderModule(m_device, shaderModule, nullptr);
+}
+
+}  // namespace VulkanEngine
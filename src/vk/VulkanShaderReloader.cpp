@@ -0,0 +1,237 @@
+#include "VulkanShaderReloader.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Releases the replaced modules not retired yet. Only once the window
+ * is done drawing.
+ */
+VulkanShaderReloader::~VulkanShaderReloader() {
+  for (auto const& replaced : m_replaced) release(m_modules, replaced);
+}
+
+/**
+ * @brief Queues the replaced modules to be released, once nothing records
+ * their pipelines anymore
+ *
+ * Call it right after every command buffer was marked for recording again:
+ * the shaders that have swapped in their new pipeline then never record an
+ * old one again.
+ *
+ * @param retireQueue
+ */
+void VulkanShaderReloader::retire(VulkanRetireQueue& retireQueue) {
+  VulkanShaderModuleCache* modules = m_modules;
+  size_t kept = 0;
+  for (size_t i = 0; i < m_replaced.size(); i++) {
+    if (!isRetirable(m_replaced[i])) {
+      if (kept != i) m_replaced[kept] = std::move(m_replaced[i]);
+      kept++;
+      continue;
+    }
+    Replaced replaced = std::move(m_replaced[i]);
+    retireQueue.retire([modules, replaced]() { release(modules, replaced); });
+  }
+  m_replaced.resize(kept);
+}
+
+/**
+ * @brief Whether a shader swapped in its new pipeline, and no longer draws
+ * with the one built from the replaced modules
+ *
+ * A shader whose new pipeline failed to build keeps drawing with the old
+ * one, which stays until a later reload builds.
+ *
+ * @param replaced
+ */
+bool VulkanShaderReloader::isRetirable(Replaced const& replaced) const {
+  VkPipeline current = replaced.shader->getPipeline();
+  return !replaced.shader->isPipelinePending() && current != replaced.pipeline;
+}
+
+/**
+ * @brief Releases the replaced modules. With their last user, the cache
+ * destroys them and the pipelines built from them.
+ *
+ * @param modules
+ * @param replaced
+ */
+void VulkanShaderReloader::release(VulkanShaderModuleCache* modules,
+                                   Replaced const& replaced) {
+  for (VkShaderModule shaderModule : replaced.shaderModules)
+    modules->release(shaderModule);
+}
+
+}  // namespace VulkanEngine
+
+#ifdef PAPERARIUM_SHADER_HOT_RELOAD
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <shaderc/shaderc.hpp>
+
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+namespace {
+
+// sources are checked at most this often
+constexpr std::chrono::milliseconds POLL_INTERVAL(500);
+
+}  // namespace
+
+/**
+ * @brief Maps a compiled shader resource to the GLSL file it was built from
+ *
+ * @param resourcePath - e.g. ":/shaders/02_assimpmodel/scene.frag.spv"
+ * @return std::string - e.g. "<source>/resources/shaders/02_assimpmodel/glsl/
+ * scene.frag", or empty if the resource is not a compiled shader
+ */
+std::string VulkanShaderReloader::getSourcePath(
+    std::string const& resourcePath) {
+  std::string const prefix = ":/shaders/";
+  std::string const suffix = ".spv";
+  if (resourcePath.compare(0, prefix.size(), prefix) != 0 ||
+      resourcePath.size() < prefix.size() + suffix.size() ||
+      resourcePath.compare(resourcePath.size() - suffix.size(), suffix.size(),
+                           suffix) != 0)
+    return "";
+  std::string relative = resourcePath.substr(
+      prefix.size(), resourcePath.size() - prefix.size() - suffix.size());
+  size_t slash = relative.rfind('/');
+  if (slash == std::string::npos) return "";
+  return std::string(PROJECT_ABSOLUTE_PATH) + "/resources/shaders/" +
+         relative.substr(0, slash) + "/glsl" + relative.substr(slash);
+}
+
+/**
+ * @brief Recompiles the sources that changed since the last poll and swaps
+ * the new modules into every shader stage using them
+ *
+ * @param objects - The engine's objects, of which the shaders are watched
+ * @return Whether any pipeline was requested again
+ */
+bool VulkanShaderReloader::poll(
+    std::vector<std::shared_ptr<VkObject>> const& objects) {
+  auto now = std::chrono::steady_clock::now();
+  if (now - m_lastPoll < POLL_INTERVAL) return false;
+  m_lastPoll = now;
+
+  // every stage using each source
+  std::map<std::string, std::vector<std::pair<VulkanShader*, size_t>>> users;
+  for (auto const& object : objects) {
+    auto shader = dynamic_cast<VulkanShader*>(object.get());
+    if (!shader) continue;
+    auto const& paths = shader->getStagePaths();
+    for (size_t i = 0; i < paths.size(); i++) {
+      std::string sourcePath = getSourcePath(paths[i]);
+      if (!sourcePath.empty()) users[sourcePath].emplace_back(shader, i);
+    }
+  }
+
+  // the old modules of each changed shader
+  std::map<VulkanShader*, Replaced> changed;
+  for (auto const& entry : users) {
+    QFileInfo info(QString::fromStdString(entry.first));
+    if (!info.exists()) continue;
+    int64_t modified = info.lastModified().toMSecsSinceEpoch();
+    auto found = m_modified.find(entry.first);
+    // the first sighting only records the time, the .spv is already current
+    if (found == m_modified.end()) {
+      m_modified[entry.first] = modified;
+      continue;
+    }
+    if (found->second == modified) continue;
+    found->second = modified;
+
+    // another window may have compiled this change already
+    auto const& first = entry.second.front();
+    std::string const& resourcePath =
+        first.first->getStagePaths()[first.second];
+    VkShaderModule shaderModule = m_modules->acquire(resourcePath, modified);
+    if (shaderModule == VK_NULL_HANDLE) {
+      std::vector<uint32_t> spirv;
+      std::string error;
+      if (!compile(entry.first, spirv, error)) {
+        LOGI("Failed to reload %s:\n%s", entry.first.c_str(), error.c_str());
+        m_errors[entry.first] = error;
+        continue;
+      }
+      VkResult result =
+          m_modules->create(resourcePath, modified, spirv, shaderModule);
+      if (result != VK_SUCCESS) {
+        m_errors[entry.first] = "vkCreateShaderModule failed: " +
+                                vks::tools::errorString(result);
+        continue;
+      }
+    }
+    m_errors.erase(entry.first);
+    LOGI("Reloaded %s", entry.first.c_str());
+    for (size_t i = 0; i < entry.second.size(); i++) {
+      auto const& user = entry.second[i];
+      // every stage holds the module once
+      if (i > 0) m_modules->acquire(resourcePath, modified);
+      Replaced& replaced = changed[user.first];
+      replaced.shader = user.first;
+      replaced.shaderModules.push_back(
+          user.first->replaceShaderModule(user.second, shaderModule));
+    }
+  }
+
+  for (auto& entry : changed) {
+    // the old pipeline keeps drawing until the new one is swapped in
+    Replaced& replaced = entry.second;
+    replaced.pipeline = entry.first->getPipeline();
+    m_pipelines->recreatePipeline(entry.first);
+    m_replaced.push_back(std::move(replaced));
+  }
+  return !changed.empty();
+}
+
+/**
+ * @brief Compiles a GLSL file to SPIR-V, the stage given by its extension
+ *
+ * @param sourcePath - A .vert or .frag file
+ * @param spirv - Receives the code on success
+ * @param error - Receives the compiler's messages on failure
+ * @return Whether the source compiled
+ */
+bool VulkanShaderReloader::compile(std::string const& sourcePath,
+                                   std::vector<uint32_t>& spirv,
+                                   std::string& error) const {
+  QString path = QString::fromStdString(sourcePath);
+  QString suffix = QFileInfo(path).suffix();
+  shaderc_shader_kind kind;
+  if (suffix == "vert") {
+    kind = shaderc_glsl_vertex_shader;
+  } else if (suffix == "frag") {
+    kind = shaderc_glsl_fragment_shader;
+  } else {
+    error = "Unknown shader stage";
+    return false;
+  }
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    error = "Could not open the file";
+    return false;
+  }
+  QByteArray source = file.readAll();
+
+  shaderc::Compiler compiler;
+  shaderc::CompileOptions options;
+  shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
+      source.constData(), static_cast<size_t>(source.size()), kind,
+      sourcePath.c_str(), options);
+  if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+    error = result.GetErrorMessage();
+    return false;
+  }
+  spirv.assign(result.cbegin(), result.cend());
+  return true;
+}
+
+}  // namespace VulkanEngine
+
+#endif /* PAPERARIUM_SHADER_HOT_RELOAD */
@@ -106,8 +106,9 @@ void UIOverlay::prepareResources() {
   memAllocInfo.allocationSize = memReqs.size;
   memAllocInfo.memoryTypeIndex = device->getMemoryType(
       memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo,
-                                   nullptr, &fontMemory));
+  VK_CHECK_RESULT(VulkanEngine::VulkanMemoryTracker::get().allocate(
+      device->logicalDevice, &memAllocInfo, &fontMemory,
+      VulkanEngine::VulkanMemoryTracker::Category::UI, "ImGui font"));
   VK_CHECK_RESULT(
       vkBindImageMemory(device->logicalDevice, fontImage, fontMemory, 0));
 
@@ -323,58 +324,62 @@ void UIOverlay::preparePipeline(const VkPipelineCache pipelineCache,
                                 &pipelineCreateInfo, nullptr, &pipeline));
 }
 
-/** Update vertex and index buffer containing the imGui elements when required
+/** Keep geometry buffers for the given number of frames in flight */
+void UIOverlay::setFrameCount(uint32_t count) {
+  for (size_t i = count; i < frames.size(); i++) {
+    frames[i].vertexBuffer.destroy();
+    frames[i].indexBuffer.destroy();
+  }
+  frames.resize(count);
+}
+
+/** Grow a frame's buffer to hold at least size bytes, to the next power of two
  */
-bool UIOverlay::update() {
-  ImDrawData* imDrawData = ImGui::GetDrawData();
-  bool updateCmdBuffers = false;
+static void reserveBuffer(vks::VulkanDevice* device, vks::Buffer& buffer,
+                          VkBufferUsageFlags usage, VkDeviceSize size) {
+  if (buffer.buffer != VK_NULL_HANDLE && buffer.size >= size) return;
+  VkDeviceSize capacity = 1;
+  while (capacity < size) capacity <<= 1;
+  buffer.unmap();
+  buffer.destroy();
+  VK_CHECK_RESULT(device->createBuffer(
+      usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &buffer, capacity));
+  buffer.map();
+}
 
-  if (!imDrawData) {
+/** Upload the imGui elements into a frame's vertex and index buffers
+ *
+ * The frame's previous submission must have completed. Nothing is recreated
+ * unless the UI outgrew the buffers, and the draw commands read the counts
+ * from the draw data, so the UI never needs the scene to be recorded again.
+ *
+ * @return Whether there is anything to draw
+ */
+bool UIOverlay::update(uint32_t frame) {
+  ImDrawData* imDrawData = ImGui::GetDrawData();
+  if (!imDrawData || frame >= frames.size()) {
     return false;
   };
 
-  // Note: Alignment is done inside buffer creation
   VkDeviceSize vertexBufferSize =
       imDrawData->TotalVtxCount * sizeof(ImDrawVert);
   VkDeviceSize indexBufferSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
-
-  // Update buffers only if vertex or index count has been changed compared to
-  // current buffer size
   if ((vertexBufferSize == 0) || (indexBufferSize == 0)) {
     return false;
   }
 
-  // Vertex buffer
-  if ((vertexBuffer.buffer == VK_NULL_HANDLE) ||
-      (vertexCount != imDrawData->TotalVtxCount)) {
-    vertexBuffer.unmap();
-    vertexBuffer.destroy();
-    VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                                         &vertexBuffer, vertexBufferSize));
-    vertexCount = imDrawData->TotalVtxCount;
-    vertexBuffer.unmap();
-    vertexBuffer.map();
-    updateCmdBuffers = true;
-  }
-
-  // Index buffer
-  VkDeviceSize indexSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
-  if ((indexBuffer.buffer == VK_NULL_HANDLE) ||
-      (indexCount < imDrawData->TotalIdxCount)) {
-    indexBuffer.unmap();
-    indexBuffer.destroy();
-    VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                                         &indexBuffer, indexBufferSize));
-    indexCount = imDrawData->TotalIdxCount;
-    indexBuffer.map();
-    updateCmdBuffers = true;
-  }
+  // buffers grown below are accounted to the UI, not to meshes
+  VulkanEngine::VulkanMemoryTracker::Scope memoryScope(
+      VulkanEngine::VulkanMemoryTracker::Category::UI, "ImGui geometry");
+  FrameGeometry& geometry = frames[frame];
+  reserveBuffer(device, geometry.vertexBuffer,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBufferSize);
+  reserveBuffer(device, geometry.indexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                indexBufferSize);
 
   // Upload data
-  ImDrawVert* vtxDst = (ImDrawVert*)vertexBuffer.mapped;
-  ImDrawIdx* idxDst = (ImDrawIdx*)indexBuffer.mapped;
+  ImDrawVert* vtxDst = (ImDrawVert*)geometry.vertexBuffer.mapped;
+  ImDrawIdx* idxDst = (ImDrawIdx*)geometry.indexBuffer.mapped;
 
   for (int n = 0; n < imDrawData->CmdListsCount; n++) {
     ImDrawList const* cmd_list = imDrawData->CmdLists[n];
@@ -387,20 +392,22 @@ bool UIOverlay::update() {
   }
 
   // Flush to make writes visible to GPU
-  vertexBuffer.flush();
-  indexBuffer.flush();
+  geometry.vertexBuffer.flush();
+  geometry.indexBuffer.flush();
 
-  return updateCmdBuffers;
+  return true;
 }
 
-void UIOverlay::draw(const VkCommandBuffer commandBuffer) {
+void UIOverlay::draw(const VkCommandBuffer commandBuffer, uint32_t frame) {
   ImDrawData* imDrawData = ImGui::GetDrawData();
   int32_t vertexOffset = 0;
   int32_t indexOffset = 0;
 
-  if ((!imDrawData) || (imDrawData->CmdListsCount == 0)) {
+  if ((!imDrawData) || (imDrawData->CmdListsCount == 0) ||
+      frame >= frames.size()) {
     return;
   }
+  FrameGeometry const& geometry = frames[frame];
 
   ImGuiIO& io = ImGui::GetIO();
 
@@ -415,8 +422,9 @@ void UIOverlay::draw(const VkCommandBuffer commandBuffer) {
                      0, sizeof(PushConstBlock), &pushConstBlock);
 
   VkDeviceSize offsets[1] = {0};
-  vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.buffer, offsets);
-  vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0,
+  vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometry.vertexBuffer.buffer,
+                         offsets);
+  vkCmdBindIndexBuffer(commandBuffer, geometry.indexBuffer.buffer, 0,
                        VK_INDEX_TYPE_UINT16);
 
   for (int32_t i = 0; i < imDrawData->CmdListsCount; i++) {
@@ -446,11 +454,11 @@ void UIOverlay::resize(uint32_t width, uint32_t height) {
 
 void UIOverlay::freeResources() {
   ImGui::DestroyContext();
-  vertexBuffer.destroy();
-  indexBuffer.destroy();
+  setFrameCount(0);
   vkDestroyImageView(device->logicalDevice, fontView, nullptr);
   vkDestroyImage(device->logicalDevice, fontImage, nullptr);
-  vkFreeMemory(device->logicalDevice, fontMemory, nullptr);
+  VulkanEngine::VulkanMemoryTracker::get().free(device->logicalDevice,
+                                                fontMemory);
   vkDestroySampler(device->logicalDevice, sampler, nullptr);
   vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayout,
                                nullptr);
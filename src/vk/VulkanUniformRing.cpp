@@ -0,0 +1,116 @@
+#include "VulkanUniformRing.h"
+#include "VulkanMemoryTracker.h"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Unmaps and destroys the ring's buffer
+ */
+VulkanUniformRing::~VulkanUniformRing() {
+  m_buffer.unmap();
+  m_buffer.destroy();
+}
+
+/**
+ * @brief Creates the ring's buffer and maps it for the rest of its lifetime
+ *
+ * @param vulkanDevice - The device to allocate the buffer on
+ * @param frameCount - Number of frames that may be in flight at once, usually
+ * the number of swap chain images
+ * @param frameSize - Bytes of uniform data available to each frame
+ */
+void VulkanUniformRing::create(vks::VulkanDevice* vulkanDevice,
+                               uint32_t frameCount, VkDeviceSize frameSize) {
+  // dynamic offsets must be multiples of minUniformBufferOffsetAlignment, so
+  // both the slots and every allocation within them are aligned to it
+  m_alignment = std::max<VkDeviceSize>(
+      vulkanDevice->properties.limits.minUniformBufferOffsetAlignment, 1);
+  m_frameCount = std::max(frameCount, 1u);
+  m_frameSize = (frameSize + m_alignment - 1) & ~(m_alignment - 1);
+  m_head = 0;
+
+  VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::UNIFORM,
+                                   "Uniform ring");
+  VK_CHECK_RESULT(vulkanDevice->createBuffer(
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      &m_buffer, m_frameSize * m_frameCount));
+  VK_CHECK_RESULT(m_buffer.map());
+}
+
+/**
+ * @brief Reserves a range of the given size in every frame's slot
+ *
+ * The range lives as long as the ring does; uniform blocks are expected to be
+ * allocated once, when their owner is prepared. The ring can't grow, since
+ * descriptors already point into its buffer, so running out of space is
+ * fatal: raise frameSize in create() instead.
+ */
+VulkanUniformRing::Allocation VulkanUniformRing::allocate(VkDeviceSize size) {
+  Allocation allocation;
+  allocation.offset = m_head;
+  allocation.size = size;
+  m_head += (size + m_alignment - 1) & ~(m_alignment - 1);
+  if (m_head > m_frameSize) {
+    char message[128];
+    snprintf(message, sizeof(message),
+             "Uniform ring out of space (%llu of %llu bytes)",
+             static_cast<unsigned long long>(m_head),
+             static_cast<unsigned long long>(m_frameSize));
+    vks::tools::exitFatal(message, -1);
+  }
+  return allocation;
+}
+
+/**
+ * @brief Copies data into the allocation's range of one frame's slot
+ *
+ * The buffer is host coherent, so no flush is needed.
+ */
+void VulkanUniformRing::write(Allocation const& allocation, void const* data,
+                              uint32_t frame) {
+  char* dst = static_cast<char*>(m_buffer.mapped) +
+              getDynamicOffset(allocation, frame);
+  memcpy(dst, data, allocation.size);
+}
+
+/**
+ * @brief Copies data into the allocation's range of every slot, used to seed
+ * frames that have not been rendered yet
+ */
+void VulkanUniformRing::writeAll(Allocation const& allocation,
+                                 void const* data) {
+  for (uint32_t frame = 0; frame < m_frameCount; frame++)
+    write(allocation, data, frame);
+}
+
+/**
+ * @brief Returns the dynamic offset pointing a descriptor at the allocation's
+ * range in the given frame's slot
+ *
+ * Frames wrap around the slots, so a swap chain that grows on resize still
+ * gets valid offsets. The render loop keeps frames sharing a slot from being
+ * in flight together.
+ */
+uint32_t VulkanUniformRing::getDynamicOffset(Allocation const& allocation,
+                                             uint32_t frame) const {
+  return static_cast<uint32_t>((frame % m_frameCount) * m_frameSize +
+                               allocation.offset);
+}
+
+/**
+ * @brief Returns the descriptor for an allocation, relative to the start of
+ * the buffer. The per-frame slot is selected with the dynamic offset.
+ */
+VkDescriptorBufferInfo VulkanUniformRing::getDescriptor(
+    Allocation const& allocation) const {
+  VkDescriptorBufferInfo descriptor = {};
+  descriptor.buffer = m_buffer.buffer;
+  descriptor.offset = 0;
+  descriptor.range = allocation.size;
+  return descriptor;
+}
+
+}  // namespace VulkanEngine
@@ -0,0 +1,199 @@
+#include "VulkanViewport.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+namespace VulkanEngine {
+
+/**
+ * @brief Allocates the view's composite set. The target is created by the
+ * first resize(), the command buffers by allocateCommandBuffers().
+ *
+ * @param vulkanDevice
+ * @param cmdPool - Pool of the draw command buffers
+ * @param compositor - Draws the target into the main pass, not owned
+ * @param retireQueue - Destroys replaced targets, not owned
+ * @param colorFormat - Color format of the main render pass
+ * @param depthFormat - Depth format of the main render pass
+ * @param descriptorIndex - Copy of the per-frame set the view is drawn with
+ */
+VulkanViewport::VulkanViewport(vks::VulkanDevice* vulkanDevice,
+                               VkCommandPool cmdPool,
+                               VulkanCompositor* compositor,
+                               VulkanRetireQueue* retireQueue,
+                               VkFormat colorFormat, VkFormat depthFormat,
+                               uint32_t descriptorIndex) {
+  m_vulkanDevice = vulkanDevice;
+  m_device = vulkanDevice->logicalDevice;
+  m_cmdPool = cmdPool;
+  m_compositor = compositor;
+  m_retireQueue = retireQueue;
+  m_colorFormat = colorFormat;
+  m_depthFormat = depthFormat;
+  m_descriptorIndex = descriptorIndex;
+  m_compositeSet = m_compositor->allocate();
+}
+
+/**
+ * @brief Frees the view's command buffers and target, once no frame in
+ * flight uses them
+ */
+VulkanViewport::~VulkanViewport() {
+  if (!m_cmdBuffers.empty())
+    vkFreeCommandBuffers(m_device, m_cmdPool,
+                         static_cast<uint32_t>(m_cmdBuffers.size()),
+                         m_cmdBuffers.data());
+  delete_ptr(m_target);
+  m_compositor->release(m_compositeSet);
+}
+
+/**
+ * @brief Sets the part of the window the view covers, taking effect at the
+ * next resize()
+ *
+ * @param offset - Top-left corner, as fractions of the window's size
+ * @param size - As fractions of the window's size
+ */
+void VulkanViewport::setRegion(glm::vec2 const& offset,
+                               glm::vec2 const& size) {
+  m_offset = offset;
+  m_size = size;
+}
+
+/**
+ * @brief Sizes the view for a window of the given size, replacing the
+ * target if that changed
+ *
+ * The old target and its composite set are retired, as frames in flight may
+ * still draw into or composite them, so the command buffers must be recorded
+ * again before the next submission.
+ *
+ * @param windowWidth - In pixels
+ * @param windowHeight - In pixels
+ */
+void VulkanViewport::resize(uint32_t windowWidth, uint32_t windowHeight) {
+  glm::vec2 window(windowWidth, windowHeight);
+  glm::ivec2 offset = glm::ivec2(m_offset * window + 0.5f);
+  // the far edge is rounded the same way, so views sharing an edge meet
+  glm::ivec2 end = glm::ivec2((m_offset + m_size) * window + 0.5f);
+  m_rect.offset = {offset.x, offset.y};
+  VkExtent2D extent = {
+      static_cast<uint32_t>(std::max(1, end.x - offset.x)),
+      static_cast<uint32_t>(std::max(1, end.y - offset.y))};
+  if (m_target && extent.width == m_rect.extent.width &&
+      extent.height == m_rect.extent.height)
+    return;
+  m_rect.extent = extent;
+  if (m_target) {
+    VulkanFrameBuffer* target = m_target;
+    VkDescriptorSet compositeSet = m_compositeSet;
+    VulkanCompositor* compositor = m_compositor;
+    m_retireQueue->retire([target, compositeSet, compositor]() {
+      delete target;
+      compositor->release(compositeSet);
+    });
+    m_compositeSet = m_compositor->allocate();
+  }
+  m_target = new VulkanFrameBuffer();
+  m_target->setVulkanDevice(m_vulkanDevice);
+  m_target->setSize(extent.width, extent.height);
+  m_target->setFormat(m_colorFormat);
+  m_target->setDepthFormat(m_depthFormat);
+  m_target->createWithColorDepth();
+  m_compositor->write(m_compositeSet, &m_target->getDescriptor());
+  m_dirty = true;
+}
+
+/**
+ * @brief Keeps one command buffer per swap chain image, reallocating them
+ * when the number of images changed
+ *
+ * @param count
+ */
+void VulkanViewport::allocateCommandBuffers(uint32_t count) {
+  if (m_cmdBuffers.size() == count) return;
+  if (!m_cmdBuffers.empty())
+    vkFreeCommandBuffers(m_device, m_cmdPool,
+                         static_cast<uint32_t>(m_cmdBuffers.size()),
+                         m_cmdBuffers.data());
+  m_cmdBuffers.resize(count);
+  VkCommandBufferAllocateInfo allocateInfo =
+      vks::initializers::commandBufferAllocateInfo(
+          m_cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, count);
+  VK_CHECK_RESULT(
+      vkAllocateCommandBuffers(m_device, &allocateInfo, m_cmdBuffers.data()));
+}
+
+/**
+ * @brief Begins the view's offscreen pass over its whole target
+ *
+ * @param cmd
+ * @param clearValues - Color and depth clear values
+ */
+void VulkanViewport::beginRenderPass(
+    VkCommandBuffer cmd, std::array<VkClearValue, 2> const& clearValues) const {
+  VkRenderPassBeginInfo renderPassBeginInfo =
+      vks::initializers::renderPassBeginInfo();
+  renderPassBeginInfo.renderPass = m_target->getRenderPass()->get();
+  renderPassBeginInfo.framebuffer = m_target->get();
+  renderPassBeginInfo.renderArea.extent = m_rect.extent;
+  renderPassBeginInfo.clearValueCount =
+      static_cast<uint32_t>(clearValues.size());
+  renderPassBeginInfo.pClearValues = clearValues.data();
+  vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+/**
+ * @brief Records the view's objects, inside its pass
+ *
+ * @param cmd
+ */
+void VulkanViewport::draw(VkCommandBuffer& cmd) const {
+  if (m_draw) m_draw(cmd);
+}
+
+/**
+ * @brief Draws the view's target into its part of the window, in the main
+ * pass
+ *
+ * @param cmd
+ */
+void VulkanViewport::composite(VkCommandBuffer cmd) const {
+  if (!m_target) return;
+  m_compositor->draw(cmd, m_compositeSet, m_rect, m_rect.extent,
+                     m_rect.extent);
+}
+
+/**
+ * @brief Marks the view dirty if its camera moved since it was last drawn
+ *
+ * @param viewProjection - Of the view's camera
+ * @return Whether it moved
+ */
+bool VulkanViewport::updateView(glm::mat4 const& viewProjection) {
+  if (viewProjection == m_viewProjection) return false;
+  m_viewProjection = viewProjection;
+  m_dirty = true;
+  return true;
+}
+
+/**
+ * @brief Width over height, for the view's projection
+ */
+float VulkanViewport::getAspect() const {
+  if (m_rect.extent.height == 0) return 1.f;
+  return static_cast<float>(m_rect.extent.width) /
+         static_cast<float>(m_rect.extent.height);
+}
+
+/**
+ * @brief Whether a point in window pixels is inside the view
+ *
+ * @param point
+ */
+bool VulkanViewport::contains(glm::vec2 const& point) const {
+  return point.x >= m_rect.offset.x && point.y >= m_rect.offset.y &&
+         point.x < m_rect.offset.x + static_cast<float>(m_rect.extent.width) &&
+         point.y < m_rect.offset.y + static_cast<float>(m_rect.extent.height);
+}
+
+}  // namespace VulkanEngine
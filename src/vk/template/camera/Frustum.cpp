@@ -0,0 +1,89 @@
+#include "camera/Frustum.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE
+#endif
+
+namespace VulkanEngine {
+
+/**
+ * @brief Extracts the planes from a clip transform, after Gribb and
+ * Hartmann, with the near plane at z = 0
+ *
+ * @param clip - e.g. a model's modelViewProjection
+ */
+void Frustum::update(glm::mat4 const& clip) {
+  glm::mat4 rows = glm::transpose(clip);
+  m_planes[0] = rows[3] + rows[0];
+  m_planes[1] = rows[3] - rows[0];
+  m_planes[2] = rows[3] + rows[1];
+  m_planes[3] = rows[3] - rows[1];
+  m_planes[4] = rows[2];
+  m_planes[5] = rows[3] - rows[2];
+  for (auto& plane : m_planes) {
+    float length = glm::length(glm::vec3(plane));
+    if (length > 0.f) plane /= length;
+  }
+}
+
+bool Frustum::intersectsSphere(glm::vec3 const& center, float radius) const {
+  for (auto const& plane : m_planes)
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+  return true;
+}
+
+/**
+ * @brief Tests the corner of the box furthest along each plane's normal
+ */
+bool Frustum::intersectsBox(glm::vec3 const& min, glm::vec3 const& max) const {
+  for (auto const& plane : m_planes) {
+    glm::vec3 normal(plane);
+    glm::vec3 corner(normal.x >= 0.f ? max.x : min.x,
+                     normal.y >= 0.f ? max.y : min.y,
+                     normal.z >= 0.f ? max.z : min.z);
+    if (glm::dot(normal, corner) + plane.w < 0.f) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Tests many spheres, four at a time where SSE is available
+ *
+ * @param x - Centers, one array per coordinate
+ * @param y
+ * @param z
+ * @param radius
+ * @param count - Of spheres
+ * @param visible - Receives 1 for each sphere that may be visible, else 0
+ */
+void Frustum::cullSpheres(float const* x, float const* y, float const* z,
+                          float const* radius, size_t count,
+                          uint8_t* visible) const {
+  size_t i = 0;
+#ifdef FRUSTUM_SSE
+  for (; i + 4 <= count; i += 4) {
+    __m128 px = _mm_loadu_ps(x + i);
+    __m128 py = _mm_loadu_ps(y + i);
+    __m128 pz = _mm_loadu_ps(z + i);
+    __m128 zero = _mm_setzero_ps();
+    __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+    // all bits set, so far no plane has the spheres outside
+    __m128 inside = _mm_cmpeq_ps(zero, zero);
+    for (auto const& plane : m_planes) {
+      __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(plane.x)),
+                     _mm_mul_ps(py, _mm_set1_ps(plane.y))),
+          _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(plane.z)),
+                     _mm_set1_ps(plane.w)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+    }
+    int mask = _mm_movemask_ps(inside);
+    for (size_t j = 0; j < 4; j++) visible[i + j] = (mask >> j) & 1;
+  }
+#endif
+  for (; i < count; i++)
+    visible[i] = intersectsSphere(glm::vec3(x[i], y[i], z[i]), radius[i]);
+}
+
+}  // namespace VulkanEngine
@@ -1,29 +1,114 @@
 #include "camera/ShadowCamera.h"
 
+#include <cfloat>
+
 namespace VulkanEngine {
 
 /**
- * @brief Create the uniform buffer for the shadow camera
+ * @brief Reserves the shadow camera uniforms in the per-frame uniform ring
  */
 void ShadowCamera::prepareUniformBuffers() {
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_uniformBuffer, sizeof(m_uboVS), &m_uboVS));
-  VK_CHECK_RESULT(m_uniformBuffer.map());
+  createUniformBuffer(sizeof(m_uboVS), &m_uboVS);
   updateUniformBuffers();
 }
 
+/**
+ * @brief Writes the light's matrix, bumping the version if it changed since
+ * the last update
+ */
 void ShadowCamera::updateUniformBuffers() {
   // matrix from light's point of view
-  glm::mat4 depthProjectionMatrix =
-      glm::perspective(glm::radians(m_lightFOV), 1.0f, m_zNear, m_zFar);
-  glm::mat4 depthViewMatrix =
-      glm::lookAt(m_lightPos, glm::vec3(0.f), glm::vec3(0, 1, 0));
+  glm::mat4 depthProjectionMatrix;
+  glm::mat4 depthViewMatrix;
+  if (m_hasBounds) {
+    fitBounds(depthViewMatrix, depthProjectionMatrix);
+  } else {
+    depthProjectionMatrix =
+        glm::perspective(glm::radians(m_lightFOV), 1.0f, m_zNear, m_zFar);
+    depthViewMatrix =
+        glm::lookAt(m_lightPos, glm::vec3(0.f), glm::vec3(0, 1, 0));
+  }
   glm::mat4 depthModelMatrix = glm::mat4(1.0f);
-  m_uboVS.depthMVP = depthProjectionMatrix * depthViewMatrix * depthModelMatrix;
-  memcpy(m_uniformBuffer.mapped, &m_uboVS, sizeof(m_uboVS));
+  glm::mat4 depthMVP =
+      depthProjectionMatrix * depthViewMatrix * depthModelMatrix;
+  if (depthMVP != m_uboVS.depthMVP) {
+    m_uboVS.depthMVP = depthMVP;
+    m_version++;
+  }
+  writeUniformBuffer(&m_uboVS);
+}
+
+/**
+ * @brief Sets the box the shadow map has to cover, in the space of the
+ * vertices it is rendered from
+ *
+ * @param min
+ * @param max
+ */
+void ShadowCamera::setBounds(glm::vec3 const& min, glm::vec3 const& max) {
+  m_boundsMin = min;
+  m_boundsMax = max;
+  m_hasBounds = true;
+}
+
+/**
+ * @brief Aims the light at the center of the bounds and fits its frustum to
+ * their corners
+ *
+ * Every texel of the shadow map then lands on the bounds' silhouette or
+ * close to it, and the depth range spans only what casts or receives.
+ *
+ * @param view - Receives the light's view matrix
+ * @param projection - Receives the light's projection matrix
+ */
+void ShadowCamera::fitBounds(glm::mat4& view, glm::mat4& projection) const {
+  glm::vec3 center = (m_boundsMin + m_boundsMax) * 0.5f;
+  glm::vec3 direction = center - m_lightPos;
+  if (glm::length(direction) < 1e-5f) direction = glm::vec3(0.f, 0.f, -1.f);
+  // lookAt degenerates when looking along its up vector
+  glm::vec3 up = std::abs(glm::normalize(direction).y) > 0.99f
+                     ? glm::vec3(0.f, 0.f, 1.f)
+                     : glm::vec3(0.f, 1.f, 0.f);
+  view = glm::lookAt(m_lightPos, m_lightPos + direction, up);
+
+  float nearest = FLT_MAX;
+  float farthest = -FLT_MAX;
+  float extentX = 0.f;
+  float extentY = 0.f;
+  float tangent = 0.f;
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 corner((i & 1) ? m_boundsMax.x : m_boundsMin.x,
+                     (i & 2) ? m_boundsMax.y : m_boundsMin.y,
+                     (i & 4) ? m_boundsMax.z : m_boundsMin.z);
+    glm::vec3 lightSpace = glm::vec3(view * glm::vec4(corner, 1.f));
+    float depth = -lightSpace.z;
+    nearest = std::min(nearest, depth);
+    farthest = std::max(farthest, depth);
+    extentX = std::max(extentX, std::abs(lightSpace.x));
+    extentY = std::max(extentY, std::abs(lightSpace.y));
+    if (depth > 0.f)
+      tangent = std::max(
+          tangent, std::max(std::abs(lightSpace.x), std::abs(lightSpace.y)) /
+                       depth);
+  }
+  // a little slack so the outermost texels aren't clipped by rounding
+  float margin = std::max(farthest - nearest, 1e-3f) * 0.01f;
+  nearest -= margin;
+  farthest += margin;
+
+  if (m_orthographic) {
+    projection = glm::ortho(-extentX, extentX, -extentY, extentY, nearest,
+                            farthest);
+    return;
+  }
+  // a light inside the bounds can't see all of them through one frustum
+  if (nearest <= 0.f || tangent <= 0.f) {
+    projection = glm::perspective(glm::radians(m_lightFOV), 1.0f, m_zNear,
+                                  std::max(farthest, m_zNear * 2.f));
+    return;
+  }
+  float fov = 2.f * std::atan(tangent * 1.01f);
+  projection = glm::perspective(fov, 1.0f, nearest, farthest);
 }
 
-}  // namespace VulkanEngine
\ No newline at end of file
+}  // namespace VulkanEngine
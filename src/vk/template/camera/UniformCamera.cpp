@@ -3,29 +3,37 @@
 namespace VulkanEngine {
 
 /**
- * @brief Creates uniform buffer for camera
+ * @brief Reserves the camera uniforms in the per-frame uniform ring
  */
 void UniformCamera::prepareUniformBuffers() {
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_uniformBuffer, sizeof(m_uboVS), &m_uboVS));
-  VK_CHECK_RESULT(m_uniformBuffer.map());
+  createUniformBuffer(sizeof(m_uboVS), &m_uboVS);
   updateUniformBuffers();
 }
 
 /**
  * @brief Propogates changes in the camera position to the GPU
+ *
+ * Also derives the matrices the scene shaders would otherwise compute for
+ * every vertex.
  */
 void UniformCamera::updateUniformBuffers() {
-  m_uboVS.projection =
-      glm::perspective(glm::radians(60.0f),
-                       static_cast<float>(*m_context->pScreenWidth) /
-                           static_cast<float>(*m_context->pScreenHeight),
-                       0.001f, 256.0f);
+  float aspect = m_aspect > 0.f
+                     ? m_aspect
+                     : static_cast<float>(*m_context->pScreenWidth) /
+                           static_cast<float>(*m_context->pScreenHeight);
+  if (m_orthographic) {
+    // zooming scales the view as it would the perspective one
+    float halfHeight = std::abs(*m_pZoom) * std::tan(glm::radians(30.0f));
+    m_uboVS.projection =
+        glm::ortho(-halfHeight * aspect, halfHeight * aspect, -halfHeight,
+                   halfHeight, -256.0f, 256.0f);
+  } else {
+    m_uboVS.projection =
+        glm::perspective(glm::radians(60.0f), aspect, 0.001f, 256.0f);
+  }
+  glm::vec2 pan = m_pPan ? *m_pPan : glm::vec2(0.f);
   m_uboVS.view =
-      glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.0f, *m_pZoom));
+      glm::translate(glm::mat4(1.0f), glm::vec3(pan.x, pan.y, *m_pZoom));
   m_uboVS.model = glm::translate(glm::mat4(1.0f), glm::vec3(0.f));
   m_uboVS.model = glm::rotate(m_uboVS.model, glm::radians(-m_pRotation->x),
                               glm::vec3(1.0f, 0.0f, 0.0f));
@@ -34,8 +42,11 @@ void UniformCamera::updateUniformBuffers() {
   m_uboVS.model = glm::rotate(m_uboVS.model, glm::radians(m_pRotation->z),
                               glm::vec3(0.0f, 0.0f, 1.0f));
   m_uboVS.model = glm::translate(m_uboVS.model, *m_pCameraPos);
-  m_uboVS.normal = glm::inverseTranspose(m_uboVS.view * m_uboVS.model);
-  memcpy(m_uniformBuffer.mapped, &m_uboVS, sizeof(m_uboVS));
+  m_uboVS.modelView = m_uboVS.view * m_uboVS.model;
+  m_uboVS.modelViewProjection = m_uboVS.projection * m_uboVS.modelView;
+  m_uboVS.normal = glm::inverseTranspose(m_uboVS.modelView);
+  m_uboVS.lightPosView = m_uboVS.modelView * m_uboVS.lightpos;
+  writeUniformBuffer(&m_uboVS);
 }
 
 }  // namespace VulkanEngine
\ No newline at end of file
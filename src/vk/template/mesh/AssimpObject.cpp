@@ -1,13 +1,30 @@
 #include "mesh/AssimpObject.h"
+
+#include <cfloat>
+#include <chrono>
+
+#include "VulkanDeviceContext.h"
+#include "VulkanMemoryTracker.h"
 #include "VulkanModel.hpp"
 
 namespace VulkanEngine {
 
+namespace {
+
+// floats before the normal in the vertex layout generateVertex loads
+constexpr size_t NORMAL_OFFSET = 7;
+// faces closer to parallel than this are flat across their edge
+constexpr float FLAT_COSINE = 0.9999f;
+
+}  // namespace
+
+constexpr uint32_t AssimpObject::INVALID_EDGE;
+
 AssimpObject::~AssimpObject() {
-  if (m_model) {
-    m_model->destroy();
-    delete_ptr(m_model);
-  }
+  m_context->geometryArena->release(m_edgeMesh);
+  delete_ptr(m_model);
+  m_indirectCommands.destroy();
+  m_edgeStates.destroy();
 }
 
 void AssimpObject::generateVertex() {
@@ -16,25 +33,523 @@ void AssimpObject::generateVertex() {
       vks::VertexLayout({vks::Component::VERTEX_COMPONENT_POSITION,
                          vks::Component::VERTEX_COMPONENT_UVVEC4,
                          vks::Component::VERTEX_COMPONENT_NORMAL});
-  m_model->loadFromFile(m_modelPath, layout, 1.f, m_context->vulkanDevice,
-                        m_context->queue, nullptr);
+  assert(layout.stride() == m_context->geometryArena->getVertexStride());
+  vks::ModelCreateInfo modelCreateInfo(1.f, 1.f, 0.f);
+  m_model->loadGeometry(m_modelPath, layout, &modelCreateInfo, nullptr);
+  // other windows showing the same model draw the same copy
+  uploadGeometry(m_model->vertexData.data(), m_model->vertexCount,
+                 m_model->indexData, m_modelPath);
   m_modelCenter = (m_model->dim.max + m_model->dim.min) * 0.5f;
+
+  auto start = std::chrono::steady_clock::now();
+  m_bvh.build(m_model->vertexData.data(), layout.stride() / sizeof(float),
+              m_model->indexData);
+  LOGI("AssimpObject|generateVertex| BVH of %zu triangles, %zu nodes, in "
+       "%.1f ms",
+       m_bvh.getTriangleCount(), m_bvh.getNodeCount(),
+       std::chrono::duration<float, std::milli>(
+           std::chrono::steady_clock::now() - start)
+           .count());
+  prepareEdges();
+  preparePartBounds();
+  if (m_bindlessTextures) prepareBindless();
+  if (m_cullFrameCount == 0)
+    m_cullFrameCount = m_context->uniformRing->getFrameCount();
+  createIndirectCommands();
 }
 
+/**
+ * @brief Gives every frame its own culled commands, for a swap chain with a
+ * different number of images. Must only be called while no frame is in
+ * flight.
+ *
+ * @param frameCount - Number of frames that cull and draw
+ */
+void AssimpObject::setFrameCount(uint32_t frameCount) {
+  if (frameCount == m_cullFrameCount) return;
+  m_cullFrameCount = frameCount;
+  if (!m_model) return;
+  m_indirectCommands.destroy();
+  createIndirectCommands();
+}
+
+/**
+ * @brief Draws the model from a bindless texture table instead of its
+ * material set. Must be called before prepare().
+ *
+ * @param bindlessTextures - Table the material textures are added to
+ * @param defaultTexture - Table index used by parts without a texture
+ * @param multiDrawIndirect - Whether all parts can go in one indirect call
+ */
+void AssimpObject::setBindless(VulkanBindlessTextures* bindlessTextures,
+                               uint32_t defaultTexture,
+                               bool multiDrawIndirect) {
+  m_bindlessTextures = bindlessTextures;
+  m_defaultTexture = defaultTexture;
+  m_multiDrawIndirect = multiDrawIndirect;
+}
+
+/**
+ * @brief Loads every material's texture into the table and registers the
+ * parts
+ */
+void AssimpObject::prepareBindless() {
+  std::vector<uint32_t> materialTextures(m_model->diffuseTextures.size(),
+                                         m_defaultTexture);
+  for (size_t i = 0; i < m_model->diffuseTextures.size(); i++) {
+    std::string const& path = m_model->diffuseTextures[i];
+    if (path.empty()) continue;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+      LOGI("AssimpObject|prepareBindless| Missing texture %s", path.c_str());
+      continue;
+    }
+    fclose(file);
+    auto texture = m_context->deviceContext->loadTexture(
+        path, VK_FORMAT_R8G8B8A8_UNORM);
+    uint32_t index = m_bindlessTextures->addTexture(texture->descriptor);
+    // a full table leaves the remaining materials on the default texture
+    if (index == VulkanBindlessTextures::INVALID_INDEX) break;
+    materialTextures[i] = index;
+    m_materialTextures.push_back(texture);
+  }
+
+  std::vector<uint32_t> partTextures;
+  for (auto const& part : m_model->parts)
+    partTextures.push_back(materialTextures[part.materialIndex]);
+  m_firstPart = m_bindlessTextures->addParts(partTextures);
+}
+
+/**
+ * @brief Finds a bounding box and sphere for each part, for culling
+ *
+ * Spheres are centered on the boxes, and only as large as the part's
+ * vertices need.
+ */
+void AssimpObject::preparePartBounds() {
+  size_t stride = m_context->geometryArena->getVertexStride() / sizeof(float);
+  size_t partCount = m_model->parts.size();
+  m_partMin.assign(partCount, glm::vec3(FLT_MAX));
+  m_partMax.assign(partCount, glm::vec3(-FLT_MAX));
+  m_partX.resize(partCount);
+  m_partY.resize(partCount);
+  m_partZ.resize(partCount);
+  m_partRadius.assign(partCount, 0.f);
+  m_partVisible.assign(partCount, 1);
+  auto position = [&](uint32_t index) {
+    float const* p = &m_model->vertexData[m_model->indexData[index] * stride];
+    return glm::vec3(p[0], p[1], p[2]);
+  };
+  for (size_t i = 0; i < partCount; i++) {
+    auto const& part = m_model->parts[i];
+    uint32_t end = part.indexBase + part.indexCount;
+    for (uint32_t index = part.indexBase; index < end; index++) {
+      glm::vec3 p = position(index);
+      m_partMin[i] = glm::min(m_partMin[i], p);
+      m_partMax[i] = glm::max(m_partMax[i], p);
+    }
+    glm::vec3 center = (m_partMin[i] + m_partMax[i]) * 0.5f;
+    float radius2 = 0.f;
+    for (uint32_t index = part.indexBase; index < end; index++) {
+      glm::vec3 offset = position(index) - center;
+      radius2 = std::max(radius2, glm::dot(offset, offset));
+    }
+    m_partX[i] = center.x;
+    m_partY[i] = center.y;
+    m_partZ[i] = center.z;
+    m_partRadius[i] = std::sqrt(radius2);
+  }
+}
+
+/**
+ * @brief Creates the indirect commands drawing the parts, for every frame
+ * and cull view, and maps them for good
+ */
+void AssimpObject::createIndirectCommands() {
+  if (m_model->parts.empty()) return;
+  uint32_t regionCount = 1 + m_cullFrameCount * CULL_VIEW_COUNT;
+  VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::MESH,
+                                   "Indirect commands");
+  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      &m_indirectCommands,
+      sizeof(VkDrawIndexedIndirectCommand) * m_model->parts.size() *
+          regionCount));
+  VK_CHECK_RESULT(m_indirectCommands.map());
+  // every part is visible until its first cull
+  auto commands =
+      static_cast<VkDrawIndexedIndirectCommand*>(m_indirectCommands.mapped);
+  for (size_t i = 0; i < m_model->parts.size() * regionCount; i++)
+    commands[i].instanceCount = 1;
+  // and points nowhere until its frame is recorded
+  m_indirectGenerations.assign(1 + m_cullFrameCount, ~0u);
+}
+
+/**
+ * @brief Points the commands of a region's frame at the mesh's current range
+ * of the geometry arena
+ *
+ * The arena only moves meshes while no frame is between recording and
+ * submission, and bumps its generation when it does, so the commands are
+ * rewritten before the command buffers that read them are recorded again.
+ * Other frames may still be in flight with the old range, so only the
+ * recorded frame's regions are, once its fence has been waited on. Region 0
+ * is shared by every frame.
+ *
+ * @param region - Region being recorded
+ */
+void AssimpObject::updateIndirectCommands(uint32_t region) {
+  VulkanGeometryArena* arena = m_context->geometryArena;
+  // 0 for region 0, otherwise one past the region's frame
+  uint32_t slot = region == 0 ? 0 : 1 + (region - 1) / CULL_VIEW_COUNT;
+  if (m_indirectGenerations[slot] == arena->getGeneration()) return;
+  VulkanGeometryArena::Mesh const& mesh = arena->get(m_mesh);
+  size_t partCount = m_model->parts.size();
+  uint32_t firstRegion = slot == 0 ? 0 : 1 + (slot - 1) * CULL_VIEW_COUNT;
+  uint32_t endRegion = slot == 0 ? 1 : firstRegion + CULL_VIEW_COUNT;
+  auto commands =
+      static_cast<VkDrawIndexedIndirectCommand*>(m_indirectCommands.mapped);
+  for (size_t i = 0; i < partCount; i++) {
+    auto const& part = m_model->parts[i];
+    VkDrawIndexedIndirectCommand command = {};
+    command.indexCount = part.indexCount;
+    command.instanceCount = 1;
+    command.firstIndex = mesh.firstIndex + part.indexBase;
+    command.vertexOffset = static_cast<int32_t>(mesh.vertexOffset);
+    // the shader finds the part's texture through its instance index. Only
+    // devices with the bindless table enable drawIndirectFirstInstance,
+    // everywhere else it must be 0.
+    command.firstInstance =
+        m_bindlessTextures ? m_firstPart + static_cast<uint32_t>(i) : 0;
+    // culled regions keep the instance count their last cull gave them
+    for (uint32_t r = firstRegion; r < endRegion; r++) {
+      VkDrawIndexedIndirectCommand& regionCommand = commands[r * partCount + i];
+      if (r > 0) command.instanceCount = regionCommand.instanceCount;
+      regionCommand = command;
+    }
+  }
+  m_indirectGenerations[slot] = arena->getGeneration();
+}
+
+/**
+ * @brief Draws every part of the model, in a single indirect call when bindless
+ *
+ * Without a bindless table this is a plain mesh draw with the material set.
+ */
 void AssimpObject::build(VkCommandBuffer& cmdBuffer,
                          VulkanShader* vulkanShader) {
-  VkDeviceSize offsets[1] = {0};
-  if (vulkanShader->getPipeline()) {
-    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                      vulkanShader->getPipeline());
+  if (!m_bindlessTextures || m_model->parts.empty()) {
+    MeshObject::build(cmdBuffer, vulkanShader);
+    return;
+  }
+  drawIndirect(cmdBuffer, vulkanShader, 0);
+}
+
+/**
+ * @brief Draws the parts the last cull of a frame and view left visible
+ *
+ * The commands are read when the frame is submitted, so cull() can change
+ * what is drawn without recording again.
+ *
+ * @param cmdBuffer
+ * @param vulkanShader
+ * @param frame - Index of the frame being recorded
+ * @param view - Which cull's results to draw with
+ */
+void AssimpObject::build(VkCommandBuffer& cmdBuffer, VulkanShader* vulkanShader,
+                         uint32_t frame, CullView view) {
+  if (m_model->parts.empty() || frame >= m_cullFrameCount) {
+    MeshObject::build(cmdBuffer, vulkanShader);
+    return;
+  }
+  drawIndirect(cmdBuffer, vulkanShader, 1 + frame * CULL_VIEW_COUNT + view);
+}
+
+/**
+ * @brief Tests the parts' bounds against a view, and gives the culled ones no
+ * instances in that frame and view's commands
+ *
+ * Spheres are tested first, four at a time, and the parts they keep are
+ * tested again with their boxes. Must only be called once the frame's
+ * previous submission has completed.
+ *
+ * @param viewProjection - Transform to clip space of the model's world,
+ * without its own transform
+ * @param frame
+ * @param view
+ * @return uint32_t - Number of parts left visible
+ */
+uint32_t AssimpObject::cull(glm::mat4 const& viewProjection, uint32_t frame,
+                            CullView view) {
+  size_t partCount = m_model->parts.size();
+  if (partCount == 0 || frame >= m_cullFrameCount) return 0;
+  Frustum frustum(viewProjection * m_transform);
+  frustum.cullSpheres(m_partX.data(), m_partY.data(), m_partZ.data(),
+                      m_partRadius.data(), partCount, m_partVisible.data());
+  auto commands =
+      static_cast<VkDrawIndexedIndirectCommand*>(m_indirectCommands.mapped) +
+      (1 + frame * CULL_VIEW_COUNT + view) * partCount;
+  uint32_t visibleCount = 0;
+  for (size_t i = 0; i < partCount; i++) {
+    bool visible = m_partVisible[i] &&
+                   frustum.intersectsBox(m_partMin[i], m_partMax[i]);
+    commands[i].instanceCount = visible ? 1 : 0;
+    visibleCount += visible;
+  }
+  return visibleCount;
+}
+
+/**
+ * @brief Draws the parts with a region of the indirect commands
+ */
+void AssimpObject::drawIndirect(VkCommandBuffer& cmdBuffer,
+                                VulkanShader* vulkanShader, uint32_t region) {
+  updateIndirectCommands(region);
+  if (!bindPipeline(cmdBuffer, vulkanShader)) return;
+  if (m_bindlessTextures)
+    m_bindlessTextures->bind(cmdBuffer, *m_context->pPipelineLayout,
+                             VulkanDescriptorSet::PER_MATERIAL);
+  uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+  uint32_t partCount = static_cast<uint32_t>(m_model->parts.size());
+  VkDeviceSize offset = VkDeviceSize(region) * partCount * stride;
+  if (m_multiDrawIndirect) {
+    vkCmdDrawIndexedIndirect(cmdBuffer, m_indirectCommands.buffer, offset,
+                             partCount, stride);
   } else {
-    std::cout << "Pipeline null, bind failed!" << std::endl;
+    for (uint32_t i = 0; i < partCount; i++)
+      vkCmdDrawIndexedIndirect(cmdBuffer, m_indirectCommands.buffer,
+                               offset + i * stride, 1, stride);
+  }
+}
+
+/**
+ * @brief Finds the mesh's unique edges, gives each a state from the faces
+ * around it, and uploads them
+ *
+ * Faces have their own copies of shared corners, so corners are welded by
+ * position first. An edge with one face, or more than two, is a cut. Between
+ * two faces it is flat when they are parallel, and otherwise a mountain or a
+ * valley fold depending on whether the surface is convex there.
+ */
+void AssimpObject::prepareEdges() {
+  size_t stride = m_context->geometryArena->getVertexStride() / sizeof(float);
+  std::vector<float> const& vertices = m_model->vertexData;
+  std::vector<uint32_t> const& indices = m_model->indexData;
+  auto position = [&](uint32_t vertex) {
+    float const* p = &vertices[vertex * stride];
+    return glm::vec3(p[0], p[1], p[2]);
+  };
+
+  // welded id of each vertex, equal for equal positions
+  uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / stride);
+  std::vector<uint32_t> order(vertexCount);
+  for (uint32_t i = 0; i < vertexCount; i++) order[i] = i;
+  auto less = [&](uint32_t a, uint32_t b) {
+    float const* p = &vertices[a * stride];
+    float const* q = &vertices[b * stride];
+    return std::lexicographical_compare(p, p + 3, q, q + 3);
+  };
+  std::sort(order.begin(), order.end(), less);
+  std::vector<uint32_t> welded(vertexCount);
+  uint32_t weldedCount = 0;
+  for (uint32_t i = 0; i < vertexCount; i++) {
+    if (i > 0 && less(order[i - 1], order[i])) weldedCount++;
+    welded[order[i]] = weldedCount;
+  }
+
+  // every triangle side, keyed by its welded ends, sorted so an edge's
+  // sides are next to each other
+  struct Side {
+    uint64_t key;
+    uint32_t triangle;
+    uint32_t corner;
+  };
+  uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+  std::vector<Side> sides;
+  sides.reserve(indices.size());
+  for (uint32_t t = 0; t < triangleCount; t++) {
+    for (uint32_t corner = 0; corner < 3; corner++) {
+      uint32_t a = welded[indices[t * 3 + corner]];
+      uint32_t b = welded[indices[t * 3 + (corner + 1) % 3]];
+      if (a > b) std::swap(a, b);
+      sides.push_back({uint64_t(a) << 32 | b, t, corner});
+    }
+  }
+  std::sort(sides.begin(), sides.end(), [](Side const& a, Side const& b) {
+    return a.key < b.key || (a.key == b.key && a.triangle < b.triangle);
+  });
+
+  // the face's normal, facing the way its shading normals do
+  auto faceNormal = [&](uint32_t t) {
+    uint32_t const* corners = &indices[t * 3];
+    glm::vec3 a = position(corners[0]);
+    glm::vec3 normal =
+        glm::cross(position(corners[1]) - a, position(corners[2]) - a);
+    float const* shading = &vertices[corners[0] * stride + NORMAL_OFFSET];
+    if (glm::dot(normal, glm::vec3(shading[0], shading[1], shading[2])) < 0.f)
+      normal = -normal;
+    float length = glm::length(normal);
+    return length > 0.f ? normal / length : normal;
+  };
+
+  std::vector<uint32_t> edgeIndices;
+  m_edgeStateValues.clear();
+  m_triangleEdges.assign(indices.size(), INVALID_EDGE);
+  for (size_t first = 0; first < sides.size();) {
+    size_t last = first + 1;
+    while (last < sides.size() && sides[last].key == sides[first].key) last++;
+    Side const& side = sides[first];
+    uint32_t edge = static_cast<uint32_t>(m_edgeStateValues.size());
+    edgeIndices.push_back(indices[side.triangle * 3 + side.corner]);
+    edgeIndices.push_back(indices[side.triangle * 3 + (side.corner + 1) % 3]);
+    for (size_t i = first; i < last; i++)
+      m_triangleEdges[sides[i].triangle * 3 + sides[i].corner] = edge;
+
+    EdgeState state = EdgeState::CUT;
+    if (last - first == 2) {
+      uint32_t other = sides[first + 1].triangle;
+      glm::vec3 normal = faceNormal(side.triangle);
+      // the other face's corner off the edge, above or below this face
+      glm::vec3 apex = position(
+          indices[other * 3 + (sides[first + 1].corner + 2) % 3]);
+      glm::vec3 onEdge = position(edgeIndices.back());
+      if (glm::dot(normal, faceNormal(other)) > FLAT_COSINE) {
+        state = EdgeState::FLAT;
+      } else {
+        state = glm::dot(normal, apex - onEdge) < 0.f ? EdgeState::MOUNTAIN
+                                                      : EdgeState::VALLEY;
+      }
+    }
+    m_edgeStateValues.push_back(static_cast<uint8_t>(state));
+    first = last;
+  }
+  m_edgeCount = static_cast<uint32_t>(m_edgeStateValues.size());
+  LOGI("AssimpObject|prepareEdges| %u edges of %u triangles", m_edgeCount,
+       triangleCount);
+
+  // the edges only depend on the model, so windows showing it share them
+  VulkanGeometryArena* arena = m_context->geometryArena;
+  std::string key = m_modelPath.empty() ? "" : m_modelPath + "#edges";
+  arena->release(m_edgeMesh);
+  m_edgeMesh = arena->upload(nullptr, 0, edgeIndices.data(),
+                             static_cast<uint32_t>(edgeIndices.size()), key);
+
+  // the shader reads whole words, four states to each, and buffers can't
+  // be empty
+  m_edgeStateValues.resize(std::max<size_t>(4, (m_edgeCount + 3) / 4 * 4));
+  VulkanMemoryTracker::Scope scope(VulkanMemoryTracker::Category::MESH,
+                                   "Edge states");
+  m_edgeStates.destroy();
+  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      &m_edgeStates, m_edgeStateValues.size(), m_edgeStateValues.data()));
+  VK_CHECK_RESULT(m_edgeStates.map());
+}
+
+/**
+ * @brief Finds the edge two triangles share
+ *
+ * @param a - Index of a triangle within the whole mesh
+ * @param b - Index of another one
+ * @return uint32_t - The edge, or INVALID_EDGE if they share none
+ */
+uint32_t AssimpObject::getEdgeOfTriangles(uint32_t a, uint32_t b) const {
+  uint32_t triangleCount = getTriangleCount();
+  if (a >= triangleCount || b >= triangleCount || a == b) return INVALID_EDGE;
+  for (uint32_t i = 0; i < 3; i++) {
+    uint32_t edge = m_triangleEdges[a * 3 + i];
+    for (uint32_t j = 0; j < 3; j++)
+      if (m_triangleEdges[b * 3 + j] == edge) return edge;
+  }
+  return INVALID_EDGE;
+}
+
+/**
+ * @brief Changes an edge's state, which only rewrites its byte of the state
+ * buffer
+ *
+ * Nothing is recorded again, but the engine is told the scene changed, so
+ * views that only draw when dirty draw again. Frames already in flight may
+ * still draw the old state, and the ones after draw the new one.
+ *
+ * @param edge
+ * @param state
+ */
+void AssimpObject::setEdgeState(uint32_t edge, EdgeState state) {
+  if (edge >= m_edgeCount) return;
+  m_edgeStateValues[edge] = static_cast<uint8_t>(state);
+  static_cast<uint8_t*>(m_edgeStates.mapped)[edge] =
+      static_cast<uint8_t>(state);
+  if (m_context->sceneChanged) m_context->sceneChanged();
+}
+
+/**
+ * @brief Draws every edge of the mesh once, as lines
+ *
+ * The shader should have a line list topology, and finds each edge's state
+ * by its primitive id.
+ */
+void AssimpObject::buildEdges(VkCommandBuffer& cmdBuffer,
+                              VulkanShader* vulkanShader) {
+  if (m_edgeCount == 0 || !bindPipeline(cmdBuffer, vulkanShader)) return;
+  // a dynamic state of every pipeline, which only lines use
+  vkCmdSetLineWidth(cmdBuffer, 1.f);
+  m_context->geometryArena->draw(cmdBuffer, m_edgeMesh, m_mesh);
+}
+
+/**
+ * @brief Finds the model part a triangle belongs to
+ *
+ * @param triangle - Index of the triangle within the whole mesh
+ * @return uint32_t - Index into the model's parts
+ */
+uint32_t AssimpObject::getPartOfTriangle(uint32_t triangle) const {
+  uint32_t index = triangle * 3;
+  for (size_t i = 0; i < m_model->parts.size(); i++) {
+    auto const& part = m_model->parts[i];
+    if (index >= part.indexBase && index < part.indexBase + part.indexCount)
+      return static_cast<uint32_t>(i);
+  }
+  return 0;
+}
+
+/**
+ * @brief Finds the edge two triangles share
+ *
+ * Faces don't share vertices once they have their own normals and UVs, so
+ * corners are matched by position.
+ *
+ * @param a - Index of a triangle within the whole mesh
+ * @param b - Index of another one
+ * @param edge - Receives the ends of the shared edge
+ * @return Whether the triangles share an edge
+ */
+bool AssimpObject::getSharedEdge(uint32_t a, uint32_t b,
+                                 std::array<glm::vec3, 2>& edge) const {
+  uint32_t triangleCount = getTriangleCount();
+  if (a >= triangleCount || b >= triangleCount || a == b) return false;
+  size_t stride = m_context->geometryArena->getVertexStride() / sizeof(float);
+  auto position = [&](uint32_t triangle, uint32_t corner) {
+    float const* vertex =
+        &m_model->vertexData[m_model->indexData[triangle * 3 + corner] *
+                             stride];
+    return glm::vec3(vertex[0], vertex[1], vertex[2]);
+  };
+  size_t shared = 0;
+  for (uint32_t i = 0; i < 3 && shared < 2; i++) {
+    glm::vec3 corner = position(a, i);
+    for (uint32_t j = 0; j < 3; j++) {
+      if (glm::all(glm::equal(corner, position(b, j)))) {
+        edge[shared++] = corner;
+        break;
+      }
+    }
   }
-  vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1,
-                         &(m_model->vertices.buffer), offsets);
-  vkCmdBindIndexBuffer(cmdBuffer, m_model->indices.buffer, 0,
-                       VK_INDEX_TYPE_UINT32);
-  vkCmdDrawIndexed(cmdBuffer, m_model->indexCount, 1, 0, 0, 0);
+  return shared == 2;
 }
 
-}  // namespace VulkanEngine
\ No newline at end of file
+}  // namespace VulkanEngine
@@ -3,8 +3,7 @@
 namespace VulkanEngine {
 
 MeshObject::~MeshObject() {
-  m_vertexBuffer.destroy();
-  m_indexBuffer.destroy();
+  m_context->geometryArena->release(m_mesh);
 }
 
 void MeshObject::prepare() {
@@ -15,22 +14,69 @@ void MeshObject::update() {
   updateVertex();
 }
 
+/**
+ * @brief Copies the mesh into the geometry arena, replacing any previous copy
+ *
+ * @param vertices Vertices matching the arena's vertex stride
+ * @param vertexCount Number of vertices
+ * @param indices Indices relative to the first of these vertices
+ * @param key Shares the copy with every mesh uploaded under the same key, in
+ * any window, e.g. the path of the file the mesh was loaded from
+ */
+void MeshObject::uploadGeometry(void const *vertices, uint32_t vertexCount, std::vector<uint32_t> const &indices, std::string const &key) {
+  VulkanGeometryArena *arena = m_context->geometryArena;
+  arena->release(m_mesh);
+  m_mesh = arena->upload(vertices, vertexCount, indices.data(), static_cast<uint32_t>(indices.size()), key);
+  m_indexCount = static_cast<uint32_t>(indices.size());
+}
+
+/**
+ * @brief Binds the shader's pipeline, then pushes the mesh's transform and
+ * binds its material, if any
+ *
+ * @param cmdBuffer The command buffer to add the commands to
+ * @param vulkanShader The shader whose pipeline we want to bind for this mesh
+ * @return Whether the pipeline was bound. It is not while it is still being
+ * built, and the draw should be skipped.
+ */
+bool MeshObject::bindPipeline(VkCommandBuffer &cmdBuffer, VulkanShader* vulkanShader) {
+  if (!vulkanShader->getPipeline()) return false;
+  vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkanShader->getPipeline());
+  vkCmdPushConstants(cmdBuffer, *m_context->pPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &m_transform);
+  // material sets hold no dynamic buffers, so any frame index will do
+  if (m_material) m_material->bind(cmdBuffer, *m_context->pPipelineLayout, 0);
+  return true;
+}
+
 /**
  * @brief Adds this mesh object to the command buffer
+ *
+ * Expects the geometry arena's buffers to be bound already, which the engine
+ * does once per render pass.
  * 
  * @param cmdBuffer The command buffer to add the commands to
  * @param vulkanShader The shader whose pipeline we want to bind for this mesh
  */
 void MeshObject::build(VkCommandBuffer &cmdBuffer, VulkanShader* vulkanShader) {
-  VkDeviceSize offsets[1] = {0};
-  if (vulkanShader->getPipeline()) {
-    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkanShader->getPipeline());
-  } else {
-    LOGI("%s", "Pipeline null, bind failure.");
-  }
-  vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &m_vertexBuffer.buffer, offsets);
-  vkCmdBindIndexBuffer(cmdBuffer, m_indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-  vkCmdDrawIndexed(cmdBuffer, m_indexCount, 1, 0, 0, 0);
+  if (!bindPipeline(cmdBuffer, vulkanShader)) return;
+  m_context->geometryArena->draw(cmdBuffer, m_mesh);
+}
+
+/**
+ * @brief Adds one copy of this mesh per instance to the command buffer, in a
+ * single draw
+ *
+ * Each copy is placed by its instance matrix, then by the mesh's transform.
+ * The shader must have been given an instanced vertex input state.
+ *
+ * @param cmdBuffer The command buffer to add the commands to
+ * @param vulkanShader The instanced shader to draw with
+ * @param instances The instance matrices
+ */
+void MeshObject::buildInstanced(VkCommandBuffer &cmdBuffer, VulkanShader* vulkanShader, VulkanInstanceBuffer *instances) {
+  if (instances->getCount() == 0 || !bindPipeline(cmdBuffer, vulkanShader)) return;
+  instances->bind(cmdBuffer);
+  m_context->geometryArena->draw(cmdBuffer, m_mesh, instances->getCount());
 }
 
 }
\ No newline at end of file
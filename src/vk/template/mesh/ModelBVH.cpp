@@ -0,0 +1,555 @@
+#include "mesh/ModelBVH.h"
+
+#include <future>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define MODEL_BVH_SSE
+#endif
+
+namespace VulkanEngine {
+
+namespace {
+
+constexpr uint32_t BIN_COUNT = 16;
+// leaves are made as soon as the SAH says so, and always at this size
+constexpr uint32_t MIN_LEAF_SIZE = 2;
+constexpr uint32_t MAX_LEAF_SIZE = 8;
+constexpr uint32_t MAX_DEPTH = 64;
+// subtrees below these are not worth a thread
+constexpr uint32_t PARALLEL_DEPTH = 4;
+constexpr uint32_t PARALLEL_MIN_TRIANGLES = 1 << 14;
+// cost of visiting a node, relative to testing a triangle
+constexpr float TRAVERSAL_COST = 1.f;
+
+/**
+ * @brief Runs f(begin, end) over [0, count) in one chunk per hardware thread
+ */
+template <typename F>
+void parallelFor(size_t count, F const& f) {
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  if (count < PARALLEL_MIN_TRIANGLES || threads == 1) {
+    f(size_t(0), count);
+    return;
+  }
+  size_t chunk = (count + threads - 1) / threads;
+  std::vector<std::future<void>> tasks;
+  for (size_t begin = 0; begin < count; begin += chunk)
+    tasks.push_back(std::async(std::launch::async, f, begin,
+                               std::min(count, begin + chunk)));
+  for (auto& task : tasks) task.get();
+}
+
+float surfaceArea(glm::vec3 const& min, glm::vec3 const& max) {
+  glm::vec3 extent = glm::max(max - min, glm::vec3(0.f));
+  return 2.f * (extent.x * extent.y + extent.y * extent.z +
+                extent.z * extent.x);
+}
+
+float boxDistance2(glm::vec3 const& min, glm::vec3 const& max,
+                   glm::vec3 const& point) {
+  glm::vec3 d = glm::max(glm::max(min - point, point - max), glm::vec3(0.f));
+  return glm::dot(d, d);
+}
+
+/**
+ * @brief Closest point of a triangle to a point, after Ericson's Real-Time
+ * Collision Detection, 5.1.5
+ *
+ * @param barycentric - Receives the weights of the second and third corners
+ */
+glm::vec3 closestPoint(glm::vec3 const& a, glm::vec3 const& ab,
+                       glm::vec3 const& ac, glm::vec3 const& p,
+                       glm::vec2& barycentric) {
+  glm::vec3 ap = p - a;
+  float d1 = glm::dot(ab, ap);
+  float d2 = glm::dot(ac, ap);
+  if (d1 <= 0.f && d2 <= 0.f) {
+    barycentric = glm::vec2(0.f, 0.f);
+    return a;
+  }
+  glm::vec3 bp = ap - ab;
+  float d3 = glm::dot(ab, bp);
+  float d4 = glm::dot(ac, bp);
+  if (d3 >= 0.f && d4 <= d3) {
+    barycentric = glm::vec2(1.f, 0.f);
+    return a + ab;
+  }
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+    float v = d1 / (d1 - d3);
+    barycentric = glm::vec2(v, 0.f);
+    return a + v * ab;
+  }
+  glm::vec3 cp = ap - ac;
+  float d5 = glm::dot(ab, cp);
+  float d6 = glm::dot(ac, cp);
+  if (d6 >= 0.f && d5 <= d6) {
+    barycentric = glm::vec2(0.f, 1.f);
+    return a + ac;
+  }
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+    float w = d2 / (d2 - d6);
+    barycentric = glm::vec2(0.f, w);
+    return a + w * ac;
+  }
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) {
+    float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    barycentric = glm::vec2(1.f - w, w);
+    return a + ab + w * (ac - ab);
+  }
+  float denominator = 1.f / (va + vb + vc);
+  barycentric = glm::vec2(vb, vc) * denominator;
+  return a + ab * barycentric.x + ac * barycentric.y;
+}
+
+/**
+ * @brief Separating axis test of a triangle against a box, after
+ * Akenine-Möller's "Fast 3D Triangle-Box Overlap Testing"
+ */
+bool overlapsBox(glm::vec3 const& center, glm::vec3 const& halfSize,
+                 glm::vec3 const& a, glm::vec3 const& ab,
+                 glm::vec3 const& ac) {
+  std::array<glm::vec3, 3> v = {a - center, a + ab - center, a + ac - center};
+  std::array<glm::vec3, 3> edges = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+  auto separates = [&](glm::vec3 const& axis) {
+    float p0 = glm::dot(v[0], axis);
+    float p1 = glm::dot(v[1], axis);
+    float p2 = glm::dot(v[2], axis);
+    float r = glm::dot(halfSize, glm::abs(axis));
+    return std::min({p0, p1, p2}) > r || std::max({p0, p1, p2}) < -r;
+  };
+  // the box's axes crossed with the triangle's edges
+  for (auto const& f : edges) {
+    if (separates(glm::vec3(0.f, -f.z, f.y)) ||
+        separates(glm::vec3(f.z, 0.f, -f.x)) ||
+        separates(glm::vec3(-f.y, f.x, 0.f)))
+      return false;
+  }
+  // the box's faces
+  glm::vec3 min = glm::min(glm::min(v[0], v[1]), v[2]);
+  glm::vec3 max = glm::max(glm::max(v[0], v[1]), v[2]);
+  if (glm::any(glm::greaterThan(min, halfSize)) ||
+      glm::any(glm::lessThan(max, -halfSize)))
+    return false;
+  // the triangle's plane
+  glm::vec3 normal = glm::cross(edges[0], edges[1]);
+  return std::abs(glm::dot(normal, v[0])) <=
+         glm::dot(halfSize, glm::abs(normal));
+}
+
+}  // namespace
+
+/**
+ * @brief The ray under a point of the screen, in the space the
+ * transformation maps from
+ *
+ * With a model's modelViewProjection, the ray is in the model's space, the
+ * one its BVH is built in.
+ *
+ * @param position - In pixels from the top left
+ * @param size - Of the screen, in pixels
+ * @param modelViewProjection
+ * @return Ray - Starting on the near plane, with a unit direction
+ */
+ModelBVH::Ray ModelBVH::Ray::fromScreen(glm::vec2 const& position,
+                                        glm::vec2 const& size,
+                                        glm::mat4 const& modelViewProjection) {
+  glm::vec2 ndc = position / size * 2.f - 1.f;
+  glm::mat4 inverse = glm::inverse(modelViewProjection);
+  glm::vec4 nearPoint = inverse * glm::vec4(ndc, 0.f, 1.f);
+  glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.f, 1.f);
+  Ray ray;
+  ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+  ray.direction =
+      glm::normalize(glm::vec3(farPoint) / farPoint.w - ray.origin);
+  return ray;
+}
+
+/**
+ * @brief Builds the hierarchy over an indexed triangle list, replacing any
+ * previous one
+ *
+ * @param vertices - Interleaved vertices, the position first
+ * @param vertexStride - In floats
+ * @param indices - Three per triangle
+ */
+void ModelBVH::build(float const* vertices, size_t vertexStride,
+                     std::vector<uint32_t> const& indices) {
+  m_nodes.clear();
+  m_triangles.clear();
+  uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+  m_triangleIds.resize(triangleCount);
+  if (triangleCount == 0) return;
+  auto position = [&](uint32_t triangle, uint32_t corner) {
+    float const* vertex = &vertices[indices[triangle * 3 + corner] *
+                                    vertexStride];
+    return glm::vec3(vertex[0], vertex[1], vertex[2]);
+  };
+
+  m_buildTriangles.resize(triangleCount);
+  parallelFor(triangleCount, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      uint32_t triangle = static_cast<uint32_t>(i);
+      glm::vec3 a = position(triangle, 0);
+      glm::vec3 b = position(triangle, 1);
+      glm::vec3 c = position(triangle, 2);
+      BuildTriangle& build = m_buildTriangles[i];
+      build.min = glm::min(glm::min(a, b), c);
+      build.max = glm::max(glm::max(a, b), c);
+      build.centroid = (a + b + c) / 3.f;
+      m_triangleIds[i] = triangle;
+    }
+  });
+
+  m_nodes.emplace_back();
+  buildNode(m_nodes, 0, 0, triangleCount, 0);
+  std::vector<BuildTriangle>().swap(m_buildTriangles);
+
+  // triangles in leaf order, so a leaf's are next to each other
+  m_triangles.resize(triangleCount);
+  parallelFor(triangleCount, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      uint32_t triangle = m_triangleIds[i];
+      glm::vec3 a = position(triangle, 0);
+      m_triangles[i] = {a, position(triangle, 1) - a,
+                        position(triangle, 2) - a};
+    }
+  });
+}
+
+/**
+ * @brief Builds a node over a range of the triangle ids and, unless it is a
+ * leaf, its children after it
+ *
+ * Near the root, the right subtree is built on another thread into its own
+ * array and appended once the left one is done. The ranges the two sides
+ * reorder don't overlap.
+ *
+ * @param nodes - Already holds the node, as its last element
+ * @param nodeIndex
+ * @param first - Into m_triangleIds
+ * @param count
+ * @param depth
+ */
+void ModelBVH::buildNode(std::vector<Node>& nodes, uint32_t nodeIndex,
+                         uint32_t first, uint32_t count, uint32_t depth) {
+  glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+  glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+  for (uint32_t i = first; i < first + count; i++) {
+    BuildTriangle const& triangle = m_buildTriangles[m_triangleIds[i]];
+    min = glm::min(min, triangle.min);
+    max = glm::max(max, triangle.max);
+    centroidMin = glm::min(centroidMin, triangle.centroid);
+    centroidMax = glm::max(centroidMax, triangle.centroid);
+  }
+  nodes[nodeIndex].min = min;
+  nodes[nodeIndex].max = max;
+  nodes[nodeIndex].leftFirst = first;
+  nodes[nodeIndex].count = count;
+  if (count <= MIN_LEAF_SIZE || depth >= MAX_DEPTH) return;
+
+  // binned SAH: the cheapest of the planes between bins, on every axis
+  struct Bin {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+    uint32_t count = 0;
+  };
+  float bestCost = FLT_MAX;
+  int bestAxis = -1;
+  uint32_t bestSplit = 0;
+  glm::vec3 extent = centroidMax - centroidMin;
+  for (int axis = 0; axis < 3; axis++) {
+    if (extent[axis] <= 0.f) continue;
+    std::array<Bin, BIN_COUNT> bins;
+    float scale = BIN_COUNT / extent[axis];
+    for (uint32_t i = first; i < first + count; i++) {
+      BuildTriangle const& triangle = m_buildTriangles[m_triangleIds[i]];
+      uint32_t bin = std::min(
+          BIN_COUNT - 1,
+          static_cast<uint32_t>(
+              (triangle.centroid[axis] - centroidMin[axis]) * scale));
+      bins[bin].min = glm::min(bins[bin].min, triangle.min);
+      bins[bin].max = glm::max(bins[bin].max, triangle.max);
+      bins[bin].count++;
+    }
+    // cost of everything left of each plane, then add the right side
+    std::array<float, BIN_COUNT - 1> costs;
+    Bin side;
+    for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+      side.min = glm::min(side.min, bins[i].min);
+      side.max = glm::max(side.max, bins[i].max);
+      side.count += bins[i].count;
+      costs[i] = side.count ? side.count * surfaceArea(side.min, side.max)
+                            : 0.f;
+    }
+    side = Bin();
+    for (uint32_t i = BIN_COUNT - 1; i > 0; i--) {
+      side.min = glm::min(side.min, bins[i].min);
+      side.max = glm::max(side.max, bins[i].max);
+      side.count += bins[i].count;
+      float cost = costs[i - 1] +
+                   (side.count ? side.count * surfaceArea(side.min, side.max)
+                               : 0.f);
+      if (side.count > 0 && side.count < count && cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestSplit = i - 1;
+      }
+    }
+  }
+  if (bestAxis < 0) return;
+  float area = surfaceArea(min, max);
+  float splitCost = TRAVERSAL_COST + (area > 0.f ? bestCost / area : 0.f);
+  if (splitCost >= static_cast<float>(count) && count <= MAX_LEAF_SIZE)
+    return;
+
+  float scale = BIN_COUNT / extent[bestAxis];
+  uint32_t* middle = std::partition(
+      m_triangleIds.data() + first, m_triangleIds.data() + first + count,
+      [&](uint32_t id) {
+        float offset =
+            m_buildTriangles[id].centroid[bestAxis] - centroidMin[bestAxis];
+        return std::min(BIN_COUNT - 1, static_cast<uint32_t>(
+                                           offset * scale)) <= bestSplit;
+      });
+  uint32_t leftCount =
+      static_cast<uint32_t>(middle - (m_triangleIds.data() + first));
+  if (leftCount == 0 || leftCount == count) return;
+  uint32_t rightFirst = first + leftCount;
+  uint32_t rightCount = count - leftCount;
+  nodes[nodeIndex].count = 0;
+
+  if (depth < PARALLEL_DEPTH && count >= PARALLEL_MIN_TRIANGLES) {
+    auto right = std::async(std::launch::async, [this, rightFirst,
+                                                 rightCount, depth]() {
+      std::vector<Node> rightNodes(1);
+      buildNode(rightNodes, 0, rightFirst, rightCount, depth + 1);
+      return rightNodes;
+    });
+    nodes.emplace_back();
+    buildNode(nodes, nodeIndex + 1, first, leftCount, depth + 1);
+    std::vector<Node> rightNodes = right.get();
+    uint32_t offset = static_cast<uint32_t>(nodes.size());
+    for (Node& node : rightNodes)
+      if (node.count == 0) node.leftFirst += offset;
+    nodes.insert(nodes.end(), rightNodes.begin(), rightNodes.end());
+    nodes[nodeIndex].leftFirst = offset;
+    return;
+  }
+  nodes.emplace_back();
+  buildNode(nodes, nodeIndex + 1, first, leftCount, depth + 1);
+  uint32_t rightIndex = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+  buildNode(nodes, rightIndex, rightFirst, rightCount, depth + 1);
+  nodes[nodeIndex].leftFirst = rightIndex;
+}
+
+/**
+ * @brief Finds the first triangle a ray hits, from either side
+ *
+ * @param ray
+ * @param hit - Receives the triangle, the distance in units of the ray's
+ * direction, the point and its barycentric coordinates
+ * @param maxDistance - Hits further than this are ignored
+ * @return Whether a triangle was hit
+ */
+bool ModelBVH::intersect(Ray const& ray, Hit& hit, float maxDistance) const {
+  hit = Hit();
+  if (m_nodes.empty()) return false;
+  // axis-parallel rays would make 0 * inf in the slab test
+  glm::vec3 direction = ray.direction;
+  for (int i = 0; i < 3; i++)
+    if (std::abs(direction[i]) < 1e-20f)
+      direction[i] = std::copysign(1e-20f, direction[i]);
+  glm::vec3 inverseDirection = 1.f / direction;
+  float best = maxDistance;
+
+#ifdef MODEL_BVH_SSE
+  __m128 origin = _mm_set_ps(0.f, ray.origin.z, ray.origin.y, ray.origin.x);
+  __m128 inverse = _mm_set_ps(0.f, inverseDirection.z, inverseDirection.y,
+                              inverseDirection.x);
+  // entry distance into a node's box, FLT_MAX if the ray misses it
+  auto enter = [&](Node const& node) {
+    // the fourth lanes hold leftFirst and count and are left out
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&node.min.x), origin),
+                           inverse);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&node.max.x), origin),
+                           inverse);
+    __m128 lower = _mm_min_ps(t1, t2);
+    __m128 upper = _mm_max_ps(t1, t2);
+    lower = _mm_max_ss(
+        _mm_max_ss(lower,
+                   _mm_shuffle_ps(lower, lower, _MM_SHUFFLE(3, 0, 2, 1))),
+        _mm_movehl_ps(lower, lower));
+    upper = _mm_min_ss(
+        _mm_min_ss(upper,
+                   _mm_shuffle_ps(upper, upper, _MM_SHUFFLE(3, 0, 2, 1))),
+        _mm_movehl_ps(upper, upper));
+    float tNear = _mm_cvtss_f32(lower);
+    float tFar = _mm_cvtss_f32(upper);
+    return tFar >= std::max(tNear, 0.f) && tNear < best ? tNear : FLT_MAX;
+  };
+#else
+  auto enter = [&](Node const& node) {
+    glm::vec3 t1 = (node.min - ray.origin) * inverseDirection;
+    glm::vec3 t2 = (node.max - ray.origin) * inverseDirection;
+    glm::vec3 lower = glm::min(t1, t2);
+    glm::vec3 upper = glm::max(t1, t2);
+    float tNear = std::max(std::max(lower.x, lower.y), lower.z);
+    float tFar = std::min(std::min(upper.x, upper.y), upper.z);
+    return tFar >= std::max(tNear, 0.f) && tNear < best ? tNear : FLT_MAX;
+  };
+#endif
+
+  // nodes still to visit, with the distance the ray enters them at
+  std::array<std::pair<uint32_t, float>, MAX_DEPTH * 2> stack;
+  size_t stackSize = 0;
+  float rootEntry = enter(m_nodes[0]);
+  if (rootEntry == FLT_MAX) return false;
+  stack[stackSize++] = {0, rootEntry};
+  while (stackSize > 0) {
+    auto entry = stack[--stackSize];
+    if (entry.second >= best) continue;
+    Node const& node = m_nodes[entry.first];
+    if (node.count > 0) {
+      for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count;
+           i++) {
+        Triangle const& triangle = m_triangles[i];
+        // Möller-Trumbore
+        glm::vec3 p = glm::cross(ray.direction, triangle.edge2);
+        float determinant = glm::dot(triangle.edge1, p);
+        if (std::abs(determinant) < 1e-12f) continue;
+        float inverseDeterminant = 1.f / determinant;
+        glm::vec3 s = ray.origin - triangle.v0;
+        float u = glm::dot(s, p) * inverseDeterminant;
+        if (u < 0.f || u > 1.f) continue;
+        glm::vec3 q = glm::cross(s, triangle.edge1);
+        float v = glm::dot(ray.direction, q) * inverseDeterminant;
+        if (v < 0.f || u + v > 1.f) continue;
+        float t = glm::dot(triangle.edge2, q) * inverseDeterminant;
+        if (t < 0.f || t >= best) continue;
+        best = t;
+        hit.triangle = m_triangleIds[i];
+        hit.distance = t;
+        hit.barycentric = glm::vec2(u, v);
+      }
+      continue;
+    }
+    // the nearer child is visited first, the other may be culled by then
+    uint32_t left = entry.first + 1;
+    uint32_t right = node.leftFirst;
+    float leftEntry = enter(m_nodes[left]);
+    float rightEntry = enter(m_nodes[right]);
+    if (leftEntry > rightEntry) {
+      std::swap(left, right);
+      std::swap(leftEntry, rightEntry);
+    }
+    if (rightEntry != FLT_MAX) stack[stackSize++] = {right, rightEntry};
+    if (leftEntry != FLT_MAX) stack[stackSize++] = {left, leftEntry};
+  }
+  if (hit.triangle == INVALID_TRIANGLE) return false;
+  hit.point = ray.origin + ray.direction * hit.distance;
+  return true;
+}
+
+/**
+ * @brief Finds the triangle closest to a point
+ *
+ * @param point
+ * @param hit - Receives the triangle, the distance to it, the closest point
+ * on it and that point's barycentric coordinates
+ * @param maxDistance - Triangles further than this are ignored
+ * @return Whether a triangle was found
+ */
+bool ModelBVH::nearest(glm::vec3 const& point, Hit& hit,
+                       float maxDistance) const {
+  hit = Hit();
+  if (m_nodes.empty()) return false;
+  float best = maxDistance < FLT_MAX ? maxDistance * maxDistance : FLT_MAX;
+
+  std::array<std::pair<uint32_t, float>, MAX_DEPTH * 2> stack;
+  size_t stackSize = 0;
+  stack[stackSize++] = {0, boxDistance2(m_nodes[0].min, m_nodes[0].max,
+                                        point)};
+  while (stackSize > 0) {
+    auto entry = stack[--stackSize];
+    if (entry.second > best) continue;
+    Node const& node = m_nodes[entry.first];
+    if (node.count > 0) {
+      for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count;
+           i++) {
+        Triangle const& triangle = m_triangles[i];
+        glm::vec2 barycentric;
+        glm::vec3 closest = closestPoint(triangle.v0, triangle.edge1,
+                                         triangle.edge2, point, barycentric);
+        glm::vec3 offset = closest - point;
+        float distance2 = glm::dot(offset, offset);
+        if (distance2 > best) continue;
+        best = distance2;
+        hit.triangle = m_triangleIds[i];
+        hit.point = closest;
+        hit.barycentric = barycentric;
+      }
+      continue;
+    }
+    uint32_t left = entry.first + 1;
+    uint32_t right = node.leftFirst;
+    float leftDistance =
+        boxDistance2(m_nodes[left].min, m_nodes[left].max, point);
+    float rightDistance =
+        boxDistance2(m_nodes[right].min, m_nodes[right].max, point);
+    if (leftDistance > rightDistance) {
+      std::swap(left, right);
+      std::swap(leftDistance, rightDistance);
+    }
+    if (rightDistance <= best) stack[stackSize++] = {right, rightDistance};
+    if (leftDistance <= best) stack[stackSize++] = {left, leftDistance};
+  }
+  if (hit.triangle == INVALID_TRIANGLE) return false;
+  hit.distance = std::sqrt(best);
+  return true;
+}
+
+/**
+ * @brief Finds every triangle overlapping a box
+ *
+ * @param min
+ * @param max
+ * @param triangles - Receives the triangles, in no particular order
+ */
+void ModelBVH::query(glm::vec3 const& min, glm::vec3 const& max,
+                     std::vector<uint32_t>& triangles) const {
+  triangles.clear();
+  if (m_nodes.empty()) return;
+  glm::vec3 center = (min + max) * 0.5f;
+  glm::vec3 halfSize = (max - min) * 0.5f;
+
+  std::array<uint32_t, MAX_DEPTH * 2> stack;
+  size_t stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    Node const& node = m_nodes[stack[--stackSize]];
+    if (glm::any(glm::greaterThan(node.min, max)) ||
+        glm::any(glm::lessThan(node.max, min)))
+      continue;
+    if (node.count == 0) {
+      stack[stackSize++] = node.leftFirst;
+      stack[stackSize++] = static_cast<uint32_t>(&node - m_nodes.data()) + 1;
+      continue;
+    }
+    // a leaf inside the box needs no exact tests
+    bool inside = glm::all(glm::greaterThanEqual(node.min, min)) &&
+                  glm::all(glm::lessThanEqual(node.max, max));
+    for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++) {
+      Triangle const& triangle = m_triangles[i];
+      if (inside || overlapsBox(center, halfSize, triangle.v0, triangle.edge1,
+                                triangle.edge2))
+        triangles.push_back(m_triangleIds[i]);
+    }
+  }
+}
+
+}  // namespace VulkanEngine
@@ -58,22 +58,9 @@ void VulkanCube::generateVertex() {
   // set up vertex indices
   std::vector<uint32_t> indices(vertices.size());
   for (int i = 0; i < indices.size(); i++) indices[i] = i;
-  m_indexCount = static_cast<uint32_t>(indices.size());
 
-  // create buffers
-  // vertex buffer. for simplicity, we don't stage to the GPUs
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_vertexBuffer, vertices.size() * sizeof(VertexTexVec4),
-      vertices.data()));
-  // index buffer
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_indexBuffer, indices.size() * sizeof(uint32_t), indices.data()));
+  // copy into device-local memory in the geometry arena
+  uploadGeometry(vertices, indices);
 }
 
 }  // namespace VulkanEngine
@@ -20,20 +20,9 @@ void VulkanPlane::generateVertex() {
   // setup the indices
   std::vector<uint32_t> indices(vertices.size());
   for (int i = 0; i < indices.size(); i++) indices[i] = i;
-  m_indexCount = static_cast<uint32_t>(indices.size());
 
-  // create buffers (in host memory, for simplicity)
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_vertexBuffer, vertices.size() * sizeof(VertexTexVec4),
-      vertices.data()));
-  VK_CHECK_RESULT(m_context->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_indexBuffer, indices.size() * sizeof(uint32_t), indices.data()));
+  // copy into device-local memory in the geometry arena
+  uploadGeometry(vertices, indices);
 }
 
 }  // namespace VulkanEngine
\ No newline at end of file
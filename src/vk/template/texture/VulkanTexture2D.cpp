@@ -74,8 +74,9 @@ void VulkanTexture2D::loadFromFile(std::string file, VkFormat format,
     memAllocInfo.memoryTypeIndex = device->getMemoryType(
         memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo,
-                                     nullptr, &stagingMemory));
+    VK_CHECK_RESULT(VulkanMemoryTracker::get().allocate(
+        device->logicalDevice, &memAllocInfo, &stagingMemory,
+        VulkanMemoryTracker::Category::STAGING, file.c_str()));
     VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer,
                                        stagingMemory, 0));
 
@@ -126,8 +127,9 @@ void VulkanTexture2D::loadFromFile(std::string file, VkFormat format,
     memAllocInfo.allocationSize = memReqs.size;
     memAllocInfo.memoryTypeIndex = device->getMemoryType(
         memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo,
-                                     nullptr, &deviceMemory));
+    VK_CHECK_RESULT(VulkanMemoryTracker::get().allocate(
+        device->logicalDevice, &memAllocInfo, &deviceMemory,
+        VulkanMemoryTracker::Category::TEXTURE, file.c_str()));
     VK_CHECK_RESULT(
         vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
 
@@ -161,7 +163,7 @@ void VulkanTexture2D::loadFromFile(std::string file, VkFormat format,
     device->flushCommandBuffer(copyCmd, copyQueue);
 
     // clean up staging resources. have been transferred to GPU now.
-    vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
+    VulkanMemoryTracker::get().free(device->logicalDevice, stagingMemory);
     vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
     // if we're not staging, and keeping the image on CPU and mappiing to GPU
   } else {
@@ -200,8 +202,9 @@ void VulkanTexture2D::loadFromFile(std::string file, VkFormat format,
                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     // allocate and bind host memory
-    VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo,
-                                     nullptr, &mappableMemory));
+    VK_CHECK_RESULT(VulkanMemoryTracker::get().allocate(
+        device->logicalDevice, &memAllocInfo, &mappableMemory,
+        VulkanMemoryTracker::Category::TEXTURE, file.c_str()));
     VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, mappableImage,
                                       mappableMemory, 0));
 